@@ -0,0 +1,123 @@
+// Tests that a leading $group which only needs the first or last document of each group is fed by a
+// DISTINCT_SCAN, and that one which only reads indexed fields is fed by a covered index scan.
+//
+// Relies on the $group being the first stage of the pipeline, so cannot wrap pipelines in $facet
+// stages. A sharded collection never uses a DISTINCT_SCAN for a $group.
+// @tags: [do_not_wrap_aggregations_in_facets, assumes_unsharded_collection]
+(function() {
+    "use strict";
+
+    load("jstests/libs/analyze_plan.js");  // For 'aggPlanHasStage' and other explain helpers.
+
+    const coll = db.use_index_only_group;
+    coll.drop();
+
+    const bulk = coll.initializeUnorderedBulkOp();
+    for (let i = 0; i < 100; ++i) {
+        bulk.insert({_id: i, a: i % 5, b: (i * 37) % 100, c: i});
+    }
+    assert.writeOK(bulk.execute());
+    assert.commandWorked(coll.createIndex({a: 1, b: 1}));
+
+    function setUseIndexOnlyPlans(enabled) {
+        assert.commandWorked(db.adminCommand(
+            {setParameter: 1, internalDocumentSourceGroupUseIndexOnlyPlans: enabled}));
+    }
+
+    function assertUsesDistinctScan(pipeline) {
+        const explainOutput = coll.explain().aggregate(pipeline);
+        assert(aggPlanHasStage(explainOutput, "DISTINCT_SCAN"),
+               "Expected pipeline " + tojsononeline(pipeline) +
+                   " to use a DISTINCT_SCAN: " + tojson(explainOutput));
+        assert(!aggPlanHasStage(explainOutput, "$sort"), tojson(explainOutput));
+    }
+
+    function assertDoesNotUseDistinctScan(pipeline) {
+        const explainOutput = coll.explain().aggregate(pipeline);
+        assert(!aggPlanHasStage(explainOutput, "DISTINCT_SCAN"),
+               "Expected pipeline " + tojsononeline(pipeline) +
+                   " *not* to use a DISTINCT_SCAN: " + tojson(explainOutput));
+    }
+
+    function assertUsesCoveredIndexScan(pipeline) {
+        const explainOutput = coll.explain().aggregate(pipeline);
+        assert(aggPlanHasStage(explainOutput, "IXSCAN"),
+               "Expected pipeline " + tojsononeline(pipeline) + " to use an IXSCAN: " +
+                   tojson(explainOutput));
+        assert(!aggPlanHasStage(explainOutput, "FETCH"),
+               "Expected pipeline " + tojsononeline(pipeline) + " *not* to FETCH: " +
+                   tojson(explainOutput));
+    }
+
+    // Checks that 'pipeline' produces the same results with and without index-only plans, and
+    // returns them sorted by _id.
+    function assertSameResultsAsWithoutIndexOnlyPlans(pipeline) {
+        const sortById = (x, y) => (x._id < y._id ? -1 : (x._id > y._id ? 1 : 0));
+        const results = coll.aggregate(pipeline).toArray().sort(sortById);
+        setUseIndexOnlyPlans(false);
+        try {
+            assertDoesNotUseDistinctScan(pipeline);
+            const expected = coll.aggregate(pipeline).toArray().sort(sortById);
+            assert.eq(expected, results, tojsononeline(pipeline));
+        } finally {
+            setUseIndexOnlyPlans(true);
+        }
+        return results;
+    }
+
+    // Index-only plans are off by default, since they bypass the plan cache and multiplanner.
+    let pipeline = [{$group: {_id: "$a"}}];
+    assertDoesNotUseDistinctScan(pipeline);
+    setUseIndexOnlyPlans(true);
+
+    // A $group on an indexed field which needs nothing else uses a DISTINCT_SCAN.
+    assertUsesDistinctScan(pipeline);
+    assert.eq(5, assertSameResultsAsWithoutIndexOnlyPlans(pipeline).length);
+
+    pipeline = [{$match: {a: {$gte: 2}}}, {$group: {_id: "$a"}}];
+    assertUsesDistinctScan(pipeline);
+    assert.eq(3, assertSameResultsAsWithoutIndexOnlyPlans(pipeline).length);
+
+    // A $sort followed by a $group taking the $first or $last of each group uses a DISTINCT_SCAN
+    // in the direction of the sort.
+    pipeline = [{$sort: {a: 1, b: 1}}, {$group: {_id: "$a", b: {$first: "$b"}}}];
+    assertUsesDistinctScan(pipeline);
+    let results = assertSameResultsAsWithoutIndexOnlyPlans(pipeline);
+    assert.eq([{_id: 0, b: 0}, {_id: 1, b: 1}, {_id: 2, b: 2}, {_id: 3, b: 3}, {_id: 4, b: 4}],
+              results);
+
+    pipeline = [{$sort: {a: 1, b: 1}}, {$group: {_id: "$a", b: {$last: "$b"}}}];
+    assertUsesDistinctScan(pipeline);
+    results = assertSameResultsAsWithoutIndexOnlyPlans(pipeline);
+    assert.eq([{_id: 0, b: 95}, {_id: 1, b: 96}, {_id: 2, b: 97}, {_id: 3, b: 98}, {_id: 4, b: 99}],
+              results);
+
+    pipeline =
+        [{$sort: {a: -1, b: -1}}, {$group: {_id: "$a", b: {$first: "$b"}, c: {$first: "$c"}}}];
+    assertUsesDistinctScan(pipeline);
+    assertSameResultsAsWithoutIndexOnlyPlans(pipeline);
+
+    // A $group mixing $first and $last, or using any other accumulator, cannot use a DISTINCT_SCAN.
+    assertDoesNotUseDistinctScan(
+        [{$sort: {a: 1, b: 1}}, {$group: {_id: "$a", f: {$first: "$b"}, l: {$last: "$b"}}}]);
+    assertDoesNotUseDistinctScan([{$group: {_id: "$a", n: {$sum: 1}}}]);
+
+    // A sort which the index cannot provide keeps the $sort.
+    assertDoesNotUseDistinctScan([{$sort: {a: 1, c: 1}}, {$group: {_id: "$a", c: {$first: "$c"}}}]);
+
+    // A $group which only reads indexed fields is fed by a covered index scan.
+    pipeline = [{$group: {_id: "$a", n: {$sum: 1}, min: {$min: "$b"}, max: {$max: "$b"}}}];
+    assertUsesCoveredIndexScan(pipeline);
+    results = assertSameResultsAsWithoutIndexOnlyPlans(pipeline);
+    assert.eq(5, results.length, tojson(results));
+    for (let result of results) {
+        assert.eq(20, result.n, tojson(results));
+    }
+
+    // Neither plan can use a multikey index, as it holds a key for each element of an array.
+    assert.writeOK(coll.insert({_id: 100, a: [1, 2], b: 0}));
+    assertDoesNotUseDistinctScan([{$group: {_id: "$a"}}]);
+    assertSameResultsAsWithoutIndexOnlyPlans([{$group: {_id: "$a", n: {$sum: 1}}}]);
+
+    setUseIndexOnlyPlans(false);
+}());
@@ -0,0 +1,100 @@
+// Tests that a $sort which has absorbed a small $limit near the front of the pipeline is performed
+// by the query system as a top-k SORT stage when no index can provide the sort.
+//
+// Relies on the ability to push leading $sorts down to the query system, so cannot wrap pipelines
+// in $facet stages. Whether a $sort is pushed down depends on the average document size on each
+// shard, so the collection must not be sharded.
+// @tags: [do_not_wrap_aggregations_in_facets, assumes_unsharded_collection]
+(function() {
+    "use strict";
+
+    load("jstests/libs/analyze_plan.js");  // For 'aggPlanHasStage' and other explain helpers.
+
+    const coll = db.use_query_top_k_sort;
+    coll.drop();
+
+    const bulk = coll.initializeUnorderedBulkOp();
+    for (let i = 0; i < 100; ++i) {
+        bulk.insert({_id: i, x: (i * 37) % 100, y: i % 2});
+    }
+    assert.writeOK(bulk.execute());
+
+    function assertHasTopKQuerySort(pipeline) {
+        const explainOutput = coll.explain().aggregate(pipeline);
+        assert(!aggPlanHasStage(explainOutput, "$sort"),
+               "Expected pipeline " + tojsononeline(pipeline) +
+                   " *not* to include a $sort stage in the explain output: " +
+                   tojson(explainOutput));
+        assert(aggPlanHasStage(explainOutput, "SORT"),
+               "Expected pipeline " + tojsononeline(pipeline) +
+                   " to include a SORT stage in the explain output: " + tojson(explainOutput));
+        for (let cursorStage of getAggPlanStages(explainOutput, "$cursor")) {
+            assert.eq(true, cursorStage.$cursor.topKSort, tojson(explainOutput));
+        }
+        return explainOutput;
+    }
+
+    function assertDoesNotHaveQuerySort(pipeline, options = {}) {
+        const explainOutput = coll.explain().aggregate(pipeline, options);
+        assert(aggPlanHasStage(explainOutput, "$sort"),
+               "Expected pipeline " + tojsononeline(pipeline) +
+                   " to include a $sort stage in the explain output: " + tojson(explainOutput));
+        assert(!aggPlanHasStage(explainOutput, "SORT"),
+               "Expected pipeline " + tojsononeline(pipeline) +
+                   " *not* to include a SORT stage in the explain output: " +
+                   tojson(explainOutput));
+        return explainOutput;
+    }
+
+    function assertResultsAreTopK(pipeline, limit) {
+        const results = coll.aggregate(pipeline).toArray();
+        assert.eq(limit, results.length, tojson(results));
+        for (let i = 0; i < results.length; ++i) {
+            assert.eq(i, results[i].x, tojson(results));
+        }
+    }
+
+    // A $sort followed by a $limit is performed by the query system, even across a $project or
+    // $addFields on either side which leaves the sort key alone.
+    let pipeline = [{$sort: {x: 1}}, {$limit: 5}];
+    assertHasTopKQuerySort(pipeline);
+    assertResultsAreTopK(pipeline, 5);
+
+    pipeline = [{$sort: {x: 1}}, {$addFields: {z: 1}}, {$limit: 5}];
+    assertHasTopKQuerySort(pipeline);
+    assertResultsAreTopK(pipeline, 5);
+
+    pipeline = [{$match: {_id: {$gte: 0}}}, {$addFields: {z: 1}}, {$sort: {x: 1}}, {$limit: 5}];
+    assertHasTopKQuerySort(pipeline);
+    assertResultsAreTopK(pipeline, 5);
+
+    pipeline = [{$project: {x: 1}}, {$sort: {x: 1}}, {$skip: 2}, {$limit: 5}];
+    assertHasTopKQuerySort(pipeline);
+
+    // A $sort on a field computed by a preceding $addFields stays in the pipeline.
+    assertDoesNotHaveQuerySort([{$addFields: {x: "$y"}}, {$sort: {x: 1}}, {$limit: 5}]);
+
+    // A $sort without a limit, or with a large one, stays in the pipeline.
+    assertDoesNotHaveQuerySort([{$sort: {x: 1}}]);
+    assertDoesNotHaveQuerySort([{$sort: {x: 1}}, {$limit: 100000}]);
+
+    // The SORT stage cannot spill to disk, so a $sort which may do so stays in the pipeline.
+    pipeline = [{$sort: {x: 1}}, {$limit: 5}];
+    assertDoesNotHaveQuerySort(pipeline, {allowDiskUse: true});
+    assert.eq(coll.aggregate(pipeline).toArray(),
+              coll.aggregate(pipeline, {allowDiskUse: true}).toArray());
+
+    // Nor does one whose top documents, at the collection's average document size, would not fit
+    // in the SORT stage's memory limit.
+    const largeDocsColl = db.use_query_top_k_sort_large_docs;
+    largeDocsColl.drop();
+    const largeString = "x".repeat(1024 * 1024);
+    for (let i = 0; i < 10; ++i) {
+        assert.writeOK(largeDocsColl.insert({_id: i, x: i, s: largeString}));
+    }
+    pipeline = [{$sort: {x: 1}}, {$limit: 40}];
+    const explainOutput = largeDocsColl.explain().aggregate(pipeline);
+    assert(aggPlanHasStage(explainOutput, "$sort"), tojson(explainOutput));
+    assert(!aggPlanHasStage(explainOutput, "SORT"), tojson(explainOutput));
+    assert.eq(10, largeDocsColl.aggregate(pipeline).itcount());
+}());
@@ -4835,6 +4835,31 @@ var authCommandsLib = {
               },
           ]
         },
+        {
+          testname: "planCacheStats",
+          command: {planCacheStats: "x"},
+          skipSharded: true,
+          setup: function(db) {
+              db.x.save({});
+          },
+          teardown: function(db) {
+              db.x.drop();
+          },
+          testcases: [
+              {
+                runOnDb: firstDbName,
+                roles: roles_readDbAdmin,
+                privileges:
+                    [{resource: {db: firstDbName, collection: "x"}, actions: ["planCacheRead"]}],
+              },
+              {
+                runOnDb: secondDbName,
+                roles: roles_readDbAdminAny,
+                privileges:
+                    [{resource: {db: secondDbName, collection: "x"}, actions: ["planCacheRead"]}],
+              },
+          ]
+        },
         {
           testname: "planCacheWrite",
           command: {planCacheClear: "x"},
@@ -0,0 +1,63 @@
+// Test the planCacheStats command, which reports the usage counters and approximate memory use of
+// a collection's plan cache, and the plan cache metrics reported by serverStatus.
+//
+// @tags: [
+//   # planCacheStats is not implemented on mongos.
+//   assumes_against_mongod_not_mongos,
+//   # The plan cache is not replicated, so queries must be routed to the node being inspected.
+//   assumes_read_preference_unchanged,
+//   does_not_support_stepdowns,
+// ]
+(function() {
+    "use strict";
+
+    const coll = db.jstests_plan_cache_stats;
+    coll.drop();
+
+    function getStats() {
+        const res = coll.runCommand("planCacheStats");
+        assert.commandWorked(res);
+        return res;
+    }
+
+    // The command fails on a collection which does not exist.
+    assert.commandFailedWithCode(db.jstests_plan_cache_stats_missing.runCommand("planCacheStats"),
+                                 ErrorCodes.BadValue);
+
+    assert.writeOK(coll.insert({a: 1, b: 1}));
+    assert.commandWorked(coll.createIndex({a: 1}));
+    assert.commandWorked(coll.createIndex({b: 1}));
+
+    let stats = getStats();
+    assert.eq(0, stats.numEntries, tojson(stats));
+    assert.eq(0, stats.estimatedSizeBytes, tojson(stats));
+    assert.eq(0, stats.counters.trialPeriods, tojson(stats));
+
+    // A query with two candidate plans goes through a trial period and is added to the cache.
+    assert.eq(1, coll.find({a: 1, b: 1}).itcount());
+    stats = getStats();
+    assert.eq(1, stats.numEntries, tojson(stats));
+    assert.eq(1, stats.entries.length, tojson(stats));
+    assert.gt(stats.estimatedSizeBytes, 0, tojson(stats));
+    assert.eq(stats.estimatedSizeBytes, stats.entries[0].estimatedSizeBytes, tojson(stats));
+    assert.eq(1, stats.counters.trialPeriods, tojson(stats));
+    assert.gte(stats.counters.trialPeriodWorks, 1, tojson(stats));
+    assert.eq(1, stats.counters.misses, tojson(stats));
+    assert.eq(0, stats.counters.hits, tojson(stats));
+
+    // Clearing the cache releases its memory but keeps the counters.
+    assert.commandWorked(coll.runCommand("planCacheClear"));
+    stats = getStats();
+    assert.eq(0, stats.numEntries, tojson(stats));
+    assert.eq(0, stats.estimatedSizeBytes, tojson(stats));
+    assert.eq(1, stats.counters.trialPeriods, tojson(stats));
+
+    // The server-wide counters are reported by serverStatus.
+    const planCacheMetrics = db.serverStatus().metrics.query.planCache;
+    assert(planCacheMetrics.hasOwnProperty("hits"), tojson(planCacheMetrics));
+    assert(planCacheMetrics.hasOwnProperty("misses"), tojson(planCacheMetrics));
+    assert(planCacheMetrics.hasOwnProperty("evictions"), tojson(planCacheMetrics));
+    assert(planCacheMetrics.hasOwnProperty("replans"), tojson(planCacheMetrics));
+    assert.gte(planCacheMetrics.trialPeriods.total, 1, tojson(planCacheMetrics));
+    assert.gte(planCacheMetrics.trialPeriods.works, 1, tojson(planCacheMetrics));
+}());
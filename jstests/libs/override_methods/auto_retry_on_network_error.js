@@ -132,6 +132,7 @@
         "planCacheListPlans",
         "planCacheListQueryShapes",
         "planCacheSetFilter",
+        "planCacheStats",
         "profile",       // Not replicated, so can't tolerate failovers.
         "setParameter",  // Not replicated, so can't tolerate failovers.
         "stageDebug",
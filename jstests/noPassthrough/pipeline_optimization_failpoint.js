@@ -6,7 +6,9 @@
     load("jstests/libs/analyze_plan.js");  // For aggPlan functions.
     Random.setRandomSeed();
 
-    const conn = MongoRunner.runMongod({});
+    // Keep the top-k $sort in the pipeline, rather than letting the query system perform it.
+    const conn = MongoRunner.runMongod(
+        {setParameter: {internalDocumentSourceSortMaxPushdownLimit: 0}});
     assert.neq(conn, null, "Mongod failed to start up.");
     const testDb = conn.getDB("test");
     const coll = testDb.agg_opt;
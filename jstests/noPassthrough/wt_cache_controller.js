@@ -0,0 +1,54 @@
+/**
+ * Tests that the WiredTiger cache controller reports its settings in serverStatus, that it can be
+ * turned on and off at runtime, and that it does not run when eviction is configured through the
+ * engine config string.
+ * @tags: [requires_wiredtiger, requires_persistence]
+ */
+(function() {
+    "use strict";
+
+    function getControllerStats(conn) {
+        const status = assert.commandWorked(conn.adminCommand({serverStatus: 1}));
+        return status.wiredTiger["cache controller"];
+    }
+
+    let conn = MongoRunner.runMongod({});
+    assert.neq(null, conn, "mongod was unable to start up");
+
+    let stats = getControllerStats(conn);
+    assert.neq(undefined, stats, "missing cache controller section");
+    assert.eq(false, stats.enabled, tojson(stats));
+    assert.eq(0, stats["pressure level"], tojson(stats));
+    assert.eq(4, stats["eviction threads max"], tojson(stats));
+    assert.eq(5, stats["eviction dirty target"], tojson(stats));
+
+    assert.commandWorked(
+        conn.adminCommand({setParameter: 1, wiredTigerCacheControllerEnabled: true}));
+    const coll = conn.getDB("test").wt_cache_controller;
+    const bulk = coll.initializeUnorderedBulkOp();
+    for (let i = 0; i < 1000; ++i) {
+        bulk.insert({_id: i, x: "x".repeat(1024)});
+    }
+    assert.writeOK(bulk.execute());
+
+    assert.soon(() => getControllerStats(conn).enabled);
+    stats = getControllerStats(conn);
+    assert.gte(stats["pressure level"], 0, tojson(stats));
+    assert.lte(stats["pressure level"], 2, tojson(stats));
+    assert.gte(stats["eviction threads max"], stats["eviction threads min"], tojson(stats));
+
+    // Turning the controller off restores the settings the connection was opened with.
+    assert.commandWorked(
+        conn.adminCommand({setParameter: 1, wiredTigerCacheControllerEnabled: false}));
+    assert.soon(() => {
+        stats = getControllerStats(conn);
+        return stats["pressure level"] === 0 && stats["eviction threads max"] === 4;
+    }, () => tojson(stats));
+    MongoRunner.stopMongod(conn);
+
+    conn = MongoRunner.runMongod(
+        {wiredTigerEngineConfigString: "eviction=(threads_min=2,threads_max=2)"});
+    assert.neq(null, conn, "mongod was unable to start up");
+    assert.eq(undefined, getControllerStats(conn));
+    MongoRunner.stopMongod(conn);
+}());
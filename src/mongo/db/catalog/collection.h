@@ -56,8 +56,12 @@
 #include "mongo/stdx/condition_variable.h"
 #include "mongo/stdx/functional.h"
 #include "mongo/stdx/mutex.h"
+#include "mongo/util/fail_point_service.h"
 
 namespace mongo {
+// Failpoint which fails inserts through the collection.
+MONGO_FAIL_POINT_DECLARE(failCollectionInserts);
+
 class CollectionCatalogEntry;
 class DatabaseCatalogEntry;
 class ExtentManager;
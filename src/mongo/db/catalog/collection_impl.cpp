@@ -98,10 +98,9 @@ MONGO_REGISTER_SHIM(Collection::parseValidationAction)
     return CollectionImpl::parseValidationAction(data);
 }
 
-namespace {
-// Used below to fail during inserts.
 MONGO_FAIL_POINT_DEFINE(failCollectionInserts);
 
+namespace {
 // Uses the collator factory to convert the BSON representation of a collator to a
 // CollatorInterface. Returns null if the BSONObj is empty. We expect the stored collation to be
 // valid, since it gets validated on collection create.
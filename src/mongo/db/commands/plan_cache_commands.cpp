@@ -40,12 +40,14 @@
 #include "mongo/db/catalog/database.h"
 #include "mongo/db/client.h"
 #include "mongo/db/commands/plan_cache_commands.h"
+#include "mongo/db/commands/server_status_metric.h"
 #include "mongo/db/db_raii.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/matcher/extensions_callback_real.h"
 #include "mongo/db/namespace_string.h"
 #include "mongo/db/query/explain.h"
 #include "mongo/db/query/plan_ranker.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/util/hex.h"
 #include "mongo/util/log.h"
 
@@ -79,6 +81,27 @@ static Status getPlanCache(OperationContext* opCtx,
     return Status::OK();
 }
 
+//
+// Plan cache usage counters aggregated over all collections, reported by serverStatus.
+//
+
+const PlanCacheCounters& globalCounters = PlanCache::getGlobalCounters();
+
+ServerStatusMetricField<Counter64> displayPlanCacheHits("query.planCache.hits",
+                                                        &globalCounters.hits);
+ServerStatusMetricField<Counter64> displayPlanCacheMisses("query.planCache.misses",
+                                                          &globalCounters.misses);
+ServerStatusMetricField<Counter64> displayPlanCacheEvictions("query.planCache.evictions",
+                                                             &globalCounters.evictions);
+ServerStatusMetricField<Counter64> displayPlanCacheReplans("query.planCache.replans",
+                                                           &globalCounters.replans);
+ServerStatusMetricField<Counter64> displayPlanCacheTrialPeriods(
+    "query.planCache.trialPeriods.total", &globalCounters.trialPeriods);
+ServerStatusMetricField<Counter64> displayPlanCacheTrialPeriodWorks(
+    "query.planCache.trialPeriods.works", &globalCounters.trialPeriodWorks);
+ServerStatusMetricField<Counter64> displayPlanCacheTrialPeriodMicros(
+    "query.planCache.trialPeriods.micros", &globalCounters.trialPeriodMicros);
+
 //
 // Command instances.
 // Registers commands with the command system and make commands
@@ -93,6 +116,7 @@ MONGO_INITIALIZER_WITH_PREREQUISITES(SetupPlanCacheCommands, MONGO_NO_PREREQUISI
     new PlanCacheListQueryShapes();
     new PlanCacheClear();
     new PlanCacheListPlans();
+    new PlanCacheStats();
 
     return Status::OK();
 }
@@ -268,6 +292,59 @@ Status PlanCacheListQueryShapes::list(const PlanCache& planCache, BSONObjBuilder
     return Status::OK();
 }
 
+PlanCacheStats::PlanCacheStats()
+    : PlanCacheCommand("planCacheStats",
+                       "Displays usage counters and memory use of a collection's plan cache.",
+                       ActionType::planCacheRead) {}
+
+Status PlanCacheStats::runPlanCacheCommand(OperationContext* opCtx,
+                                           const string& ns,
+                                           const BSONObj& cmdObj,
+                                           BSONObjBuilder* bob) {
+    // This is a read lock. The query cache is owned by the collection.
+    AutoGetCollectionForReadCommand ctx(opCtx, NamespaceString(ns));
+
+    PlanCache* planCache;
+    Status status = getPlanCache(opCtx, ctx.getCollection(), ns, &planCache);
+    if (!status.isOK()) {
+        return status;
+    }
+    return stats(*planCache, bob);
+}
+
+// static
+Status PlanCacheStats::stats(const PlanCache& planCache, BSONObjBuilder* bob) {
+    invariant(bob);
+
+    auto entries = planCache.getAllEntries();
+
+    bob->appendNumber("numEntries", static_cast<long long>(entries.size()));
+    bob->appendNumber("estimatedSizeBytes",
+                      static_cast<long long>(planCache.estimatedSizeBytes()));
+    bob->appendNumber("maxSizeBytes", internalQueryCacheMaxSizeBytes.load());
+
+    BSONObjBuilder countersBuilder(bob->subobjStart("counters"));
+    planCache.getCounters().appendTo(&countersBuilder);
+    countersBuilder.doneFast();
+
+    BSONArrayBuilder arrayBuilder(bob->subarrayStart("entries"));
+    for (auto&& entry : entries) {
+        invariant(entry);
+
+        BSONObjBuilder entryBuilder(arrayBuilder.subobjStart());
+        entryBuilder.append("queryHash", unsignedIntToFixedLengthHex(entry->queryHash));
+        entryBuilder.append("isActive", entry->isActive);
+        entryBuilder.appendNumber("works", static_cast<long long>(entry->works));
+        entryBuilder.appendNumber("estimatedSizeBytes",
+                                  static_cast<long long>(entry->estimatedEntrySizeBytes));
+        entryBuilder.append("timeOfCreation", entry->timeOfCreation);
+        entryBuilder.doneFast();
+    }
+    arrayBuilder.doneFast();
+
+    return Status::OK();
+}
+
 PlanCacheClear::PlanCacheClear()
     : PlanCacheCommand("planCacheClear",
                        "Drops one or all cached queries in a collection.",
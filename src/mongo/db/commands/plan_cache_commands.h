@@ -120,6 +120,27 @@ public:
     static Status list(const PlanCache& planCache, BSONObjBuilder* bob);
 };
 
+/**
+ * planCacheStats
+ *
+ * { planCacheStats: <collection> }
+ *
+ */
+class PlanCacheStats : public PlanCacheCommand {
+public:
+    PlanCacheStats();
+    virtual Status runPlanCacheCommand(OperationContext* opCtx,
+                                       const std::string& ns,
+                                       const BSONObj& cmdObj,
+                                       BSONObjBuilder* bob);
+
+    /**
+     * Reports the usage counters and the approximate size of collection's plan cache, along with
+     * the size and state of each of its entries.
+     */
+    static Status stats(const PlanCache& planCache, BSONObjBuilder* bob);
+};
+
 /**
  * planCacheClear
  *
@@ -32,7 +32,9 @@
 
 #include "mongo/db/commands/run_aggregate.h"
 
+#include <algorithm>
 #include <boost/optional.hpp>
+#include <iterator>
 #include <vector>
 
 #include "mongo/db/auth/authorization_session.h"
@@ -503,14 +505,39 @@ Status runAggregate(OperationContext* opCtx,
 
         pipelines.emplace_back(std::move(pipeline));
 
-        auto exchange =
-            dynamic_cast<DocumentSourceExchange*>(pipelines[0]->getSources().back().get());
-        if (exchange) {
+        const auto& sources = pipelines[0]->getSources();
+        auto exchangeIt = std::find_if(sources.begin(), sources.end(), [](const auto& stage) {
+            return dynamic_cast<DocumentSourceExchange*>(stage.get());
+        });
+        if (exchangeIt != sources.end()) {
+            auto exchange = static_cast<DocumentSourceExchange*>(exchangeIt->get());
+
+            // Every consumer runs its own copy of the stages after the $exchange, if any.
+            Pipeline::SourceContainer suffix(std::next(exchangeIt), sources.end());
+            exchange->assertConsumersCanRun(suffix);
+
+            std::vector<Value> serializedSuffix;
+            for (auto&& stage : suffix) {
+                stage->serializeToArray(serializedSuffix);
+            }
+
+            Pipeline::SourceContainer prefix(sources.begin(), exchangeIt);
             for (size_t idx = 1; idx < exchange->getConsumers(); ++idx) {
-                auto sources = pipelines[0]->getSources();
-                sources.back() = new DocumentSourceExchange(expCtx, exchange->getExchange(), idx);
+                auto consumerExpCtx = expCtx->copyWith(expCtx->ns, expCtx->uuid);
+                consumerExpCtx->variables = expCtx->variables;
+                consumerExpCtx->variablesParseState = expCtx->variablesParseState.copyWith(
+                    consumerExpCtx->variables.useIdGenerator());
+
+                auto consumerSources = prefix;
+                consumerSources.push_back(
+                    new DocumentSourceExchange(consumerExpCtx, exchange->getExchange(), idx));
+                for (auto&& stage : serializedSuffix) {
+                    consumerSources.splice(
+                        consumerSources.end(),
+                        DocumentSource::parse(consumerExpCtx, stage.getDocument().toBson()));
+                }
                 pipelines.emplace_back(
-                    uassertStatusOK(Pipeline::create(std::move(sources), expCtx)));
+                    uassertStatusOK(Pipeline::create(std::move(consumerSources), consumerExpCtx)));
             }
         }
 
@@ -60,6 +60,7 @@
 #include "mongo/db/storage/storage_options.h"
 #include "mongo/db/write_concern.h"
 #include "mongo/db/write_concern_options.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/util/log.h"
 #include "mongo/util/mongoutils/str.h"
 #include "mongo/util/scopeguard.h"
@@ -281,7 +282,8 @@ void Helpers::emptyCollection(OperationContext* opCtx, const NamespaceString& ns
 }
 
 Helpers::RemoveSaver::RemoveSaver(const string& a, const string& b, const string& why) {
-    static int NUM = 0;
+    // RemoveSavers may be constructed concurrently, as rollback files can be written in parallel.
+    static AtomicWord<int> NUM{0};
 
     _root = storageGlobalParams.dbpath;
     if (a.size())
@@ -293,7 +295,7 @@ Helpers::RemoveSaver::RemoveSaver(const string& a, const string& b, const string
     _file = _root;
 
     stringstream ss;
-    ss << why << "." << terseCurrentTime(false) << "." << NUM++ << ".bson";
+    ss << why << "." << terseCurrentTime(false) << "." << NUM.fetchAndAdd(1) << ".bson";
     _file /= ss.str();
 
     auto encryptionHooks = EncryptionHooks::get(getGlobalServiceContext());
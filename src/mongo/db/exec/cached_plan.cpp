@@ -200,9 +200,11 @@ Status CachedPlanStage::replan(PlanYieldPolicy* yieldPolicy, bool shouldCache) {
 
     _specificStats.replanned = true;
 
+    PlanCache* cache = _collection->infoCache()->getPlanCache();
+    cache->recordReplan();
+
     if (shouldCache) {
         // Deactivate the current cache entry.
-        PlanCache* cache = _collection->infoCache()->getPlanCache();
         cache->deactivate(*_canonicalQuery);
     }
 
@@ -196,6 +196,34 @@ PlanStage::StageState CollectionScan::doWork(WorkingSetID* out) {
     return returnIfMatches(member, id, out);
 }
 
+PlanStage::StageState CollectionScan::doWorkBatch(size_t maxUnits,
+                                                  vector<WorkingSetID>* out,
+                                                  WorkingSetID* stateOut) {
+    // Same loop as the default implementation, but since this class is final the call to doWork()
+    // is bound statically, letting the cursor advance, WorkingSet allocation and filter for each
+    // record run back to back without going through the stage tree.
+    const size_t firstResult = out->size();
+    for (size_t units = 0; units < maxUnits; ++units) {
+        // Advancing the cursor may free the record which our last result points into, while that
+        // result is still buffered in 'out'.
+        if (out->size() > firstResult) {
+            _workingSet->get(out->back())->makeObjOwnedIfNeeded();
+        }
+
+        WorkingSetID id = WorkingSet::INVALID_ID;
+        const StageState state = recordWork(doWork(&id));
+
+        if (PlanStage::ADVANCED == state) {
+            out->push_back(id);
+        } else if (PlanStage::NEED_TIME != state) {
+            *stateOut = id;
+            return state;
+        }
+    }
+
+    return PlanStage::NEED_TIME;
+}
+
 Status CollectionScan::setLatestOplogEntryTimestamp(const Record& record) {
     auto tsElem = record.data.toBson()[repl::OpTime::kTimestampFieldName];
     if (tsElem.type() != BSONType::bsonTimestamp) {
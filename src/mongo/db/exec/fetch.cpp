@@ -30,11 +30,14 @@
 
 #include "mongo/db/exec/fetch.h"
 
+#include <algorithm>
+
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/concurrency/write_conflict_exception.h"
 #include "mongo/db/exec/filter.h"
 #include "mongo/db/exec/scoped_timer.h"
 #include "mongo/db/exec/working_set_common.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/storage/record_fetcher.h"
 #include "mongo/stdx/memory.h"
 #include "mongo/util/fail_point_service.h"
@@ -65,9 +68,9 @@ FetchStage::FetchStage(OperationContext* opCtx,
 FetchStage::~FetchStage() {}
 
 bool FetchStage::isEOF() {
-    if (WorkingSet::INVALID_ID != _idRetrying) {
+    if (hasBufferedChildResult()) {
         // We asked the parent for a page-in, but still haven't had a chance to return the
-        // paged in document
+        // paged in document, or there are results from a batch we have not gotten to yet.
         return false;
     }
 
@@ -82,55 +85,24 @@ PlanStage::StageState FetchStage::doWork(WorkingSetID* out) {
     // Either retry the last WSM we worked on or get a new one from our child.
     WorkingSetID id;
     StageState status;
-    if (_idRetrying == WorkingSet::INVALID_ID) {
-        status = child()->work(&id);
-    } else {
+    if (_idRetrying != WorkingSet::INVALID_ID) {
         status = ADVANCED;
         id = _idRetrying;
         _idRetrying = WorkingSet::INVALID_ID;
+    } else if (!_childResults.empty()) {
+        status = ADVANCED;
+        id = _childResults.front();
+        _childResults.pop_front();
+    } else if (_childBatchState) {
+        status = _childBatchState->first;
+        id = _childBatchState->second;
+        _childBatchState = boost::none;
+    } else {
+        status = child()->work(&id);
     }
 
     if (PlanStage::ADVANCED == status) {
-        WorkingSetMember* member = _ws->get(id);
-
-        // If there's an obj there, there is no fetching to perform.
-        if (member->hasObj()) {
-            ++_specificStats.alreadyHasObj;
-        } else {
-            // We need a valid RecordId to fetch from and this is the only state that has one.
-            verify(WorkingSetMember::RID_AND_IDX == member->getState());
-            verify(member->hasRecordId());
-
-            try {
-                if (!_cursor)
-                    _cursor = _collection->getCursor(getOpCtx());
-
-                if (auto fetcher = _cursor->fetcherForId(member->recordId)) {
-                    // There's something to fetch. Hand the fetcher off to the WSM, and pass up
-                    // a fetch request.
-                    _idRetrying = id;
-                    member->setFetcher(fetcher.release());
-                    *out = id;
-                    return NEED_YIELD;
-                }
-
-                // The doc is already in memory, so go ahead and grab it. Now we have a RecordId
-                // as well as an unowned object
-                if (!WorkingSetCommon::fetch(getOpCtx(), _ws, id, _cursor)) {
-                    _ws->free(id);
-                    return NEED_TIME;
-                }
-            } catch (const WriteConflictException&) {
-                // Ensure that the BSONObj underlying the WorkingSetMember is owned because it may
-                // be freed when we yield.
-                member->makeObjOwnedIfNeeded();
-                _idRetrying = id;
-                *out = WorkingSet::INVALID_ID;
-                return NEED_YIELD;
-            }
-        }
-
-        return returnIfMatches(member, id, out);
+        return fetchAndFilter(id, out);
     } else if (PlanStage::FAILURE == status || PlanStage::DEAD == status) {
         // The stage which produces a failure is responsible for allocating a working set member
         // with error details.
@@ -144,24 +116,170 @@ PlanStage::StageState FetchStage::doWork(WorkingSetID* out) {
     return status;
 }
 
+PlanStage::StageState FetchStage::doWorkBatch(size_t maxUnits,
+                                              vector<WorkingSetID>* out,
+                                              WorkingSetID* stateOut) {
+    if (!hasBufferedChildResult() && !isEOF()) {
+        const size_t lookahead = static_cast<size_t>(internalQueryFetchLookaheadRecords.load());
+        WorkingSetID childStateId = WorkingSet::INVALID_ID;
+        _childBatch.clear();
+        const StageState childState =
+            child()->workBatch(std::max(maxUnits, lookahead), &_childBatch, &childStateId);
+
+        if (lookahead > 1) {
+            prefetch(_childBatch, lookahead);
+        }
+
+        _childResults.insert(_childResults.end(), _childBatch.begin(), _childBatch.end());
+        if (PlanStage::NEED_TIME != childState) {
+            _childBatchState = std::make_pair(childState, childStateId);
+        }
+
+        if (!hasBufferedChildResult()) {
+            // Our child worked through a whole batch without producing anything.
+            return recordWork(PlanStage::NEED_TIME);
+        }
+    }
+
+    // Fetch and filter what our child produced, without asking it for more one unit at a time.
+    bool lastResultFetched = false;
+    for (size_t units = 0; units < maxUnits; ++units) {
+        // Fetching the next result moves '_cursor', which may free the record that the last result
+        // we fetched points into, while that result is still buffered in 'out'.
+        if (lastResultFetched) {
+            _ws->get(out->back())->makeObjOwnedIfNeeded();
+            lastResultFetched = false;
+        }
+
+        WorkingSetID id = WorkingSet::INVALID_ID;
+        const size_t alreadyHasObj = _specificStats.alreadyHasObj;
+        const StageState state = recordWork(doWork(&id));
+
+        if (PlanStage::ADVANCED == state) {
+            out->push_back(id);
+            lastResultFetched = (alreadyHasObj == _specificStats.alreadyHasObj);
+        } else if (PlanStage::NEED_TIME != state) {
+            *stateOut = id;
+            return state;
+        }
+
+        if (!hasBufferedChildResult()) {
+            break;
+        }
+    }
+
+    return PlanStage::NEED_TIME;
+}
+
+PlanStage::StageState FetchStage::fetchAndFilter(WorkingSetID id, WorkingSetID* out) {
+    WorkingSetMember* member = _ws->get(id);
+
+    // If there's an obj there, there is no fetching to perform.
+    if (member->hasObj()) {
+        ++_specificStats.alreadyHasObj;
+    } else {
+        // We need a valid RecordId to fetch from and this is the only state that has one.
+        verify(WorkingSetMember::RID_AND_IDX == member->getState());
+        verify(member->hasRecordId());
+
+        try {
+            if (!_cursor)
+                _cursor = _collection->getCursor(getOpCtx());
+
+            if (auto fetcher = _cursor->fetcherForId(member->recordId)) {
+                // There's something to fetch. Hand the fetcher off to the WSM, and pass up
+                // a fetch request.
+                _idRetrying = id;
+                member->setFetcher(fetcher.release());
+                *out = id;
+                return NEED_YIELD;
+            }
+
+            // The doc is already in memory, so go ahead and grab it. Now we have a RecordId
+            // as well as an unowned object
+            if (!WorkingSetCommon::fetch(getOpCtx(), _ws, id, _cursor)) {
+                _ws->free(id);
+                return NEED_TIME;
+            }
+        } catch (const WriteConflictException&) {
+            // Ensure that the BSONObj underlying the WorkingSetMember is owned because it may
+            // be freed when we yield.
+            member->makeObjOwnedIfNeeded();
+            _idRetrying = id;
+            *out = WorkingSet::INVALID_ID;
+            return NEED_YIELD;
+        }
+    }
+
+    return returnIfMatches(member, id, out);
+}
+
+void FetchStage::prefetch(const vector<WorkingSetID>& ids, size_t lookahead) {
+    _prefetchIds.clear();
+    for (auto id : ids) {
+        if (_prefetchIds.size() == lookahead) {
+            break;
+        }
+        WorkingSetMember* member = _ws->get(id);
+        if (!member->hasObj() && member->hasRecordId()) {
+            _prefetchIds.push_back(member->recordId);
+        }
+    }
+
+    // Nothing is gained by reading a single record ahead of its fetch.
+    if (_prefetchIds.size() < 2) {
+        return;
+    }
+
+    std::sort(_prefetchIds.begin(), _prefetchIds.end());
+    _prefetchIds.erase(std::unique(_prefetchIds.begin(), _prefetchIds.end()), _prefetchIds.end());
+
+    try {
+        if (!_prefetchCursor)
+            _prefetchCursor = _collection->getCursor(getOpCtx());
+
+        for (const auto& recordId : _prefetchIds) {
+            if (_prefetchCursor->seekExact(recordId)) {
+                ++_specificStats.docsPrefetched;
+            }
+        }
+    } catch (const WriteConflictException&) {
+        // The conflict is dealt with when the record is fetched.
+    }
+}
+
 void FetchStage::doSaveState() {
     if (_cursor)
         _cursor->saveUnpositioned();
+    if (_prefetchCursor)
+        _prefetchCursor->saveUnpositioned();
+
+    // Results from our child's last batch may point into memory owned by its storage engine
+    // cursor, which is not valid across a yield.
+    for (auto id : _childResults) {
+        _ws->get(id)->makeObjOwnedIfNeeded();
+    }
 }
 
 void FetchStage::doRestoreState() {
     if (_cursor)
         _cursor->restore();
+    if (_prefetchCursor)
+        _prefetchCursor->restore();
 }
 
 void FetchStage::doDetachFromOperationContext() {
     if (_cursor)
         _cursor->detachFromOperationContext();
+    if (_prefetchCursor)
+        _prefetchCursor->detachFromOperationContext();
 }
 
 void FetchStage::doReattachToOperationContext() {
     if (_cursor)
         _cursor->reattachToOperationContext(getOpCtx());
+    if (_prefetchCursor)
+        _prefetchCursor->reattachToOperationContext(getOpCtx());
 }
 
 void FetchStage::doInvalidate(OperationContext* opCtx, const RecordId& dl, InvalidationType type) {
@@ -174,6 +292,14 @@ void FetchStage::doInvalidate(OperationContext* opCtx, const RecordId& dl, Inval
             WorkingSetCommon::fetchAndInvalidateRecordId(opCtx, member, _collection);
         }
     }
+
+    // The same goes for any results from our child's last batch which we have not fetched yet.
+    for (auto id : _childResults) {
+        WorkingSetMember* member = _ws->get(id);
+        if (member->hasRecordId() && (member->recordId == dl)) {
+            WorkingSetCommon::fetchAndInvalidateRecordId(opCtx, member, _collection);
+        }
+    }
 }
 
 PlanStage::StageState FetchStage::returnIfMatches(WorkingSetMember* member,
@@ -28,7 +28,10 @@
 
 #pragma once
 
+#include <boost/optional.hpp>
+#include <deque>
 #include <memory>
+#include <utility>
 
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/jsobj.h"
@@ -59,6 +62,9 @@ public:
 
     bool isEOF() final;
     StageState doWork(WorkingSetID* out) final;
+    StageState doWorkBatch(size_t maxUnits,
+                           std::vector<WorkingSetID>* out,
+                           WorkingSetID* stateOut) final;
 
     void doSaveState() final;
     void doRestoreState() final;
@@ -77,6 +83,29 @@ public:
     static const char* kStageType;
 
 private:
+    /**
+     * Returns true if there is a result or state from our child which we have not yet passed on,
+     * either because a fetch needs to be retried or because it came from a batch of child results.
+     */
+    bool hasBufferedChildResult() const {
+        return WorkingSet::INVALID_ID != _idRetrying || !_childResults.empty() || _childBatchState;
+    }
+
+    /**
+     * Transitions the member with id 'id', which our child has produced, to a state which has an
+     * object by fetching it from '_collection' if needed, then applies our filter to it. Returns
+     * the outcome of the unit of work as doWork() would.
+     */
+    StageState fetchAndFilter(WorkingSetID id, WorkingSetID* out);
+
+    /**
+     * Reads the records of up to 'lookahead' of the members in 'ids' which still need to be
+     * fetched through '_prefetchCursor', in RecordId order, so that the storage engine has them
+     * in memory by the time fetchAndFilter() gets to them. This is only a hint: records which
+     * cannot be read now are left for fetchAndFilter().
+     */
+    void prefetch(const std::vector<WorkingSetID>& ids, size_t lookahead);
+
     /**
      * If the member (with id memberID) passes our filter, set *out to memberID and return that
      * ADVANCED.  Otherwise, free memberID and return NEED_TIME.
@@ -88,6 +117,9 @@ private:
     const Collection* _collection;
     // Used to fetch Records from _collection.
     std::unique_ptr<SeekableRecordCursor> _cursor;
+    // Used to read Records from _collection ahead of fetching them. Kept apart from '_cursor' so
+    // that reading ahead never invalidates a record which has been fetched but not yet returned.
+    std::unique_ptr<SeekableRecordCursor> _prefetchCursor;
 
     // _ws is not owned by us.
     WorkingSet* _ws;
@@ -98,6 +130,20 @@ private:
     // If not Null, we use this rather than asking our child what to do next.
     WorkingSetID _idRetrying;
 
+    // Results which our child produced through workBatch() but which have not been fetched yet, in
+    // the order they were produced. These are consumed before asking our child for more.
+    std::deque<WorkingSetID> _childResults;
+
+    // If the last batch from our child ended in a state other than ADVANCED or NEED_TIME, that
+    // state and its WorkingSetID. It is passed up once '_childResults' is drained.
+    boost::optional<std::pair<StageState, WorkingSetID>> _childBatchState;
+
+    // Reused across calls to doWorkBatch() to receive results from our child.
+    std::vector<WorkingSetID> _childBatch;
+
+    // Reused across calls to prefetch() to sort the record ids to read ahead.
+    std::vector<RecordId> _prefetchIds;
+
     // Stats
     FetchStats _specificStats;
 };
@@ -227,6 +227,26 @@ PlanStage::StageState IndexScan::doWork(WorkingSetID* out) {
     return PlanStage::ADVANCED;
 }
 
+PlanStage::StageState IndexScan::doWorkBatch(size_t maxUnits,
+                                             std::vector<WorkingSetID>* out,
+                                             WorkingSetID* stateOut) {
+    // Our results hold the index key, which is owned, and no object, so unlike the default
+    // implementation we can keep advancing the cursor while earlier results are buffered in 'out'.
+    for (size_t units = 0; units < maxUnits; ++units) {
+        WorkingSetID id = WorkingSet::INVALID_ID;
+        const StageState state = recordWork(doWork(&id));
+
+        if (PlanStage::ADVANCED == state) {
+            out->push_back(id);
+        } else if (PlanStage::NEED_TIME != state) {
+            *stateOut = id;
+            return state;
+        }
+    }
+
+    return PlanStage::NEED_TIME;
+}
+
 bool IndexScan::isEOF() {
     return _commonStats.isEOF;
 }
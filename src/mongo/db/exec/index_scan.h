@@ -130,6 +130,9 @@ public:
               const MatchExpression* filter);
 
     StageState doWork(WorkingSetID* out) final;
+    StageState doWorkBatch(size_t maxUnits,
+                           std::vector<WorkingSetID>* out,
+                           WorkingSetID* stateOut) final;
     bool isEOF() final;
     void doSaveState() final;
     void doRestoreState() final;
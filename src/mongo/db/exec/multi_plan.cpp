@@ -49,6 +49,7 @@
 #include "mongo/stdx/memory.h"
 #include "mongo/util/log.h"
 #include "mongo/util/mongoutils/str.h"
+#include "mongo/util/timer.h"
 
 namespace mongo {
 
@@ -212,6 +213,7 @@ Status MultiPlanStage::pickBestPlan(PlanYieldPolicy* yieldPolicy) {
 
     // Work the plans, stopping when a plan hits EOF or returns some
     // fixed number of results.
+    Timer trialPeriodTimer;
     for (size_t ix = 0; ix < numWorks; ++ix) {
         bool moreToDo = workAllPlans(numResults, yieldPolicy);
         if (!moreToDo) {
@@ -219,6 +221,15 @@ Status MultiPlanStage::pickBestPlan(PlanYieldPolicy* yieldPolicy) {
         }
     }
 
+    if (_collection) {
+        size_t trialPeriodWorks = 0;
+        for (auto&& candidate : _candidates) {
+            trialPeriodWorks += candidate.root->getCommonStats()->works;
+        }
+        _collection->infoCache()->getPlanCache()->recordTrialPeriod(trialPeriodWorks,
+                                                                    trialPeriodTimer.micros());
+    }
+
     if (_failure) {
         invariant(WorkingSet::INVALID_ID != _statusMemberId);
         WorkingSetMember* member = _candidates[0].ws->get(_statusMemberId);
@@ -56,6 +56,62 @@ PlanStage::StageState PlanStage::work(WorkingSetID* out) {
     return workResult;
 }
 
+PlanStage::StageState PlanStage::workBatch(size_t maxUnits,
+                                           std::vector<WorkingSetID>* out,
+                                           WorkingSetID* stateOut) {
+    invariant(_opCtx);
+    invariant(maxUnits > 0);
+    ScopedTimer timer(getClock(), &_commonStats.executionTimeMillis);
+
+    return doWorkBatch(maxUnits, out, stateOut);
+}
+
+PlanStage::StageState PlanStage::doWorkBatch(size_t maxUnits,
+                                             std::vector<WorkingSetID>* out,
+                                             WorkingSetID* stateOut) {
+    for (size_t units = 0; units < maxUnits; ++units) {
+        WorkingSetID id = WorkingSet::INVALID_ID;
+        const StageState state = recordWork(doWork(&id));
+
+        if (StageState::ADVANCED == state) {
+            // Working any further could move a storage engine cursor which the result points into.
+            out->push_back(id);
+            return StageState::NEED_TIME;
+        } else if (StageState::NEED_TIME != state) {
+            *stateOut = id;
+            return state;
+        }
+    }
+
+    return StageState::NEED_TIME;
+}
+
+PlanStage::StageState PlanStage::recordWork(StageState state) {
+    ++_commonStats.works;
+
+    if (StageState::ADVANCED == state) {
+        ++_commonStats.advanced;
+    } else if (StageState::NEED_TIME == state) {
+        ++_commonStats.needTime;
+    } else if (StageState::NEED_YIELD == state) {
+        ++_commonStats.needYield;
+    }
+
+    return state;
+}
+
+void PlanStage::recordBatchWork(size_t units, size_t advanced, StageState lastState) {
+    const bool endedEarly = StageState::ADVANCED != lastState && StageState::NEED_TIME != lastState;
+    invariant(units >= advanced + (endedEarly ? 1 : 0));
+
+    _commonStats.works += units;
+    _commonStats.advanced += advanced;
+    _commonStats.needTime += units - advanced - (endedEarly ? 1 : 0);
+    if (StageState::NEED_YIELD == lastState) {
+        ++_commonStats.needYield;
+    }
+}
+
 void PlanStage::saveState() {
     ++_commonStats.yields;
     for (auto&& child : _children) {
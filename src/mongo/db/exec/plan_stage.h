@@ -188,6 +188,23 @@ public:
      */
     StageState work(WorkingSetID* out);
 
+    /**
+     * Perform up to 'maxUnits' units of work on the query, as if work() had been called that many
+     * times in a row, and append the id of every result produced to 'out'.
+     *
+     * Stops early as soon as a unit of work results in anything other than ADVANCED or
+     * NEED_TIME, and returns that state. Any WorkingSetID which work() would have placed in its out
+     * parameter for that state is placed in '*stateOut'. The results appended to 'out' were all
+     * produced before the returned state. Returns NEED_TIME if all 'maxUnits' units of work were
+     * performed; 'out' may or may not have grown in that case.
+     *
+     * The caller owns every WorkingSetID appended to 'out' and must free them from the working set
+     * when done with them, exactly as for ADVANCED results of work(). As for work(), a result may
+     * point into memory owned by a storage engine cursor, and is only valid until this stage is
+     * worked again or its state is saved.
+     */
+    StageState workBatch(size_t maxUnits, std::vector<WorkingSetID>* out, WorkingSetID* stateOut);
+
     /**
      * Returns true if no more work can be done on the query / out of results.
      */
@@ -347,6 +364,35 @@ protected:
      */
     virtual StageState doWork(WorkingSetID* out) = 0;
 
+    /**
+     * Performs up to 'maxUnits' units of work.  See comment at workBatch() above.
+     *
+     * The default implementation calls doWork() in a loop until it produces a result, which saves
+     * the per-unit timing and virtual dispatch of the caller but not that of any children. It stops
+     * at the first result because it cannot tell whether the result points into a storage engine
+     * cursor which further work would move. Stages which can produce or transform results a block
+     * at a time should override this and call workBatch() on their children. Overrides must make
+     * any result still buffered in 'out' owned before moving the cursor it points into, and must
+     * keep the common stats up to date for every unit of work, for example via recordWork() or
+     * recordBatchWork().
+     */
+    virtual StageState doWorkBatch(size_t maxUnits,
+                                   std::vector<WorkingSetID>* out,
+                                   WorkingSetID* stateOut);
+
+    /**
+     * Updates the common stats for a single unit of work which resulted in 'state', and returns
+     * 'state'.
+     */
+    StageState recordWork(StageState state);
+
+    /**
+     * Updates the common stats for 'units' units of work, 'advanced' of which produced a result.
+     * If 'lastState' is anything other than ADVANCED or NEED_TIME, it is the outcome of the final
+     * unit of work; all other units are counted as NEED_TIME.
+     */
+    void recordBatchWork(size_t units, size_t advanced, StageState lastState);
+
     /**
      * Saves any stage-specific state required to resume where it was if the underlying data
      * changes.
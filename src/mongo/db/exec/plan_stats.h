@@ -345,7 +345,7 @@ struct EnsureSortedStats : public SpecificStats {
 };
 
 struct FetchStats : public SpecificStats {
-    FetchStats() : alreadyHasObj(0), forcedFetches(0), docsExamined(0) {}
+    FetchStats() : alreadyHasObj(0), forcedFetches(0), docsExamined(0), docsPrefetched(0) {}
 
     SpecificStats* clone() const final {
         FetchStats* specific = new FetchStats(*this);
@@ -360,6 +360,10 @@ struct FetchStats : public SpecificStats {
 
     // The total number of full documents touched by the fetch stage.
     size_t docsExamined;
+
+    // How many records were read ahead of being fetched, as enabled by
+    // 'internalQueryFetchLookaheadRecords'?
+    size_t docsPrefetched;
 };
 
 struct GroupStats : public SpecificStats {
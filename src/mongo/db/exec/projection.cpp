@@ -221,6 +221,35 @@ PlanStage::StageState ProjectionStage::doWork(WorkingSetID* out) {
     return status;
 }
 
+PlanStage::StageState ProjectionStage::doWorkBatch(size_t maxUnits,
+                                                   vector<WorkingSetID>* out,
+                                                   WorkingSetID* stateOut) {
+    // Each unit of work our child performs is also one of ours, so let it fill the batch and then
+    // project the results in place.
+    const size_t firstResult = out->size();
+    const size_t childWorksBefore = child()->getCommonStats()->works;
+    StageState status = child()->workBatch(maxUnits, out, stateOut);
+    const size_t numResults = out->size() - firstResult;
+
+    for (size_t i = firstResult; i < out->size(); ++i) {
+        Status projStatus = transform(_ws->get((*out)[i]));
+        if (!projStatus.isOK()) {
+            warning() << "Couldn't execute projection, status = " << redact(projStatus);
+            for (size_t j = firstResult; j < out->size(); ++j) {
+                _ws->free((*out)[j]);
+            }
+            out->resize(firstResult);
+            *stateOut = WorkingSetCommon::allocateStatusMember(_ws, projStatus);
+            recordBatchWork(
+                child()->getCommonStats()->works - childWorksBefore, 0, PlanStage::FAILURE);
+            return PlanStage::FAILURE;
+        }
+    }
+
+    recordBatchWork(child()->getCommonStats()->works - childWorksBefore, numResults, status);
+    return status;
+}
+
 unique_ptr<PlanStageStats> ProjectionStage::getStats() {
     _commonStats.isEOF = isEOF();
     unique_ptr<PlanStageStats> ret = make_unique<PlanStageStats>(_commonStats, STAGE_PROJECTION);
@@ -70,6 +70,26 @@ PlanStage::StageState QueuedDataStage::doWork(WorkingSetID* out) {
     return state;
 }
 
+PlanStage::StageState QueuedDataStage::doWorkBatch(size_t maxUnits,
+                                                   std::vector<WorkingSetID>* out,
+                                                   WorkingSetID* stateOut) {
+    // Our results were handed to us by the caller rather than read through a cursor, so they stay
+    // valid however many of them are buffered in 'out'.
+    for (size_t units = 0; units < maxUnits; ++units) {
+        WorkingSetID id = WorkingSet::INVALID_ID;
+        const StageState state = recordWork(doWork(&id));
+
+        if (PlanStage::ADVANCED == state) {
+            out->push_back(id);
+        } else if (PlanStage::NEED_TIME != state) {
+            *stateOut = id;
+            return state;
+        }
+    }
+
+    return PlanStage::NEED_TIME;
+}
+
 bool QueuedDataStage::isEOF() {
     return _results.empty();
 }
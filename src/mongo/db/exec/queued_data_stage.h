@@ -50,6 +50,9 @@ public:
     QueuedDataStage(OperationContext* opCtx, WorkingSet* ws);
 
     StageState doWork(WorkingSetID* out) final;
+    StageState doWorkBatch(size_t maxUnits,
+                           std::vector<WorkingSetID>* out,
+                           WorkingSetID* stateOut) final;
 
     bool isEOF() final;
 
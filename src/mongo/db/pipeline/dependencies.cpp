@@ -222,8 +222,9 @@ std::vector<DepsTracker::MetadataType> DepsTracker::getAllRequiredMetadataTypes(
 }
 
 namespace {
-// Mutually recursive with arrayHelper
+// Mutually recursive with arrayHelper and fieldHelper
 Document documentHelper(const BSONObj& bson, const Document& neededFields, int nFieldsNeeded = -1);
+Value fieldHelper(const BSONElement& bsonElement, const Value& isNeeded);
 
 // Handles array-typed values for ParsedDeps::extractFields
 Value arrayHelper(const BSONObj& bson, const Document& neededFields) {
@@ -264,26 +265,35 @@ Document documentHelper(const BSONObj& bson, const Document& neededFields, int n
             continue;
 
         --nFieldsNeeded;  // Found a needed field.
-        if (isNeeded.getType() == Bool) {
-            md.addField(fieldName, Value(bsonElement));
-        } else {
-            dassert(isNeeded.getType() == Object);
-
-            if (bsonElement.type() == BSONType::Object) {
-                md.addField(
-                    fieldName,
-                    Value(documentHelper(bsonElement.embeddedObject(), isNeeded.getDocument())));
-            } else if (bsonElement.type() == BSONType::Array) {
-                md.addField(fieldName,
-                            arrayHelper(bsonElement.embeddedObject(), isNeeded.getDocument()));
-            }
+        Value value = fieldHelper(bsonElement, isNeeded);
+        if (!value.missing()) {
+            md.addField(fieldName, std::move(value));
         }
     }
 
     return md.freeze();
 }
+
+// Handles a needed field, whose entry in the look-up table is 'isNeeded'
+Value fieldHelper(const BSONElement& bsonElement, const Value& isNeeded) {
+    if (isNeeded.getType() == Bool) {
+        return Value(bsonElement);
+    }
+
+    dassert(isNeeded.getType() == Object);
+    if (bsonElement.type() == BSONType::Object) {
+        return Value(documentHelper(bsonElement.embeddedObject(), isNeeded.getDocument()));
+    } else if (bsonElement.type() == BSONType::Array) {
+        return arrayHelper(bsonElement.embeddedObject(), isNeeded.getDocument());
+    }
+    return Value();
+}
 }  // namespace
 
+Value ParsedDeps::extractField(const BSONElement& elem, const Value& isNeeded) {
+    return fieldHelper(elem, isNeeded);
+}
+
 Document ParsedDeps::extractFields(const BSONObj& input) const {
     return documentHelper(input, _fields, _nFields);
 }
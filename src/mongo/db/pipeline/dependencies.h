@@ -198,9 +198,17 @@ public:
     Document extractFields(const BSONObj& input) const;
 
 private:
-    friend struct DepsTracker;  // so it can call constructor
+    friend struct DepsTracker;   // so it can call constructor
+    friend class DocumentBatch;  // so it can extract fields one at a time
     explicit ParsedDeps(Document&& fields) : _fields(std::move(fields)), _nFields(_fields.size()) {}
 
+    /**
+     * Returns the needed parts of the top-level field 'elem', where 'isNeeded' is its entry in
+     * '_fields'. Returns a missing Value if the field has sub-fields which are needed but is not an
+     * object or array.
+     */
+    static Value extractField(const BSONElement& elem, const Value& isNeeded);
+
     Document _fields;
     int _nFields;  // Cache the number of top-level fields needed.
 };
@@ -0,0 +1,104 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/pipeline/document_batch.h"
+
+namespace mongo {
+
+DocumentBatch::DocumentBatch(const ParsedDeps& deps) {
+    _columns.reserve(deps._nFields);
+    for (auto it = deps._fields.fieldIterator(); it.more();) {
+        auto field = it.next();
+        _columns.push_back({field.first.toString(), field.second, {}});
+    }
+}
+
+void DocumentBatch::append(const BSONObj& input) {
+    const size_t row = size();
+    _rowStarts.push_back(_fieldOrder.size());
+    for (auto&& column : _columns) {
+        column.values.emplace_back();
+    }
+
+    // Matching names against the few needed fields is cheaper than hashing every field of a wide
+    // input, and stops once all of them have been seen.
+    size_t nFieldsNeeded = _columns.size();
+    BSONObjIterator it(input);
+    while (it.more() && nFieldsNeeded > 0) {
+        auto elem = it.next();
+        const StringData fieldName = elem.fieldNameStringData();
+        for (size_t i = 0; i < _columns.size(); ++i) {
+            Column& column = _columns[i];
+            if (column.name != fieldName || !column.values[row].missing()) {
+                continue;
+            }
+
+            --nFieldsNeeded;
+            column.values[row] = ParsedDeps::extractField(elem, column.isNeeded);
+            if (!column.values[row].missing()) {
+                _fieldOrder.push_back(i);
+                _approximateSize += column.values[row].getApproximateSize();
+            }
+            break;
+        }
+    }
+}
+
+void DocumentBatch::clear() {
+    for (auto&& column : _columns) {
+        column.values.clear();
+    }
+    _fieldOrder.clear();
+    _rowStarts.clear();
+    _approximateSize = 0;
+}
+
+boost::optional<size_t> DocumentBatch::getColumn(StringData name) const {
+    for (size_t i = 0; i < _columns.size(); ++i) {
+        if (_columns[i].name == name) {
+            return i;
+        }
+    }
+    return boost::none;
+}
+
+Document DocumentBatch::getDocument(size_t row) const {
+    const size_t begin = _rowStarts[row];
+    const size_t end = row + 1 < _rowStarts.size() ? _rowStarts[row + 1] : _fieldOrder.size();
+
+    MutableDocument md(end - begin);
+    for (size_t i = begin; i < end; ++i) {
+        const Column& column = _columns[_fieldOrder[i]];
+        md.addField(column.name, column.values[row]);
+    }
+    return md.freeze();
+}
+
+}  // namespace mongo
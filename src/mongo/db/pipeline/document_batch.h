@@ -0,0 +1,115 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/optional.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "mongo/base/string_data.h"
+#include "mongo/bson/bsonobj.h"
+#include "mongo/db/pipeline/dependencies.h"
+#include "mongo/db/pipeline/document.h"
+#include "mongo/db/pipeline/value.h"
+
+namespace mongo {
+
+/**
+ * A batch of input documents stored by column. Only the top-level fields which a ParsedDeps says
+ * are needed are extracted from each input BSONObj, straight into one column of Values per field,
+ * so stages which read a few fields of wide documents need not build a Document for every input.
+ *
+ * A row is only turned back into a Document, with its fields in their original order, on request.
+ */
+class DocumentBatch {
+public:
+    explicit DocumentBatch(const ParsedDeps& deps);
+
+    /**
+     * Adds the needed fields of 'input' to the batch as a new row.
+     */
+    void append(const BSONObj& input);
+
+    /**
+     * Removes every row, keeping the columns.
+     */
+    void clear();
+
+    size_t size() const {
+        return _rowStarts.size();
+    }
+
+    bool empty() const {
+        return _rowStarts.empty();
+    }
+
+    /**
+     * Returns the index of the column holding the top-level field 'name', or boost::none if the
+     * batch does not hold that field.
+     */
+    boost::optional<size_t> getColumn(StringData name) const;
+
+    /**
+     * Returns the value of 'column' in 'row', which is missing if the row has no such field.
+     */
+    const Value& getValue(size_t column, size_t row) const {
+        return _columns[column].values[row];
+    }
+
+    /**
+     * Returns 'row' as the Document ParsedDeps::extractFields() would have produced for it.
+     */
+    Document getDocument(size_t row) const;
+
+    /**
+     * Returns the approximate number of bytes held by the rows of the batch.
+     */
+    size_t getApproximateSize() const {
+        return _approximateSize;
+    }
+
+private:
+    struct Column {
+        std::string name;
+        Value isNeeded;  // This field's entry in the ParsedDeps look-up table.
+        std::vector<Value> values;
+    };
+
+    std::vector<Column> _columns;
+
+    // The columns present in each row, in the order the row's input had them. Those of row 'i'
+    // start at _fieldOrder[_rowStarts[i]].
+    std::vector<uint32_t> _fieldOrder;
+    std::vector<size_t> _rowStarts;
+
+    size_t _approximateSize = 0;
+};
+
+}  // namespace mongo
@@ -0,0 +1,130 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/bson/bsonmisc.h"
+#include "mongo/bson/bsonobj.h"
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/bson/json.h"
+#include "mongo/db/pipeline/dependencies.h"
+#include "mongo/db/pipeline/document.h"
+#include "mongo/db/pipeline/document_batch.h"
+#include "mongo/db/pipeline/document_value_test_util.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+ParsedDeps makeParsedDeps(std::set<std::string> fields) {
+    DepsTracker deps;
+    deps.fields = std::move(fields);
+    return *deps.toParsedDeps();
+}
+
+TEST(DocumentBatchTest, ShouldOnlyHoldNeededTopLevelFields) {
+    DocumentBatch batch(makeParsedDeps({"a", "c.d"}));
+    batch.append(fromjson("{a: 1, b: 2, c: {d: 3, e: 4}}"));
+
+    ASSERT_EQ(batch.size(), 1UL);
+    ASSERT_FALSE(batch.getColumn("b"));
+    ASSERT_FALSE(batch.getColumn("c.d"));
+
+    auto a = batch.getColumn("a");
+    ASSERT_TRUE(a);
+    ASSERT_VALUE_EQ(batch.getValue(*a, 0), Value(1));
+
+    auto c = batch.getColumn("c");
+    ASSERT_TRUE(c);
+    ASSERT_VALUE_EQ(batch.getValue(*c, 0), Value(Document{{"d", 3}}));
+}
+
+TEST(DocumentBatchTest, ShouldHoldMissingValueForAbsentField) {
+    DocumentBatch batch(makeParsedDeps({"a", "b"}));
+    batch.append(fromjson("{a: 1}"));
+    batch.append(fromjson("{b: 2}"));
+
+    auto a = batch.getColumn("a");
+    auto b = batch.getColumn("b");
+    ASSERT_TRUE(a && b);
+    ASSERT_VALUE_EQ(batch.getValue(*a, 0), Value(1));
+    ASSERT_TRUE(batch.getValue(*b, 0).missing());
+    ASSERT_TRUE(batch.getValue(*a, 1).missing());
+    ASSERT_VALUE_EQ(batch.getValue(*b, 1), Value(2));
+}
+
+TEST(DocumentBatchTest, GetDocumentShouldMatchExtractFields) {
+    const auto parsedDeps = makeParsedDeps({"a", "c.d", "x"});
+    DocumentBatch batch(parsedDeps);
+
+    const BSONObj inputs[] = {fromjson("{c: [{d: 1, e: 2}, {e: 3}, 4], b: 1, a: 'str'}"),
+                              fromjson("{a: 1, x: {y: 1}, c: 5}"),
+                              fromjson("{b: 1}"),
+                              fromjson("{}")};
+    for (auto&& input : inputs) {
+        batch.append(input);
+    }
+
+    ASSERT_EQ(batch.size(), 4UL);
+    for (size_t row = 0; row < batch.size(); ++row) {
+        ASSERT_DOCUMENT_EQ(batch.getDocument(row), parsedDeps.extractFields(inputs[row]));
+    }
+
+    // Field order is that of the input, not of the columns.
+    ASSERT_EQ(batch.getDocument(0).toBson().firstElementFieldName(), std::string("c"));
+}
+
+TEST(DocumentBatchTest, ShouldOnlyHoldFirstOccurrenceOfDuplicateField) {
+    const auto parsedDeps = makeParsedDeps({"a"});
+    DocumentBatch batch(parsedDeps);
+    const BSONObj input = BSON("a" << 1 << "a" << 2);
+    batch.append(input);
+
+    auto a = batch.getColumn("a");
+    ASSERT_TRUE(a);
+    ASSERT_VALUE_EQ(batch.getValue(*a, 0), Value(1));
+    ASSERT_DOCUMENT_EQ(batch.getDocument(0), parsedDeps.extractFields(input));
+}
+
+TEST(DocumentBatchTest, ClearShouldRemoveEveryRow) {
+    DocumentBatch batch(makeParsedDeps({"a"}));
+    batch.append(fromjson("{a: 'some string'}"));
+    ASSERT_FALSE(batch.empty());
+    ASSERT_GT(batch.getApproximateSize(), 0UL);
+
+    batch.clear();
+    ASSERT_TRUE(batch.empty());
+    ASSERT_EQ(batch.getApproximateSize(), 0UL);
+
+    batch.append(fromjson("{a: 2}"));
+    ASSERT_EQ(batch.size(), 1UL);
+    ASSERT_VALUE_EQ(batch.getValue(*batch.getColumn("a"), 0), Value(2));
+}
+
+}  // namespace
+}  // namespace mongo
@@ -59,6 +59,7 @@ namespace mongo {
 
 class AggregationRequest;
 class Document;
+class DocumentBatch;
 
 /**
  * Registers a DocumentSource to have the name 'key'.
@@ -439,6 +440,25 @@ public:
      */
     virtual GetNextResult getNext() = 0;
 
+    /**
+     * Returns true if this stage can also return its results a batch at a time through
+     * getNextBatch(), holding just the top-level fields which later stages depend on.
+     */
+    virtual bool canProduceBatches() const {
+        return false;
+    }
+
+    /**
+     * Returns the next batch of results in columnar form, or nullptr once there are no more. Only
+     * valid if canProduceBatches() returns true, and must not be mixed with calls to getNext(). The
+     * batch is only valid until the next call.
+     *
+     * All implementers must call pExpCtx->checkForInterrupt().
+     */
+    virtual const DocumentBatch* getNextBatch() {
+        MONGO_UNREACHABLE;
+    }
+
     /**
      * Returns a struct containing information about any special constraints imposed on using this
      * stage. Input parameter Pipeline::SplitState is used by stages whose requirements change
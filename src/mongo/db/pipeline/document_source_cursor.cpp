@@ -63,6 +63,19 @@ DocumentSource::GetNextResult DocumentSourceCursor::getNext() {
     return std::move(out);
 }
 
+const DocumentBatch* DocumentSourceCursor::getNextBatch() {
+    pExpCtx->checkForInterrupt();
+    invariant(canProduceBatches() && _currentBatch.empty());
+
+    if (!_columnarBatch) {
+        _columnarBatch.emplace(*_dependencies);
+    }
+    _columnarBatch->clear();
+
+    loadBatch();
+    return _columnarBatch->empty() ? nullptr : _columnarBatch.get_ptr();
+}
+
 Document DocumentSourceCursor::transformBSONObjToDocument(const BSONObj& obj) const {
     return _dependencies ? _dependencies->extractFields(obj) : Document::fromBsonWithMetaData(obj);
 }
@@ -87,7 +100,9 @@ void DocumentSourceCursor::loadBatch() {
             ON_BLOCK_EXIT([this] { recordPlanSummaryStats(); });
 
             while ((state = _exec->getNext(&resultObj, nullptr)) == PlanExecutor::ADVANCED) {
-                if (_shouldProduceEmptyDocs) {
+                if (_columnarBatch) {
+                    _columnarBatch->append(resultObj);
+                } else if (_shouldProduceEmptyDocs) {
                     _currentBatch.push_back(Document());
                 } else {
                     _currentBatch.push_back(transformBSONObjToDocument(resultObj));
@@ -100,7 +115,11 @@ void DocumentSourceCursor::loadBatch() {
                     verify(_docsAddedToBatches < _limit->getLimit());
                 }
 
-                memUsageBytes += _currentBatch.back().getApproximateSize();
+                if (_columnarBatch) {
+                    memUsageBytes = static_cast<int>(_columnarBatch->getApproximateSize());
+                } else {
+                    memUsageBytes += _currentBatch.back().getApproximateSize();
+                }
 
                 // As long as we're waiting for inserts, we shouldn't do any batching at this level
                 // we need the whole pipeline to see each document to see if we should stop waiting.
@@ -194,6 +213,9 @@ Value DocumentSourceCursor::serialize(boost::optional<ExplainOptions::Verbosity>
     if (!_sort.isEmpty())
         out["sort"] = Value(_sort);
 
+    if (_isTopKSort)
+        out["topKSort"] = Value(true);
+
     if (_limit)
         out["limit"] = Value(_limit->getLimit());
 
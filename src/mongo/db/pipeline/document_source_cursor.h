@@ -32,6 +32,7 @@
 
 #include "mongo/db/db_raii.h"
 #include "mongo/db/namespace_string.h"
+#include "mongo/db/pipeline/document_batch.h"
 #include "mongo/db/pipeline/document_source.h"
 #include "mongo/db/pipeline/document_source_limit.h"
 #include "mongo/db/query/explain_options.h"
@@ -48,6 +49,15 @@ public:
     // virtuals from DocumentSource
     GetNextResult getNext() final;
 
+    /**
+     * The cursor can hand out batches whenever it only extracts the fields later stages need.
+     */
+    bool canProduceBatches() const override {
+        return _dependencies && !_shouldProduceEmptyDocs;
+    }
+
+    const DocumentBatch* getNextBatch() final;
+
     const char* getSourceName() const override;
 
     BSONObjSet getOutputSorts() override {
@@ -111,6 +121,14 @@ public:
         _sort = sort;
     }
 
+    /**
+     * Records whether the query system performs the sort as a top-k SORT stage, rather than
+     * reading the documents in order from an index. This gets used for explain output.
+     */
+    void setIsTopKSort(bool isTopKSort) {
+        _isTopKSort = isTopKSort;
+    }
+
     /**
      * Informs this object of projection and dependency information.
      *
@@ -192,8 +210,9 @@ private:
     void cleanupExecutor(const AutoGetCollectionForRead& readLock);
 
     /**
-     * Reads a batch of data from '_exec'. Subclasses can specify custom behavior to be performed on
-     * each document by overloading transformBSONObjToDocument().
+     * Reads a batch of data from '_exec' into '_columnarBatch' if there is one, or '_currentBatch'
+     * otherwise. Subclasses can specify custom behavior to be performed on each document by
+     * overloading transformBSONObjToDocument().
      */
     void loadBatch();
 
@@ -202,9 +221,13 @@ private:
     // Batches results returned from the underlying PlanExecutor.
     std::deque<Document> _currentBatch;
 
+    // Used in place of '_currentBatch' once a consumer asks for columnar batches.
+    boost::optional<DocumentBatch> _columnarBatch;
+
     // BSONObj members must outlive _projection and cursor.
     BSONObj _query;
     BSONObj _sort;
+    bool _isTopKSort = false;
     BSONObj _projection;
     bool _shouldProduceEmptyDocs = false;
     boost::optional<ParsedDeps> _dependencies;
@@ -35,12 +35,97 @@
 #include <set>
 
 #include "mongo/db/hasher.h"
+#include "mongo/db/matcher/expression_algo.h"
 #include "mongo/db/pipeline/document_source_exchange.h"
+#include "mongo/db/pipeline/document_source_group.h"
+#include "mongo/db/pipeline/document_source_sort.h"
 #include "mongo/db/storage/key_string.h"
 #include "mongo/util/log.h"
 
 namespace mongo {
 
+namespace {
+
+/**
+ * Follows 'path' from its component at 'index' as ExpressionFieldPath does, collecting the values
+ * found within arrays of subdocuments into an array.
+ */
+Value extractPathValue(const Document& input, const FieldPath& path, size_t index) {
+    Value val = input[path.getFieldName(index)];
+    if (index == path.getPathLength() - 1) {
+        return val;
+    }
+
+    switch (val.getType()) {
+        case Object:
+            return extractPathValue(val.getDocument(), path, index + 1);
+        case Array: {
+            std::vector<Value> result;
+            for (const auto& elem : val.getArray()) {
+                if (elem.getType() != Object) {
+                    continue;
+                }
+
+                Value nested = extractPathValue(elem.getDocument(), path, index + 1);
+                if (!nested.missing()) {
+                    result.push_back(std::move(nested));
+                }
+            }
+            return Value(std::move(result));
+        }
+        default:
+            return Value();
+    }
+}
+
+/**
+ * Returns the paths in the output of a stage which modifies the paths described by 'modPaths', on
+ * which its output is partitioned if its input is partitioned on 'partitionPaths'. Returns
+ * boost::none if the stage may change the value at any of the paths.
+ */
+boost::optional<std::set<std::string>> partitionPathsAfter(
+    const DocumentSource::GetModPathsReturn& modPaths,
+    const std::set<std::string>& partitionPaths) {
+    using ModType = DocumentSource::GetModPathsReturn::Type;
+
+    std::set<std::string> ret;
+    for (auto&& partitionPath : partitionPaths) {
+        bool preserved = false;
+        if (modPaths.type == ModType::kFiniteSet) {
+            preserved = std::none_of(
+                modPaths.paths.begin(), modPaths.paths.end(), [&](const std::string& path) {
+                    return path == partitionPath ||
+                        expression::isPathPrefixOf(path, partitionPath) ||
+                        expression::isPathPrefixOf(partitionPath, path);
+                });
+        } else if (modPaths.type == ModType::kAllExcept) {
+            preserved = std::any_of(
+                modPaths.paths.begin(), modPaths.paths.end(), [&](const std::string& path) {
+                    return path == partitionPath || expression::isPathPrefixOf(path, partitionPath);
+                });
+        }
+
+        if (preserved) {
+            ret.insert(partitionPath);
+        }
+
+        // A renamed path carries the same value under its new name.
+        for (auto&& rename : modPaths.renames) {
+            if (rename.second == partitionPath) {
+                ret.insert(rename.first);
+                preserved = true;
+            }
+        }
+
+        if (!preserved) {
+            return boost::none;
+        }
+    }
+    return ret;
+}
+
+}  // namespace
+
 REGISTER_DOCUMENT_SOURCE(exchange,
                          LiteParsedDocumentSourceDefault::parse,
                          DocumentSourceExchange::createFromBson);
@@ -78,13 +163,60 @@ DocumentSource::GetNextResult DocumentSourceExchange::getNext() {
     return _exchange->getNext(_consumerId);
 }
 
-Exchange::Exchange(const ExchangeSpec& spec)
+DocumentSource::GetNextResult DocumentSourceExchange::getNextWithRoutingKey(Value* routingKey) {
+    return _exchange->getNext(_consumerId, routingKey);
+}
+
+void DocumentSourceExchange::assertConsumersCanRun(const Pipeline::SourceContainer& stages) const {
+    // The partitioning ignores collation, so it says nothing about which strings compare equal
+    // under a non-simple one.
+    boost::optional<std::set<std::string>> partitionPaths;
+    if (!pExpCtx->getCollator()) {
+        partitionPaths = _exchange->getPartitionPaths();
+    }
+
+    for (auto&& stage : stages) {
+        if (auto group = dynamic_cast<DocumentSourceGroup*>(stage.get())) {
+            partitionPaths = partitionPaths ? group->getOutputPartitionPaths(*partitionPaths)
+                                            : boost::none;
+            uassert(51130,
+                    str::stream() << "$group after $exchange must group by every field of the "
+                                     "exchange key, using the simple collation: "
+                                  << _exchange->getSpec().getKey(),
+                    partitionPaths);
+            continue;
+        }
+
+        if (auto sort = dynamic_cast<DocumentSourceSort*>(stage.get())) {
+            uassert(51131, "$sort after $exchange must not have a limit", sort->getLimit() < 0);
+            continue;
+        }
+
+        uassert(51132,
+                str::stream() << stage->getSourceName()
+                              << " is not allowed after $exchange, since it would need to merge "
+                                 "the results of the consumers",
+                !dynamic_cast<NeedsMergerDocumentSource*>(stage.get()) &&
+                    stage->constraints(Pipeline::SplitState::kUnsplit).streamType ==
+                        StreamType::kStreaming);
+
+        if (partitionPaths) {
+            partitionPaths = partitionPathsAfter(stage->getModifiedPaths(), *partitionPaths);
+        }
+    }
+}
+
+Exchange::Exchange(const ExchangeSpec& spec) : Exchange(spec, nullptr) {}
+
+Exchange::Exchange(const ExchangeSpec& spec, Partitioner partitioner)
     : _spec(spec),
       _keyPattern(spec.getKey().getOwned()),
+      _keyPaths(extractKeyPaths(_keyPattern)),
       _ordering(extractOrdering(_keyPattern)),
       _boundaries(extractBoundaries(spec.getBoundaries())),
       _consumerIds(extractConsumerIds(spec.getConsumerids(), spec.getConsumers())),
       _policy(spec.getPolicy()),
+      _partitioner(std::move(partitioner)),
       _orderPreserving(spec.getOrderPreserving()),
       _maxBufferSize(spec.getBufferSize()) {
     uassert(50901, "$exchange must have at least one consumer", spec.getConsumers() > 0);
@@ -93,10 +225,18 @@ Exchange::Exchange(const ExchangeSpec& spec)
         _consumers.emplace_back(std::make_unique<ExchangeBuffer>());
     }
 
-    if (_policy == ExchangePolicyEnum::kRange || _policy == ExchangePolicyEnum::kHash) {
+    if (_partitioner) {
+        invariant(_policy == ExchangePolicyEnum::kHash);
+        uassert(51137,
+                "$exchange boundaries must not be specified with a partitioner.",
+                _boundaries.empty());
+    } else if (_policy == ExchangePolicyEnum::kRange ||
+               (_policy == ExchangePolicyEnum::kHash && !_boundaries.empty())) {
         uassert(50900,
                 "$exchange boundaries do not match number of consumers.",
                 _boundaries.size() == _consumerIds.size() + 1);
+    } else if (_policy == ExchangePolicyEnum::kHash) {
+        uassert(51129, "$exchange hash policy requires a key.", !_keyPaths.empty());
     } else {
         uassert(50899, "$exchange boundaries must not be specified.", _boundaries.empty());
     }
@@ -187,14 +327,36 @@ Ordering Exchange::extractOrdering(const BSONObj& obj) {
     return hasHashKey ? Ordering::make(BSONObj()) : Ordering::make(obj);
 }
 
-DocumentSource::GetNextResult Exchange::getNext(size_t consumerId) {
+std::vector<FieldPath> Exchange::extractKeyPaths(const BSONObj& obj) {
+    std::vector<FieldPath> ret;
+    for (const auto& element : obj) {
+        ret.emplace_back(element.fieldNameStringData());
+    }
+    return ret;
+}
+
+std::set<std::string> Exchange::getPartitionPaths() const {
+    // Range policies, and hash policies with boundaries, read each key field as a top-level field
+    // and route a missing one apart from null. Neither matches how a $group reads its _id.
+    std::set<std::string> ret;
+    if (!_partitioner && _policy == ExchangePolicyEnum::kHash && _boundaries.empty()) {
+        for (const auto& path : _keyPaths) {
+            ret.insert(path.fullPath());
+        }
+    }
+    return ret;
+}
+
+DocumentSource::GetNextResult Exchange::getNext(size_t consumerId, Value* routingKey) {
     // Grab a lock.
     stdx::unique_lock<stdx::mutex> lk(_mutex);
 
     for (;;) {
+        uassertStatusOK(_errorStatus);
+
         // Check if we have a document.
         if (!_consumers[consumerId]->isEmpty()) {
-            auto doc = _consumers[consumerId]->getNext();
+            auto doc = _consumers[consumerId]->getNext(routingKey);
 
             // See if the loading is blocked on this consumer and if so unblock it.
             if (_loadingThreadId == consumerId) {
@@ -205,8 +367,9 @@ DocumentSource::GetNextResult Exchange::getNext(size_t consumerId) {
             return doc;
         }
 
-        // There is not any document so try to load more from the source.
-        if (_loadingThreadId == kInvalidThreadId) {
+        // There is not any document so try to load more from the source. An exchange with a
+        // partitioner is only ever loaded by load().
+        if (_loadingThreadId == kInvalidThreadId && !_partitioner) {
             LOG(3) << "A consumer " << consumerId << " begins loading";
 
             // This consumer won the race and will fill the buffers.
@@ -215,7 +378,16 @@ DocumentSource::GetNextResult Exchange::getNext(size_t consumerId) {
             // This will return when some exchange buffer is full and we cannot make any forward
             // progress anymore.
             // The return value is an index of a full consumer buffer.
-            size_t fullConsumerId = loadNextBatch();
+            size_t fullConsumerId;
+            try {
+                fullConsumerId = loadNextBatch();
+            } catch (const DBException& ex) {
+                // No other consumer can make progress without the source, so fail them all.
+                _errorStatus = ex.toStatus();
+                _loadingThreadId = kInvalidThreadId;
+                _haveBufferSpace.notify_all();
+                throw;
+            }
 
             // The loading cannot continue until the consumer with the full buffer consumes some
             // documents.
@@ -231,6 +403,50 @@ DocumentSource::GetNextResult Exchange::getNext(size_t consumerId) {
     }
 }
 
+void Exchange::load() {
+    invariant(_partitioner);
+
+    stdx::unique_lock<stdx::mutex> lk(_mutex);
+
+    for (;;) {
+        uassertStatusOK(_errorStatus);
+
+        // Wait for the consumer with the full buffer to consume some documents.
+        if (_loadingThreadId != kInvalidThreadId) {
+            _haveBufferSpace.wait(lk);
+            continue;
+        }
+
+        size_t fullConsumerId;
+        try {
+            fullConsumerId = loadNextBatch();
+        } catch (const DBException& ex) {
+            // The consumers cannot make progress without the source, so fail them all.
+            _errorStatus = ex.toStatus();
+            _haveBufferSpace.notify_all();
+            throw;
+        }
+
+        _loadingThreadId = fullConsumerId;
+        _haveBufferSpace.notify_all();
+
+        // Every consumer has been sent EOF.
+        if (fullConsumerId == kInvalidThreadId) {
+            return;
+        }
+    }
+}
+
+void Exchange::abort(Status status) {
+    invariant(!status.isOK());
+
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    if (_errorStatus.isOK()) {
+        _errorStatus = std::move(status);
+    }
+    _haveBufferSpace.notify_all();
+}
+
 size_t Exchange::loadNextBatch() {
     auto input = pSource->getNext();
 
@@ -255,7 +471,7 @@ size_t Exchange::loadNextBatch() {
                     return target;
             } break;
             case ExchangePolicyEnum::kRange: {
-                size_t target = getTargetConsumer(input.getDocument());
+                size_t target = getTargetConsumer(input.getDocument(), nullptr);
                 bool full = _consumers[target]->appendDocument(std::move(input), _maxBufferSize);
                 if (full && _orderPreserving) {
                     // TODO send the high watermark here.
@@ -264,8 +480,10 @@ size_t Exchange::loadNextBatch() {
                     return target;
             } break;
             case ExchangePolicyEnum::kHash: {
-                size_t target = getTargetConsumer(input.getDocument());
-                bool full = _consumers[target]->appendDocument(std::move(input), _maxBufferSize);
+                Value routingKey;
+                size_t target = getTargetConsumer(input.getDocument(), &routingKey);
+                bool full = _consumers[target]->appendDocument(
+                    std::move(input), _maxBufferSize, std::move(routingKey));
                 if (full && _orderPreserving) {
                     // TODO send the high watermark here.
                 }
@@ -287,7 +505,29 @@ size_t Exchange::loadNextBatch() {
     return kInvalidThreadId;
 }
 
-size_t Exchange::getTargetConsumer(const Document& input) {
+size_t Exchange::getTargetConsumer(const Document& input, Value* routingKey) {
+    if (_partitioner) {
+        invariant(routingKey);
+        size_t cid = _partitioner(input, routingKey);
+        invariant(cid < _consumers.size());
+        return cid;
+    }
+
+    if (_policy == ExchangePolicyEnum::kHash && _boundaries.empty()) {
+        // Hash the whole key, so that the consumer depends on nothing but the key's values.
+        BSONArrayBuilder ab;
+        for (const auto& path : _keyPaths) {
+            ab << extractKeyValue(input, path);
+        }
+        auto hash = BSONElementHasher::hash64(BSON("" << ab.arr()).firstElement(),
+                                              BSONElementHasher::DEFAULT_HASH_SEED);
+
+        size_t cid = _consumerIds[static_cast<unsigned long long>(hash) % _consumerIds.size()];
+        invariant(cid < _consumers.size());
+
+        return cid;
+    }
+
     // Build the key.
     BSONObjBuilder kb;
     for (auto elem : _keyPattern) {
@@ -300,7 +540,6 @@ size_t Exchange::getTargetConsumer(const Document& input) {
         }
     }
 
-    // TODO implement hash keys for the hash policy.
     KeyString key{KeyString::Version::V1, kb.obj(), _ordering};
     std::string keyStr{key.getBuffer(), key.getSize()};
 
@@ -317,10 +556,19 @@ size_t Exchange::getTargetConsumer(const Document& input) {
     return cid;
 }
 
-DocumentSource::GetNextResult Exchange::ExchangeBuffer::getNext() {
+Value Exchange::extractKeyValue(const Document& input, const FieldPath& path) {
+    // A $group treats a missing _id as null, so the two must go to the same consumer.
+    auto value = extractPathValue(input, path, 0);
+    return value.missing() ? Value(BSONNULL) : value;
+}
+
+DocumentSource::GetNextResult Exchange::ExchangeBuffer::getNext(Value* routingKey) {
     invariant(!_buffer.empty());
 
-    auto result = std::move(_buffer.front());
+    auto result = std::move(_buffer.front().first);
+    if (routingKey) {
+        *routingKey = std::move(_buffer.front().second);
+    }
     _buffer.pop_front();
 
     if (result.isAdvanced()) {
@@ -330,11 +578,13 @@ DocumentSource::GetNextResult Exchange::ExchangeBuffer::getNext() {
     return result;
 }
 
-bool Exchange::ExchangeBuffer::appendDocument(DocumentSource::GetNextResult input, size_t limit) {
+bool Exchange::ExchangeBuffer::appendDocument(DocumentSource::GetNextResult input,
+                                              size_t limit,
+                                              Value routingKey) {
     if (input.isAdvanced()) {
         _bytesInBuffer += input.getDocument().getApproximateSize();
     }
-    _buffer.push_back(std::move(input));
+    _buffer.emplace_back(std::move(input), std::move(routingKey));
 
     // The buffer is full.
     return _bytesInBuffer >= limit;
@@ -29,12 +29,15 @@
 #pragma once
 
 #include <deque>
+#include <set>
+#include <string>
 #include <vector>
 
 #include "mongo/bson/ordering.h"
 #include "mongo/db/pipeline/document_source.h"
 #include "mongo/db/pipeline/document_source_exchange_gen.h"
 #include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/functional.h"
 #include "mongo/stdx/mutex.h"
 
 namespace mongo {
@@ -61,9 +64,52 @@ class Exchange : public RefCountable {
      */
     static Ordering extractOrdering(const BSONObj& obj);
 
+    /**
+     * Extract the paths named by the key.
+     */
+    static std::vector<FieldPath> extractKeyPaths(const BSONObj& obj);
+
 public:
+    /**
+     * Returns the consumer to which 'input' is sent, and sets 'routingKey' to the key by which it
+     * was chosen. The key is handed to the consumer along with the document.
+     */
+    using Partitioner = stdx::function<size_t(const Document& input, Value* routingKey)>;
+
     explicit Exchange(const ExchangeSpec& spec);
-    DocumentSource::GetNextResult getNext(size_t consumerId);
+
+    /**
+     * Constructs an exchange with the hash policy which sends each document to the consumer
+     * returned by 'partitioner', rather than to one chosen by the key and boundaries in 'spec'.
+     * This allows a stage to partition its input by a computed key. 'partitioner' must return a
+     * value less than the number of consumers.
+     *
+     * The consumers of such an exchange never read from the source themselves. Instead, the thread
+     * which owns the source loads the exchange by calling load(), so that the source and the
+     * partitioner are only ever used by that thread.
+     */
+    Exchange(const ExchangeSpec& spec, Partitioner partitioner);
+
+    /**
+     * Returns the next document for 'consumerId'. If 'routingKey' is not null, it is set to the
+     * key returned by the partitioner for that document.
+     */
+    DocumentSource::GetNextResult getNext(size_t consumerId, Value* routingKey = nullptr);
+
+    /**
+     * Reads the whole of the source into the consumers' buffers, waiting whenever a buffer is full
+     * for its consumer to drain it. May only be called on an exchange with a partitioner, whose
+     * consumers are running on other threads. Throws if the source fails or the exchange is
+     * aborted.
+     */
+    void load();
+
+    /**
+     * Causes every current and future call to getNext() to fail with 'status'. Used by a consumer
+     * which cannot continue, since the other consumers may otherwise wait forever for it to drain
+     * its buffer.
+     */
+    void abort(Status status);
 
     size_t getConsumers() const {
         return _consumers.size();
@@ -77,22 +123,40 @@ public:
         return _spec;
     }
 
+    /**
+     * Returns the paths of the key on which this exchange partitions its input, such that all
+     * documents with equal values at every one of these paths are sent to the same consumer. The
+     * values are compared without regard to any collation. Returns an empty set unless this is a
+     * hash exchange without boundaries, as only that policy reads the key the way a $group reads
+     * its _id.
+     */
+    std::set<std::string> getPartitionPaths() const;
+
 private:
     size_t loadNextBatch();
 
-    size_t getTargetConsumer(const Document& input);
+    size_t getTargetConsumer(const Document& input, Value* routingKey);
+
+    /**
+     * Returns the value at 'path' in 'input' as a field path expression would evaluate it, except
+     * that a missing value is returned as null.
+     */
+    static Value extractKeyValue(const Document& input, const FieldPath& path);
 
     class ExchangeBuffer {
     public:
-        bool appendDocument(DocumentSource::GetNextResult input, size_t limit);
-        DocumentSource::GetNextResult getNext();
+        bool appendDocument(DocumentSource::GetNextResult input,
+                            size_t limit,
+                            Value routingKey = Value());
+        DocumentSource::GetNextResult getNext(Value* routingKey);
         bool isEmpty() const {
             return _buffer.empty();
         }
 
     private:
         size_t _bytesInBuffer{0};
-        std::deque<DocumentSource::GetNextResult> _buffer;
+        // Each document together with the key its partitioner routed it by, if any.
+        std::deque<std::pair<DocumentSource::GetNextResult, Value>> _buffer;
     };
 
     // Keep a copy of the spec for serialization purposes.
@@ -101,6 +165,9 @@ private:
     // A pattern for extracting a key from a document used by range and hash policies.
     const BSONObj _keyPattern;
 
+    // The paths named by '_keyPattern', in the same order.
+    const std::vector<FieldPath> _keyPaths;
+
     const Ordering _ordering;
 
     // Range boundaries. The boundaries are ordered and must cover the whole domain, e.g.
@@ -118,6 +185,9 @@ private:
     // A policy that tells how to distribute input documents to consumers.
     const ExchangePolicyEnum _policy;
 
+    // If set, chooses the consumer for each document in place of the key pattern and boundaries.
+    const Partitioner _partitioner;
+
     // If set to true then a producer sends special 'high watermark' documents to consumers in order
     // to prevent deadlocks.
     const bool _orderPreserving;
@@ -137,6 +207,9 @@ private:
 
     size_t _roundRobinCounter{0};
 
+    // Set if loading failed or a consumer aborted the exchange. Every consumer fails with it.
+    Status _errorStatus = Status::OK();
+
     std::vector<std::unique_ptr<ExchangeBuffer>> _consumers;
 };
 
@@ -183,6 +256,12 @@ public:
 
     GetNextResult getNext(size_t consumerId);
 
+    /**
+     * Like getNext(), but also sets 'routingKey' to the key the exchange's partitioner returned for
+     * the document.
+     */
+    GetNextResult getNextWithRoutingKey(Value* routingKey);
+
     size_t getConsumers() const {
         return _exchange->getConsumers();
     }
@@ -191,6 +270,16 @@ public:
         return _exchange;
     }
 
+    /**
+     * Throws unless 'stages', which follow this stage in the pipeline, can run separately on each
+     * consumer such that the union of the consumers' results is the result of the whole pipeline.
+     * Streaming stages can always do so. A $group can do so only if every document for one of its
+     * groups is guaranteed to reach the same consumer, which is the case when its _id includes
+     * every path on which the exchange partitions its input and no earlier stage has modified
+     * those paths. A $sort without a limit orders the results of each consumer.
+     */
+    void assertConsumersCanRun(const Pipeline::SourceContainer& stages) const;
+
 private:
     boost::intrusive_ptr<Exchange> _exchange;
 
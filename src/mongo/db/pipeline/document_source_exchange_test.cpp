@@ -28,10 +28,14 @@
 
 #include "mongo/platform/basic.h"
 
+#include <map>
+#include <set>
+
 #include "mongo/db/hasher.h"
 #include "mongo/db/pipeline/aggregation_context_fixture.h"
 #include "mongo/db/pipeline/document_source_exchange.h"
 #include "mongo/db/pipeline/document_source_mock.h"
+#include "mongo/db/pipeline/document_source_sort.h"
 #include "mongo/db/storage/key_string.h"
 #include "mongo/executor/network_interface_factory.h"
 #include "mongo/executor/thread_pool_task_executor.h"
@@ -455,6 +459,243 @@ TEST_F(DocumentSourceExchangeTest, RangeRandomHashExchangeNConsumer) {
     ASSERT_EQ(nDocs, processedDocs.load());
 }
 
+TEST_F(DocumentSourceExchangeTest, HashExchangeNConsumer) {
+    const size_t nDocs = 500;
+    auto source = getRandomMockSource(nDocs, getNewSeed());
+
+    const size_t nConsumers = 4;
+
+    ExchangeSpec spec;
+    spec.setPolicy(ExchangePolicyEnum::kHash);
+    spec.setKey(BSON("a"
+                     << "hashed"));
+    spec.setConsumers(nConsumers);
+    spec.setBufferSize(1024);
+
+    boost::intrusive_ptr<Exchange> ex = new Exchange(spec);
+
+    std::vector<boost::intrusive_ptr<DocumentSourceExchange>> prods;
+
+    for (size_t idx = 0; idx < nConsumers; ++idx) {
+        prods.push_back(new DocumentSourceExchange(getExpCtx(), ex, idx));
+        prods.back()->setSource(source.get());
+    }
+
+    std::vector<executor::TaskExecutor::CallbackHandle> handles;
+    std::vector<std::set<int>> keysByConsumer(nConsumers);
+
+    AtomicWord<size_t> processedDocs{0};
+
+    for (size_t id = 0; id < nConsumers; ++id) {
+        auto handle = _executor->scheduleWork(
+            [prods, id, &processedDocs, &keysByConsumer](
+                const executor::TaskExecutor::CallbackArgs& cb) {
+                PseudoRandom prng(getNewSeed());
+
+                auto input = prods[id]->getNext();
+
+                size_t docs = 0;
+                for (; input.isAdvanced(); input = prods[id]->getNext()) {
+                    keysByConsumer[id].insert(input.getDocument()["a"].getInt());
+                    ++docs;
+
+                    // This helps randomizing thread scheduling forcing different threads to load
+                    // buffers. The sleep API is inherently imprecise so we cannot guarantee 100%
+                    // reproducibility.
+                    sleepmillis(prng.nextInt32() % 50 + 1);
+                }
+                processedDocs.fetchAndAdd(docs);
+            });
+
+        handles.emplace_back(std::move(handle.getValue()));
+    }
+
+    for (auto& h : handles)
+        _executor->wait(h);
+
+    ASSERT_EQ(nDocs, processedDocs.load());
+
+    // Every key is delivered to exactly one consumer.
+    std::set<int> allKeys;
+    size_t totalKeys = 0;
+    for (auto&& keys : keysByConsumer) {
+        allKeys.insert(keys.begin(), keys.end());
+        totalKeys += keys.size();
+    }
+    ASSERT_EQ(allKeys.size(), totalKeys);
+}
+
+TEST_F(DocumentSourceExchangeTest, HashExchangeSendsEqualKeysToSameConsumer) {
+    auto source = DocumentSourceMock::create({"{_id: 0, a: {b: 1}}",
+                                              "{_id: 1, a: {b: 1.0}}",
+                                              "{_id: 2, a: {b: NumberLong(1)}}",
+                                              "{_id: 3, a: {b: NumberDecimal('1')}}",
+                                              "{_id: 4, a: [{b: 1}, {b: 2}]}",
+                                              "{_id: 5, a: [{b: 1.0}, {c: 3}, {b: 2.0}]}",
+                                              "{_id: 6, a: {c: 1}}",
+                                              "{_id: 7, a: {b: null}}",
+                                              "{_id: 8}"});
+
+    const size_t nConsumers = 16;
+
+    ExchangeSpec spec;
+    spec.setPolicy(ExchangePolicyEnum::kHash);
+    spec.setKey(BSON("a.b" << 1));
+    spec.setConsumers(nConsumers);
+
+    boost::intrusive_ptr<Exchange> ex = new Exchange(spec);
+    ex->setSource(source.get());
+
+    // The default buffers are large enough to load every document at once, so the consumers can be
+    // drained one after another.
+    std::map<int, size_t> consumerById;
+    for (size_t id = 0; id < nConsumers; ++id) {
+        for (auto input = ex->getNext(id); input.isAdvanced(); input = ex->getNext(id)) {
+            consumerById[input.getDocument()["_id"].getInt()] = id;
+        }
+    }
+
+    ASSERT_EQ(consumerById.size(), 9u);
+    ASSERT_EQ(consumerById[0], consumerById[1]);
+    ASSERT_EQ(consumerById[0], consumerById[2]);
+    ASSERT_EQ(consumerById[0], consumerById[3]);
+    ASSERT_EQ(consumerById[4], consumerById[5]);
+    ASSERT_EQ(consumerById[6], consumerById[7]);
+    ASSERT_EQ(consumerById[6], consumerById[8]);
+}
+
+TEST_F(DocumentSourceExchangeTest, PartitionerExchangeIsLoadedByProducer) {
+    const size_t nDocs = 500;
+    auto source = getMockSource(nDocs);
+
+    const size_t nConsumers = 4;
+
+    ExchangeSpec spec;
+    spec.setPolicy(ExchangePolicyEnum::kHash);
+    spec.setConsumers(nConsumers);
+    spec.setBufferSize(1024);
+
+    boost::intrusive_ptr<Exchange> ex =
+        new Exchange(spec, [nConsumers](const Document& input, Value* routingKey) {
+            *routingKey = input["a"];
+            return static_cast<size_t>(routingKey->getInt()) % nConsumers;
+        });
+
+    std::vector<boost::intrusive_ptr<DocumentSourceExchange>> prods;
+
+    for (size_t idx = 0; idx < nConsumers; ++idx) {
+        prods.push_back(new DocumentSourceExchange(getExpCtx(), ex, idx));
+        prods.back()->setSource(source.get());
+    }
+
+    std::vector<executor::TaskExecutor::CallbackHandle> handles;
+
+    AtomicWord<size_t> processedDocs{0};
+
+    for (size_t id = 0; id < nConsumers; ++id) {
+        auto handle = _executor->scheduleWork(
+            [prods, id, nConsumers, &processedDocs](
+                const executor::TaskExecutor::CallbackArgs& cb) {
+                Value routingKey;
+                auto input = prods[id]->getNextWithRoutingKey(&routingKey);
+
+                size_t docs = 0;
+                for (; input.isAdvanced(); input = prods[id]->getNextWithRoutingKey(&routingKey)) {
+                    // Each document arrives with the key that the partitioner returned for it.
+                    ASSERT_EQ(routingKey.getInt(), input.getDocument()["a"].getInt());
+                    ASSERT_EQ(static_cast<size_t>(routingKey.getInt()) % nConsumers, id);
+                    ++docs;
+                }
+                processedDocs.fetchAndAdd(docs);
+            });
+
+        handles.emplace_back(std::move(handle.getValue()));
+    }
+
+    // The buffers hold only a fraction of the input, so this must wait for the consumers to drain
+    // them, which they do without ever reading from the source themselves.
+    ex->load();
+
+    for (auto& h : handles)
+        _executor->wait(h);
+
+    ASSERT_EQ(nDocs, processedDocs.load());
+}
+
+TEST_F(DocumentSourceExchangeTest, HashExchangeAllowsGroupOnKeyAfterIt) {
+    auto exchange = DocumentSourceExchange::createFromBson(
+        fromjson("{$exchange: {policy: 'hash', consumers: 2, key: {a: 'hashed'}}}").firstElement(),
+        getExpCtx());
+    auto exchangeStage = static_cast<DocumentSourceExchange*>(exchange.get());
+
+    auto parseSuffix = [&](const std::vector<BSONObj>& stages) {
+        return uassertStatusOK(Pipeline::parse(stages, getExpCtx()))->getSources();
+    };
+
+    exchangeStage->assertConsumersCanRun(parseSuffix(
+        {fromjson("{$match: {c: 1}}"), fromjson("{$group: {_id: {x: '$a', y: '$b', z: '$c'}}}")}));
+    exchangeStage->assertConsumersCanRun(parseSuffix(
+        {fromjson("{$addFields: {c: 1}}"), fromjson("{$sortByCount: '$a'}")}));
+
+    // The output of the first $group remains partitioned on its _id.
+    exchangeStage->assertConsumersCanRun(
+        parseSuffix({fromjson("{$group: {_id: {x: '$a', y: '$b'}, n: {$sum: 1}}}"),
+                     fromjson("{$group: {_id: {y: '$_id.y', x: '$_id.x'}, n: {$sum: '$n'}}}"),
+                     fromjson("{$sort: {n: -1}}")}));
+
+    // The key fields survive being renamed.
+    exchangeStage->assertConsumersCanRun(
+        parseSuffix({fromjson("{$project: {c: '$a', b: 1}}"),
+                     fromjson("{$group: {_id: {c: '$c', b: '$b'}}}")}));
+}
+
+TEST_F(DocumentSourceExchangeTest, HashExchangeRejectsStagesWhichNeedMerging) {
+    auto exchange = DocumentSourceExchange::createFromBson(
+        fromjson("{$exchange: {policy: 'hash', consumers: 2, key: {a: 1}}}").firstElement(),
+        getExpCtx());
+    auto exchangeStage = static_cast<DocumentSourceExchange*>(exchange.get());
+
+    auto parseSuffix = [&](const std::vector<BSONObj>& stages) {
+        return uassertStatusOK(Pipeline::parse(stages, getExpCtx()))->getSources();
+    };
+
+    ASSERT_THROWS_CODE(
+        exchangeStage->assertConsumersCanRun(parseSuffix({fromjson("{$group: {_id: '$b'}}")})),
+        AssertionException,
+        51130);
+    ASSERT_THROWS_CODE(exchangeStage->assertConsumersCanRun(parseSuffix(
+                           {fromjson("{$addFields: {a: 1}}"), fromjson("{$group: {_id: '$a'}}")})),
+                       AssertionException,
+                       51130);
+    ASSERT_THROWS_CODE(exchangeStage->assertConsumersCanRun(parseSuffix({fromjson(
+                           "{$bucket: {groupBy: '$a', boundaries: [0, 10], default: 'x'}}")})),
+                       AssertionException,
+                       51130);
+    ASSERT_THROWS_CODE(
+        exchangeStage->assertConsumersCanRun(parseSuffix({fromjson("{$limit: 1}")})),
+        AssertionException,
+        51132);
+    ASSERT_THROWS_CODE(exchangeStage->assertConsumersCanRun(
+                           {DocumentSourceSort::create(getExpCtx(), BSON("a" << 1), 1)}),
+                       AssertionException,
+                       51131);
+}
+
+TEST_F(DocumentSourceExchangeTest, RangeExchangeRejectsGroupAfterIt) {
+    // A range exchange reads its key as top-level fields and routes a missing key apart from a null
+    // one, so it does not partition the input the way a $group on the key needs.
+    auto exchange = DocumentSourceExchange::createFromBson(
+        fromjson("{$exchange: {policy: 'range', consumers: 2, key: {a: 1}, "
+                 "boundaries: [{a: {$minKey: 1}}, {a: 0}, {a: {$maxKey: 1}}]}}")
+            .firstElement(),
+        getExpCtx());
+    auto exchangeStage = static_cast<DocumentSourceExchange*>(exchange.get());
+
+    auto suffix = uassertStatusOK(Pipeline::parse({fromjson("{$group: {_id: '$a'}}")}, getExpCtx()))
+                      ->getSources();
+    ASSERT_THROWS_CODE(exchangeStage->assertConsumersCanRun(suffix), AssertionException, 51130);
+}
+
 TEST_F(DocumentSourceExchangeTest, RejectNoConsumers) {
     BSONObj spec = BSON("$exchange" << BSON("policy"
                                             << "broadcast"
@@ -74,6 +74,14 @@ public:
      */
     BSONObjSet getOutputSorts() final;
 
+    /**
+     * The distance and location fields are computed for each document, so this stage never hands
+     * out columnar batches.
+     */
+    bool canProduceBatches() const final {
+        return false;
+    }
+
 private:
     DocumentSourceGeoNearCursor(Collection*,
                                 std::unique_ptr<PlanExecutor, PlanExecutor::Deleter>,
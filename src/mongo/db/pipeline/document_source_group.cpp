@@ -28,17 +28,25 @@
 
 #include "mongo/platform/basic.h"
 
+#include <algorithm>
+
+#include "mongo/db/client.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/pipeline/accumulation_statement.h"
 #include "mongo/db/pipeline/accumulator.h"
 #include "mongo/db/pipeline/document.h"
+#include "mongo/db/pipeline/document_batch.h"
 #include "mongo/db/pipeline/document_source_group.h"
 #include "mongo/db/pipeline/expression.h"
+#include "mongo/db/pipeline/expression_compiled.h"
 #include "mongo/db/pipeline/expression_context.h"
 #include "mongo/db/pipeline/lite_parsed_document_source.h"
 #include "mongo/db/pipeline/value.h"
 #include "mongo/db/pipeline/value_comparator.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/stdx/memory.h"
+#include "mongo/util/concurrency/thread_pool.h"
+#include "mongo/util/scopeguard.h"
 
 namespace mongo {
 
@@ -70,7 +78,9 @@ DocumentSource::GetNextResult DocumentSourceGroup::getNext() {
         accum->reset();  // Prep accumulators for a new group.
     }
 
-    if (_spilled) {
+    if (!_partitions.empty()) {
+        return getNextPartitioned();
+    } else if (_spilled) {
         return getNextSpilled();
     } else if (_streaming) {
         return getNextStreaming();
@@ -164,7 +174,24 @@ DocumentSource::GetNextResult DocumentSourceGroup::getNextStreaming() {
     return std::move(out);
 }
 
+DocumentSource::GetNextResult DocumentSourceGroup::getNextPartitioned() {
+    for (; _currentPartition < _partitions.size(); ++_currentPartition) {
+        auto next = _partitions[_currentPartition]->getNext();
+        if (!next.isEOF()) {
+            return next;
+        }
+    }
+    return GetNextResult::makeEOF();
+}
+
 void DocumentSourceGroup::doDispose() {
+    for (auto&& partition : _partitions) {
+        _usedDisk = _usedDisk || partition->usedDisk();
+        partition->dispose();
+    }
+    _partitions.clear();
+    _partitionSources.clear();
+
     // Free our resources.
     _groups = pExpCtx->getValueComparator().makeUnorderedValueMap<Accumulators>();
     _sorterIterator.reset();
@@ -180,11 +207,12 @@ intrusive_ptr<DocumentSource> DocumentSourceGroup::optimize() {
     // will be only one group. We should take advantage of that to avoid going through the hash
     // table.
     for (size_t i = 0; i < _idExpressions.size(); i++) {
-        _idExpressions[i] = _idExpressions[i]->optimize();
+        _idExpressions[i] = ExpressionCompiled::compile(pExpCtx, _idExpressions[i]->optimize());
     }
 
     for (auto&& accumulatedField : _accumulatedFields) {
-        accumulatedField.expression = accumulatedField.expression->optimize();
+        accumulatedField.expression =
+            ExpressionCompiled::compile(pExpCtx, accumulatedField.expression->optimize());
     }
 
     return this;
@@ -481,65 +509,31 @@ DocumentSource::GetNextResult DocumentSourceGroup::initialize() {
     }
 
 
-    // Barring any pausing, this loop exhausts 'pSource' and populates '_groups'.
-    GetNextResult input = pSource->getNext();
-    for (; input.isAdvanced(); input = pSource->getNext()) {
-        if (_memoryUsageBytes > _maxMemoryUsageBytes) {
-            uassert(16945,
-                    "Exceeded memory limit for $group, but didn't allow external sort."
-                    " Pass allowDiskUse:true to opt in.",
-                    _allowDiskUse);
-            _sortedFiles.push_back(spill());
-            _memoryUsageBytes = 0;
-        }
+    if (canPartition()) {
+        auto result = initializePartitioned();
+        _initialized = true;
+        return result;
+    }
+
+    // A partition reads from an exchange which routed each document by its group key, so it reuses
+    // that key rather than computing it again.
+    auto exchangeSource = _isPartition ? static_cast<DocumentSourceExchange*>(pSource) : nullptr;
+    Value routingKey;
+    auto getNextInput = [&] {
+        return exchangeSource ? exchangeSource->getNextWithRoutingKey(&routingKey)
+                              : pSource->getNext();
+    };
 
+    // Barring any pausing, this loop exhausts 'pSource' and populates '_groups'.
+    GetNextResult input = canGroupBatches() ? groupBatches() : getNextInput();
+    for (; input.isAdvanced(); input = getNextInput()) {
         // We release the result document here so that it does not outlive the end of this loop
         // iteration. Not releasing could lead to an array copy when this group follows an unwind.
         auto rootDocument = input.releaseDocument();
-        Value id = computeId(rootDocument);
-
-        // Look for the _id value in the map. If it's not there, add a new entry with a blank
-        // accumulator. This is done in a somewhat odd way in order to avoid hashing 'id' and
-        // looking it up in '_groups' multiple times.
-        const size_t oldSize = _groups->size();
-        vector<intrusive_ptr<Accumulator>>& group = (*_groups)[id];
-        const bool inserted = _groups->size() != oldSize;
-
-        if (inserted) {
-            _memoryUsageBytes += id.getApproximateSize();
-
-            // Add the accumulators
-            group.reserve(numAccumulators);
-            for (auto&& accumulatedField : _accumulatedFields) {
-                group.push_back(accumulatedField.makeAccumulator(pExpCtx));
-            }
-        } else {
-            for (auto&& groupObj : group) {
-                // subtract old mem usage. New usage added back after processing.
-                _memoryUsageBytes -= groupObj->memUsageForSorter();
-            }
-        }
-
-        /* tickle all the accumulators for the group we found */
-        dassert(numAccumulators == group.size());
-
-        for (size_t i = 0; i < numAccumulators; i++) {
-            group[i]->process(_accumulatedFields[i].expression->evaluate(rootDocument),
-                              _doingMerge);
-
-            _memoryUsageBytes += group[i]->memUsageForSorter();
-        }
-
-        if (kDebugBuild && !storageGlobalParams.readOnly) {
-            // In debug mode, spill every time we have a duplicate id to stress merge logic.
-            if (!inserted &&                 // is a dup
-                !pExpCtx->inMongos &&        // can't spill to disk in mongos
-                !_allowDiskUse &&            // don't change behavior when testing external sort
-                _sortedFiles.size() < 20) {  // don't open too many FDs
-
-                _sortedFiles.push_back(spill());
-            }
-        }
+        Value id = exchangeSource ? std::move(routingKey) : computeId(rootDocument);
+        processInput(std::move(id), [&](size_t i) {
+            return _accumulatedFields[i].expression->evaluate(rootDocument);
+        });
     }
 
     switch (input.getStatus()) {
@@ -585,10 +579,384 @@ DocumentSource::GetNextResult DocumentSourceGroup::initialize() {
     MONGO_UNREACHABLE;
 }
 
+template <typename ArgumentFn>
+void DocumentSourceGroup::processInput(Value id, const ArgumentFn& getArgument) {
+    const size_t numAccumulators = _accumulatedFields.size();
+
+    if (_memoryUsageBytes > _maxMemoryUsageBytes) {
+        uassert(16945,
+                "Exceeded memory limit for $group, but didn't allow external sort."
+                " Pass allowDiskUse:true to opt in.",
+                _allowDiskUse);
+        _sortedFiles.push_back(spill());
+        _memoryUsageBytes = 0;
+    }
+
+    // Look for the _id value in the map. If it's not there, add a new entry with a blank
+    // accumulator. This is done in a somewhat odd way in order to avoid hashing 'id' and
+    // looking it up in '_groups' multiple times.
+    const size_t oldSize = _groups->size();
+    vector<intrusive_ptr<Accumulator>>& group = (*_groups)[id];
+    const bool inserted = _groups->size() != oldSize;
+
+    if (inserted) {
+        _memoryUsageBytes += id.getApproximateSize();
+
+        // Add the accumulators
+        group.reserve(numAccumulators);
+        for (auto&& accumulatedField : _accumulatedFields) {
+            group.push_back(accumulatedField.makeAccumulator(pExpCtx));
+        }
+    } else {
+        for (auto&& groupObj : group) {
+            // subtract old mem usage. New usage added back after processing.
+            _memoryUsageBytes -= groupObj->memUsageForSorter();
+        }
+    }
+
+    /* tickle all the accumulators for the group we found */
+    dassert(numAccumulators == group.size());
+
+    for (size_t i = 0; i < numAccumulators; i++) {
+        group[i]->process(getArgument(i), _doingMerge);
+
+        _memoryUsageBytes += group[i]->memUsageForSorter();
+    }
+
+    if (kDebugBuild && !storageGlobalParams.readOnly) {
+        // In debug mode, spill every time we have a duplicate id to stress merge logic.
+        if (!inserted &&                 // is a dup
+            !pExpCtx->inMongos &&        // can't spill to disk in mongos
+            !_allowDiskUse &&            // don't change behavior when testing external sort
+            _sortedFiles.size() < 20) {  // don't open too many FDs
+
+            _sortedFiles.push_back(spill());
+        }
+    }
+}
+
+namespace {
+/**
+ * Evaluates a constant, or a path below ROOT, from the column of a DocumentBatch holding the path's
+ * top-level field.
+ */
+class ColumnExpression {
+public:
+    explicit ColumnExpression(const intrusive_ptr<Expression>& expression)
+        : _fieldPath(dynamic_cast<ExpressionFieldPath*>(expression.get())) {
+        if (!_fieldPath) {
+            _constant = static_cast<ExpressionConstant*>(expression.get())->getValue();
+        }
+    }
+
+    static bool canEvaluate(const intrusive_ptr<Expression>& expression) {
+        if (dynamic_cast<ExpressionConstant*>(expression.get())) {
+            return true;
+        }
+        auto fieldPath = dynamic_cast<ExpressionFieldPath*>(expression.get());
+        return fieldPath && fieldPath->isRootFieldPath() &&
+            fieldPath->getFieldPath().getPathLength() > 1;
+    }
+
+    /**
+     * Looks up the column to read in 'batch', which must be called for each new batch.
+     */
+    void bind(const DocumentBatch& batch) {
+        if (_fieldPath) {
+            _column = batch.getColumn(_fieldPath->getFieldPath().getFieldName(1));
+        }
+    }
+
+    Value evaluate(const DocumentBatch& batch, size_t row) const {
+        if (!_fieldPath) {
+            return _constant;
+        }
+        return _fieldPath->evaluateFromTopLevelField(_column ? batch.getValue(*_column, row)
+                                                             : Value());
+    }
+
+private:
+    const ExpressionFieldPath* _fieldPath;
+    Value _constant;
+    boost::optional<size_t> _column;
+};
+}  // namespace
+
+bool DocumentSourceGroup::canGroupBatches() const {
+    if (!pSource || !pSource->canProduceBatches() ||
+        pExpCtx->tailableMode != TailableModeEnum::kNormal) {
+        return false;
+    }
+
+    return std::all_of(
+               _idExpressions.begin(), _idExpressions.end(), ColumnExpression::canEvaluate) &&
+        std::all_of(_accumulatedFields.begin(),
+                    _accumulatedFields.end(),
+                    [](const AccumulationStatement& accumulatedField) {
+                        return ColumnExpression::canEvaluate(accumulatedField.expression);
+                    });
+}
+
+DocumentSource::GetNextResult DocumentSourceGroup::groupBatches() {
+    vector<ColumnExpression> idExpressions(_idExpressions.begin(), _idExpressions.end());
+    vector<ColumnExpression> arguments;
+    for (auto&& accumulatedField : _accumulatedFields) {
+        arguments.emplace_back(accumulatedField.expression);
+    }
+
+    while (const DocumentBatch* batch = pSource->getNextBatch()) {
+        for (auto&& expression : idExpressions) {
+            expression.bind(*batch);
+        }
+        for (auto&& argument : arguments) {
+            argument.bind(*batch);
+        }
+
+        for (size_t row = 0; row < batch->size(); ++row) {
+            // Mirrors computeId().
+            Value id;
+            if (idExpressions.size() == 1) {
+                id = idExpressions[0].evaluate(*batch, row);
+                if (id.missing()) {
+                    id = Value(BSONNULL);
+                }
+            } else {
+                vector<Value> vals;
+                vals.reserve(idExpressions.size());
+                for (auto&& expression : idExpressions) {
+                    vals.push_back(expression.evaluate(*batch, row));
+                }
+                id = Value(std::move(vals));
+            }
+
+            processInput(std::move(id),
+                         [&](size_t i) { return arguments[i].evaluate(*batch, row); });
+        }
+    }
+    return GetNextResult::makeEOF();
+}
+
 bool DocumentSourceGroup::usedDisk() {
+    for (auto&& partition : _partitions) {
+        _usedDisk = _usedDisk || partition->usedDisk();
+    }
     return _usedDisk;
 }
 
+boost::optional<std::set<std::string>> DocumentSourceGroup::getOutputPartitionPaths(
+    const std::set<std::string>& partitionPaths) const {
+    if (partitionPaths.empty()) {
+        return boost::none;
+    }
+
+    std::set<std::string> outputPaths;
+    for (auto&& partitionPath : partitionPaths) {
+        bool covered = false;
+        for (size_t i = 0; i < _idExpressions.size(); ++i) {
+            auto fieldPath = dynamic_cast<ExpressionFieldPath*>(_idExpressions[i].get());
+            if (!fieldPath || !fieldPath->isRootFieldPath() ||
+                fieldPath->getFieldPath().getPathLength() == 1 ||
+                fieldPath->getFieldPath().tail().fullPath() != partitionPath) {
+                continue;
+            }
+
+            outputPaths.insert(_idFieldNames.empty() ? "_id" : "_id." + _idFieldNames[i]);
+            covered = true;
+        }
+
+        if (!covered) {
+            return boost::none;
+        }
+    }
+    return outputPaths;
+}
+
+namespace {
+/**
+ * If 'expression' is a path into the current document whose components are all field names,
+ * rather than array indexes or variables, returns the path without the leading "CURRENT".
+ */
+boost::optional<std::string> getPlainFieldPath(const intrusive_ptr<Expression>& expression) {
+    auto fieldPath = dynamic_cast<ExpressionFieldPath*>(expression.get());
+    if (!fieldPath || !fieldPath->isRootFieldPath() ||
+        fieldPath->getFieldPath().getPathLength() == 1) {
+        return boost::none;
+    }
+
+    const FieldPath path = fieldPath->getFieldPath().tail();
+    for (size_t i = 0; i < path.getPathLength(); ++i) {
+        const auto component = path.getFieldName(i);
+        if (std::all_of(component.begin(), component.end(), [](char c) { return isdigit(c); })) {
+            // An index treats a numeric component as an array index, but a $group does not.
+            return boost::none;
+        }
+    }
+    return path.fullPath();
+}
+}  // namespace
+
+boost::optional<DocumentSourceGroup::DistinctScanRewrite>
+DocumentSourceGroup::getDistinctScanRewrite(const BSONObj& inputSortPattern) const {
+    if (_doingMerge || !_idFieldNames.empty() || _idExpressions.size() != 1) {
+        return boost::none;
+    }
+
+    auto groupKeyPath = getPlainFieldPath(_idExpressions.front());
+    if (!groupKeyPath) {
+        return boost::none;
+    }
+
+    // The documents of a group are only contiguous in the input if it is sorted by the group key
+    // first.
+    if (!inputSortPattern.isEmpty() &&
+        inputSortPattern.firstElementFieldName() != StringData(*groupKeyPath)) {
+        return boost::none;
+    }
+    for (auto&& elem : inputSortPattern) {
+        if (!elem.isNumber()) {
+            return boost::none;
+        }
+    }
+
+    size_t numFirst = 0;
+    size_t numLast = 0;
+    for (auto&& accumulatedField : _accumulatedFields) {
+        if (!getPlainFieldPath(accumulatedField.expression)) {
+            return boost::none;
+        }
+
+        const StringData opName = accumulatedField.makeAccumulator(pExpCtx)->getOpName();
+        if (opName == "$first") {
+            ++numFirst;
+        } else if (opName == "$last") {
+            ++numLast;
+        } else {
+            return boost::none;
+        }
+    }
+    if (numFirst > 0 && numLast > 0) {
+        return boost::none;
+    }
+
+    DistinctScanRewrite rewrite;
+    rewrite.groupKeyPath = *groupKeyPath;
+    rewrite.sortPattern =
+        inputSortPattern.isEmpty() ? BSON(*groupKeyPath << 1) : inputSortPattern.getOwned();
+    if (numLast == 0) {
+        return rewrite;
+    }
+
+    // The last document of each group in the input order is the first in the reverse order, where
+    // a $first of each field gives the same result as a $last in the original order.
+    BSONObjBuilder reverseSort;
+    for (auto&& elem : rewrite.sortPattern) {
+        reverseSort.append(elem.fieldName(), -elem.numberInt());
+    }
+    rewrite.sortPattern = reverseSort.obj();
+
+    std::vector<AccumulationStatement> firstStatements;
+    for (auto&& accumulatedField : _accumulatedFields) {
+        firstStatements.emplace_back(accumulatedField.fieldName,
+                                     accumulatedField.expression,
+                                     AccumulationStatement::getFactory("$first"));
+    }
+    rewrite.groupStage = DocumentSourceGroup::create(
+        pExpCtx, _idExpressions.front(), std::move(firstStatements), _maxMemoryUsageBytes);
+    return rewrite;
+}
+
+bool DocumentSourceGroup::canPartition() const {
+    // A partitioned $group pulls its input from several threads in turn, so it is restricted to
+    // the top level of non-tailable mongod pipelines, whose sources never pause.
+    return internalDocumentSourceGroupPartitions.load() > 1 && !_isPartition &&
+        !pExpCtx->inMongos && pExpCtx->tailableMode == TailableModeEnum::kNormal &&
+        pExpCtx->subPipelineDepth == 0;
+}
+
+DocumentSource::GetNextResult DocumentSourceGroup::initializePartitioned() {
+    const size_t numPartitions = internalDocumentSourceGroupPartitions.load();
+
+    ExchangeSpec spec;
+    spec.setPolicy(ExchangePolicyEnum::kHash);
+    spec.setConsumers(numPartitions);
+
+    // The group key is computed with this stage's expressions on this thread, which alone loads the
+    // exchange, and is handed to the partition along with the document. The partitions evaluate
+    // their own copies of the expressions for the accumulators.
+    boost::intrusive_ptr<Exchange> exchange =
+        new Exchange(spec, [this, numPartitions](const Document& input, Value* routingKey) {
+            *routingKey = computeId(input);
+            return pExpCtx->getValueComparator().hash(*routingKey) % numPartitions;
+        });
+    exchange->setSource(pSource);
+
+    // Give each partition its own ExpressionContext, since evaluating expressions writes to the
+    // ExpressionContext's variables.
+    const BSONObj groupSpec = serialize().getDocument().toBson();
+    for (size_t i = 0; i < numPartitions; ++i) {
+        auto expCtx = pExpCtx->copyWith(pExpCtx->ns, pExpCtx->uuid);
+        expCtx->variables = pExpCtx->variables;
+        expCtx->variablesParseState =
+            pExpCtx->variablesParseState.copyWith(expCtx->variables.useIdGenerator());
+
+        intrusive_ptr<DocumentSourceGroup> partition(static_cast<DocumentSourceGroup*>(
+            createFromBson(groupSpec.firstElement(), expCtx).get()));
+        partition->_isPartition = true;
+        // Partitions are not part of a Pipeline, so nothing else compiles their expressions.
+        partition->optimize();
+        partition->_maxMemoryUsageBytes = std::max<size_t>(_maxMemoryUsageBytes / numPartitions, 1);
+
+        _partitionSources.emplace_back(new DocumentSourceExchange(expCtx, exchange, i));
+        partition->setSource(_partitionSources.back().get());
+        _partitions.push_back(std::move(partition));
+    }
+
+    ThreadPool::Options options;
+    options.poolName = "GroupPartitionPool";
+    options.threadNamePrefix = "GroupPartition";
+    options.minThreads = options.maxThreads = numPartitions;
+    options.onCreateThread = [](const std::string& threadName) {
+        Client::initThread(threadName.c_str());
+    };
+    ThreadPool pool(options);
+    pool.startup();
+
+    // Each partition runs under its own OperationContext, while 'pSource', whose resources belong
+    // to this operation, is only read on this thread by Exchange::load().
+    std::vector<Status> statuses(numPartitions, Status::OK());
+    for (size_t i = 0; i < numPartitions; ++i) {
+        invariant(pool.schedule([&, i] {
+            auto& partitionExpCtx = _partitions[i]->pExpCtx;
+            auto partitionOpCtx = cc().makeOperationContext();
+            partitionExpCtx->opCtx = partitionOpCtx.get();
+            ON_BLOCK_EXIT([&] { partitionExpCtx->opCtx = pExpCtx->opCtx; });
+
+            try {
+                auto result = _partitions[i]->initialize();
+                invariant(result.isEOF());
+            } catch (const DBException& ex) {
+                statuses[i] = ex.toStatus();
+                exchange->abort(statuses[i]);
+            }
+        }));
+    }
+
+    Status loadStatus = Status::OK();
+    try {
+        exchange->load();
+    } catch (const DBException& ex) {
+        loadStatus = ex.toStatus();
+    }
+    pool.shutdown();
+    pool.join();
+
+    uassertStatusOK(loadStatus);
+    for (auto&& status : statuses) {
+        uassertStatusOK(status);
+    }
+    return GetNextResult::makeEOF();
+}
+
 shared_ptr<Sorter<Value, Value>::Iterator> DocumentSourceGroup::spill() {
     _usedDisk = true;
     vector<const GroupsMap::value_type*> ptrs;  // using pointers to speed sorting
@@ -29,11 +29,13 @@
 #pragma once
 
 #include <memory>
+#include <set>
 #include <utility>
 
 #include "mongo/db/pipeline/accumulation_statement.h"
 #include "mongo/db/pipeline/accumulator.h"
 #include "mongo/db/pipeline/document_source.h"
+#include "mongo/db/pipeline/document_source_exchange.h"
 #include "mongo/db/sorter/sorter.h"
 
 namespace mongo {
@@ -98,6 +100,43 @@ public:
         return _streaming;
     }
 
+    /**
+     * Suppose this stage's input is partitioned such that all documents with equal values at each
+     * of 'partitionPaths' are in the same partition. If the _id of this stage includes a field path
+     * to each of 'partitionPaths', every group lies within one partition and so a copy of this
+     * stage can compute complete groups from each partition. In that case, returns the paths of
+     * the corresponding _id fields, on which the output is partitioned in the same way. Otherwise
+     * returns boost::none.
+     */
+    boost::optional<std::set<std::string>> getOutputPartitionPaths(
+        const std::set<std::string>& partitionPaths) const;
+
+    /**
+     * Describes how a $group can be computed from only the first document of each group, such as
+     * the documents produced by a DISTINCT_SCAN. See getDistinctScanRewrite().
+     */
+    struct DistinctScanRewrite {
+        // The dotted path of the field the $group is keyed on.
+        std::string groupKeyPath;
+
+        // The order in which the first document of each group must be chosen.
+        BSONObj sortPattern;
+
+        // The stage to run over those documents in place of the original $group, or null if the
+        // original can be kept.
+        boost::intrusive_ptr<DocumentSourceGroup> groupStage;
+    };
+
+    /**
+     * If this stage is keyed on a single field path, and either every accumulator is a $first or
+     * every accumulator is a $last of a field path, then its output only depends on the first or
+     * last document of each group. Returns how to compute it from the first document of each
+     * group, given that this stage's input is sorted by 'inputSortPattern', or in no particular
+     * order if 'inputSortPattern' is empty. Otherwise returns boost::none.
+     */
+    boost::optional<DistinctScanRewrite> getDistinctScanRewrite(
+        const BSONObj& inputSortPattern) const;
+
     // Virtuals for NeedsMergerDocumentSource.
     boost::intrusive_ptr<DocumentSource> getShardSource() final;
     std::list<boost::intrusive_ptr<DocumentSource>> getMergeSources() final;
@@ -122,6 +161,7 @@ private:
     GetNextResult getNextStreaming();
     GetNextResult getNextSpilled();
     GetNextResult getNextStandard();
+    GetNextResult getNextPartitioned();
 
     /**
      * Attempt to identify an input sort order that allows us to turn into a streaming $group. If we
@@ -141,6 +181,43 @@ private:
      */
     GetNextResult initialize();
 
+    /**
+     * Returns true if this $group may split its input across the threads of a partitioned $group
+     * rather than grouping it on the calling thread. See internalDocumentSourceGroupPartitions.
+     */
+    bool canPartition() const;
+
+    /**
+     * Hash-partitions the input by group key through an Exchange, with a copy of this $group
+     * consuming each partition in its own thread and OperationContext while the calling thread
+     * reads the input. Since every group lies wholly within one partition, each copy produces final
+     * results for its groups. Returns once all of the input has been consumed, leaving the copies
+     * in '_partitions' ready to return their results.
+     */
+    GetNextResult initializePartitioned();
+
+    /**
+     * Returns true if 'pSource' can hand out DocumentBatches and every _id and accumulator
+     * expression is a constant or a path below ROOT, which can be evaluated straight from a batch's
+     * columns.
+     */
+    bool canGroupBatches() const;
+
+    /**
+     * Consumes all of 'pSource' a DocumentBatch at a time, evaluating the group key and accumulator
+     * arguments over the batch's columns rather than over a Document built for each input. Returns
+     * the EOF which ends the input.
+     */
+    GetNextResult groupBatches();
+
+    /**
+     * Adds an input with group key 'id' to its group, creating the group if there is none, and
+     * passes 'getArgument(i)' to the group's i-th accumulator. Spills first if over the memory
+     * limit.
+     */
+    template <typename ArgumentFn>
+    void processInput(Value id, const ArgumentFn& getArgument);
+
     /**
      * Spill groups map to disk and returns an iterator to the file. Note: Since a sorted $group
      * does not exhaust the previous stage before returning, and thus does not maintain as large a
@@ -195,6 +272,15 @@ private:
     std::pair<Value, Value> _firstPartOfNextGroup;
     // Only used when '_sorted' is true.
     boost::optional<Document> _firstDocOfNextGroup;
+
+    // Only used when this $group has been partitioned. Each stage in '_partitions' reads from the
+    // corresponding consumer in '_partitionSources', and their results are returned in turn.
+    std::vector<boost::intrusive_ptr<DocumentSourceGroup>> _partitions;
+    std::vector<boost::intrusive_ptr<DocumentSourceExchange>> _partitionSources;
+    size_t _currentPartition = 0;
+
+    // Set on the copies created by initializePartitioned(), which must not partition again.
+    bool _isPartition = false;
 };
 
 }  // namespace mongo
@@ -28,6 +28,7 @@
 
 #include "mongo/platform/basic.h"
 
+#include <algorithm>
 #include <boost/intrusive_ptr.hpp>
 #include <deque>
 #include <map>
@@ -41,12 +42,14 @@
 #include "mongo/db/pipeline/aggregation_context_fixture.h"
 #include "mongo/db/pipeline/aggregation_request.h"
 #include "mongo/db/pipeline/dependencies.h"
+#include "mongo/db/pipeline/document_batch.h"
 #include "mongo/db/pipeline/document_source_group.h"
 #include "mongo/db/pipeline/document_source_mock.h"
 #include "mongo/db/pipeline/document_value_test_util.h"
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/expression_context_for_test.h"
 #include "mongo/db/pipeline/value_comparator.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/query/query_test_service_context.h"
 #include "mongo/dbtests/dbtests.h"
 #include "mongo/stdx/memory.h"
@@ -189,6 +192,182 @@ TEST_F(DocumentSourceGroupTest, ShouldCorrectlyTrackMemoryUsageBetweenPauses) {
     ASSERT_THROWS_CODE(group->getNext(), AssertionException, 16945);
 }
 
+// Enables partitioned execution of $group for the duration of each test.
+class DocumentSourceGroupPartitionedTest : public DocumentSourceGroupTest {
+public:
+    DocumentSourceGroupPartitionedTest() : _tempDir("DocumentSourceGroupPartitionedTest") {
+        internalDocumentSourceGroupPartitions.store(4);
+        getExpCtx()->tempDir = _tempDir.path();
+    }
+
+    ~DocumentSourceGroupPartitionedTest() {
+        internalDocumentSourceGroupPartitions.store(0);
+    }
+
+private:
+    TempDir _tempDir;
+};
+
+TEST_F(DocumentSourceGroupPartitionedTest, ShouldProduceEachGroupOnce) {
+    auto expCtx = getExpCtx();
+    VariablesParseState vps = expCtx->variablesParseState;
+    AccumulationStatement sumStatement{"total",
+                                       ExpressionFieldPath::parse(expCtx, "$x", vps),
+                                       AccumulationStatement::getFactory("$sum")};
+    auto groupByExpression = ExpressionFieldPath::parse(expCtx, "$key", vps);
+    auto group = DocumentSourceGroup::create(expCtx, groupByExpression, {sumStatement});
+
+    const int numDocs = 1000;
+    const int numKeys = 37;
+    deque<DocumentSource::GetNextResult> inputs;
+    for (int i = 0; i < numDocs; ++i) {
+        inputs.emplace_back(Document{{"key", i % numKeys}, {"x", 1}});
+    }
+    auto mock = DocumentSourceMock::create(inputs);
+    group->setSource(mock.get());
+
+    map<int, int> totals;
+    for (auto result = group->getNext(); result.isAdvanced(); result = group->getNext()) {
+        auto doc = result.releaseDocument();
+        ASSERT_TRUE(totals.emplace(doc["_id"].coerceToInt(), doc["total"].coerceToInt()).second);
+    }
+    ASSERT_TRUE(group->getNext().isEOF());
+
+    ASSERT_EQ(totals.size(), static_cast<size_t>(numKeys));
+    for (auto&& total : totals) {
+        ASSERT_EQ(total.second, numDocs / numKeys + (total.first < numDocs % numKeys ? 1 : 0));
+    }
+}
+
+TEST_F(DocumentSourceGroupPartitionedTest, ShouldErrorIfAPartitionExceedsItsMemoryLimit) {
+    auto expCtx = getExpCtx();
+    const size_t maxMemoryUsageBytes = 1000;
+
+    VariablesParseState vps = expCtx->variablesParseState;
+    AccumulationStatement pushStatement{"spaceHog",
+                                        ExpressionFieldPath::parse(expCtx, "$largeStr", vps),
+                                        AccumulationStatement::getFactory("$push")};
+    auto groupByExpression = ExpressionFieldPath::parse(expCtx, "$_id", vps);
+    auto group = DocumentSourceGroup::create(
+        expCtx, groupByExpression, {pushStatement}, maxMemoryUsageBytes);
+
+    string largeStr(maxMemoryUsageBytes, 'x');
+    deque<DocumentSource::GetNextResult> inputs;
+    for (int i = 0; i < 20; ++i) {
+        inputs.emplace_back(Document{{"_id", i}, {"largeStr", largeStr}});
+    }
+    auto mock = DocumentSourceMock::create(inputs);
+    group->setSource(mock.get());
+
+    ASSERT_THROWS_CODE(group->getNext(), AssertionException, 16945);
+}
+
+// A mock which hands its inputs to a consumer which asks for them as DocumentBatches, the way a
+// $cursor stage does.
+class DocumentSourceBatchedMock : public DocumentSourceMock {
+public:
+    DocumentSourceBatchedMock(vector<BSONObj> inputs, const ParsedDeps& deps, size_t batchSize)
+        : DocumentSourceMock({}), _inputs(std::move(inputs)), _batch(deps), _batchSize(batchSize) {}
+
+    bool canProduceBatches() const final {
+        return true;
+    }
+
+    const DocumentBatch* getNextBatch() final {
+        _batch.clear();
+        for (; _nextInput < _inputs.size() && _batch.size() < _batchSize; ++_nextInput) {
+            _batch.append(_inputs[_nextInput]);
+        }
+        return _batch.empty() ? nullptr : &_batch;
+    }
+
+private:
+    const vector<BSONObj> _inputs;
+    size_t _nextInput = 0;
+    DocumentBatch _batch;
+    const size_t _batchSize;
+};
+
+class DocumentSourceGroupBatchedInputTest : public DocumentSourceGroupTest {
+public:
+    DocumentSourceGroupBatchedInputTest() : _tempDir("DocumentSourceGroupBatchedInputTest") {
+        getExpCtx()->tempDir = _tempDir.path();
+    }
+
+    /**
+     * Runs the $group 'spec' over 'inputs', both as Documents and as DocumentBatches, and checks
+     * that both produce the same groups.
+     */
+    void assertBatchedResultsMatch(const BSONObj& spec, const vector<BSONObj>& inputs) {
+        auto expected = runGroup(spec, inputs, false);
+        auto batched = runGroup(spec, inputs, true);
+        ASSERT_EQ(expected.size(), batched.size());
+        for (size_t i = 0; i < expected.size(); ++i) {
+            ASSERT_DOCUMENT_EQ(expected[i], batched[i]);
+        }
+    }
+
+private:
+    vector<Document> runGroup(const BSONObj& spec, const vector<BSONObj>& inputs, bool batched) {
+        auto group = DocumentSourceGroup::createFromBson(spec.firstElement(), getExpCtx());
+
+        intrusive_ptr<DocumentSourceMock> source;
+        if (batched) {
+            DepsTracker deps;
+            group->getDependencies(&deps);
+            source = new DocumentSourceBatchedMock(inputs, *deps.toParsedDeps(), 7);
+        } else {
+            deque<DocumentSource::GetNextResult> queue;
+            for (auto&& input : inputs) {
+                queue.emplace_back(Document(input));
+            }
+            source = DocumentSourceMock::create(queue);
+        }
+        group->setSource(source.get());
+
+        vector<Document> results;
+        for (auto next = group->getNext(); next.isAdvanced(); next = group->getNext()) {
+            results.push_back(next.releaseDocument());
+        }
+        std::sort(results.begin(), results.end(), [](const Document& lhs, const Document& rhs) {
+            return ValueComparator().evaluate(lhs["_id"] < rhs["_id"]);
+        });
+        return results;
+    }
+
+    TempDir _tempDir;
+};
+
+TEST_F(DocumentSourceGroupBatchedInputTest, ShouldGroupByTopLevelAndNestedFields) {
+    vector<BSONObj> inputs;
+    for (int i = 0; i < 50; ++i) {
+        inputs.push_back(BSON("a" << BSON("b" << i % 4 << "c" << i) << "x" << i << "y"
+                                  << "unused"));
+    }
+    inputs.push_back(BSON("x" << 1));
+    inputs.push_back(BSON("a" << BSON_ARRAY(BSON("b" << 1) << BSON("b" << 2)) << "x" << 2));
+
+    assertBatchedResultsMatch(fromjson("{$group: {_id: '$a.b', total: {$sum: '$x'}}}"), inputs);
+    assertBatchedResultsMatch(
+        fromjson("{$group: {_id: {b: '$a.b', x: '$x'}, c: {$push: '$a.c'}, m: {$max: '$z'}}}"),
+        inputs);
+    assertBatchedResultsMatch(fromjson("{$group: {_id: null, count: {$sum: 1}}}"), inputs);
+    assertBatchedResultsMatch(fromjson("{$group: {_id: '$x', a: {$first: '$a'}}}"), inputs);
+}
+
+TEST_F(DocumentSourceGroupBatchedInputTest, ShouldNotAskForBatchesIfAnExpressionNeedsADocument) {
+    auto group = DocumentSourceGroup::createFromBson(
+        fromjson("{$group: {_id: {$add: ['$x', 1]}}}").firstElement(), getExpCtx());
+    DepsTracker deps;
+    group->getDependencies(&deps);
+    intrusive_ptr<DocumentSourceBatchedMock> source =
+        new DocumentSourceBatchedMock({BSON("x" << 1)}, *deps.toParsedDeps(), 1);
+    group->setSource(source.get());
+
+    // The mock holds no Documents, so a $group which does not ask for batches sees none.
+    ASSERT_TRUE(group->getNext().isEOF());
+}
+
 BSONObj toBson(const intrusive_ptr<DocumentSource>& source) {
     vector<Value> arr;
     source->serializeToArray(arr);
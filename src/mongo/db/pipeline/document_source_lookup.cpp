@@ -210,6 +210,10 @@ DocumentSource::GetNextResult DocumentSourceLookUp::getNext() {
         return unwindResult();
     }
 
+    if (_hashJoin) {
+        return hashJoinResult();
+    }
+
     auto nextInput = pSource->getNext();
     if (!nextInput.isAdvanced()) {
         return nextInput;
@@ -221,6 +225,14 @@ DocumentSource::GetNextResult DocumentSourceLookUp::getNext() {
     // '_unwindSrc' would be non-null, and we would not have made it here.
     invariant(!_matchSrc);
 
+    if (!_hashJoinAttempted && canUseHashJoin()) {
+        // Wait until there is at least one input document before reading the foreign collection.
+        _hashJoinAttempted = true;
+        if (buildHashJoin()) {
+            return hashJoinResult(std::move(inputDoc));
+        }
+    }
+
     if (!wasConstructedWithPipelineSyntax()) {
         auto matchStage =
             makeMatchStageFromInput(inputDoc, *_localField, _foreignField->fullPath(), BSONObj());
@@ -252,6 +264,98 @@ DocumentSource::GetNextResult DocumentSourceLookUp::getNext() {
     return output.freeze();
 }
 
+bool DocumentSourceLookUp::canUseHashJoin() const {
+    return internalDocumentSourceLookupUseHashJoin.load() && !wasConstructedWithPipelineSyntax() &&
+        !_unwindSrc && !pExpCtx->inMongos && LookupHashJoin::canJoinOn(*_foreignField);
+}
+
+bool DocumentSourceLookUp::buildHashJoin() {
+    auto hashJoin = stdx::make_unique<LookupHashJoin>(
+        _fromExpCtx,
+        *_localField,
+        *_foreignField,
+        static_cast<size_t>(internalDocumentSourceLookupHashJoinMaxMemoryBytes.load()),
+        pExpCtx->allowDiskUse,
+        pExpCtx->tempDir);
+
+    // Read the foreign namespace through everything but the placeholder for the trailing $match,
+    // which leaves only the view pipeline, if any.
+    copyVariablesToExpCtx(_variables, _variablesParseState, _fromExpCtx.get());
+    const std::vector<BSONObj> foreignPipeline(_resolvedPipeline.begin(),
+                                               _resolvedPipeline.end() - 1);
+    auto pipeline = uassertStatusOK(
+        pExpCtx->mongoProcessInterface->makePipeline(foreignPipeline, _fromExpCtx));
+
+    while (auto foreignDoc = pipeline->getNext()) {
+        if (!hashJoin->addForeignDocument(*foreignDoc)) {
+            return false;
+        }
+    }
+    _usedDisk = _usedDisk || pipeline->usedDisk() || hashJoin->isSpilled();
+
+    _hashJoin = std::move(hashJoin);
+    return true;
+}
+
+DocumentSource::GetNextResult DocumentSourceLookUp::hashJoinResult(
+    boost::optional<Document> input) {
+    if (!_hashJoin->isSpilled()) {
+        if (!input) {
+            auto nextInput = pSource->getNext();
+            if (!nextInput.isAdvanced()) {
+                return nextInput;
+            }
+            input = nextInput.releaseDocument();
+        }
+        auto results = _hashJoin->probe(*input);
+        return addResultsToInput(std::move(*input), std::move(results));
+    }
+
+    // A spilled hash join is blocking: it must see every input document before it can join any.
+    if (!_hashJoin->isFinishedProbing()) {
+        if (input) {
+            _hashJoin->addLocalDocument(std::move(*input));
+        }
+
+        auto nextInput = pSource->getNext();
+        for (; nextInput.isAdvanced(); nextInput = pSource->getNext()) {
+            _hashJoin->addLocalDocument(nextInput.releaseDocument());
+        }
+        if (nextInput.isPaused()) {
+            return nextInput;
+        }
+        _hashJoin->finishProbing();
+    }
+
+    if (!_hashJoin->more()) {
+        return GetNextResult::makeEOF();
+    }
+    auto next = _hashJoin->next();
+    return addResultsToInput(std::move(next.first), std::move(next.second));
+}
+
+Document DocumentSourceLookUp::addResultsToInput(Document input, std::vector<Value> results) {
+    // Measure the results as the nested-loop $lookup does, so both fail on the same input.
+    int objsize = 0;
+    for (auto&& result : results) {
+        objsize += result.getDocument().getApproximateSize();
+    }
+    if (objsize > BSONObjMaxInternalSize) {
+        // Report the query the nested-loop $lookup would have issued for this document.
+        auto matchStage =
+            makeMatchStageFromInput(input, *_localField, _foreignField->fullPath(), BSONObj());
+        uasserted(51138,
+                  str::stream() << "Total size of documents in " << _fromNs.coll()
+                                << " matching pipeline "
+                                << matchStage.toString()
+                                << " exceeds maximum document size");
+    }
+
+    MutableDocument output(std::move(input));
+    output.setNestedField(_as, Value(std::move(results)));
+    return output.freeze();
+}
+
 std::unique_ptr<Pipeline, PipelineDeleter> DocumentSourceLookUp::buildPipeline(
     const Document& inputDoc) {
     // Copy all 'let' variables into the foreign pipeline's expression context.
@@ -438,6 +542,7 @@ bool DocumentSourceLookUp::usedDisk() {
 }
 
 void DocumentSourceLookUp::doDispose() {
+    _hashJoin.reset();
     if (_pipeline) {
         _usedDisk = _usedDisk || _pipeline->usedDisk();
         _pipeline->dispose(pExpCtx->opCtx);
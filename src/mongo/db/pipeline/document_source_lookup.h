@@ -36,6 +36,7 @@
 #include "mongo/db/pipeline/document_source_unwind.h"
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/lite_parsed_pipeline.h"
+#include "mongo/db/pipeline/lookup_hash_join.h"
 #include "mongo/db/pipeline/lookup_set_cache.h"
 #include "mongo/db/pipeline/value_comparator.h"
 
@@ -253,6 +254,31 @@ private:
 
     GetNextResult unwindResult();
 
+    /**
+     * Returns true if this stage may execute as a hash join rather than by querying the foreign
+     * collection once per input document. See LookupHashJoin.
+     */
+    bool canUseHashJoin() const;
+
+    /**
+     * Reads the whole foreign collection into '_hashJoin'. Returns false, leaving '_hashJoin'
+     * unset, if the hash join was abandoned because it exceeded its memory limit without
+     * permission to spill.
+     */
+    bool buildHashJoin();
+
+    /**
+     * Produces the next result using '_hashJoin'. If 'input' is set, it is joined before any
+     * further document is requested from the source.
+     */
+    GetNextResult hashJoinResult(boost::optional<Document> input = boost::none);
+
+    /**
+     * Sets 'results' as the 'as' field of 'input', asserting that their total size does not exceed
+     * the maximum document size.
+     */
+    Document addResultsToInput(Document input, std::vector<Value> results);
+
     /**
      * Copies 'vars' and 'vps' to the Variables and VariablesParseState objects in 'expCtx'. These
      * copies provide access to 'let' defined variables in sub-pipeline execution.
@@ -316,6 +342,12 @@ private:
     // from a cursor source.
     boost::optional<SequentialDocumentCache> _cache;
 
+    // Set if a $lookup with localField/foreignField syntax is executing as a hash join.
+    // '_hashJoinAttempted' records that the decision has been made, so that a join abandoned for
+    // exceeding its memory limit is not rebuilt.
+    std::unique_ptr<LookupHashJoin> _hashJoin;
+    bool _hashJoinAttempted = false;
+
     // The ExpressionContext used when performing aggregation pipelines against the '_resolvedNs'
     // namespace.
     boost::intrusive_ptr<ExpressionContext> _fromExpCtx;
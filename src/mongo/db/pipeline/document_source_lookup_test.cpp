@@ -47,6 +47,7 @@
 #include "mongo/db/repl/replication_coordinator_mock.h"
 #include "mongo/db/repl/storage_interface_mock.h"
 #include "mongo/db/server_options.h"
+#include "mongo/unittest/temp_dir.h"
 
 namespace mongo {
 namespace {
@@ -58,6 +59,8 @@ using std::vector;
 using DocumentSourceLookUpTest = AggregationContextFixture;
 
 const long long kDefaultMaxCacheSize = internalDocumentSourceLookupCacheSizeBytes.load();
+const long long kDefaultHashJoinMaxMemoryBytes =
+    internalDocumentSourceLookupHashJoinMaxMemoryBytes.load();
 const auto kExplain = ExplainOptions::Verbosity::kQueryPlanner;
 
 // For tests which need to run in a replica set context.
@@ -1105,5 +1108,219 @@ TEST_F(DocumentSourceLookUpTest, ShouldNotCacheIfCorrelatedStageIsAbsorbedIntoPl
     ASSERT_VALUE_EQ(Value(subPipeline->writeExplainOps(kExplain)), Value(BSONArray(expectedPipe)));
 }
 
+// Restores the $lookup hash join knobs modified by each test.
+class DocumentSourceLookUpHashJoinTest : public DocumentSourceLookUpTest {
+public:
+    ~DocumentSourceLookUpHashJoinTest() {
+        internalDocumentSourceLookupUseHashJoin.store(false);
+        internalDocumentSourceLookupHashJoinMaxMemoryBytes.store(kDefaultHashJoinMaxMemoryBytes);
+    }
+
+    /**
+     * Runs a $lookup of 'localField' against 'foreignField' over 'localDocs', with a mocked foreign
+     * collection containing 'foreignDocs', and returns every document it outputs. Pauses are
+     * skipped.
+     */
+    vector<Document> runLookUp(bool useHashJoin,
+                               deque<DocumentSource::GetNextResult> localDocs,
+                               deque<DocumentSource::GetNextResult> foreignDocs,
+                               StringData localField,
+                               StringData foreignField,
+                               bool* usedDisk = nullptr) {
+        internalDocumentSourceLookupUseHashJoin.store(useHashJoin);
+
+        auto expCtx = getExpCtx();
+        NamespaceString fromNs("test", "foreign");
+        expCtx->setResolvedNamespace_forTest(fromNs, {fromNs, std::vector<BSONObj>{}});
+        expCtx->mongoProcessInterface =
+            std::make_shared<MockMongoInterface>(std::move(foreignDocs));
+
+        auto lookupSpec = Document{{"$lookup",
+                                    Document{{"from", fromNs.coll()},
+                                             {"localField", localField},
+                                             {"foreignField", foreignField},
+                                             {"as", "joined"_sd}}}}
+                              .toBson();
+        auto lookup = DocumentSourceLookUp::createFromBson(lookupSpec.firstElement(), expCtx);
+        auto mockLocalSource = DocumentSourceMock::create(std::move(localDocs));
+        lookup->setSource(mockLocalSource.get());
+
+        vector<Document> results;
+        for (auto next = lookup->getNext(); !next.isEOF(); next = lookup->getNext()) {
+            if (next.isAdvanced()) {
+                results.push_back(next.releaseDocument());
+            }
+        }
+        if (usedDisk) {
+            *usedDisk = lookup->usedDisk();
+        }
+        lookup->dispose();
+        return results;
+    }
+
+    /**
+     * Asserts that the hash join produces the same results as the nested-loop $lookup.
+     */
+    void assertHashJoinMatchesNestedLoop(deque<DocumentSource::GetNextResult> localDocs,
+                                         deque<DocumentSource::GetNextResult> foreignDocs,
+                                         StringData localField,
+                                         StringData foreignField,
+                                         bool expectUsedDisk = false) {
+        auto expected = runLookUp(false, localDocs, foreignDocs, localField, foreignField);
+        bool usedDisk = false;
+        auto actual =
+            runLookUp(true, localDocs, foreignDocs, localField, foreignField, &usedDisk);
+
+        ASSERT_EQ(expected.size(), actual.size());
+        for (size_t i = 0; i < expected.size(); ++i) {
+            ASSERT_DOCUMENT_EQ(expected[i], actual[i]);
+        }
+        ASSERT_EQ(expectUsedDisk, usedDisk);
+    }
+
+    deque<DocumentSource::GetNextResult> localDocs() {
+        return {Document(fromjson("{_id: 0, a: 1}")),
+                Document(fromjson("{_id: 1, a: [1, 3]}")),
+                Document(fromjson("{_id: 2}")),
+                Document(fromjson("{_id: 3, a: null}")),
+                Document(fromjson("{_id: 4, a: [[1]]}")),
+                Document(fromjson("{_id: 5, a: {c: 1}}")),
+                Document(fromjson("{_id: 6, a: 'x'}")),
+                Document(fromjson("{_id: 7, a: 4}")),
+                Document(fromjson("{_id: 8, a: [2, 2]}"))};
+    }
+
+    deque<DocumentSource::GetNextResult> foreignDocs() {
+        return {Document(fromjson("{_id: 0, b: 1}")),
+                Document(fromjson("{_id: 1, b: [1, 2]}")),
+                Document(fromjson("{_id: 2, b: null}")),
+                Document(fromjson("{_id: 3}")),
+                Document(fromjson("{_id: 4, b: [[1], 3]}")),
+                Document(fromjson("{_id: 5, b: 'x'}")),
+                Document(fromjson("{_id: 6, b: 1.0}")),
+                Document(fromjson("{_id: 7, b: {c: 1}}")),
+                Document(fromjson("{_id: 8, b: [null, 2]}"))};
+    }
+};
+
+TEST_F(DocumentSourceLookUpHashJoinTest, ShouldMatchNestedLoopResults) {
+    assertHashJoinMatchesNestedLoop(localDocs(), foreignDocs(), "a", "b");
+}
+
+TEST_F(DocumentSourceLookUpHashJoinTest, ShouldMatchNestedLoopResultsOnDottedForeignField) {
+    deque<DocumentSource::GetNextResult> localDocs{Document(fromjson("{a: 1}")),
+                                                   Document(fromjson("{a: 2}")),
+                                                   Document(fromjson("{a: null}")),
+                                                   Document(fromjson("{a: [1, 3]}"))};
+    deque<DocumentSource::GetNextResult> foreignDocs{
+        Document(fromjson("{_id: 0, x: [{y: 1}, {y: 2}]}")),
+        Document(fromjson("{_id: 1, x: {y: 1}}")),
+        Document(fromjson("{_id: 2, x: 5}")),
+        Document(fromjson("{_id: 3, x: [1]}")),
+        Document(fromjson("{_id: 4, x: [{z: 1}]}")),
+        Document(fromjson("{_id: 5}")),
+        Document(fromjson("{_id: 6, x: [[{y: 1}]]}")),
+        Document(fromjson("{_id: 7, x: {y: [3, [1]]}}"))};
+    assertHashJoinMatchesNestedLoop(localDocs, foreignDocs, "a", "x.y");
+}
+
+TEST_F(DocumentSourceLookUpHashJoinTest, ShouldOrderMatchesAsNestedLoopDoesInBothModes) {
+    // Each local document has several keys, listed out of order, so that its matches for the
+    // different keys interleave in the foreign collection.
+    deque<DocumentSource::GetNextResult> localDocs{Document(fromjson("{_id: 0, a: [3, 1, 2]}")),
+                                                   Document(fromjson("{_id: 1, a: [2, 3]}")),
+                                                   Document(fromjson("{_id: 2, a: 1}")),
+                                                   Document(fromjson("{_id: 3, a: [4, 4, 0]}"))};
+    deque<DocumentSource::GetNextResult> foreignDocs;
+    for (int i = 0; i < 40; ++i) {
+        if (i % 3 == 0) {
+            foreignDocs.push_back(
+                Document{{"_id", i}, {"b", vector<Value>{Value(i % 5), Value(2)}}});
+        } else {
+            foreignDocs.push_back(Document{{"_id", i}, {"b", (i * 7) % 5}});
+        }
+    }
+
+    auto results = runLookUp(true, localDocs, foreignDocs, "a", "b");
+    ASSERT_EQ(results.size(), 4U);
+    for (auto&& result : results) {
+        auto joined = result["joined"].getArray();
+        ASSERT_FALSE(joined.empty());
+        for (size_t i = 1; i < joined.size(); ++i) {
+            ASSERT_LT(joined[i - 1]["_id"].getInt(), joined[i]["_id"].getInt());
+        }
+    }
+    assertHashJoinMatchesNestedLoop(localDocs, foreignDocs, "a", "b");
+
+    // A limit which holds only a few foreign documents spills the join, and spreads the matches
+    // for each local document over several hash ranges.
+    unittest::TempDir tempDir("DocumentSourceLookUpHashJoinTest");
+    getExpCtx()->tempDir = tempDir.path();
+    getExpCtx()->allowDiskUse = true;
+    internalDocumentSourceLookupHashJoinMaxMemoryBytes.store(200);
+    assertHashJoinMatchesNestedLoop(localDocs, foreignDocs, "a", "b", true);
+}
+
+TEST_F(DocumentSourceLookUpHashJoinTest, ShouldFallBackToNestedLoopIfMemoryExceededWithoutDiskUse) {
+    internalDocumentSourceLookupHashJoinMaxMemoryBytes.store(1);
+    getExpCtx()->allowDiskUse = false;
+    assertHashJoinMatchesNestedLoop(localDocs(), foreignDocs(), "a", "b");
+}
+
+TEST_F(DocumentSourceLookUpHashJoinTest, ShouldSpillIfMemoryExceededWithDiskUse) {
+    unittest::TempDir tempDir("DocumentSourceLookUpHashJoinTest");
+    getExpCtx()->tempDir = tempDir.path();
+    getExpCtx()->allowDiskUse = true;
+    internalDocumentSourceLookupHashJoinMaxMemoryBytes.store(1);
+    assertHashJoinMatchesNestedLoop(localDocs(), foreignDocs(), "a", "b", true);
+}
+
+TEST_F(DocumentSourceLookUpHashJoinTest, ShouldPropagatePausesWhileSpilled) {
+    unittest::TempDir tempDir("DocumentSourceLookUpHashJoinTest");
+    auto expCtx = getExpCtx();
+    expCtx->tempDir = tempDir.path();
+    expCtx->allowDiskUse = true;
+    internalDocumentSourceLookupHashJoinMaxMemoryBytes.store(1);
+    internalDocumentSourceLookupUseHashJoin.store(true);
+
+    NamespaceString fromNs("test", "foreign");
+    expCtx->setResolvedNamespace_forTest(fromNs, {fromNs, std::vector<BSONObj>{}});
+    expCtx->mongoProcessInterface = std::make_shared<MockMongoInterface>(
+        deque<DocumentSource::GetNextResult>{Document{{"_id", 0}}, Document{{"_id", 1}}});
+
+    auto lookupSpec = Document{{"$lookup",
+                                Document{{"from", fromNs.coll()},
+                                         {"localField", "foreignId"_sd},
+                                         {"foreignField", "_id"_sd},
+                                         {"as", "foreignDocs"_sd}}}}
+                          .toBson();
+    auto lookup = DocumentSourceLookUp::createFromBson(lookupSpec.firstElement(), expCtx);
+    auto mockLocalSource =
+        DocumentSourceMock::create({Document{{"foreignId", 1}},
+                                    DocumentSource::GetNextResult::makePauseExecution(),
+                                    Document{{"foreignId", 0}}});
+    lookup->setSource(mockLocalSource.get());
+
+    // The spilled join cannot produce any output until it has seen all of its input.
+    ASSERT_TRUE(lookup->getNext().isPaused());
+
+    auto next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(
+        next.releaseDocument(),
+        (Document{{"foreignId", 1}, {"foreignDocs", vector<Value>{Value(Document{{"_id", 1}})}}}));
+
+    next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(
+        next.releaseDocument(),
+        (Document{{"foreignId", 0}, {"foreignDocs", vector<Value>{Value(Document{{"_id", 0}})}}}));
+
+    ASSERT_TRUE(lookup->getNext().isEOF());
+    ASSERT_TRUE(lookup->getNext().isEOF());
+    ASSERT_TRUE(lookup->usedDisk());
+    lookup->dispose();
+}
+
 }  // namespace
 }  // namespace mongo
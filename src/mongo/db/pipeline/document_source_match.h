@@ -50,6 +50,11 @@ public:
 
     const char* getSourceName() const override;
 
+    GetModPathsReturn getModifiedPaths() const final {
+        // A $match does not modify any paths.
+        return {GetModPathsReturn::Type::kFiniteSet, std::set<std::string>{}, {}};
+    }
+
     StageConstraints constraints(Pipeline::SplitState pipeState) const override {
         return {StreamType::kStreaming,
                 PositionRequirement::kNone,
@@ -30,16 +30,21 @@
 
 #include "mongo/db/pipeline/document_source_sort.h"
 
+#include <algorithm>
+
 #include "mongo/db/jsobj.h"
+#include "mongo/db/matcher/expression_algo.h"
 #include "mongo/db/pipeline/document.h"
 #include "mongo/db/pipeline/document_path_support.h"
 #include "mongo/db/pipeline/document_source_merge_cursors.h"
+#include "mongo/db/pipeline/document_source_single_document_transformation.h"
 #include "mongo/db/pipeline/document_source_skip.h"
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/expression_context.h"
 #include "mongo/db/pipeline/lite_parsed_document_source.h"
 #include "mongo/db/pipeline/value.h"
 #include "mongo/db/query/collation/collation_index_key.h"
+#include "mongo/db/query/query_knobs.h"
 
 namespace mongo {
 
@@ -207,15 +212,63 @@ Pipeline::SourceContainer::iterator DocumentSourceSort::doOptimizeAt(
             sortItr = std::next(itr);
             skipSum = 0;
         } else if (!nextStage->constraints().canSwapWithLimit) {
-            return std::next(itr);
+            break;
         } else {
             ++sortItr;
         }
     }
 
+    // A top-k sort only needs to see the documents which a preceding $project or $addFields would
+    // transform, so it can go first if the transformation leaves the sort key alone. This both
+    // saves transforming documents which the limit discards and may bring the $sort to the front
+    // of the pipeline, where the query system can perform it.
+    if (_limitSrc && itr != container->begin()) {
+        auto prevItr = std::prev(itr);
+        auto transformation =
+            dynamic_cast<DocumentSourceSingleDocumentTransformation*>(prevItr->get());
+        if (transformation && !modifiesSortKey(transformation->getModifiedPaths())) {
+            std::swap(*prevItr, *itr);
+            return prevItr;
+        }
+    }
+
     return std::next(itr);
 }
 
+bool DocumentSourceSort::modifiesSortKey(const GetModPathsReturn& modPaths) const {
+    for (auto&& keyPart : _sortPattern) {
+        if (!keyPart.fieldPath) {
+            // A $meta sort depends on metadata rather than any path.
+            return true;
+        }
+
+        const auto& sortPath = keyPart.fieldPath->fullPath();
+        switch (modPaths.type) {
+            case GetModPathsReturn::Type::kFiniteSet:
+                for (auto&& path : modPaths.paths) {
+                    if (path == sortPath || expression::isPathPrefixOf(path, sortPath) ||
+                        expression::isPathPrefixOf(sortPath, path)) {
+                        return true;
+                    }
+                }
+                break;
+            case GetModPathsReturn::Type::kAllExcept:
+                if (std::none_of(modPaths.paths.begin(),
+                                 modPaths.paths.end(),
+                                 [&](const std::string& path) {
+                                     return path == sortPath ||
+                                         expression::isPathPrefixOf(path, sortPath);
+                                 })) {
+                    return true;
+                }
+                break;
+            default:
+                return true;
+        }
+    }
+    return false;
+}
+
 DepsTracker::State DocumentSourceSort::getDependencies(DepsTracker* deps) const {
     for (auto&& keyPart : _sortPattern) {
         if (keyPart.expression) {
@@ -328,6 +381,9 @@ SortOptions DocumentSourceSort::makeSortOptions() const {
     if (pExpCtx->allowDiskUse && !pExpCtx->inMongos) {
         opts.extSortAllowed = true;
         opts.tempDir = pExpCtx->tempDir;
+        opts.runGenerationThreads = internalSorterRunGenerationThreads.load();
+        opts.maxMergeFanIn = internalSorterMaxMergeFanIn.load();
+        opts.spillCompressor = *SortOptions::parseCompressor(internalSorterSpillCompressor);
     }
 
     return opts;
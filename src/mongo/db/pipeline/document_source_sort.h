@@ -154,7 +154,8 @@ public:
 
 protected:
     /**
-     * Attempts to absorb a subsequent $limit stage so that it an perform a top-k sort.
+     * Attempts to absorb a subsequent $limit stage so that it an perform a top-k sort. A top-k sort
+     * then moves ahead of a preceding $project or $addFields which does not modify its sort key.
      */
     Pipeline::SourceContainer::iterator doOptimizeAt(Pipeline::SourceContainer::iterator itr,
                                                      Pipeline::SourceContainer* container) final;
@@ -188,6 +189,12 @@ private:
 
     explicit DocumentSourceSort(const boost::intrusive_ptr<ExpressionContext>& pExpCtx);
 
+    /**
+     * Returns true if a stage which modifies the paths described by 'modPaths' may change the sort
+     * key of a document.
+     */
+    bool modifiesSortKey(const GetModPathsReturn& modPaths) const;
+
     Value serialize(boost::optional<ExplainOptions::Verbosity> explain = boost::none) const final {
         MONGO_UNREACHABLE;  // Should call serializeToArray instead.
     }
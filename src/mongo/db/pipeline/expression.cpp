@@ -263,7 +263,13 @@ const char* ExpressionAbs::getOpName() const {
 
 /* ------------------------- ExpressionAdd ----------------------------- */
 
-Value ExpressionAdd::evaluate(const Document& root) const {
+namespace {
+/**
+ * Adds up the 'n' operands returned by 'getOperand', which is only called for each operand once
+ * the ones before it have been added.
+ */
+template <typename GetOperand>
+Value addOperands(size_t n, const GetOperand& getOperand) {
     // We'll try to return the narrowest possible result value while avoiding overflow, loss
     // of precision due to intermediate rounding or implicit use of decimal types. To do that,
     // compute a compensated sum for non-decimal values and a separate decimal sum for decimal
@@ -273,9 +279,8 @@ Value ExpressionAdd::evaluate(const Document& root) const {
     BSONType totalType = NumberInt;
     bool haveDate = false;
 
-    const size_t n = vpOperand.size();
     for (size_t i = 0; i < n; ++i) {
-        Value val = vpOperand[i]->evaluate(root);
+        Value val = getOperand(i);
 
         switch (val.getType()) {
             case NumberDecimal:
@@ -337,6 +342,15 @@ Value ExpressionAdd::evaluate(const Document& root) const {
             massert(16417, "$add resulted in a non-numeric type", false);
     }
 }
+}  // namespace
+
+Value ExpressionAdd::evaluate(const Document& root) const {
+    return addOperands(vpOperand.size(), [&](size_t i) { return vpOperand[i]->evaluate(root); });
+}
+
+Value ExpressionAdd::apply(const Value* operands, size_t numOperands) {
+    return addOperands(numOperands, [&](size_t i) { return operands[i]; });
+}
 
 REGISTER_EXPRESSION(add, ExpressionAdd::parse);
 const char* ExpressionAdd::getOpName() const {
@@ -812,9 +826,14 @@ static const CmpLookup cmpLookup[7] = {
 Value ExpressionCompare::evaluate(const Document& root) const {
     Value pLeft(vpOperand[0]->evaluate(root));
     Value pRight(vpOperand[1]->evaluate(root));
+    return apply(pLeft, pRight);
+}
 
-    int cmp = getExpressionContext()->getValueComparator().compare(pLeft, pRight);
+Value ExpressionCompare::apply(const Value& lhs, const Value& rhs) const {
+    return applyToComparison(getExpressionContext()->getValueComparator().compare(lhs, rhs));
+}
 
+Value ExpressionCompare::applyToComparison(int cmp) const {
     // Make cmp one of 1, 0, or -1.
     if (cmp == 0) {
         // leave as 0
@@ -1779,7 +1798,10 @@ void ExpressionDateToString::_doAddDependencies(DepsTracker* deps) const {
 Value ExpressionDivide::evaluate(const Document& root) const {
     Value lhs = vpOperand[0]->evaluate(root);
     Value rhs = vpOperand[1]->evaluate(root);
+    return apply(lhs, rhs);
+}
 
+Value ExpressionDivide::apply(const Value& lhs, const Value& rhs) {
     auto assertNonZero = [](bool nonZero) { uassert(16608, "can't $divide by zero", nonZero); };
 
     if (lhs.numeric() && rhs.numeric()) {
@@ -2042,6 +2064,23 @@ Value ExpressionFieldPath::evaluate(const Document& root) const {
     }
 }
 
+Value ExpressionFieldPath::evaluateFromTopLevelField(const Value& topLevelField) const {
+    invariant(isRootFieldPath() && _fieldPath.getPathLength() > 1);
+
+    // Mirrors the first step of evaluatePath(1, root).
+    if (_fieldPath.getPathLength() == 2)
+        return topLevelField;
+
+    switch (topLevelField.getType()) {
+        case Object:
+            return evaluatePath(2, topLevelField.getDocument());
+        case Array:
+            return evaluatePathArray(2, topLevelField);
+        default:
+            return Value();
+    }
+}
+
 Value ExpressionFieldPath::serialize(bool explain) const {
     if (_fieldPath.getFieldName(0) == "CURRENT" && _fieldPath.getPathLength() > 1) {
         // use short form for "$$CURRENT.foo" but not just "$$CURRENT"
@@ -2547,7 +2586,13 @@ const char* ExpressionMod::getOpName() const {
 
 /* ------------------------- ExpressionMultiply ----------------------------- */
 
-Value ExpressionMultiply::evaluate(const Document& root) const {
+namespace {
+/**
+ * Multiplies together the 'n' operands returned by 'getOperand', which is only called for each
+ * operand once the ones before it have been multiplied.
+ */
+template <typename GetOperand>
+Value multiplyOperands(size_t n, const GetOperand& getOperand) {
     /*
       We'll try to return the narrowest possible result value.  To do that
       without creating intermediate Values, do the arithmetic for double
@@ -2560,9 +2605,8 @@ Value ExpressionMultiply::evaluate(const Document& root) const {
 
     BSONType productType = NumberInt;
 
-    const size_t n = vpOperand.size();
     for (size_t i = 0; i < n; ++i) {
-        Value val = vpOperand[i]->evaluate(root);
+        Value val = getOperand(i);
 
         if (val.numeric()) {
             BSONType oldProductType = productType;
@@ -2602,6 +2646,16 @@ Value ExpressionMultiply::evaluate(const Document& root) const {
     else
         massert(16418, "$multiply resulted in a non-numeric type", false);
 }
+}  // namespace
+
+Value ExpressionMultiply::evaluate(const Document& root) const {
+    return multiplyOperands(vpOperand.size(),
+                            [&](size_t i) { return vpOperand[i]->evaluate(root); });
+}
+
+Value ExpressionMultiply::apply(const Value* operands, size_t numOperands) {
+    return multiplyOperands(numOperands, [&](size_t i) { return operands[i]; });
+}
 
 REGISTER_EXPRESSION(multiply, ExpressionMultiply::parse);
 const char* ExpressionMultiply::getOpName() const {
@@ -4266,7 +4320,10 @@ const char* ExpressionStrLenCP::getOpName() const {
 Value ExpressionSubtract::evaluate(const Document& root) const {
     Value lhs = vpOperand[0]->evaluate(root);
     Value rhs = vpOperand[1]->evaluate(root);
+    return apply(lhs, rhs);
+}
 
+Value ExpressionSubtract::apply(const Value& lhs, const Value& rhs) {
     BSONType diffType = Value::getWidestNumeric(rhs.getType(), lhs.getType());
 
     if (diffType == NumberDecimal) {
@@ -670,6 +670,12 @@ public:
         : ExpressionVariadic<ExpressionAdd>(expCtx) {}
 
     Value evaluate(const Document& root) const final;
+
+    /**
+     * Returns the sum of the 'numOperands' already evaluated operands starting at 'operands'.
+     */
+    static Value apply(const Value* operands, size_t numOperands);
+
     const char* getOpName() const final;
 
     bool isAssociative() const final {
@@ -811,6 +817,18 @@ public:
         : ExpressionFixedArity<ExpressionCompare, 2>(expCtx), cmpOp(cmpOp) {}
 
     Value evaluate(const Document& root) const final;
+
+    /**
+     * Compares the already evaluated operands 'lhs' and 'rhs'.
+     */
+    Value apply(const Value& lhs, const Value& rhs) const;
+
+    /**
+     * Returns the result of this comparison given the result 'cmp' of comparing its operands, as
+     * returned by ValueComparator::compare().
+     */
+    Value applyToComparison(int cmp) const;
+
     const char* getOpName() const final;
 
     CmpOp getOp() const {
@@ -1062,6 +1080,7 @@ public:
         : ExpressionFixedArity<ExpressionDivide, 2>(expCtx) {}
 
     Value evaluate(const Document& root) const final;
+    static Value apply(const Value& lhs, const Value& rhs);
     const char* getOpName() const final;
 };
 
@@ -1112,6 +1131,14 @@ public:
         return _fieldPath;
     }
 
+    /**
+     * Returns what evaluate() would, given only the value of the path's top-level field in the root
+     * document. This lets callers which hold the fields of their input apart, such as in a
+     * DocumentBatch, evaluate the path without building a Document. Only valid for a path below
+     * ROOT.
+     */
+    Value evaluateFromTopLevelField(const Value& topLevelField) const;
+
     ComputedPaths getComputedPaths(const std::string& exprFieldPath,
                                    Variables::Id renamingVar) const final;
 
@@ -1432,6 +1459,12 @@ public:
         : ExpressionVariadic<ExpressionMultiply>(expCtx) {}
 
     Value evaluate(const Document& root) const final;
+
+    /**
+     * Returns the product of the 'numOperands' already evaluated operands starting at 'operands'.
+     */
+    static Value apply(const Value* operands, size_t numOperands);
+
     const char* getOpName() const final;
 
     bool isAssociative() const final {
@@ -1783,6 +1816,7 @@ public:
         : ExpressionFixedArity<ExpressionSubtract, 2>(expCtx) {}
 
     Value evaluate(const Document& root) const final;
+    static Value apply(const Value& lhs, const Value& rhs);
     const char* getOpName() const final;
 };
 
@@ -0,0 +1,342 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/pipeline/expression_compiled.h"
+
+#include <cmath>
+
+#include "mongo/db/query/query_knobs.h"
+
+namespace mongo {
+
+using boost::intrusive_ptr;
+
+namespace {
+/**
+ * Returns -1, 0 or 1 as 'lhs' is less than, equal to or greater than 'rhs'.
+ */
+template <typename T>
+int compareNumbers(T lhs, T rhs) {
+    return (lhs > rhs) - (lhs < rhs);
+}
+
+bool isIntOrDouble(BSONType type) {
+    return type == NumberInt || type == NumberDouble;
+}
+}  // namespace
+
+intrusive_ptr<Expression> ExpressionCompiled::compile(
+    const intrusive_ptr<ExpressionContext>& expCtx, const intrusive_ptr<Expression>& expression) {
+    // Constants and field paths are as cheap to evaluate directly.
+    if (!internalPipelineCompileExpressions.load() ||
+        dynamic_cast<ExpressionCompiled*>(expression.get()) ||
+        dynamic_cast<ExpressionConstant*>(expression.get()) ||
+        dynamic_cast<ExpressionFieldPath*>(expression.get())) {
+        return expression;
+    }
+
+    intrusive_ptr<ExpressionCompiled> compiled(new ExpressionCompiled(expCtx, expression));
+    if (!compiled->compileInto(expression.get(), compiled->allocateRegister())) {
+        return expression;
+    }
+    compiled->_registers.resize(compiled->_numRegisters);
+    return compiled;
+}
+
+ExpressionCompiled::ExpressionCompiled(const intrusive_ptr<ExpressionContext>& expCtx,
+                                       const intrusive_ptr<Expression>& original)
+    : Expression(expCtx), _original(original) {}
+
+size_t ExpressionCompiled::emit(
+    OpCode opCode, uint32_t dst, uint32_t src, uint32_t arg, const Expression* expression) {
+    _program.push_back({opCode, dst, src, arg, expression});
+    return _program.size() - 1;
+}
+
+boost::optional<uint32_t> ExpressionCompiled::compileOperands(
+    const ExpressionVector& operands, std::vector<size_t>* slowPathJumps) {
+    // Allocate all of the operands' registers before compiling any of them, so they are adjacent.
+    const uint32_t first = _numRegisters;
+    for (size_t i = 0; i < operands.size(); ++i) {
+        allocateRegister();
+    }
+
+    for (size_t i = 0; i < operands.size(); ++i) {
+        if (!compileInto(operands[i].get(), first + i)) {
+            return boost::none;
+        }
+        if (slowPathJumps && i + 1 < operands.size()) {
+            slowPathJumps->push_back(emit(OpCode::kJumpUnlessNumeric, 0, first + i));
+        }
+    }
+    return first;
+}
+
+bool ExpressionCompiled::compileInto(const Expression* expression, uint32_t dst) {
+    if (auto constant = dynamic_cast<const ExpressionConstant*>(expression)) {
+        _constants.push_back(constant->getValue());
+        emit(OpCode::kLoadConstant, dst, 0, _constants.size() - 1);
+        return true;
+    }
+
+    if (auto fieldPath = dynamic_cast<const ExpressionFieldPath*>(expression)) {
+        const bool isTopLevelField =
+            fieldPath->isRootFieldPath() && fieldPath->getFieldPath().getPathLength() == 2;
+        emit(isTopLevelField ? OpCode::kLoadField : OpCode::kEvaluate, dst, 0, 0, fieldPath);
+        return true;
+    }
+
+    // $add and $multiply stop at the first operand which is not a number, such as a null, without
+    // evaluating the rest. If any operand but the last is not a number, the original expression is
+    // evaluated instead, as that is rare and this keeps the results and errors the same.
+    const bool isAdd = dynamic_cast<const ExpressionAdd*>(expression);
+    if (isAdd || dynamic_cast<const ExpressionMultiply*>(expression)) {
+        auto&& operands = static_cast<const ExpressionNary*>(expression)->getOperandList();
+        std::vector<size_t> slowPathJumps;
+        auto first = compileOperands(operands, &slowPathJumps);
+        if (!first) {
+            return false;
+        }
+        emit(isAdd ? OpCode::kAdd : OpCode::kMultiply, dst, *first, operands.size());
+        if (!slowPathJumps.empty()) {
+            const size_t jumpToEnd = emit(OpCode::kJump, 0);
+            for (auto&& jump : slowPathJumps) {
+                patchJump(jump);
+            }
+            emit(OpCode::kEvaluate, dst, 0, 0, expression);
+            patchJump(jumpToEnd);
+        }
+        return true;
+    }
+
+    OpCode binaryOpCode;
+    if (dynamic_cast<const ExpressionSubtract*>(expression)) {
+        binaryOpCode = OpCode::kSubtract;
+    } else if (dynamic_cast<const ExpressionDivide*>(expression)) {
+        binaryOpCode = OpCode::kDivide;
+    } else if (dynamic_cast<const ExpressionCompare*>(expression)) {
+        binaryOpCode = OpCode::kCompare;
+    } else {
+        return compileLogical(expression, dst);
+    }
+
+    auto first = compileOperands(static_cast<const ExpressionNary*>(expression)->getOperandList());
+    if (!first) {
+        return false;
+    }
+    emit(binaryOpCode, dst, *first, 0, expression);
+    return true;
+}
+
+bool ExpressionCompiled::compileLogical(const Expression* expression, uint32_t dst) {
+    // $and and $or evaluate their operands in turn until one of them decides the result. Each
+    // operand is coerced to a bool in 'dst', so that 'dst' holds the result once the last operand
+    // has been evaluated or a jump past the end has been taken.
+    const bool isAnd = dynamic_cast<const ExpressionAnd*>(expression);
+    if (isAnd || dynamic_cast<const ExpressionOr*>(expression)) {
+        auto&& operands = static_cast<const ExpressionNary*>(expression)->getOperandList();
+        if (operands.empty()) {
+            _constants.push_back(Value(isAnd));
+            emit(OpCode::kLoadConstant, dst, 0, _constants.size() - 1);
+            return true;
+        }
+
+        std::vector<size_t> jumps;
+        for (size_t i = 0; i < operands.size(); ++i) {
+            if (!compileInto(operands[i].get(), dst)) {
+                return false;
+            }
+            emit(OpCode::kCoerceToBool, dst, dst);
+            if (i + 1 < operands.size()) {
+                jumps.push_back(emit(isAnd ? OpCode::kJumpIfFalse : OpCode::kJumpIfTrue, 0, dst));
+            }
+        }
+        for (auto&& jump : jumps) {
+            patchJump(jump);
+        }
+        return true;
+    }
+
+    if (dynamic_cast<const ExpressionNot*>(expression)) {
+        auto&& operands = static_cast<const ExpressionNary*>(expression)->getOperandList();
+        if (!compileInto(operands[0].get(), dst)) {
+            return false;
+        }
+        emit(OpCode::kNot, dst, dst);
+        return true;
+    }
+
+    if (dynamic_cast<const ExpressionCond*>(expression)) {
+        auto&& operands = static_cast<const ExpressionNary*>(expression)->getOperandList();
+        if (!compileInto(operands[0].get(), dst)) {
+            return false;
+        }
+        const size_t jumpToElse = emit(OpCode::kJumpIfFalse, 0, dst);
+        if (!compileInto(operands[1].get(), dst)) {
+            return false;
+        }
+        const size_t jumpToEnd = emit(OpCode::kJump, 0);
+        patchJump(jumpToElse);
+        if (!compileInto(operands[2].get(), dst)) {
+            return false;
+        }
+        patchJump(jumpToEnd);
+        return true;
+    }
+
+    return false;
+}
+
+Value ExpressionCompiled::evaluate(const Document& root) const {
+    Value* const registers = _registers.data();
+
+    size_t pc = 0;
+    while (pc < _program.size()) {
+        const Instruction& instruction = _program[pc++];
+        Value& dst = registers[instruction.dst];
+        const Value* const src = registers + instruction.src;
+
+        switch (instruction.opCode) {
+            case OpCode::kLoadConstant:
+                dst = _constants[instruction.arg];
+                break;
+
+            case OpCode::kLoadField:
+                dst = root[static_cast<const ExpressionFieldPath*>(instruction.expression)
+                               ->getFieldPath()
+                               .getFieldName(1)];
+                break;
+
+            case OpCode::kEvaluate:
+                dst = instruction.expression->evaluate(root);
+                break;
+
+            case OpCode::kAdd:
+                if (instruction.arg == 2) {
+                    if (src[0].getType() == NumberInt && src[1].getType() == NumberInt) {
+                        dst = Value::createIntOrLong(static_cast<long long>(src[0].getInt()) +
+                                                     src[1].getInt());
+                        break;
+                    }
+                    if (isIntOrDouble(src[0].getType()) && isIntOrDouble(src[1].getType())) {
+                        // Starting from 0.0 gives the same sign of zero as the general case.
+                        dst = Value(0.0 + src[0].coerceToDouble() + src[1].coerceToDouble());
+                        break;
+                    }
+                }
+                dst = ExpressionAdd::apply(src, instruction.arg);
+                break;
+
+            case OpCode::kMultiply:
+                if (instruction.arg == 2) {
+                    if (src[0].getType() == NumberInt && src[1].getType() == NumberInt) {
+                        dst = Value::createIntOrLong(static_cast<long long>(src[0].getInt()) *
+                                                     src[1].getInt());
+                        break;
+                    }
+                    if (isIntOrDouble(src[0].getType()) && isIntOrDouble(src[1].getType())) {
+                        dst = Value(src[0].coerceToDouble() * src[1].coerceToDouble());
+                        break;
+                    }
+                }
+                dst = ExpressionMultiply::apply(src, instruction.arg);
+                break;
+
+            case OpCode::kSubtract:
+                if (src[0].getType() == NumberInt && src[1].getType() == NumberInt) {
+                    dst = Value::createIntOrLong(static_cast<long long>(src[0].getInt()) -
+                                                 src[1].getInt());
+                } else if (isIntOrDouble(src[0].getType()) && isIntOrDouble(src[1].getType())) {
+                    dst = Value(src[0].coerceToDouble() - src[1].coerceToDouble());
+                } else {
+                    dst = ExpressionSubtract::apply(src[0], src[1]);
+                }
+                break;
+
+            case OpCode::kDivide:
+                if (isIntOrDouble(src[0].getType()) && isIntOrDouble(src[1].getType()) &&
+                    src[1].coerceToDouble() != 0.0) {
+                    dst = Value(src[0].coerceToDouble() / src[1].coerceToDouble());
+                } else {
+                    dst = ExpressionDivide::apply(src[0], src[1]);
+                }
+                break;
+
+            case OpCode::kCompare: {
+                auto compare = static_cast<const ExpressionCompare*>(instruction.expression);
+                if (src[0].getType() == NumberInt && src[1].getType() == NumberInt) {
+                    dst = compare->applyToComparison(
+                        compareNumbers(src[0].getInt(), src[1].getInt()));
+                } else if (src[0].getType() == NumberDouble && src[1].getType() == NumberDouble &&
+                           !std::isnan(src[0].getDouble()) && !std::isnan(src[1].getDouble())) {
+                    dst = compare->applyToComparison(
+                        compareNumbers(src[0].getDouble(), src[1].getDouble()));
+                } else {
+                    dst = compare->apply(src[0], src[1]);
+                }
+                break;
+            }
+
+            case OpCode::kCoerceToBool:
+                dst = Value(src->coerceToBool());
+                break;
+
+            case OpCode::kNot:
+                dst = Value(!src->coerceToBool());
+                break;
+
+            case OpCode::kJump:
+                pc = instruction.arg;
+                break;
+
+            case OpCode::kJumpIfTrue:
+                if (src->coerceToBool()) {
+                    pc = instruction.arg;
+                }
+                break;
+
+            case OpCode::kJumpIfFalse:
+                if (!src->coerceToBool()) {
+                    pc = instruction.arg;
+                }
+                break;
+
+            case OpCode::kJumpUnlessNumeric:
+                if (!src->numeric()) {
+                    pc = instruction.arg;
+                }
+                break;
+        }
+    }
+
+    return registers[0];
+}
+
+}  // namespace mongo
@@ -0,0 +1,162 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/intrusive_ptr.hpp>
+#include <boost/optional.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "mongo/db/pipeline/expression.h"
+
+namespace mongo {
+
+/**
+ * Evaluates an optimized Expression tree by running a flat program compiled from it, rather than by
+ * walking the tree with virtual calls. The program is register based: each instruction reads the
+ * results of earlier instructions from a register file and writes its own result back to it, and
+ * the arithmetic and comparison instructions have fast paths for operands of common numeric types.
+ *
+ * Only trees made up of constants, field paths, $add, $subtract, $multiply, $divide, the comparison
+ * operators, $and, $or, $not and $cond can be compiled. Everything other than evaluation is
+ * forwarded to the original tree, which the program refers to and which must not change after it
+ * has been compiled.
+ *
+ * The register file is reused by each evaluation, so an ExpressionCompiled must not be evaluated
+ * by more than one thread at a time.
+ */
+class ExpressionCompiled final : public Expression {
+public:
+    /**
+     * Returns an ExpressionCompiled which evaluates 'expression', or 'expression' itself if it
+     * contains an unsupported operator, if compiling it would not save anything, or if
+     * internalPipelineCompileExpressions is off.
+     */
+    static boost::intrusive_ptr<Expression> compile(
+        const boost::intrusive_ptr<ExpressionContext>& expCtx,
+        const boost::intrusive_ptr<Expression>& expression);
+
+    Value evaluate(const Document& root) const final;
+
+    Value serialize(bool explain) const final {
+        return _original->serialize(explain);
+    }
+
+    ComputedPaths getComputedPaths(const std::string& exprFieldPath,
+                                   Variables::Id renamingVar) const final {
+        return _original->getComputedPaths(exprFieldPath, renamingVar);
+    }
+
+    /**
+     * Returns the number of instructions in the compiled program.
+     */
+    size_t getProgramSize() const {
+        return _program.size();
+    }
+
+protected:
+    void _doAddDependencies(DepsTracker* deps) const final {
+        _original->addDependencies(deps);
+    }
+
+private:
+    enum class OpCode : uint8_t {
+        kLoadConstant,       // dst = constants[arg]
+        kLoadField,          // dst = root[name], for the path "$$ROOT.<name>" in 'expression'
+        kEvaluate,           // dst = expression->evaluate(root), for other paths and slow paths
+        kAdd,                // dst = sum of the 'arg' registers starting at src
+        kMultiply,           // dst = product of the 'arg' registers starting at src
+        kSubtract,           // dst = src - (src + 1)
+        kDivide,             // dst = src / (src + 1)
+        kCompare,            // dst = expression->apply(src, src + 1)
+        kCoerceToBool,       // dst = src.coerceToBool()
+        kNot,                // dst = !src.coerceToBool()
+        kJump,               // continue at instruction 'arg'
+        kJumpIfTrue,         // continue at instruction 'arg' if src is true
+        kJumpIfFalse,        // continue at instruction 'arg' if src is false
+        kJumpUnlessNumeric,  // continue at instruction 'arg' unless src is a number
+    };
+
+    struct Instruction {
+        OpCode opCode;
+        uint32_t dst;
+        uint32_t src;
+        uint32_t arg;
+        const Expression* expression;
+    };
+
+    ExpressionCompiled(const boost::intrusive_ptr<ExpressionContext>& expCtx,
+                       const boost::intrusive_ptr<Expression>& original);
+
+    /**
+     * Appends the instructions which evaluate 'expression' into register 'dst' to the program.
+     * Returns false if 'expression' cannot be compiled.
+     */
+    bool compileInto(const Expression* expression, uint32_t dst);
+
+    /**
+     * Compiles the boolean operators $and, $or and $not, and $cond.
+     */
+    bool compileLogical(const Expression* expression, uint32_t dst);
+
+    /**
+     * Appends the instructions which evaluate each of 'operands' into consecutive registers, and
+     * returns the first of them. If 'slowPathJumps' is non-null, a kJumpUnlessNumeric follows each
+     * operand but the last, and their indexes are added to 'slowPathJumps'.
+     */
+    boost::optional<uint32_t> compileOperands(const ExpressionVector& operands,
+                                              std::vector<size_t>* slowPathJumps = nullptr);
+
+    size_t emit(OpCode opCode,
+                uint32_t dst,
+                uint32_t src = 0,
+                uint32_t arg = 0,
+                const Expression* expression = nullptr);
+
+    uint32_t allocateRegister() {
+        return _numRegisters++;
+    }
+
+    // Points the jump at '_program[jump]' at the next instruction to be emitted.
+    void patchJump(size_t jump) {
+        _program[jump].arg = _program.size();
+    }
+
+    const boost::intrusive_ptr<Expression> _original;
+
+    std::vector<Instruction> _program;
+    std::vector<Value> _constants;
+    uint32_t _numRegisters = 0;
+
+    // The result of the program is left in the first register.
+    mutable std::vector<Value> _registers;
+};
+
+}  // namespace mongo
@@ -0,0 +1,198 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <cmath>
+#include <limits>
+
+#include "mongo/bson/bsonmisc.h"
+#include "mongo/bson/json.h"
+#include "mongo/db/pipeline/document.h"
+#include "mongo/db/pipeline/document_value_test_util.h"
+#include "mongo/db/pipeline/expression.h"
+#include "mongo/db/pipeline/expression_compiled.h"
+#include "mongo/db/pipeline/expression_context_for_test.h"
+#include "mongo/db/query/query_knobs.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+using boost::intrusive_ptr;
+
+class ExpressionCompiledTest : public unittest::Test {
+protected:
+    void setUp() override {
+        internalPipelineCompileExpressions.store(true);
+    }
+
+    void tearDown() override {
+        internalPipelineCompileExpressions.store(false);
+    }
+
+    intrusive_ptr<Expression> parse(const std::string& json) {
+        const BSONObj spec = fromjson("{expr: " + json + "}");
+        return Expression::parseOperand(_expCtx, spec.firstElement(), _expCtx->variablesParseState)
+            ->optimize();
+    }
+
+    /**
+     * Checks that 'json' compiles, and that the compiled expression gives the same result, or
+     * fails with the same error, as the original on each of a range of inputs.
+     */
+    void assertCompiledMatchesOriginal(const std::string& json) {
+        auto original = parse(json);
+        auto compiled = ExpressionCompiled::compile(_expCtx, original);
+        ASSERT_TRUE(dynamic_cast<ExpressionCompiled*>(compiled.get())) << json;
+        ASSERT_VALUE_EQ(compiled->serialize(false), original->serialize(false));
+
+        for (auto&& input : inputs()) {
+            boost::optional<Value> expected;
+            int expectedCode = 0;
+            try {
+                expected = original->evaluate(input);
+            } catch (const DBException& ex) {
+                expectedCode = ex.code();
+            }
+
+            try {
+                Value actual = compiled->evaluate(input);
+                ASSERT_TRUE(expected) << json << " on " << input.toString() << " gave "
+                                      << actual.toString() << " rather than error "
+                                      << expectedCode;
+                ASSERT_EQ(actual.getType(), expected->getType()) << json << " on "
+                                                                 << input.toString();
+                ASSERT_VALUE_EQ(actual, *expected);
+                if (actual.getType() == NumberDouble) {
+                    ASSERT_EQ(std::signbit(actual.getDouble()), std::signbit(expected->getDouble()))
+                        << json << " on " << input.toString();
+                }
+            } catch (const DBException& ex) {
+                ASSERT_EQ(ex.code(), expectedCode) << json << " on " << input.toString();
+            }
+        }
+    }
+
+    static std::vector<Document> inputs() {
+        std::vector<BSONObj> numbers = {BSON("" << 3),
+                                        BSON("" << -7),
+                                        BSON("" << 0),
+                                        BSON("" << std::numeric_limits<int>::max()),
+                                        BSON("" << 5LL),
+                                        BSON("" << std::numeric_limits<long long>::max()),
+                                        BSON("" << 2.5),
+                                        BSON("" << -0.0),
+                                        BSON("" << 0.0),
+                                        BSON("" << std::numeric_limits<double>::quiet_NaN()),
+                                        BSON("" << std::numeric_limits<double>::infinity()),
+                                        BSON("" << Decimal128("1.5")),
+                                        BSON("" << BSONNULL),
+                                        BSON(""
+                                             << "str"),
+                                        BSON("" << Date_t::fromMillisSinceEpoch(1000)),
+                                        BSON("" << true),
+                                        BSONObj()};
+
+        std::vector<Document> inputs;
+        for (auto&& a : numbers) {
+            for (auto&& b : numbers) {
+                MutableDocument doc;
+                if (!a.isEmpty()) {
+                    doc.addField("a", Value(a.firstElement()));
+                }
+                if (!b.isEmpty()) {
+                    doc.addField("b", Value(b.firstElement()));
+                }
+                doc.addField("sub", Value(Document{{"c", 4}, {"d", 1.5}}));
+                inputs.push_back(doc.freeze());
+            }
+        }
+        return inputs;
+    }
+
+    intrusive_ptr<ExpressionContextForTest> _expCtx = new ExpressionContextForTest();
+};
+
+TEST_F(ExpressionCompiledTest, ArithmeticMatchesTreeEvaluation) {
+    assertCompiledMatchesOriginal("{$add: ['$a', '$b']}");
+    assertCompiledMatchesOriginal("{$add: ['$a', '$b', '$sub.c', 1]}");
+    assertCompiledMatchesOriginal("{$add: ['$a', {$divide: ['$b', 0]}]}");
+    assertCompiledMatchesOriginal("{$subtract: ['$a', '$b']}");
+    assertCompiledMatchesOriginal("{$multiply: ['$a', '$b']}");
+    assertCompiledMatchesOriginal("{$multiply: ['$a', '$b', '$sub.d']}");
+    assertCompiledMatchesOriginal("{$divide: ['$a', '$b']}");
+    assertCompiledMatchesOriginal(
+        "{$subtract: [{$multiply: ['$a', 2]}, {$divide: [{$add: ['$b', '$sub.c']}, '$a']}]}");
+}
+
+TEST_F(ExpressionCompiledTest, ComparisonsMatchTreeEvaluation) {
+    for (auto&& op : {"$eq", "$ne", "$gt", "$gte", "$lt", "$lte", "$cmp"}) {
+        assertCompiledMatchesOriginal(std::string("{") + op + ": ['$a', '$b']}");
+    }
+    assertCompiledMatchesOriginal("{$gt: [{$add: ['$a', 1]}, '$b']}");
+}
+
+TEST_F(ExpressionCompiledTest, LogicalOperatorsMatchTreeEvaluation) {
+    assertCompiledMatchesOriginal("{$and: ['$a', '$b']}");
+    assertCompiledMatchesOriginal("{$or: ['$a', '$b', {$gt: ['$sub.c', 3]}]}");
+    assertCompiledMatchesOriginal("{$not: ['$a']}");
+    assertCompiledMatchesOriginal("{$cond: [{$lt: ['$a', '$b']}, '$a', {$add: ['$b', 1]}]}");
+    assertCompiledMatchesOriginal("{$and: [{$gt: ['$a', 0]}, {$divide: ['$b', '$a']}]}");
+    assertCompiledMatchesOriginal("{$or: [{$eq: ['$a', 0]}, {$divide: ['$b', '$a']}]}");
+}
+
+TEST_F(ExpressionCompiledTest, ShouldNotCompileUnsupportedExpressions) {
+    for (auto&& json : {"'$a'",
+                        "{$const: 1}",
+                        "{$concat: ['$a', 'x']}",
+                        "{$add: ['$a', {$abs: '$b'}]}",
+                        "{$cond: [true, '$a', {$size: '$b'}]}"}) {
+        auto expression = parse(json);
+        ASSERT_EQ(ExpressionCompiled::compile(_expCtx, expression), expression) << json;
+    }
+}
+
+TEST_F(ExpressionCompiledTest, ShouldNotCompileWhenDisabled) {
+    internalPipelineCompileExpressions.store(false);
+
+    auto expression = parse("{$add: ['$a', 1]}");
+    ASSERT_EQ(ExpressionCompiled::compile(_expCtx, expression), expression);
+}
+
+TEST_F(ExpressionCompiledTest, ShouldReportDependenciesOfOriginal) {
+    auto compiled = ExpressionCompiled::compile(_expCtx, parse("{$add: ['$a', '$sub.c']}"));
+    DepsTracker deps;
+    compiled->addDependencies(&deps);
+    ASSERT_EQ(deps.fields.size(), 2UL);
+    ASSERT_EQ(deps.fields.count("a"), 1UL);
+    ASSERT_EQ(deps.fields.count("sub.c"), 1UL);
+}
+
+}  // namespace
+}  // namespace mongo
@@ -0,0 +1,418 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/pipeline/lookup_hash_join.h"
+
+#include <algorithm>
+
+#include "mongo/db/matcher/expression_leaf.h"
+#include "mongo/db/matcher/path_internal.h"
+#include "mongo/db/pipeline/document_path_support.h"
+#include "mongo/stdx/memory.h"
+
+namespace mongo {
+
+namespace {
+
+constexpr StringData kKeyFieldName = "k"_sd;
+
+/**
+ * Orders spilled entries by their sort keys, which are arrays of integers and so need no collator.
+ */
+class SpillComparator {
+public:
+    int operator()(const Sorter<Value, Document>::Data& lhs,
+                   const Sorter<Value, Document>::Data& rhs) const {
+        return Value::compare(lhs.first, rhs.first, nullptr);
+    }
+};
+
+Value makeSortKey(long long first, long long second) {
+    return Value(std::vector<Value>{Value(first), Value(second)});
+}
+
+long long getSortKeyPart(const Value& sortKey, size_t i) {
+    return sortKey.getArray()[i].getLong();
+}
+
+template <typename Iterator, typename Data>
+void advanceIterator(Iterator* it, boost::optional<Data>* next) {
+    if (it->more()) {
+        *next = it->next();
+    } else {
+        *next = boost::none;
+    }
+}
+
+}  // namespace
+
+/**
+ * The {<foreignField>: {$eq: <key>}} query which the nested-loop $lookup issues for a single key,
+ * except that the key can be replaced. This allows the join to verify every candidate with the
+ * one expression, rather than building and parsing a $match for each probe.
+ */
+class LookupHashJoin::KeyMatcher final : public ComparisonMatchExpression {
+public:
+    KeyMatcher(StringData path, const CollatorInterface* collator)
+        : ComparisonMatchExpression(EQ, path, kNullKey.firstElement()) {
+        setCollator(collator);
+    }
+
+    /**
+     * Makes this expression match the documents which an $eq on 'key' matches.
+     */
+    void setKey(const Value& key) {
+        BSONObjBuilder bob;
+        key.addToBsonObj(&bob, "");
+        _key = bob.obj();
+        _rhs = _key.firstElement();
+        uassert(ErrorCodes::BadValue,
+                "cannot compare to undefined",
+                _rhs.type() != BSONType::Undefined);
+    }
+
+    StringData name() const final {
+        return EqualityMatchExpression::kName;
+    }
+
+    std::unique_ptr<MatchExpression> shallowClone() const final {
+        auto clone = stdx::make_unique<EqualityMatchExpression>(path(), _rhs);
+        clone->setCollator(_collator);
+        return std::move(clone);
+    }
+
+private:
+    static const BSONObj kNullKey;
+
+    // Owns the element which '_rhs' refers to.
+    BSONObj _key;
+};
+
+const BSONObj LookupHashJoin::KeyMatcher::kNullKey = BSON("" << BSONNULL);
+
+LookupHashJoin::LookupHashJoin(const boost::intrusive_ptr<ExpressionContext>& fromExpCtx,
+                               FieldPath localField,
+                               FieldPath foreignField,
+                               size_t maxMemoryUsageBytes,
+                               bool allowDiskUse,
+                               std::string tempDir)
+    : _fromExpCtx(fromExpCtx),
+      _localField(std::move(localField)),
+      _foreignField(std::move(foreignField)),
+      _maxMemoryUsageBytes(maxMemoryUsageBytes),
+      _allowDiskUse(allowDiskUse),
+      _tempDir(std::move(tempDir)),
+      _table(_fromExpCtx->getValueComparator()),
+      _keyMatcher(stdx::make_unique<KeyMatcher>(_foreignField.fullPath(),
+                                                _fromExpCtx->getCollator())) {}
+
+LookupHashJoin::~LookupHashJoin() = default;
+
+bool LookupHashJoin::canJoinOn(const FieldPath& foreignField) {
+    // A numeric path component may address an array element by position, which the keys
+    // extracted by visitForeignKeys() do not account for.
+    for (size_t i = 0; i < foreignField.getPathLength(); ++i) {
+        if (isAllDigits(foreignField.getFieldName(i))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool LookupHashJoin::addForeignDocument(const Document& foreignDoc) {
+    invariant(!_abandoned);
+    invariant(_numLocalDocs == 0);
+
+    const size_t ordinal = _numForeignDocs++;
+    auto bson = foreignDoc.toBson();
+
+    if (_spilled) {
+        addToBuildSorter(ordinal, bson);
+        return true;
+    }
+
+    insertIntoTable(ordinal, std::move(bson), &_table);
+    if (_table.memoryUsageBytes > _maxMemoryUsageBytes) {
+        if (!_allowDiskUse) {
+            _abandoned = true;
+            _table.clear();
+            return false;
+        }
+        spill();
+    }
+    return true;
+}
+
+std::vector<Value> LookupHashJoin::probe(const Document& localDoc) {
+    invariant(!_abandoned && !_spilled);
+
+    std::vector<size_t> matches;
+    findMatches(_table, getLocalKeys(localDoc), &matches);
+
+    std::vector<Value> results;
+    results.reserve(matches.size());
+    for (auto&& i : matches) {
+        results.emplace_back(Document(_table.docs[i].second));
+    }
+    return results;
+}
+
+void LookupHashJoin::addLocalDocument(Document localDoc) {
+    invariant(_spilled && !isFinishedProbing());
+
+    const long long seq = _numLocalDocs++;
+    for (auto&& key : getLocalKeys(localDoc)) {
+        _probeSorter->add(makeSortKey(hashKey(key), seq), Document{{kKeyFieldName, key}});
+    }
+    _localSorter->add(Value(seq), localDoc);
+}
+
+void LookupHashJoin::finishProbing() {
+    invariant(_spilled && !isFinishedProbing());
+
+    std::unique_ptr<SpillSorter> resultsSorter(
+        SpillSorter::make(makeSortOptions(), SpillComparator()));
+    std::unique_ptr<SpillSorter::Iterator> buildIt(_buildSorter->done());
+    std::unique_ptr<SpillSorter::Iterator> probeIt(_probeSorter->done());
+    _buildSorter.reset();
+    _probeSorter.reset();
+
+    boost::optional<SpillSorter::Data> nextBuild;
+    boost::optional<SpillSorter::Data> nextProbe;
+    advanceIterator(buildIt.get(), &nextBuild);
+    advanceIterator(probeIt.get(), &nextProbe);
+
+    HashTable chunk(_fromExpCtx->getValueComparator());
+    while (nextBuild && nextProbe) {
+        // Load the foreign documents for the next range of hashes that fits in memory. Every entry
+        // with a given hash belongs to the same range.
+        chunk.clear();
+        long long maxHash;
+        do {
+            maxHash = getSortKeyPart(nextBuild->first, 0);
+            insertIntoTable(getSortKeyPart(nextBuild->first, 1),
+                            nextBuild->second.toBson(),
+                            &chunk,
+                            maxHash);
+            advanceIterator(buildIt.get(), &nextBuild);
+        } while (nextBuild && (getSortKeyPart(nextBuild->first, 0) == maxHash ||
+                               chunk.memoryUsageBytes < _maxMemoryUsageBytes));
+
+        // Probe with every local key whose hash falls in the range. Keys whose hashes precede the
+        // range have no matching foreign documents.
+        std::vector<size_t> matches;
+        while (nextProbe && getSortKeyPart(nextProbe->first, 0) <= maxHash) {
+            const long long seq = getSortKeyPart(nextProbe->first, 1);
+            matches.clear();
+            findMatches(chunk, {nextProbe->second[kKeyFieldName]}, &matches);
+            for (auto&& i : matches) {
+                resultsSorter->add(makeSortKey(seq, chunk.docs[i].first),
+                                   Document(chunk.docs[i].second));
+            }
+            advanceIterator(probeIt.get(), &nextProbe);
+        }
+    }
+
+    _resultsIt.reset(resultsSorter->done());
+    advanceIterator(_resultsIt.get(), &_nextResult);
+    _localIt.reset(_localSorter->done());
+    _localSorter.reset();
+}
+
+bool LookupHashJoin::more() {
+    invariant(isFinishedProbing());
+    return _localIt->more();
+}
+
+std::pair<Document, std::vector<Value>> LookupHashJoin::next() {
+    invariant(isFinishedProbing());
+
+    auto local = _localIt->next();
+    const long long seq = local.first.getLong();
+
+    // A foreign document is recorded once for each local key it matched, so skip repeats.
+    std::vector<Value> results;
+    boost::optional<long long> lastOrdinal;
+    while (_nextResult && getSortKeyPart(_nextResult->first, 0) == seq) {
+        const long long ordinal = getSortKeyPart(_nextResult->first, 1);
+        if (ordinal != lastOrdinal) {
+            results.emplace_back(std::move(_nextResult->second));
+            lastOrdinal = ordinal;
+        }
+        advanceIterator(_resultsIt.get(), &_nextResult);
+    }
+    return {std::move(local.second), std::move(results)};
+}
+
+void LookupHashJoin::visitForeignKeys(const Document& foreignDoc,
+                                      const KeyCallback& callback) const {
+    visitForeignKeys(Value(foreignDoc), 0, callback);
+}
+
+void LookupHashJoin::visitForeignKeys(const Value& value,
+                                      size_t pathIndex,
+                                      const KeyCallback& callback) const {
+    if (pathIndex == _foreignField.getPathLength()) {
+        // An equality to null also matches missing and undefined values.
+        if (value.missing() || value.getType() == BSONType::Undefined) {
+            callback(Value(BSONNULL));
+            return;
+        }
+
+        // An equality matches either the whole array or any one of its elements.
+        callback(value);
+        if (value.isArray()) {
+            for (auto&& elem : value.getArray()) {
+                callback(elem.getType() == BSONType::Undefined ? Value(BSONNULL) : elem);
+            }
+        }
+        return;
+    }
+
+    if (value.isArray()) {
+        for (auto&& elem : value.getArray()) {
+            visitForeignKeys(elem, pathIndex, callback);
+        }
+        if (value.getArray().empty()) {
+            callback(Value(BSONNULL));
+        }
+        return;
+    }
+
+    if (value.getType() != BSONType::Object) {
+        callback(Value(BSONNULL));
+        return;
+    }
+
+    const auto field = _foreignField.getFieldName(pathIndex);
+    visitForeignKeys(value.getDocument().getField(field), pathIndex + 1, callback);
+}
+
+std::vector<Value> LookupHashJoin::getLocalKeys(const Document& localDoc) const {
+    std::vector<Value> keys;
+    document_path_support::visitAllValuesAtPath(
+        localDoc, _localField, [&](const Value& key) { keys.push_back(key); });
+
+    if (keys.empty()) {
+        // Missing values are treated as null.
+        keys.push_back(Value(BSONNULL));
+    }
+    return keys;
+}
+
+void LookupHashJoin::insertIntoTable(size_t ordinal,
+                                     BSONObj foreignDoc,
+                                     HashTable* table,
+                                     boost::optional<long long> onlyHash) const {
+    const size_t pos = table->docs.size();
+    visitForeignKeys(Document(foreignDoc), [&](const Value& key) {
+        if (onlyHash && hashKey(key) != *onlyHash) {
+            return;
+        }
+
+        auto& positions = table->keyToDocs[key];
+        if (positions.empty()) {
+            table->memoryUsageBytes += key.getApproximateSize();
+        }
+        if (positions.empty() || positions.back() != pos) {
+            positions.push_back(pos);
+            table->memoryUsageBytes += sizeof(size_t);
+        }
+    });
+
+    table->memoryUsageBytes += foreignDoc.objsize();
+    table->docs.emplace_back(ordinal, std::move(foreignDoc));
+}
+
+void LookupHashJoin::addToBuildSorter(size_t ordinal, const BSONObj& foreignDoc) {
+    Document doc(foreignDoc);
+
+    std::vector<long long> hashes;
+    visitForeignKeys(doc, [&](const Value& key) { hashes.push_back(hashKey(key)); });
+    std::sort(hashes.begin(), hashes.end());
+    hashes.erase(std::unique(hashes.begin(), hashes.end()), hashes.end());
+
+    for (auto&& hash : hashes) {
+        _buildSorter->add(makeSortKey(hash, ordinal), doc);
+    }
+}
+
+void LookupHashJoin::findMatches(const HashTable& table,
+                                 const std::vector<Value>& localKeys,
+                                 std::vector<size_t>* out) {
+    // The table is keyed by a superset of the values each foreign document can match, so filter
+    // the candidates through the query the nested-loop $lookup would have issued. That query
+    // matches a document if it matches an $eq on any one of the keys, and every document which
+    // matches the $eq on a key is stored under that key.
+    for (auto&& key : localKeys) {
+        auto it = table.keyToDocs.find(key);
+        if (it == table.keyToDocs.end()) {
+            continue;
+        }
+
+        _keyMatcher->setKey(key);
+        for (auto&& i : it->second) {
+            if (_keyMatcher->matchesBSON(table.docs[i].second)) {
+                out->push_back(i);
+            }
+        }
+    }
+
+    if (localKeys.size() > 1) {
+        std::sort(out->begin(), out->end());
+        out->erase(std::unique(out->begin(), out->end()), out->end());
+    }
+}
+
+void LookupHashJoin::spill() {
+    invariant(!_spilled);
+    _spilled = true;
+
+    _buildSorter.reset(SpillSorter::make(makeSortOptions(), SpillComparator()));
+    _probeSorter.reset(SpillSorter::make(makeSortOptions(), SpillComparator()));
+    _localSorter.reset(SpillSorter::make(makeSortOptions(), SpillComparator()));
+
+    for (auto&& entry : _table.docs) {
+        addToBuildSorter(entry.first, entry.second);
+    }
+    _table.clear();
+}
+
+SortOptions LookupHashJoin::makeSortOptions() const {
+    return SortOptions()
+        .MaxMemoryUsageBytes(_maxMemoryUsageBytes)
+        .ExtSortAllowed(true)
+        .TempDir(_tempDir);
+}
+
+}  // namespace mongo
+
+#include "mongo/db/sorter/sorter.cpp"
+// Explicit instantiation unneeded since we aren't exposing Sorter outside of this file.
@@ -0,0 +1,243 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/intrusive_ptr.hpp>
+#include <boost/optional.hpp>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/bson/bsonobj.h"
+#include "mongo/db/pipeline/document.h"
+#include "mongo/db/pipeline/expression_context.h"
+#include "mongo/db/pipeline/field_path.h"
+#include "mongo/db/pipeline/value.h"
+#include "mongo/db/pipeline/value_comparator.h"
+#include "mongo/db/sorter/sorter.h"
+#include "mongo/stdx/functional.h"
+
+namespace mongo {
+
+/**
+ * Executes a localField/foreignField $lookup as a hash join. The foreign documents are inserted
+ * into a hash table keyed by every value a query on 'foreignField' could match, and each local
+ * document is then joined by probing that table with its 'localField' values rather than by
+ * querying the foreign collection. Candidates found in the table are verified against the same
+ * $match that the nested-loop $lookup would have issued, so the results are identical. The
+ * foreign documents which join with a local document are returned in the order in which they were
+ * added, which is the order in which a collection scan for that $match would have found them.
+ *
+ * While the foreign documents fit in 'maxMemoryUsageBytes' the join streams: probe() may be called
+ * once per local document. If the limit is exceeded and disk use is not allowed, the join abandons
+ * itself and the caller is expected to fall back to per-document queries. If disk use is allowed,
+ * the join spills everything it has seen to a Sorter ordered by key hash and becomes blocking:
+ * every local document must be passed to addLocalDocument(), after which finishProbing() joins the
+ * two sides one hash range at a time and the results are returned, in input order, by next().
+ */
+class LookupHashJoin {
+    MONGO_DISALLOW_COPYING(LookupHashJoin);
+
+public:
+    /**
+     * 'fromExpCtx' is the ExpressionContext of the foreign namespace. Its collation determines
+     * which keys are considered equal.
+     */
+    LookupHashJoin(const boost::intrusive_ptr<ExpressionContext>& fromExpCtx,
+                   FieldPath localField,
+                   FieldPath foreignField,
+                   size_t maxMemoryUsageBytes,
+                   bool allowDiskUse,
+                   std::string tempDir);
+
+    ~LookupHashJoin();
+
+    /**
+     * Returns false if a hash join cannot reproduce the matching semantics of a query on
+     * 'foreignField', e.g. because it contains a positional path component.
+     */
+    static bool canJoinOn(const FieldPath& foreignField);
+
+    /**
+     * Adds a document from the foreign collection to the hash table. Returns false if the memory
+     * limit was exceeded without permission to spill, in which case the join is abandoned and
+     * must not be used further.
+     */
+    bool addForeignDocument(const Document& foreignDoc);
+
+    bool isAbandoned() const {
+        return _abandoned;
+    }
+
+    /**
+     * Returns true if the join has spilled to disk, and therefore must be driven through
+     * addLocalDocument(), finishProbing(), more() and next() rather than probe().
+     */
+    bool isSpilled() const {
+        return _spilled;
+    }
+
+    /**
+     * Returns the foreign documents which join with 'localDoc', in the order in which they were
+     * added. May only be called if the join has not spilled.
+     */
+    std::vector<Value> probe(const Document& localDoc);
+
+    /**
+     * Buffers 'localDoc' to be joined once all local documents have been seen. May only be called
+     * if the join has spilled.
+     */
+    void addLocalDocument(Document localDoc);
+
+    /**
+     * Joins the buffered local documents with the spilled foreign documents. Must be called once,
+     * after the last call to addLocalDocument() and before the first call to more().
+     */
+    void finishProbing();
+
+    bool isFinishedProbing() const {
+        return static_cast<bool>(_localIt);
+    }
+
+    /**
+     * Iterates over the buffered local documents, in the order in which they were added, each
+     * paired with the foreign documents which join with it in the order in which those were added.
+     */
+    bool more();
+    std::pair<Document, std::vector<Value>> next();
+
+private:
+    class KeyMatcher;
+
+    using SpillSorter = Sorter<Value, Document>;
+    using KeyCallback = stdx::function<void(const Value&)>;
+
+    // Holds the foreign documents in a single hash range while the spilled join is in progress, or
+    // all foreign documents while the join is in memory.
+    struct HashTable {
+        explicit HashTable(const ValueComparator& comparator)
+            : keyToDocs(comparator.makeUnorderedValueMap<std::vector<size_t>>()) {}
+
+        void clear() {
+            keyToDocs.clear();
+            docs.clear();
+            memoryUsageBytes = 0;
+        }
+
+        // Maps each key to the positions in 'docs' of the documents containing it, in ascending
+        // order. Each entry of 'docs' pairs a foreign document with its ordinal.
+        ValueUnorderedMap<std::vector<size_t>> keyToDocs;
+        std::vector<std::pair<size_t, BSONObj>> docs;
+        size_t memoryUsageBytes = 0;
+    };
+
+    /**
+     * Invokes 'callback' on each key under which 'foreignDoc' is stored. This is a superset of the
+     * values a query on '_foreignField' can match: the value at the path, the elements of an array
+     * at the path, and null for each branch on which the path is missing.
+     */
+    void visitForeignKeys(const Document& foreignDoc, const KeyCallback& callback) const;
+    void visitForeignKeys(const Value& value, size_t pathIndex, const KeyCallback& callback) const;
+
+    /**
+     * Returns the values of '_localField' in 'localDoc', or a single null if there are none. These
+     * are the values the nested-loop $lookup would query for.
+     */
+    std::vector<Value> getLocalKeys(const Document& localDoc) const;
+
+    /**
+     * Inserts the document with ordinal 'ordinal' into 'table' under each of its keys, or only
+     * under those keys whose hash is 'onlyHash' if specified.
+     */
+    void insertIntoTable(size_t ordinal,
+                         BSONObj foreignDoc,
+                         HashTable* table,
+                         boost::optional<long long> onlyHash = boost::none) const;
+
+    /**
+     * Adds the document with ordinal 'ordinal' to '_buildSorter' once for each distinct hash of its
+     * keys.
+     */
+    void addToBuildSorter(size_t ordinal, const BSONObj& foreignDoc);
+
+    /**
+     * Appends to 'out' the positions in 'table.docs' of the documents stored under any of
+     * 'localKeys' which match the query the nested-loop $lookup would have issued, in ascending
+     * order.
+     */
+    void findMatches(const HashTable& table,
+                     const std::vector<Value>& localKeys,
+                     std::vector<size_t>* out);
+
+    /**
+     * Switches from an in-memory to a spilled join, moving the contents of '_table' into
+     * '_buildSorter'.
+     */
+    void spill();
+
+    SortOptions makeSortOptions() const;
+
+    long long hashKey(const Value& key) const {
+        return static_cast<long long>(_fromExpCtx->getValueComparator().hash(key));
+    }
+
+    boost::intrusive_ptr<ExpressionContext> _fromExpCtx;
+    const FieldPath _localField;
+    const FieldPath _foreignField;
+    const size_t _maxMemoryUsageBytes;
+    const bool _allowDiskUse;
+    const std::string _tempDir;
+
+    bool _abandoned = false;
+    bool _spilled = false;
+    size_t _numForeignDocs = 0;
+    long long _numLocalDocs = 0;
+
+    HashTable _table;
+
+    // Verifies the candidates found in the table, one local key at a time.
+    std::unique_ptr<KeyMatcher> _keyMatcher;
+
+    // The following are only used once the join has spilled. '_buildSorter' holds the foreign
+    // documents keyed by [hash, ordinal], once for each distinct hash of their keys. '_probeSorter'
+    // holds one entry for each local key, keyed by [hash, local sequence number]. The local
+    // documents themselves are held in '_localSorter' keyed by sequence number, and the joined
+    // pairs are collected in a sorter keyed by [sequence number, ordinal], so that the output can
+    // be produced by merging the latter two.
+    std::unique_ptr<SpillSorter> _buildSorter;
+    std::unique_ptr<SpillSorter> _probeSorter;
+    std::unique_ptr<SpillSorter> _localSorter;
+    std::unique_ptr<SpillSorter::Iterator> _localIt;
+    std::unique_ptr<SpillSorter::Iterator> _resultsIt;
+    boost::optional<SpillSorter::Data> _nextResult;
+};
+
+}  // namespace mongo
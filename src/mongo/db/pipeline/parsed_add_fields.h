@@ -90,6 +90,7 @@ public:
      */
     void optimize() final {
         _root->optimize();
+        _root->compileExpressions(_expCtx);
     }
 
     DepsTracker::State addDependencies(DepsTracker* deps) const final {
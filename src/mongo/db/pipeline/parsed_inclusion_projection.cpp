@@ -32,6 +32,8 @@
 
 #include <algorithm>
 
+#include "mongo/db/pipeline/expression_compiled.h"
+
 namespace mongo {
 
 namespace parsed_aggregation_projection {
@@ -55,6 +57,15 @@ void InclusionNode::optimize() {
     }
 }
 
+void InclusionNode::compileExpressions(const boost::intrusive_ptr<ExpressionContext>& expCtx) {
+    for (auto&& expressionIt : _expressions) {
+        expressionIt.second = ExpressionCompiled::compile(expCtx, expressionIt.second);
+    }
+    for (auto&& childPair : _children) {
+        childPair.second->compileExpressions(expCtx);
+    }
+}
+
 void InclusionNode::serialize(MutableDocument* output,
                               boost::optional<ExplainOptions::Verbosity> explain) const {
     // Always put "_id" first if it was included (implicitly or explicitly).
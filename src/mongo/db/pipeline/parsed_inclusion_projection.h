@@ -62,6 +62,12 @@ public:
      */
     void optimize();
 
+    /**
+     * Replaces each computed expression with a compiled version of it, where possible. Must follow
+     * optimize().
+     */
+    void compileExpressions(const boost::intrusive_ptr<ExpressionContext>& expCtx);
+
     /**
      * Serialize this projection.
      */
@@ -222,6 +228,7 @@ public:
      */
     void optimize() final {
         _root->optimize();
+        _root->compileExpressions(_expCtx);
     }
 
     DepsTracker::State addDependencies(DepsTracker* deps) const final {
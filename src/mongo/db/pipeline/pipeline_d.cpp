@@ -45,6 +45,8 @@
 #include "mongo/db/exec/shard_filter.h"
 #include "mongo/db/exec/working_set.h"
 #include "mongo/db/index/index_access_method.h"
+#include "mongo/db/index/index_descriptor.h"
+#include "mongo/db/index_names.h"
 #include "mongo/db/matcher/extensions_callback_real.h"
 #include "mongo/db/namespace_string.h"
 #include "mongo/db/ops/write_ops_exec.h"
@@ -64,7 +66,9 @@
 #include "mongo/db/pipeline/pipeline.h"
 #include "mongo/db/query/collation/collator_interface.h"
 #include "mongo/db/query/get_executor.h"
+#include "mongo/db/query/parsed_distinct.h"
 #include "mongo/db/query/plan_summary_stats.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/query/query_planner.h"
 #include "mongo/db/s/collection_sharding_state.h"
 #include "mongo/db/s/sharding_state.h"
@@ -147,7 +151,9 @@ StatusWith<std::unique_ptr<PlanExecutor, PlanExecutor::Deleter>> attemptToGetExe
     BSONObj queryObj,
     BSONObj projectionObj,
     BSONObj sortObj,
+    boost::optional<long long> limit,
     const AggregationRequest* aggRequest,
+    const BSONObj& hintObj,
     const size_t plannerOpts,
     const MatchExpressionParser::AllowedFeatureSet& matcherFeatures) {
     auto qr = stdx::make_unique<QueryRequest>(nss);
@@ -156,9 +162,10 @@ StatusWith<std::unique_ptr<PlanExecutor, PlanExecutor::Deleter>> attemptToGetExe
     qr->setFilter(queryObj);
     qr->setProj(projectionObj);
     qr->setSort(sortObj);
+    qr->setLimit(limit);
+    qr->setHint(hintObj);
     if (aggRequest) {
         qr->setExplain(static_cast<bool>(aggRequest->getExplain()));
-        qr->setHint(aggRequest->getHint());
     }
 
     // If the pipeline has a non-null collator, set the collation option to the result of
@@ -188,6 +195,80 @@ StatusWith<std::unique_ptr<PlanExecutor, PlanExecutor::Deleter>> attemptToGetExe
     return getExecutorFind(opCtx, collection, nss, std::move(cq.getValue()), plannerOpts);
 }
 
+/**
+ * Returns a hint naming the index with the fewest fields which holds every field in 'deps', or an
+ * empty object if there is no such index. An index which may hold several keys for a document, or
+ * no key at all for some documents, is not considered, nor is one whose keys are collation keys
+ * rather than the values themselves.
+ */
+BSONObj getCoveringIndexHint(OperationContext* opCtx,
+                             Collection* collection,
+                             const DepsTracker& deps) {
+    if (!collection || deps.fields.empty() || deps.needWholeDocument ||
+        deps.getNeedsAnyMetadata()) {
+        return BSONObj();
+    }
+
+    const IndexDescriptor* bestIndex = nullptr;
+    IndexCatalog::IndexIterator ii = collection->getIndexCatalog()->getIndexIterator(opCtx, false);
+    while (ii.more()) {
+        const IndexDescriptor* desc = ii.next();
+        const IndexCatalogEntry* entry = ii.catalogEntry(desc);
+        if (!IndexNames::findPluginName(desc->keyPattern()).empty() || desc->isSparse() ||
+            entry->getFilterExpression() || entry->getCollator() || desc->isMultikey(opCtx)) {
+            continue;
+        }
+
+        const bool coversDeps =
+            std::all_of(deps.fields.begin(), deps.fields.end(), [&](const std::string& field) {
+                return desc->keyPattern().hasField(field);
+            });
+        if (coversDeps && (!bestIndex || desc->getNumFields() < bestIndex->getNumFields())) {
+            bestIndex = desc;
+        }
+    }
+    return bestIndex ? BSON("$hint" << bestIndex->indexName()) : BSONObj();
+}
+
+/**
+ * Attempts to build a PlanExecutor which produces, from a DISTINCT_SCAN, the first document in
+ * 'rewrite.sortPattern' order of each distinct value of 'rewrite.groupKeyPath' matching 'queryObj'.
+ */
+StatusWith<std::unique_ptr<PlanExecutor, PlanExecutor::Deleter>> attemptToGetDistinctScanExecutor(
+    OperationContext* opCtx,
+    Collection* collection,
+    const NamespaceString& nss,
+    const intrusive_ptr<ExpressionContext>& pExpCtx,
+    BSONObj queryObj,
+    BSONObj projectionObj,
+    const DocumentSourceGroup::DistinctScanRewrite& rewrite,
+    const AggregationRequest* aggRequest) {
+    auto qr = stdx::make_unique<QueryRequest>(nss);
+    qr->setFilter(queryObj);
+    qr->setProj(projectionObj);
+    qr->setSort(rewrite.sortPattern);
+    if (aggRequest) {
+        qr->setExplain(static_cast<bool>(aggRequest->getExplain()));
+    }
+    qr->setCollation(pExpCtx->getCollator() ? pExpCtx->getCollator()->getSpec().toBSON()
+                                            : pExpCtx->collation);
+
+    const ExtensionsCallbackReal extensionsCallback(pExpCtx->opCtx, &nss);
+
+    auto cq = CanonicalQuery::canonicalize(
+        opCtx, std::move(qr), pExpCtx, extensionsCallback, Pipeline::kAllowedMatcherFeatures);
+    if (!cq.isOK()) {
+        return {cq.getStatus()};
+    }
+
+    ParsedDistinct parsedDistinct(std::move(cq.getValue()), rewrite.groupKeyPath);
+    return getExecutorDistinct(opCtx,
+                               collection,
+                               nss.ns(),
+                               &parsedDistinct,
+                               QueryPlannerParams::STRICT_DISTINCT_ONLY);
+}
+
 BSONObj removeSortKeyMetaProjection(BSONObj projectionObj) {
     if (!projectionObj[Document::metaFieldSortKey]) {
         return projectionObj;
@@ -338,7 +419,28 @@ void PipelineD::prepareGenericCursorSource(Collection* collection,
         }
     }
 
+    // A leading $group which only needs the first or last document of each group is fed by a
+    // DISTINCT_SCAN, which skips over the rest of each group's index keys.
+    if (auto exec = prepareDistinctScanExecutor(collection,
+                                                nss,
+                                                aggRequest,
+                                                pipeline,
+                                                oplogReplay,
+                                                deps,
+                                                queryObj,
+                                                projForQuery,
+                                                &sortObj)) {
+        addCursorSource(pipeline,
+                        DocumentSourceCursor::create(collection, std::move(exec), expCtx),
+                        deps,
+                        queryObj,
+                        sortObj,
+                        projForQuery);
+        return;
+    }
+
     // Create the PlanExecutor.
+    bool isTopKSort = false;
     auto exec = uassertStatusOK(prepareExecutor(expCtx->opCtx,
                                                 collection,
                                                 nss,
@@ -351,7 +453,8 @@ void PipelineD::prepareGenericCursorSource(Collection* collection,
                                                 aggRequest,
                                                 Pipeline::kAllowedMatcherFeatures,
                                                 &sortObj,
-                                                &projForQuery));
+                                                &projForQuery,
+                                                &isTopKSort));
 
 
     if (!projForQuery.isEmpty() && !sources.empty()) {
@@ -364,14 +467,88 @@ void PipelineD::prepareGenericCursorSource(Collection* collection,
         }
     }
 
+    auto cursor = DocumentSourceCursor::create(collection, std::move(exec), expCtx);
+    cursor->setIsTopKSort(isTopKSort);
     addCursorSource(pipeline,
-                    DocumentSourceCursor::create(collection, std::move(exec), expCtx),
+                    std::move(cursor),
                     deps,
                     queryObj,
                     sortObj,
                     projForQuery);
 }
 
+std::unique_ptr<PlanExecutor, PlanExecutor::Deleter> PipelineD::prepareDistinctScanExecutor(
+    Collection* collection,
+    const NamespaceString& nss,
+    const AggregationRequest* aggRequest,
+    Pipeline* pipeline,
+    bool oplogReplay,
+    const DepsTracker& deps,
+    const BSONObj& queryObj,
+    const BSONObj& projectionObj,
+    BSONObj* sortObj) {
+    Pipeline::SourceContainer& sources = pipeline->_sources;
+    auto expCtx = pipeline->getContext();
+
+    if (!internalDocumentSourceGroupUseIndexOnlyPlans.load() || !collection || oplogReplay ||
+        expCtx->tailableMode != TailableModeEnum::kNormal ||
+        (aggRequest && !aggRequest->getHint().isEmpty()) ||
+        DocumentSourceMatch::isTextQuery(queryObj) || deps.getNeedsAnyMetadata() ||
+        projectionObj.isEmpty() || sources.empty()) {
+        return nullptr;
+    }
+
+    // A $sort which has absorbed a $limit decides which documents reach the $group, so it must
+    // stay.
+    auto sourcesIt = sources.begin();
+    auto sortStage = dynamic_cast<DocumentSourceSort*>(sourcesIt->get());
+    BSONObj inputSortPattern;
+    if (sortStage) {
+        if (sortStage->getLimitSrc()) {
+            return nullptr;
+        }
+        const auto serialization =
+            DocumentSourceSort::SortKeySerialization::kForPipelineSerialization;
+        inputSortPattern = sortStage->sortKeyPattern(serialization).toBson();
+        ++sourcesIt;
+    }
+
+    auto groupStage =
+        sourcesIt == sources.end() ? nullptr : dynamic_cast<DocumentSourceGroup*>(sourcesIt->get());
+    if (!groupStage) {
+        return nullptr;
+    }
+
+    auto rewrite = groupStage->getDistinctScanRewrite(inputSortPattern);
+    if (!rewrite) {
+        return nullptr;
+    }
+
+    auto swExec = attemptToGetDistinctScanExecutor(expCtx->opCtx,
+                                                   collection,
+                                                   nss,
+                                                   expCtx,
+                                                   queryObj,
+                                                   projectionObj,
+                                                   *rewrite,
+                                                   aggRequest);
+    if (!swExec.isOK()) {
+        LOG(5) << "Not using a distinct scan for " << groupStage->getSourceName() << ": "
+               << swExec.getStatus();
+        return nullptr;
+    }
+
+    // The PlanExecutor produces the documents of each group in the order the $sort would have.
+    if (sortStage) {
+        sources.pop_front();
+    }
+    if (rewrite->groupStage) {
+        sources.front() = rewrite->groupStage;
+    }
+    *sortObj = rewrite->sortPattern;
+    return std::move(swExec.getValue());
+}
+
 void PipelineD::prepareGeoNearCursorSource(Collection* collection,
                                            const NamespaceString& nss,
                                            const AggregationRequest* aggRequest,
@@ -400,6 +577,7 @@ void PipelineD::prepareGeoNearCursorSource(Collection* collection,
     BSONObj fullQuery = geoNearStage->asNearQuery(nearFieldName);
     BSONObj proj = deps.toProjection();
     BSONObj sortFromQuerySystem;
+    bool isTopKSort = false;
     auto exec = uassertStatusOK(prepareExecutor(expCtx->opCtx,
                                                 collection,
                                                 nss,
@@ -412,7 +590,8 @@ void PipelineD::prepareGeoNearCursorSource(Collection* collection,
                                                 aggRequest,
                                                 Pipeline::kGeoNearMatcherFeatures,
                                                 &sortFromQuerySystem,
-                                                &proj));
+                                                &proj,
+                                                &isTopKSort));
 
     invariant(sortFromQuerySystem.isEmpty(),
               str::stream() << "Unexpectedly got the following sort from the query system: "
@@ -444,7 +623,8 @@ StatusWith<std::unique_ptr<PlanExecutor, PlanExecutor::Deleter>> PipelineD::prep
     const AggregationRequest* aggRequest,
     const MatchExpressionParser::AllowedFeatureSet& matcherFeatures,
     BSONObj* sortObj,
-    BSONObj* projectionObj) {
+    BSONObj* projectionObj,
+    bool* isTopKSort) {
     // The query system has the potential to use an index to provide a non-blocking sort and/or to
     // use the projection to generate a covered plan. If this is possible, it is more efficient to
     // let the query system handle those parts of the pipeline. If not, it is more efficient to use
@@ -483,11 +663,14 @@ StatusWith<std::unique_ptr<PlanExecutor, PlanExecutor::Deleter>> PipelineD::prep
         plannerOpts |= QueryPlannerParams::TRACK_LATEST_OPLOG_TS;
     }
 
+    const BSONObj userHint = aggRequest ? aggRequest->getHint() : BSONObj();
     const BSONObj emptyProjection;
     const BSONObj metaSortProjection = BSON("$meta"
                                             << "sortKey");
     if (sortStage) {
         // See if the query system can provide a non-blocking sort.
+        size_t sortPlannerOpts = plannerOpts;
+        boost::optional<long long> sortLimit;
         auto swExecutorSort =
             attemptToGetExecutor(opCtx,
                                  collection,
@@ -497,10 +680,45 @@ StatusWith<std::unique_ptr<PlanExecutor, PlanExecutor::Deleter>> PipelineD::prep
                                  queryObj,
                                  expCtx->needsMerge ? metaSortProjection : emptyProjection,
                                  *sortObj,
+                                 sortLimit,
                                  aggRequest,
-                                 plannerOpts,
+                                 userHint,
+                                 sortPlannerOpts,
                                  matcherFeatures);
 
+        // The SORT stage cannot spill, and is held to the smaller blocking sort memory limit of
+        // the query system, so the top 'limit' documents must be expected to fit within it.
+        const long long limit = sortStage->getLimit();
+        const bool topKFitsInSortStage = !collection ||
+            limit * collection->averageObjectSize(opCtx) <=
+                internalQueryExecMaxBlockingSortBytes.load();
+        if (!swExecutorSort.isOK() && swExecutorSort != ErrorCodes::QueryPlanKilled &&
+            !expCtx->allowDiskUse && limit > 0 &&
+            limit <= internalDocumentSourceSortMaxPushdownLimit.load() && topKFitsInSortStage) {
+            // No index provides the sort, but the $sort only has to keep its top 'limit' documents.
+            // A SORT stage with a limit does that in the query system, without producing a
+            // Document for every input. This is not done when the $sort would be allowed to spill,
+            // or when documents of the average size in the collection would not fit in the SORT
+            // stage's memory limit.
+            sortPlannerOpts &= ~QueryPlannerParams::NO_BLOCKING_SORT;
+            sortLimit = limit;
+            swExecutorSort =
+                attemptToGetExecutor(opCtx,
+                                     collection,
+                                     nss,
+                                     expCtx,
+                                     oplogReplay,
+                                     queryObj,
+                                     expCtx->needsMerge ? metaSortProjection : emptyProjection,
+                                     *sortObj,
+                                     sortLimit,
+                                     aggRequest,
+                                     userHint,
+                                     sortPlannerOpts,
+                                     matcherFeatures);
+            *isTopKSort = swExecutorSort.isOK();
+        }
+
         if (swExecutorSort.isOK()) {
             // Success! Now see if the query system can also cover the projection.
             auto swExecutorSortAndProj = attemptToGetExecutor(opCtx,
@@ -511,8 +729,10 @@ StatusWith<std::unique_ptr<PlanExecutor, PlanExecutor::Deleter>> PipelineD::prep
                                                               queryObj,
                                                               *projectionObj,
                                                               *sortObj,
+                                                              sortLimit,
                                                               aggRequest,
-                                                              plannerOpts,
+                                                              userHint,
+                                                              sortPlannerOpts,
                                                               matcherFeatures);
 
             std::unique_ptr<PlanExecutor, PlanExecutor::Deleter> exec;
@@ -563,6 +783,18 @@ StatusWith<std::unique_ptr<PlanExecutor, PlanExecutor::Deleter>> PipelineD::prep
         plannerOpts |= QueryPlannerParams::NO_UNCOVERED_PROJECTIONS;
     }
 
+    // A leading $group which only reads a few fields, such as one computing a count, $min or $max
+    // per group over the whole collection, can be fed from the keys of an index holding all of
+    // them without fetching any documents. The planner would otherwise prefer a collection scan,
+    // so name the index explicitly.
+    BSONObj coveringHint = userHint;
+    if (coveringHint.isEmpty() && internalDocumentSourceGroupUseIndexOnlyPlans.load() &&
+        queryObj.isEmpty() && !oplogReplay && expCtx->tailableMode == TailableModeEnum::kNormal &&
+        !pipeline->_sources.empty() &&
+        dynamic_cast<DocumentSourceGroup*>(pipeline->_sources.front().get())) {
+        coveringHint = getCoveringIndexHint(opCtx, collection, deps);
+    }
+
     // See if the query system can cover the projection.
     auto swExecutorProj = attemptToGetExecutor(opCtx,
                                                collection,
@@ -572,7 +804,9 @@ StatusWith<std::unique_ptr<PlanExecutor, PlanExecutor::Deleter>> PipelineD::prep
                                                queryObj,
                                                *projectionObj,
                                                *sortObj,
+                                               boost::none,
                                                aggRequest,
+                                               coveringHint,
                                                plannerOpts,
                                                matcherFeatures);
     if (swExecutorProj.isOK()) {
@@ -596,7 +830,9 @@ StatusWith<std::unique_ptr<PlanExecutor, PlanExecutor::Deleter>> PipelineD::prep
                                 queryObj,
                                 *projectionObj,
                                 *sortObj,
+                                boost::none,
                                 aggRequest,
+                                userHint,
                                 plannerOpts,
                                 matcherFeatures);
 }
@@ -110,9 +110,11 @@ private:
      * an index to provide a more efficient sort or projection, the sort and/or projection will be
      * incorporated into the PlanExecutor.
      *
-     * 'sortObj' will be set to an empty object if the query system cannot provide a non-blocking
-     * sort, and 'projectionObj' will be set to an empty object if the query system cannot provide a
-     * covered projection.
+     * 'sortObj' will be set to an empty object if the query system cannot provide the sort, and
+     * 'projectionObj' will be set to an empty object if the query system cannot provide a covered
+     * projection. The query system provides the sort either with an index or, if 'sortStage' has
+     * absorbed a small enough $limit, with a top-k SORT stage, in which case 'isTopKSort' is set to
+     * true.
      */
     static StatusWith<std::unique_ptr<PlanExecutor, PlanExecutor::Deleter>> prepareExecutor(
         OperationContext* opCtx,
@@ -127,7 +129,26 @@ private:
         const AggregationRequest* aggRequest,
         const MatchExpressionParser::AllowedFeatureSet& matcherFeatures,
         BSONObj* sortObj,
-        BSONObj* projectionObj);
+        BSONObj* projectionObj,
+        bool* isTopKSort);
+
+    /**
+     * If 'pipeline' begins with a $group, possibly preceded by a $sort, which only needs the first
+     * or last document of each group, returns a PlanExecutor which skips through an index with a
+     * DISTINCT_SCAN to produce just those documents, restricted to 'projectionObj'. In that case
+     * the $sort is removed from 'pipeline', the $group is replaced if necessary, and 'sortObj' is
+     * set to the order the PlanExecutor produces. Otherwise returns null.
+     */
+    static std::unique_ptr<PlanExecutor, PlanExecutor::Deleter> prepareDistinctScanExecutor(
+        Collection* collection,
+        const NamespaceString& nss,
+        const AggregationRequest* aggRequest,
+        Pipeline* pipeline,
+        bool oplogReplay,
+        const DepsTracker& deps,
+        const BSONObj& queryObj,
+        const BSONObj& projectionObj,
+        BSONObj* sortObj);
 
     /**
      * Adds 'cursor' to the front of 'pipeline', using 'deps' to inform the cursor of its
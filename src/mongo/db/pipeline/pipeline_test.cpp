@@ -224,6 +224,62 @@ TEST(PipelineOptimizationTest, SortMatchProjSkipLimBecomesMatchTopKSortSkipProj)
     assertPipelineOptimizesAndSerializesTo(inputPipe, outputPipe, serializedPipe);
 }
 
+TEST(PipelineOptimizationTest, TopKSortMovesBeforeAddFieldsWhichDoesNotModifySortKey) {
+    std::string inputPipe =
+        "[{$addFields: {b: 1}}"
+        ",{$sort: {a: 1}}"
+        ",{$limit: 5}"
+        "]";
+    std::string outputPipe =
+        "[{$sort: {sortKey: {a: 1}, limit: 5}}"
+        ",{$addFields: {b: {$const: 1}}}"
+        "]";
+    std::string serializedPipe =
+        "[{$sort: {a: 1}}"
+        ",{$limit: 5}"
+        ",{$addFields: {b: {$const: 1}}}"
+        "]";
+    assertPipelineOptimizesAndSerializesTo(inputPipe, outputPipe, serializedPipe);
+}
+
+TEST(PipelineOptimizationTest, TopKSortMovesBeforeProjectionsWhichPreserveSortKey) {
+    std::string inputPipe =
+        "[{$project: {a: 1, b: 1}}"
+        ",{$project: {b: 0}}"
+        ",{$sort: {'a.c': -1}}"
+        ",{$skip: 2}"
+        ",{$limit: 5}"
+        "]";
+    std::string outputPipe =
+        "[{$sort: {sortKey: {'a.c': -1}, limit: 7}}"
+        ",{$skip: 2}"
+        ",{$project: {_id: true, a: true, b: true}}"
+        ",{$project: {b: false}}"
+        "]";
+    std::string serializedPipe =
+        "[{$sort: {'a.c': -1}}"
+        ",{$limit: 7}"
+        ",{$skip: 2}"
+        ",{$project: {_id: true, a: true, b: true}}"
+        ",{$project: {b: false}}"
+        "]";
+    assertPipelineOptimizesAndSerializesTo(inputPipe, outputPipe, serializedPipe);
+}
+
+TEST(PipelineOptimizationTest, TopKSortDoesNotMoveBeforeAddFieldsWhichModifiesSortKey) {
+    assertPipelineOptimizesTo(
+        "[{$addFields: {a: {b: 1}}}, {$sort: {'a.b': 1}}, {$limit: 5}]",
+        "[{$addFields: {a: {b: {$const: 1}}}}, {$sort: {sortKey: {'a.b': 1}, limit: 5}}]");
+    assertPipelineOptimizesTo(
+        "[{$project: {b: 1}}, {$sort: {a: 1}}, {$limit: 5}]",
+        "[{$project: {_id: true, b: true}}, {$sort: {sortKey: {a: 1}, limit: 5}}]");
+}
+
+TEST(PipelineOptimizationTest, SortWithoutLimitDoesNotMoveBeforeAddFields) {
+    assertPipelineOptimizesTo("[{$addFields: {b: 1}}, {$sort: {a: 1}}]",
+                              "[{$addFields: {b: {$const: 1}}}, {$sort: {sortKey: {a: 1}}}]");
+}
+
 TEST(PipelineOptimizationTest, RemoveSkipZero) {
     assertPipelineOptimizesTo("[{$skip: 0}]", "[]");
 }
@@ -38,6 +38,7 @@
 
 #include "mongo/base/error_codes.h"
 #include "mongo/base/parse_number.h"
+#include "mongo/bson/simple_bsonelement_comparator.h"
 #include "mongo/db/catalog/index_catalog.h"
 #include "mongo/db/exec/cached_plan.h"
 #include "mongo/db/exec/collection_scan.h"
@@ -1080,12 +1081,21 @@ bool turnIxscanIntoCount(QuerySolution* soln) {
  * Multikey indices cannot be used for the fast distinct hack if the field is dotted.  Currently the
  * solution generated for the distinct hack includes a projection stage and the projection stage
  * cannot be covered with a dotted field.
+ *
+ * With QueryPlannerParams::STRICT_DISTINCT_ONLY in 'plannerOptions', multikey and sparse indices
+ * are never suitable, and the index must provide 'sortPattern' if it is not empty. 'directionOut'
+ * is set to the direction in which the index must be scanned to provide it.
  */
 bool getDistinctNodeIndex(const std::vector<IndexEntry>& indices,
                           const std::string& field,
                           const CollatorInterface* collator,
-                          size_t* indexOut) {
+                          size_t plannerOptions,
+                          const BSONObj& sortPattern,
+                          size_t* indexOut,
+                          int* directionOut) {
     invariant(indexOut);
+    invariant(directionOut);
+    const bool strict = plannerOptions & QueryPlannerParams::STRICT_DISTINCT_ONLY;
     bool isDottedField = str::contains(field, '.');
     int minFields = std::numeric_limits<int>::max();
     for (size_t i = 0; i < indices.size(); ++i) {
@@ -1109,11 +1119,29 @@ bool getDistinctNodeIndex(const std::vector<IndexEntry>& indices,
         if (indices[i].keyPattern.firstElement().fieldNameStringData() != StringData(field)) {
             continue;
         }
+        int direction = 1;
+        if (strict) {
+            // Skip indices which may hold several keys for a document, or none at all.
+            if (indices[i].multikey || indices[i].sparse) {
+                continue;
+            }
+            // Skip indices which cannot provide the sort in either direction.
+            const BSONObj indexSort = QueryPlannerAnalysis::getSortPattern(indices[i].keyPattern);
+            const auto& eltCmp = SimpleBSONElementComparator::kInstance;
+            if (!sortPattern.isEmpty() && !sortPattern.isPrefixOf(indexSort, eltCmp)) {
+                if (!QueryPlannerCommon::reverseSortObj(sortPattern).isPrefixOf(indexSort,
+                                                                                eltCmp)) {
+                    continue;
+                }
+                direction = -1;
+            }
+        }
         int nFields = indices[i].keyPattern.nFields();
         // Pick the index with the lowest number of fields.
         if (nFields < minFields) {
             minFields = nFields;
             *indexOut = i;
+            *directionOut = direction;
         }
     }
     return minFields != std::numeric_limits<int>::max();
@@ -1405,7 +1433,8 @@ StatusWith<unique_ptr<PlanExecutor, PlanExecutor::Deleter>> getExecutorDistinct(
     OperationContext* opCtx,
     Collection* collection,
     const std::string& ns,
-    ParsedDistinct* parsedDistinct) {
+    ParsedDistinct* parsedDistinct,
+    size_t plannerOptions) {
     const auto readConcernArgs = repl::ReadConcernArgs::get(opCtx);
     const auto yieldPolicy =
         readConcernArgs.getLevel() == repl::ReadConcernLevel::kSnapshotReadConcern
@@ -1422,6 +1451,13 @@ StatusWith<unique_ptr<PlanExecutor, PlanExecutor::Deleter>> getExecutorDistinct(
                                   yieldPolicy);
     }
 
+    // A DISTINCT_SCAN cannot filter out documents which the shard does not own.
+    const bool strict = plannerOptions & QueryPlannerParams::STRICT_DISTINCT_ONLY;
+    if (strict && ShardingState::get(opCtx)->needCollectionMetadata(opCtx, ns)) {
+        return Status(ErrorCodes::BadValue,
+                      "no distinct scan plan: the collection requires shard filtering");
+    }
+
     // TODO: check for idhack here?
 
     // When can we do a fast distinct hack?
@@ -1435,6 +1471,10 @@ StatusWith<unique_ptr<PlanExecutor, PlanExecutor::Deleter>> getExecutorDistinct(
 
     QueryPlannerParams plannerParams;
     plannerParams.options = QueryPlannerParams::NO_TABLE_SCAN;
+    if (strict) {
+        // The query's sort must be provided by the scan, not by a SORT stage over its output.
+        plannerParams.options |= QueryPlannerParams::NO_BLOCKING_SORT;
+    }
 
     IndexCatalog::IndexIterator ii = collection->getIndexCatalog()->getIndexIterator(opCtx, false);
     while (ii.more()) {
@@ -1459,6 +1499,10 @@ StatusWith<unique_ptr<PlanExecutor, PlanExecutor::Deleter>> getExecutorDistinct(
     // If there are no suitable indices for the distinct hack bail out now into regular planning
     // with no projection.
     if (plannerParams.indices.empty()) {
+        if (strict) {
+            return Status(ErrorCodes::BadValue,
+                          "no distinct scan plan: no index has the distinct field");
+        }
         return getExecutor(opCtx, collection, parsedDistinct->releaseQuery(), yieldPolicy);
     }
 
@@ -1468,11 +1512,12 @@ StatusWith<unique_ptr<PlanExecutor, PlanExecutor::Deleter>> getExecutorDistinct(
 
     // Applying a projection allows the planner to try to give us covered plans that we can turn
     // into the projection hack.  getDistinctProjection deals with .find() projection semantics
-    // (ie _id:1 being implied by default).
-    BSONObj projection = getDistinctProjection(parsedDistinct->getKey());
-
+    // (ie _id:1 being implied by default). A strict caller may need other fields as well, and
+    // provides its own projection.
     auto qr = stdx::make_unique<QueryRequest>(parsedDistinct->getQuery()->getQueryRequest());
-    qr->setProj(projection);
+    if (!strict || qr->getProj().isEmpty()) {
+        qr->setProj(getDistinctProjection(parsedDistinct->getKey()));
+    }
 
     const boost::intrusive_ptr<ExpressionContext> expCtx;
     auto statusWithCQ =
@@ -1497,14 +1542,23 @@ StatusWith<unique_ptr<PlanExecutor, PlanExecutor::Deleter>> getExecutorDistinct(
     // Not every index in plannerParams.indices may be suitable. Refer to
     // getDistinctNodeIndex().
     size_t distinctNodeIndex = 0;
+    int distinctNodeDirection = 1;
     if (parsedDistinct->getQuery()->getQueryRequest().getFilter().isEmpty() &&
         getDistinctNodeIndex(plannerParams.indices,
                              parsedDistinct->getKey(),
                              cq->getCollator(),
-                             &distinctNodeIndex)) {
+                             plannerOptions,
+                             cq->getQueryRequest().getSort(),
+                             &distinctNodeIndex,
+                             &distinctNodeDirection)) {
         auto dn = stdx::make_unique<DistinctNode>(plannerParams.indices[distinctNodeIndex]);
-        dn->direction = 1;
+        dn->direction = distinctNodeDirection;
         IndexBoundsBuilder::allValuesBounds(dn->index.keyPattern, &dn->bounds);
+        if (dn->direction == -1) {
+            for (auto&& oil : dn->bounds.fields) {
+                oil.reverse();
+            }
+        }
         dn->fieldNo = 0;
 
         // An index with a non-simple collation requires a FETCH stage.
@@ -1542,6 +1596,9 @@ StatusWith<unique_ptr<PlanExecutor, PlanExecutor::Deleter>> getExecutorDistinct(
     // See if we can answer the query in a fast-distinct compatible fashion.
     auto statusWithSolutions = QueryPlanner::plan(*cq, plannerParams);
     if (!statusWithSolutions.isOK()) {
+        if (strict) {
+            return statusWithSolutions.getStatus();
+        }
         return getExecutor(opCtx, collection, std::move(cq), yieldPolicy);
     }
     auto solutions = std::move(statusWithSolutions.getValue());
@@ -1572,6 +1629,10 @@ StatusWith<unique_ptr<PlanExecutor, PlanExecutor::Deleter>> getExecutorDistinct(
 
     // If we're here, the planner made a soln with the restricted index set but we couldn't
     // translate any of them into a distinct-compatible soln. Just go through normal planning.
+    if (strict) {
+        return Status(ErrorCodes::BadValue,
+                      "no distinct scan plan: no solution could use a distinct scan");
+    }
     return getExecutor(opCtx, collection, parsedDistinct->releaseQuery(), yieldPolicy);
 }
 
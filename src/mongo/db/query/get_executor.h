@@ -123,12 +123,17 @@ bool turnIxscanIntoDistinctIxscan(QuerySolution* soln, const std::string& field)
  * Distinct is unique in that it doesn't care about getting all the results; it just wants all
  * possible values of a certain field.  As such, we can skip lots of data in certain cases (see
  * body of method for detail).
+ *
+ * If 'plannerOptions' includes QueryPlannerParams::STRICT_DISTINCT_ONLY, an error is returned
+ * rather than an executor which does not use a DISTINCT_SCAN. In that mode the query's sort and
+ * projection, if any, are honored: the first key of each distinct value is taken in sort order.
  */
 StatusWith<std::unique_ptr<PlanExecutor, PlanExecutor::Deleter>> getExecutorDistinct(
     OperationContext* opCtx,
     Collection* collection,
     const std::string& ns,
-    ParsedDistinct* parsedDistinct);
+    ParsedDistinct* parsedDistinct,
+    size_t plannerOptions = QueryPlannerParams::DEFAULT);
 
 /*
  * Get a PlanExecutor for a query executing as part of a count command.
@@ -107,22 +107,39 @@ public:
         // If the store has grown beyond its allowed size,
         // evict the least recently used entry.
         if (_currentSize > _maxSize) {
-            V* evictedEntry = _kvList.back().second;
-            invariant(evictedEntry);
-
-            _kvMap.erase(_kvList.back().first);
-            _kvList.pop_back();
-            _currentSize--;
+            auto evictedEntry = evictLeastRecentlyUsed();
             invariant(_currentSize == _maxSize);
-
-            // Pass ownership of evicted entry to caller.
-            // If caller chooses to ignore this unique_ptr,
-            // the evicted entry will be deleted automatically.
-            return std::unique_ptr<V>(evictedEntry);
+            return evictedEntry;
         }
         return std::unique_ptr<V>();
     }
 
+    /**
+     * Removes the least recently used entry from the kv-store and passes
+     * ownership of it to the caller. Returns an empty unique_ptr if the
+     * kv-store is empty.
+     *
+     * Lets the client enforce limits of its own, such as a bound on the
+     * total size of the stored values, on top of the entry count limit.
+     */
+    std::unique_ptr<V> evictLeastRecentlyUsed() {
+        if (_kvList.empty()) {
+            return std::unique_ptr<V>();
+        }
+
+        V* evictedEntry = _kvList.back().second;
+        invariant(evictedEntry);
+
+        _kvMap.erase(_kvList.back().first);
+        _kvList.pop_back();
+        _currentSize--;
+
+        // Pass ownership of evicted entry to caller.
+        // If caller chooses to ignore this unique_ptr,
+        // the evicted entry will be deleted automatically.
+        return std::unique_ptr<V>(evictedEntry);
+    }
+
     /**
      * Retrieve the value associated with 'key' from
      * the kv-store. The value is returned through the
@@ -175,6 +175,37 @@ TEST(LRUKeyValueTest, ReplaceKeyTest) {
     assertInKVStore(cache, 4, 5);
 }
 
+/**
+ * Test that evictLeastRecentlyUsed() removes entries in LRU order, honoring
+ * promotions, and returns an empty pointer once the kv-store is empty.
+ */
+TEST(LRUKeyValueTest, EvictLeastRecentlyUsedTest) {
+    LRUKeyValue<int, int> cache(10);
+    cache.add(1, new int(1));
+    cache.add(2, new int(2));
+    cache.add(3, new int(3));
+
+    // Promote 1 so that 2 becomes the least recently used.
+    assertInKVStore(cache, 1, 1);
+
+    std::unique_ptr<int> evicted = cache.evictLeastRecentlyUsed();
+    ASSERT(evicted);
+    ASSERT_EQUALS(*evicted, 2);
+    ASSERT_EQUALS(cache.size(), (size_t)2);
+    assertNotInKVStore(cache, 2);
+
+    evicted = cache.evictLeastRecentlyUsed();
+    ASSERT(evicted);
+    ASSERT_EQUALS(*evicted, 3);
+
+    evicted = cache.evictLeastRecentlyUsed();
+    ASSERT(evicted);
+    ASSERT_EQUALS(*evicted, 1);
+    ASSERT_EQUALS(cache.size(), (size_t)0);
+
+    ASSERT(!cache.evictLeastRecentlyUsed());
+}
+
 /**
  * Test iteration over the kv-store.
  */
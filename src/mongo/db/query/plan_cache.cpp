@@ -65,6 +65,68 @@ const char kEncodeSortSection = '~';
 const char kEncodeProjectionSection = '|';
 const char kEncodeCollationSection = '#';
 
+// Usage counters aggregated over every plan cache on the server.
+PlanCacheCounters globalPlanCacheCounters;
+
+/**
+ * Returns the approximate number of bytes of memory held by 'tree' and its descendants.
+ */
+size_t estimateIndexTreeSizeBytes(const PlanCacheIndexTree* tree) {
+    if (!tree) {
+        return 0;
+    }
+
+    size_t size = sizeof(PlanCacheIndexTree);
+    if (tree->entry) {
+        size += sizeof(IndexEntry) + tree->entry->keyPattern.objsize() + tree->entry->name.size();
+    }
+    for (auto&& orPushdown : tree->orPushdowns) {
+        size += sizeof(orPushdown) + orPushdown.indexName.size() +
+            orPushdown.route.size() * sizeof(size_t);
+    }
+    for (auto&& child : tree->children) {
+        size += sizeof(child) + estimateIndexTreeSizeBytes(child);
+    }
+    return size;
+}
+
+/**
+ * Returns the approximate number of bytes of memory held by 'stats' and its descendants. Specific
+ * stats are not measured, and are assumed to be about as large as the common stats.
+ */
+size_t estimateStatsSizeBytes(const PlanStageStats* stats) {
+    size_t size = sizeof(PlanStageStats);
+    if (stats->specific) {
+        size += sizeof(CommonStats);
+    }
+    for (auto&& child : stats->children) {
+        size += sizeof(child) + estimateStatsSizeBytes(child.get());
+    }
+    return size;
+}
+
+/**
+ * Returns the approximate number of bytes of memory held by 'entry', stored under 'key'.
+ */
+size_t estimateEntrySizeBytes(const PlanCacheKey& key, const PlanCacheEntry& entry) {
+    size_t size = sizeof(entry) + key.size() + entry.query.objsize() + entry.sort.objsize() +
+        entry.projection.objsize() + entry.collation.objsize() +
+        entry.feedback.capacity() * sizeof(double);
+
+    for (auto&& solution : entry.plannerData) {
+        size += sizeof(solution) + sizeof(SolutionCacheData) +
+            estimateIndexTreeSizeBytes(solution->tree.get());
+    }
+
+    size += sizeof(PlanRankingDecision);
+    for (auto&& stats : entry.decision->stats) {
+        size += sizeof(stats) + estimateStatsSizeBytes(stats.get());
+    }
+    size += entry.decision->scores.capacity() * sizeof(double) +
+        entry.decision->candidateOrder.capacity() * sizeof(size_t);
+    return size;
+}
+
 /**
  * Encode user-provided string. Cache key delimiters seen in the
  * user string are escaped with a backslash.
@@ -434,6 +496,7 @@ PlanCacheEntry* PlanCacheEntry::clone() const {
     entry->timeOfCreation = timeOfCreation;
     entry->isActive = isActive;
     entry->works = works;
+    entry->estimatedEntrySizeBytes = estimatedEntrySizeBytes;
 
     // Copy performance stats.
     entry->feedback = feedback;
@@ -566,9 +629,16 @@ std::unique_ptr<CachedSolution> PlanCache::getCacheEntryIfActive(const PlanCache
     if (res.state == PlanCache::CacheEntryState::kPresentInactive) {
         LOG(2) << "Not using cached entry for " << redact(res.cachedSolution->toString())
                << " since it is inactive";
+    }
+
+    if (res.state != PlanCache::CacheEntryState::kPresentActive) {
+        _counters.misses.increment();
+        globalPlanCacheCounters.misses.increment();
         return nullptr;
     }
 
+    _counters.hits.increment();
+    globalPlanCacheCounters.hits.increment();
     return std::move(res.cachedSolution);
 }
 
@@ -867,17 +937,48 @@ Status PlanCache::set(const CanonicalQuery& query,
         projBuilder.append(elem);
     }
     newEntry->projection = projBuilder.obj();
+    newEntry->estimatedEntrySizeBytes = estimateEntrySizeBytes(key, *newEntry);
 
+    // The entry being replaced, if any, is deleted by the add() below.
+    PlanCacheEntry* replacedEntry = nullptr;
+    if (_cache.get(key, &replacedEntry).isOK()) {
+        invariant(replacedEntry);
+        _cacheBytes -= replacedEntry->estimatedEntrySizeBytes;
+    }
+
+    _cacheBytes += newEntry->estimatedEntrySizeBytes;
     std::unique_ptr<PlanCacheEntry> evictedEntry = _cache.add(key, newEntry.release());
 
     if (NULL != evictedEntry.get()) {
+        _cacheBytes -= evictedEntry->estimatedEntrySizeBytes;
+        _counters.evictions.increment();
+        globalPlanCacheCounters.evictions.increment();
         LOG(1) << _ns << ": plan cache maximum size exceeded - "
                << "removed least recently used entry " << redact(evictedEntry->toString());
     }
 
+    evictToRespectSizeLimit(cacheLock);
+
     return Status::OK();
 }
 
+void PlanCache::evictToRespectSizeLimit(WithLock) {
+    const long long maxSizeBytes = internalQueryCacheMaxSizeBytes.load();
+    if (maxSizeBytes <= 0) {
+        return;
+    }
+
+    while (_cacheBytes > static_cast<size_t>(maxSizeBytes) && _cache.size() > 1) {
+        std::unique_ptr<PlanCacheEntry> evictedEntry = _cache.evictLeastRecentlyUsed();
+        invariant(evictedEntry);
+        _cacheBytes -= evictedEntry->estimatedEntrySizeBytes;
+        _counters.evictions.increment();
+        globalPlanCacheCounters.evictions.increment();
+        LOG(1) << _ns << ": plan cache maximum size in bytes exceeded - "
+               << "removed least recently used entry " << redact(evictedEntry->toString());
+    }
+}
+
 void PlanCache::deactivate(const CanonicalQuery& query) {
     if (internalQueryCacheDisableInactiveEntries.load()) {
         // This is a noop if inactive entries are disabled.
@@ -936,13 +1037,24 @@ Status PlanCache::feedback(const CanonicalQuery& cq, double score) {
 }
 
 Status PlanCache::remove(const CanonicalQuery& canonicalQuery) {
+    const auto key = computeKey(canonicalQuery);
+
     stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
-    return _cache.remove(computeKey(canonicalQuery));
+    PlanCacheEntry* entry = nullptr;
+    Status cacheStatus = _cache.get(key, &entry);
+    if (!cacheStatus.isOK()) {
+        return cacheStatus;
+    }
+    invariant(entry);
+
+    _cacheBytes -= entry->estimatedEntrySizeBytes;
+    return _cache.remove(key);
 }
 
 void PlanCache::clear() {
     stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
     _cache.clear();
+    _cacheBytes = 0;
 }
 
 PlanCacheKey PlanCache::computeKey(const CanonicalQuery& cq) const {
@@ -988,6 +1100,38 @@ size_t PlanCache::size() const {
     return _cache.size();
 }
 
+size_t PlanCache::estimatedSizeBytes() const {
+    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
+    return _cacheBytes;
+}
+
+const PlanCacheCounters& PlanCache::getGlobalCounters() {
+    return globalPlanCacheCounters;
+}
+
+void PlanCache::recordReplan() {
+    _counters.replans.increment();
+    globalPlanCacheCounters.replans.increment();
+}
+
+void PlanCache::recordTrialPeriod(size_t works, long long micros) {
+    for (auto counters : {&_counters, &globalPlanCacheCounters}) {
+        counters->trialPeriods.increment();
+        counters->trialPeriodWorks.increment(works);
+        counters->trialPeriodMicros.increment(micros);
+    }
+}
+
+void PlanCacheCounters::appendTo(BSONObjBuilder* builder) const {
+    builder->append("hits", hits.get());
+    builder->append("misses", misses.get());
+    builder->append("evictions", evictions.get());
+    builder->append("replans", replans.get());
+    builder->append("trialPeriods", trialPeriods.get());
+    builder->append("trialPeriodWorks", trialPeriodWorks.get());
+    builder->append("trialPeriodMicros", trialPeriodMicros.get());
+}
+
 void PlanCache::notifyOfIndexEntries(const std::vector<IndexEntry>& indexEntries) {
     _indexabilityState.updateDiscriminators(indexEntries);
 }
@@ -31,6 +31,7 @@
 #include <boost/optional/optional.hpp>
 #include <set>
 
+#include "mongo/base/counter.h"
 #include "mongo/db/exec/plan_stats.h"
 #include "mongo/db/query/canonical_query.h"
 #include "mongo/db/query/index_tag.h"
@@ -39,6 +40,7 @@
 #include "mongo/db/query/query_planner_params.h"
 #include "mongo/platform/atomic_word.h"
 #include "mongo/stdx/mutex.h"
+#include "mongo/util/concurrency/with_lock.h"
 
 namespace mongo {
 
@@ -279,6 +281,36 @@ public:
     // trigger a replan. Running a query of the same shape while this cache entry is inactive may
     // cause this value to be increased.
     size_t works = 0;
+
+    // Approximate number of bytes of memory held by this entry, including its cache key. Computed
+    // by the cache when the entry is added, and used to bound the total size of the cache.
+    size_t estimatedEntrySizeBytes = 0;
+};
+
+/**
+ * Counters describing how a plan cache has been used. Each PlanCache keeps its own set, and every
+ * update is also applied to a set aggregated over all of the server's plan caches, which is
+ * reported by serverStatus.
+ */
+struct PlanCacheCounters {
+    // Lookups by the planner which found an active entry.
+    Counter64 hits;
+
+    // Lookups by the planner which found no entry, or only an inactive one.
+    Counter64 misses;
+
+    // Entries removed to respect the entry count or byte size limits of the cache.
+    Counter64 evictions;
+
+    // Times a cached plan was found to perform poorly and the query was replanned.
+    Counter64 replans;
+
+    // Multi-planner trial periods, and the total works and time spent in them.
+    Counter64 trialPeriods;
+    Counter64 trialPeriodWorks;
+    Counter64 trialPeriodMicros;
+
+    void appendTo(BSONObjBuilder* builder) const;
 };
 
 /**
@@ -384,6 +416,7 @@ public:
     /**
      * If the cache entry exists and is active, return a CachedSolution. If the cache entry is
      * inactive, log a message and return a nullptr. If no cache entry exists, return a nullptr.
+     * Counts the lookup as a hit or a miss.
      */
     std::unique_ptr<CachedSolution> getCacheEntryIfActive(const PlanCacheKey& key) const;
 
@@ -450,6 +483,35 @@ public:
      */
     size_t size() const;
 
+    /**
+     * Returns the approximate number of bytes held by the entries in the cache.
+     */
+    size_t estimatedSizeBytes() const;
+
+    /**
+     * Returns the usage counters of this cache.
+     */
+    const PlanCacheCounters& getCounters() const {
+        return _counters;
+    }
+
+    /**
+     * Returns the usage counters aggregated over every plan cache on this server.
+     */
+    static const PlanCacheCounters& getGlobalCounters();
+
+    /**
+     * Records that a plan retrieved from this cache was evicted from the cache during execution
+     * and the query replanned.
+     */
+    void recordReplan();
+
+    /**
+     * Records a multi-planner trial period for a query over this cache's collection, during which
+     * the candidate plans performed 'works' works in total over 'micros' microseconds.
+     */
+    void recordTrialPeriod(size_t works, long long micros);
+
     /**
      * Updates internal state kept about the collection's indexes.  Must be called when the set
      * of indexes on the associated collection have changed.
@@ -474,11 +536,26 @@ private:
     void encodeKeyForSort(const BSONObj& sortObj, StringBuilder* keyBuilder) const;
     void encodeKeyForProj(const BSONObj& projObj, StringBuilder* keyBuilder) const;
 
+    /**
+     * Evicts least recently used entries until the cache respects internalQueryCacheMaxSizeBytes.
+     * The most recently used entry is always kept, however large it is.
+     *
+     * Callers must hold _cacheMutex.
+     */
+    void evictToRespectSizeLimit(WithLock);
+
     LRUKeyValue<PlanCacheKey, PlanCacheEntry> _cache;
 
-    // Protects _cache.
+    // Approximate number of bytes held by the entries in _cache.
+    size_t _cacheBytes = 0;
+
+    // Protects _cache and _cacheBytes.
     mutable stdx::mutex _cacheMutex;
 
+    // Counters are updated atomically, so are safe to update without holding _cacheMutex. They
+    // are mutable since lookups, which are logically const, count hits and misses.
+    mutable PlanCacheCounters _counters;
+
     // Full namespace of collection.
     std::string _ns;
 
@@ -762,6 +762,116 @@ TEST(PlanCacheTest, DeactivateCacheEntry) {
     ASSERT_EQ(entry->works, 20U);
 }
 
+TEST(PlanCacheTest, LookupsCountHitsAndMisses) {
+    PlanCache planCache;
+    unique_ptr<CanonicalQuery> cq(canonicalize("{a: 1}"));
+    auto qs = getQuerySolutionForCaching();
+    std::vector<QuerySolution*> solns = {qs.get()};
+    const auto key = planCache.computeKey(*cq);
+    QueryTestServiceContext serviceContext;
+
+    // A lookup for an absent entry is a miss.
+    ASSERT_FALSE(planCache.getCacheEntryIfActive(key));
+    ASSERT_EQ(planCache.getCounters().misses.get(), 1);
+
+    // So is a lookup which finds an inactive entry.
+    ASSERT_OK(planCache.set(*cq, solns, createDecision(1U, 50), Date_t{}));
+    ASSERT_FALSE(planCache.getCacheEntryIfActive(key));
+    ASSERT_EQ(planCache.getCounters().misses.get(), 2);
+    ASSERT_EQ(planCache.getCounters().hits.get(), 0);
+
+    // Once the entry is active, lookups are hits.
+    ASSERT_OK(planCache.set(*cq, solns, createDecision(1U, 20), Date_t{}));
+    ASSERT_TRUE(planCache.getCacheEntryIfActive(key));
+    ASSERT_EQ(planCache.getCounters().hits.get(), 1);
+    ASSERT_EQ(planCache.getCounters().misses.get(), 2);
+
+    // Inspecting the cache does not count as a lookup.
+    ASSERT_EQ(planCache.get(*cq).state, PlanCache::CacheEntryState::kPresentActive);
+    ASSERT_EQ(planCache.getCounters().hits.get(), 1);
+}
+
+TEST(PlanCacheTest, RecordsReplansAndTrialPeriods) {
+    PlanCache planCache;
+    const long long globalReplans = PlanCache::getGlobalCounters().replans.get();
+    const long long globalTrialPeriodWorks = PlanCache::getGlobalCounters().trialPeriodWorks.get();
+
+    planCache.recordReplan();
+    planCache.recordTrialPeriod(30, 100);
+    planCache.recordTrialPeriod(12, 5);
+
+    ASSERT_EQ(planCache.getCounters().replans.get(), 1);
+    ASSERT_EQ(planCache.getCounters().trialPeriods.get(), 2);
+    ASSERT_EQ(planCache.getCounters().trialPeriodWorks.get(), 42);
+    ASSERT_EQ(planCache.getCounters().trialPeriodMicros.get(), 105);
+    ASSERT_EQ(PlanCache::getGlobalCounters().replans.get(), globalReplans + 1);
+    ASSERT_EQ(PlanCache::getGlobalCounters().trialPeriodWorks.get(), globalTrialPeriodWorks + 42);
+}
+
+TEST(PlanCacheTest, EstimatedSizeTracksEntries) {
+    PlanCache planCache;
+    unique_ptr<CanonicalQuery> cqA(canonicalize("{a: 1}"));
+    unique_ptr<CanonicalQuery> cqB(canonicalize("{b: 1, c: {$gt: 5}}"));
+    QueryTestServiceContext serviceContext;
+    ASSERT_EQ(planCache.estimatedSizeBytes(), 0U);
+
+    addCacheEntryForShape(*cqA, &planCache);
+    const size_t sizeA = assertGet(planCache.getEntry(*cqA))->estimatedEntrySizeBytes;
+    ASSERT_GT(sizeA, 0U);
+    ASSERT_EQ(planCache.estimatedSizeBytes(), sizeA);
+
+    addCacheEntryForShape(*cqB, &planCache);
+    const size_t sizeB = assertGet(planCache.getEntry(*cqB))->estimatedEntrySizeBytes;
+    ASSERT_EQ(planCache.estimatedSizeBytes(), sizeA + sizeB);
+
+    // Replacing an entry does not count the replaced entry twice.
+    auto qs = getQuerySolutionForCaching();
+    std::vector<QuerySolution*> solns = {qs.get()};
+    ASSERT_OK(planCache.set(*cqA, solns, createDecision(1U, 0), Date_t{}));
+    ASSERT_EQ(planCache.estimatedSizeBytes(), sizeA + sizeB);
+
+    ASSERT_OK(planCache.remove(*cqA));
+    ASSERT_EQ(planCache.estimatedSizeBytes(), sizeB);
+
+    planCache.clear();
+    ASSERT_EQ(planCache.estimatedSizeBytes(), 0U);
+}
+
+TEST(PlanCacheTest, PlanCacheEvictsEntriesToRespectSizeLimitInBytes) {
+    PlanCache planCache;
+    unique_ptr<CanonicalQuery> cqA(canonicalize("{a: 1}"));
+    unique_ptr<CanonicalQuery> cqB(canonicalize("{b: 1}"));
+    unique_ptr<CanonicalQuery> cqC(canonicalize("{c: 1}"));
+    QueryTestServiceContext serviceContext;
+
+    addCacheEntryForShape(*cqA, &planCache);
+    const size_t entrySize = planCache.estimatedSizeBytes();
+
+    // Allow room for two entries of this size.
+    internalQueryCacheMaxSizeBytes.store(2 * entrySize + entrySize / 2);
+    ON_BLOCK_EXIT([] { internalQueryCacheMaxSizeBytes.store(0); });
+
+    addCacheEntryForShape(*cqB, &planCache);
+    ASSERT_EQ(planCache.size(), 2U);
+    ASSERT_EQ(planCache.getCounters().evictions.get(), 0);
+
+    // Adding a third entry evicts the least recently used one, {a: 1}.
+    addCacheEntryForShape(*cqC, &planCache);
+    ASSERT_EQ(planCache.size(), 2U);
+    ASSERT_EQ(planCache.getCounters().evictions.get(), 1);
+    ASSERT_EQ(planCache.get(*cqA).state, PlanCache::CacheEntryState::kNotPresent);
+    ASSERT_EQ(planCache.get(*cqB).state, PlanCache::CacheEntryState::kPresentInactive);
+    ASSERT_EQ(planCache.get(*cqC).state, PlanCache::CacheEntryState::kPresentInactive);
+    ASSERT_LTE(planCache.estimatedSizeBytes(), 2 * entrySize + entrySize / 2);
+
+    // The most recently added entry is always kept, even if it alone exceeds the limit.
+    internalQueryCacheMaxSizeBytes.store(1);
+    addCacheEntryForShape(*cqA, &planCache);
+    ASSERT_EQ(planCache.size(), 1U);
+    ASSERT_EQ(planCache.getCounters().evictions.get(), 3);
+    ASSERT_EQ(planCache.get(*cqA).state, PlanCache::CacheEntryState::kPresentInactive);
+}
+
 
 /**
  * Each test in the CachePlanSelectionTest suite goes through
@@ -50,6 +50,7 @@
 #include "mongo/db/query/find_common.h"
 #include "mongo/db/query/mock_yield_policies.h"
 #include "mongo/db/query/plan_yield_policy.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/repl/replication_coordinator.h"
 #include "mongo/db/service_context.h"
 #include "mongo/db/storage/record_fetcher.h"
@@ -348,6 +349,12 @@ void PlanExecutor::saveState() {
     // boundaries.
     WorkingSetCommon::prepareForSnapshotChange(_workingSet.get());
 
+    // Results from the root stage's last batch which have not been returned yet may point into
+    // memory owned by a storage engine cursor, which is not valid across a yield.
+    for (auto id : _batchedResults) {
+        _workingSet->get(id)->makeObjOwnedIfNeeded();
+    }
+
     if (!isMarkedAsKilled()) {
         _root->saveState();
     }
@@ -543,8 +550,10 @@ PlanExecutor::ExecState PlanExecutor::getNextImpl(Snapshotted<BSONObj>* objOut,
         //   1) The yield policy's timer elapsed, or
         //   2) some stage requested a yield due to a document fetch, or
         //   3) we need to yield and retry due to a WriteConflictException.
-        // In all cases, the actual yielding happens here.
-        if (_yieldPolicy->shouldYieldOrInterrupt()) {
+        // In all cases, the actual yielding happens here. When working in batches, we only check
+        // between batches, so that a yield never happens while we are part way through one.
+        const bool midBatch = !_batchedResults.empty() || _batchedState;
+        if (!midBatch && _yieldPolicy->shouldYieldOrInterrupt()) {
             auto yieldStatus = _yieldPolicy->yieldOrInterrupt(fetcher.get());
             if (!yieldStatus.isOK()) {
                 if (objOut) {
@@ -560,7 +569,7 @@ PlanExecutor::ExecState PlanExecutor::getNextImpl(Snapshotted<BSONObj>* objOut,
         fetcher.reset();
 
         WorkingSetID id = WorkingSet::INVALID_ID;
-        PlanStage::StageState code = _root->work(&id);
+        PlanStage::StageState code = workRoot(&id);
 
         if (code != PlanStage::NEED_YIELD)
             writeConflictsInARow = 0;
@@ -653,9 +662,57 @@ PlanExecutor::ExecState PlanExecutor::getNextImpl(Snapshotted<BSONObj>* objOut,
     }
 }
 
+bool PlanExecutor::shouldWorkInBatches(int batchSize) const {
+    if (batchSize <= 1) {
+        return false;
+    }
+
+    if (_nss.isOplog() || (_cq && _cq->getQueryRequest().isTailable())) {
+        return false;
+    }
+
+    return supportsDocLocking();
+}
+
+PlanStage::StageState PlanExecutor::workRoot(WorkingSetID* out) {
+    if (_batchedResults.empty() && !_batchedState) {
+        // Read the knob once, since it may be changed at any time.
+        const int batchSize = internalQueryExecWorkBatchSize.load();
+        if (!shouldWorkInBatches(batchSize)) {
+            return _root->work(out);
+        }
+
+        _batch.clear();
+        WorkingSetID stateId = WorkingSet::INVALID_ID;
+        const PlanStage::StageState code = _root->workBatch(batchSize, &_batch, &stateId);
+
+        _batchedResults.insert(_batchedResults.end(), _batch.begin(), _batch.end());
+
+        if (PlanStage::NEED_TIME != code) {
+            _batchedState = std::make_pair(code, stateId);
+        }
+    }
+
+    if (!_batchedResults.empty()) {
+        *out = _batchedResults.front();
+        _batchedResults.pop_front();
+        return PlanStage::ADVANCED;
+    }
+
+    if (_batchedState) {
+        const PlanStage::StageState code = _batchedState->first;
+        *out = _batchedState->second;
+        _batchedState = boost::none;
+        return code;
+    }
+
+    return PlanStage::NEED_TIME;
+}
+
 bool PlanExecutor::isEOF() {
     invariant(_currentState == kUsable);
-    return isMarkedAsKilled() || (_stash.empty() && _root->isEOF());
+    return isMarkedAsKilled() ||
+        (_stash.empty() && _batchedResults.empty() && !_batchedState && _root->isEOF());
 }
 
 void PlanExecutor::markAsKilled(Status killStatus) {
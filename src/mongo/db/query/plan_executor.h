@@ -29,10 +29,14 @@
 #pragma once
 
 #include <boost/optional.hpp>
+#include <deque>
 #include <queue>
+#include <utility>
+#include <vector>
 
 #include "mongo/base/status.h"
 #include "mongo/db/catalog/util/partitioned.h"
+#include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/invalidation_type.h"
 #include "mongo/db/query/query_solution.h"
 #include "mongo/db/storage/snapshot.h"
@@ -506,6 +510,22 @@ private:
 
     ExecState getNextImpl(Snapshotted<BSONObj>* objOut, RecordId* dlOut);
 
+    /**
+     * Returns true if the root stage should be worked in batches of 'batchSize', the value read
+     * from 'internalQueryExecWorkBatchSize', through PlanStage::workBatch(). This is only the case
+     * when 'batchSize' is greater than 1, and never for
+     * tailable cursors or oplog scans, which must not run ahead of the results they have returned,
+     * nor on storage engines without document-level locking, whose invalidations do not reach
+     * results buffered here.
+     */
+    bool shouldWorkInBatches(int batchSize) const;
+
+    /**
+     * Performs the next unit of work on the root stage, or hands back a result or state which was
+     * buffered by an earlier call to PlanStage::workBatch().
+     */
+    PlanStage::StageState workRoot(WorkingSetID* out);
+
     /**
      * New PlanExecutor instances are created with the static make() methods above.
      */
@@ -580,6 +600,17 @@ private:
     // stages.
     std::queue<BSONObj> _stash;
 
+    // Results produced by the root stage in a batch which have not been returned yet, in the order
+    // they were produced. The ids are owned by this executor until they are returned or freed.
+    std::deque<WorkingSetID> _batchedResults;
+
+    // If the root stage's last batch ended in a state other than ADVANCED or NEED_TIME, that state
+    // and its WorkingSetID. It is handled once '_batchedResults' has been drained.
+    boost::optional<std::pair<PlanStage::StageState, WorkingSetID>> _batchedState;
+
+    // Reused across batches to receive results from the root stage.
+    std::vector<WorkingSetID> _batch;
+
     enum { kUsable, kSaved, kDetached, kDisposed } _currentState = kUsable;
 
     // Set if this PlanExecutor is registered with the CursorManager.
@@ -28,6 +28,8 @@
 
 #pragma once
 
+#include <string>
+
 #include "mongo/platform/atomic_proxy.h"
 #include "mongo/platform/atomic_word.h"
 
@@ -64,6 +66,10 @@ extern AtomicBool internalQueryPlannerEnableHashIntersection;
 // How many entries in the cache?
 extern AtomicInt32 internalQueryCacheSize;
 
+// Approximately how many bytes may the entries in a collection's cache hold? Least recently used
+// entries are evicted beyond this. 0 means the cache is bounded by entry count alone.
+extern AtomicInt64 internalQueryCacheMaxSizeBytes;
+
 // How many feedback entries do we collect before possibly evicting from the cache based on bad
 // performance?
 extern AtomicInt32 internalQueryCacheFeedbacksStored;
@@ -120,6 +126,18 @@ extern AtomicInt32 internalQueryExecYieldIterations;
 // Yield if it's been at least this many milliseconds since we last yielded.
 extern AtomicInt32 internalQueryExecYieldPeriodMS;
 
+// If greater than 1, the PlanExecutor asks the root stage for up to this many units of work at a
+// time through PlanStage::workBatch(), rather than one at a time, and checks whether to yield once
+// per batch. 0 or 1 disables batched execution.
+extern AtomicInt32 internalQueryExecWorkBatchSize;
+
+// If greater than 1, a FetchStage worked in batches reads up to this many of the records its child
+// produced through a separate cursor, in RecordId order, before fetching them in the order they
+// were produced. This lets the storage engine read cold pages in key order rather than at random.
+// It also asks its child for batches of at least this size, so it is limited to 1024. 0 or 1
+// disables reading ahead.
+extern AtomicInt32 internalQueryFetchLookaheadRecords;
+
 // Limit the size that we write without yielding to 16MB / 64 (max expected number of indexes)
 const int64_t insertVectorMaxBytes = 256 * 1024;
 
@@ -128,16 +146,59 @@ extern AtomicInt32 internalQueryFacetBufferSizeBytes;
 
 extern AtomicInt64 internalDocumentSourceSortMaxBlockingSortBytes;
 
+// A $sort at the front of a pipeline which has absorbed a $limit no greater than this is performed
+// by the query system as a top-k SORT stage when no index can provide the sort, unless the
+// aggregation allows disk use. Zero disables this.
+extern AtomicInt64 internalDocumentSourceSortMaxPushdownLimit;
+
+// Number of threads which sort and spill runs in parallel for external sorts without a limit, such
+// as index builds and $sort with allowDiskUse. The sort's memory limit is split between them.
+extern AtomicInt32 internalSorterRunGenerationThreads;
+
+// The most spilled runs an external sort merges at once. A sort which spilled more runs first
+// merges them in groups into fewer, longer runs. Zero means no limit.
+extern AtomicInt32 internalSorterMaxMergeFanIn;
+
+// How external sorts compress their spill files: "none", "snappy" or "zlib".
+extern std::string internalSorterSpillCompressor;
+
 extern AtomicInt64 internalDocumentSourceGroupMaxMemoryBytes;
 
+// If greater than 1, an unsorted $group in a mongod pipeline hash-partitions its input by group key
+// across this many threads through an exchange. Each thread groups its share of the input within
+// an equal share of the $group memory limit, and the results are concatenated. Each such $group
+// starts its own threads, so this is limited to 16.
+extern AtomicInt32 internalDocumentSourceGroupPartitions;
+
+// If true, a $group at the front of a pipeline is answered from index keys alone when possible:
+// with a DISTINCT_SCAN visiting one key per group when it only needs the first or last document
+// of each group, or else with a covered scan of an index holding every field it reads. Off by
+// default, since the covered scan is chosen by hint rather than by the plan cache or multiplanner.
+extern AtomicBool internalDocumentSourceGroupUseIndexOnlyPlans;
+
 extern AtomicInt32 internalInsertMaxBatchSize;
 
 extern AtomicInt32 internalDocumentSourceCursorBatchSizeBytes;
 
 extern AtomicInt32 internalDocumentSourceLookupCacheSizeBytes;
 
+// If true, a $lookup using the localField/foreignField syntax reads the foreign collection once
+// into a hash table and probes it with each input document, rather than querying the foreign
+// collection once per input document.
+extern AtomicBool internalDocumentSourceLookupUseHashJoin;
+
+// The approximate number of bytes of foreign documents a $lookup hash join may hold in memory. If
+// exceeded, the join spills to disk when allowDiskUse is set, and otherwise falls back to querying
+// the foreign collection per input document.
+extern AtomicInt64 internalDocumentSourceLookupHashJoinMaxMemoryBytes;
+
 extern AtomicBool internalQueryProhibitBlockingMergeOnMongoS;
 
+// If true, $project, $addFields and $group compile each of their expressions made up only of
+// supported operators into a flat program, which is run in place of walking the expression tree.
+// Off by default.
+extern AtomicBool internalPipelineCompileExpressions;
+
 //
 // In-progress features.
 //
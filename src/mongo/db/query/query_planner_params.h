@@ -91,6 +91,12 @@ struct QueryPlannerParams {
 
         // Set this so that collection scans on the oplog wait for visibility before reading.
         OPLOG_SCAN_WAIT_FOR_VISIBLE = 1 << 10,
+
+        // Set this when only a plan which skips through an index with a DISTINCT_SCAN is wanted,
+        // for a caller which needs every document of each distinct value to be reflected by the
+        // one it is given, such as an aggregation $group. Indexes which may hold several keys for
+        // a document, or no key for some documents, are not used.
+        STRICT_DISTINCT_ONLY = 1 << 11,
     };
 
     // See Options enum above.
@@ -1082,6 +1082,27 @@ void DistinctNode::appendToString(mongoutils::str::stream* ss, int indent) const
     *ss << "bounds = " << bounds.toString() << '\n';
 }
 
+void DistinctNode::computeProperties() {
+    sorts.clear();
+
+    // A multikey index may produce several keys for one document, so cannot provide any sorts.
+    if (index.multikey) {
+        return;
+    }
+
+    BSONObj sortPattern = QueryPlannerAnalysis::getSortPattern(index.keyPattern);
+    if (direction == -1) {
+        sortPattern = QueryPlannerCommon::reverseSortObj(sortPattern);
+    }
+
+    // We're sorted not only by sortPattern but also by all prefixes of it.
+    BSONObjBuilder prefixBob;
+    for (auto&& elem : sortPattern) {
+        prefixBob.append(elem);
+        sorts.insert(prefixBob.asTempObj().getOwned());
+    }
+}
+
 QuerySolutionNode* DistinctNode::clone() const {
     DistinctNode* copy = new DistinctNode(this->index);
     cloneBaseData(copy);
@@ -862,8 +862,11 @@ struct DistinctNode : public QuerySolutionNode {
     }
     virtual void appendToString(mongoutils::str::stream* ss, int indent) const;
 
-    // This stage is created "on top" of normal planning and as such the properties
-    // below don't really matter.
+    // This stage is usually created "on top" of normal planning and as such the properties
+    // below don't really matter. When it is planned directly, the sorts let the planner know
+    // that the first key of each distinct value is produced in index order.
+    void computeProperties();
+
     bool fetched() const {
         return false;
     }
@@ -35,10 +35,14 @@
 #include <algorithm>
 #include <iterator>
 
+#include "mongo/base/counter.h"
 #include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/commands/server_status_metric.h"
 #include "mongo/db/query/query_knobs.h"
 #include "mongo/db/repl/oplog_entry.h"
 #include "mongo/db/repl/sync_tail.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/platform/bits.h"
 #include "mongo/util/assert_util.h"
 #include "mongo/util/log.h"
 
@@ -51,7 +55,59 @@ namespace {
 const auto kInsertGroupMaxBatchSize = insertVectorMaxBytes;
 
 // Limit number of ops in a single group.
-constexpr auto kInsertGroupMaxBatchCount = 64;
+MONGO_EXPORT_SERVER_PARAMETER(replInsertGroupMaxBatchCount, int, 64)
+    ->withValidator([](const int& newVal) {
+        if (newVal < 1 || newVal > 10000) {
+            return Status(ErrorCodes::BadValue,
+                          "replInsertGroupMaxBatchCount must be between 1 and 10000");
+        }
+
+        return Status::OK();
+    });
+
+/**
+ * Counts the number of inserts applied together by each writer, including inserts applied alone,
+ * in buckets whose lower bounds are powers of two. Reported in serverStatus as
+ * metrics.repl.apply.insertGroups.
+ */
+class InsertGroupSizeMetric : public ServerStatusMetric {
+public:
+    static constexpr int kMaxBuckets = 15;
+
+    InsertGroupSizeMetric() : ServerStatusMetric("repl.apply.insertGroups") {}
+
+    void record(std::size_t groupSize) {
+        invariant(groupSize > 0U);
+        const int log2 = 63 - countLeadingZeros64(groupSize);
+        _buckets[std::min(log2, kMaxBuckets - 1)].increment();
+        _groups.increment();
+        _ops.increment(groupSize);
+    }
+
+    void appendAtLeaf(BSONObjBuilder& b) const override {
+        BSONObjBuilder metricBuilder(b.subobjStart(_leafName));
+        metricBuilder.append("groups", _groups.get());
+        metricBuilder.append("ops", _ops.get());
+
+        BSONArrayBuilder histogramBuilder(metricBuilder.subarrayStart("histogram"));
+        for (int i = 0; i < kMaxBuckets; ++i) {
+            if (_buckets[i].get() == 0) {
+                continue;
+            }
+            BSONObjBuilder entryBuilder(histogramBuilder.subobjStart());
+            entryBuilder.append("size", 1LL << i);
+            entryBuilder.append("count", _buckets[i].get());
+            entryBuilder.doneFast();
+        }
+        histogramBuilder.doneFast();
+        metricBuilder.doneFast();
+    }
+
+private:
+    Counter64 _buckets[kMaxBuckets];
+    Counter64 _groups;
+    Counter64 _ops;
+} insertGroupSizes;
 
 }  // namespace
 
@@ -85,10 +141,12 @@ StatusWith<InsertGroup::ConstIterator> InsertGroup::groupAndApplyInserts(ConstIt
         return Status(ErrorCodes::TypeMismatch, "Can only group insert operations.");
     }
     if (entry.isForCappedCollection) {
+        insertGroupSizes.record(1U);
         return Status(ErrorCodes::InvalidOptions,
                       "Cannot group insert operations on capped collections.");
     }
     if (it <= _doNotGroupBeforePoint) {
+        insertGroupSizes.record(1U);
         return Status(ErrorCodes::InvalidPath,
                       "Cannot group an insert operation that we previously attempted to group.");
     }
@@ -100,6 +158,7 @@ StatusWith<InsertGroup::ConstIterator> InsertGroup::groupAndApplyInserts(ConstIt
     auto batchSize = entry.getObject().objsize();
     auto batchCount = OperationPtrs::size_type(1);
     auto batchNamespace = entry.getNamespace();
+    const auto maxBatchCount = OperationPtrs::size_type(replInsertGroupMaxBatchCount.load());
 
     /**
      * Search for the op that delimits this insert batch, and save its position
@@ -126,11 +185,12 @@ StatusWith<InsertGroup::ConstIterator> InsertGroup::groupAndApplyInserts(ConstIt
                 || opNamespace != batchNamespace                  // Must be in the same namespace.
                 || batchSize > kInsertGroupMaxBatchSize  // Must not create too large an object.
                 ||
-                batchCount > kInsertGroupMaxBatchCount;  // Limit number of ops in a single group.
+                batchCount > maxBatchCount;  // Limit number of ops in a single group.
         });
 
     // See if we were able to create a group that contains more than a single op.
     if (std::distance(it, endOfGroupableOpsIterator) == 1) {
+        insertGroupSizes.record(1U);
         return Status(ErrorCodes::NoSuchKey,
                       "Not able to create a group with more than a single insert operation");
     }
@@ -187,6 +247,7 @@ StatusWith<InsertGroup::ConstIterator> InsertGroup::groupAndApplyInserts(ConstIt
     try {
         // Apply the group of inserts.
         uassertStatusOK(SyncTail::syncApply(_opCtx, groupedInsertObj, _mode));
+        insertGroupSizes.record(std::distance(it, endOfGroupableOpsIterator));
         // It succeeded, advance the oplogEntriesIterator to the end of the
         // group of inserts.
         return endOfGroupableOpsIterator - 1;
@@ -209,6 +270,9 @@ StatusWith<InsertGroup::ConstIterator> InsertGroup::groupAndApplyInserts(ConstIt
         // are beyond this group of ops.
         _doNotGroupBeforePoint = endOfGroupableOpsIterator - 1;
 
+        // The first insert of the group is applied alone by the caller.
+        insertGroupSizes.record(1U);
+
         return status;
     }
 
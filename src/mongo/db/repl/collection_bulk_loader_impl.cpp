@@ -35,6 +35,7 @@
 #include "mongo/bson/bsonobj.h"
 #include "mongo/bson/bsonobjbuilder.h"
 #include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog/document_validation.h"
 #include "mongo/db/catalog/index_create.h"
 #include "mongo/db/client.h"
 #include "mongo/db/concurrency/d_concurrency.h"
@@ -43,7 +44,10 @@
 #include "mongo/db/jsobj.h"
 #include "mongo/db/operation_context.h"
 #include "mongo/db/repl/collection_bulk_loader_impl.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/db/storage/record_store.h"
 #include "mongo/util/destructor_guard.h"
+#include "mongo/util/fail_point_service.h"
 #include "mongo/util/log.h"
 #include "mongo/util/mongoutils/str.h"
 #include "mongo/util/scopeguard.h"
@@ -51,6 +55,37 @@
 namespace mongo {
 namespace repl {
 
+namespace {
+
+// Whether documents are appended through a RecordStoreBulkBuilder, when the storage engine
+// supports one, instead of being inserted one WriteUnitOfWork at a time.
+MONGO_EXPORT_SERVER_PARAMETER(collectionBulkLoaderUseRecordStoreBulkBuilder, bool, true);
+
+/**
+ * Returns true if documents for 'coll' may bypass Collection::insertDocument(). The bulk path
+ * skips document validation, op observers and the insert failpoint, so it is only used for
+ * non-capped user collections whose every document is also fed to an index builder.
+ */
+bool canUseRecordStoreBulkBuilder(OperationContext* opCtx,
+                                  const Collection* coll,
+                                  bool hasIndexers) {
+    if (!collectionBulkLoaderUseRecordStoreBulkBuilder.load() || !hasIndexers ||
+        coll->isCapped() || !documentValidationDisabled(opCtx)) {
+        return false;
+    }
+
+    const NamespaceString& nss = coll->ns();
+    if (nss.isSystem() || nss.isOnInternalDb()) {
+        return false;
+    }
+
+    // Tests inject insert failures through this failpoint, which only Collection::insertDocument()
+    // checks.
+    return !MONGO_FAIL_POINT(failCollectionInserts);
+}
+
+}  // namespace
+
 CollectionBulkLoaderImpl::CollectionBulkLoaderImpl(ServiceContext::UniqueClient&& client,
                                                    ServiceContext::UniqueOperationContext&& opCtx,
                                                    std::unique_ptr<AutoGetCollection>&& autoColl,
@@ -100,6 +135,12 @@ Status CollectionBulkLoaderImpl::init(const std::vector<BSONObj>& secondaryIndex
                 _idIndexBlock.reset();
             }
 
+            if (canUseRecordStoreBulkBuilder(
+                    _opCtx.get(), coll, _idIndexBlock || _secondaryIndexesBlock)) {
+                // Null if the storage engine cannot bulk load this collection right now.
+                _recordStoreBulkBuilder = coll->getRecordStore()->getBulkBuilder(_opCtx.get());
+            }
+
             return Status::OK();
         });
 }
@@ -110,6 +151,10 @@ Status CollectionBulkLoaderImpl::insertDocuments(const std::vector<BSONObj>::con
     return _runTaskReleaseResourcesOnFailure([&]() -> Status {
         UnreplicatedWritesBlock uwb(_opCtx.get());
 
+        if (_recordStoreBulkBuilder) {
+            return _insertDocumentsInBulk(begin, end);
+        }
+
         for (auto iter = begin; iter != end; ++iter) {
             std::vector<MultiIndexBlock*> indexers;
             if (_idIndexBlock) {
@@ -155,12 +200,46 @@ Status CollectionBulkLoaderImpl::insertDocuments(const std::vector<BSONObj>::con
     });
 }
 
+Status CollectionBulkLoaderImpl::_insertDocumentsInBulk(
+    const std::vector<BSONObj>::const_iterator begin,
+    const std::vector<BSONObj>::const_iterator end) {
+    invariant(!_opCtx->lockState()->inAWriteUnitOfWork());
+    for (auto iter = begin; iter != end; ++iter) {
+        auto loc = _recordStoreBulkBuilder->addRecord(iter->objdata(), iter->objsize());
+        if (!loc.isOK()) {
+            return loc.getStatus();
+        }
+
+        // Index builds in the loader are foreground builds, so these only add keys to sorters.
+        for (auto&& indexer : {_idIndexBlock.get(), _secondaryIndexesBlock.get()}) {
+            if (!indexer) {
+                continue;
+            }
+            auto status = indexer->insert(*iter, loc.getValue());
+            if (!status.isOK()) {
+                return status;
+            }
+        }
+    }
+    return Status::OK();
+}
+
 Status CollectionBulkLoaderImpl::commit() {
     return _runTaskReleaseResourcesOnFailure([this]() -> Status {
         _stats.startBuildingIndexes = Date_t::now();
         LOG(2) << "Creating indexes for ns: " << _nss.ns();
         UnreplicatedWritesBlock uwb(_opCtx.get());
 
+        // The documents must be visible before duplicates on the _id index are deleted by
+        // RecordId.
+        if (_recordStoreBulkBuilder) {
+            auto status = _recordStoreBulkBuilder->commit();
+            if (!status.isOK()) {
+                return status;
+            }
+            _recordStoreBulkBuilder.reset();
+        }
+
         // Commit before deleting dups, so the dups will be removed from secondary indexes when
         // deleted.
         if (_secondaryIndexesBlock) {
@@ -222,6 +301,8 @@ Status CollectionBulkLoaderImpl::commit() {
 
 void CollectionBulkLoaderImpl::_releaseResources() {
     invariant(&cc() == _opCtx->getClient());
+    _recordStoreBulkBuilder.reset();
+
     if (_secondaryIndexesBlock) {
         // A valid Client is required to drop unfinished indexes.
         Client::initThreadIfNotAlready();
@@ -38,6 +38,7 @@
 #include "mongo/db/namespace_string.h"
 #include "mongo/db/repl/collection_bulk_loader.h"
 #include "mongo/db/repl/storage_interface.h"
+#include "mongo/db/storage/record_store.h"
 
 namespace mongo {
 namespace repl {
@@ -79,6 +80,12 @@ public:
 private:
     void _releaseResources();
 
+    /**
+     * Appends the documents through '_recordStoreBulkBuilder' and feeds them to the index builders.
+     */
+    Status _insertDocumentsInBulk(const std::vector<BSONObj>::const_iterator begin,
+                                  const std::vector<BSONObj>::const_iterator end);
+
     template <typename F>
     Status _runTaskReleaseResourcesOnFailure(F task) noexcept;
 
@@ -88,6 +95,9 @@ private:
     NamespaceString _nss;
     std::unique_ptr<MultiIndexBlock> _idIndexBlock;
     std::unique_ptr<MultiIndexBlock> _secondaryIndexesBlock;
+    // Set when the collection's documents are appended through a bulk builder on its RecordStore
+    // rather than inserted one WriteUnitOfWork at a time.
+    std::unique_ptr<RecordStoreBulkBuilder> _recordStoreBulkBuilder;
     BSONObj _idIndexSpec;
     Stats _stats;
 };
@@ -32,13 +32,16 @@
 
 #include "mongo/db/repl/collection_cloner.h"
 
+#include <algorithm>
 #include <utility>
 
 #include "mongo/base/string_data.h"
+#include "mongo/bson/simple_bsonobj_comparator.h"
 #include "mongo/bson/util/bson_extract.h"
 #include "mongo/client/remote_command_retry_scheduler.h"
 #include "mongo/db/catalog/collection_options.h"
 #include "mongo/db/namespace_string.h"
+#include "mongo/db/query/killcursors_request.h"
 #include "mongo/db/repl/storage_interface.h"
 #include "mongo/db/repl/storage_interface_mock.h"
 #include "mongo/db/server_parameters.h"
@@ -62,12 +65,38 @@ constexpr auto kCountResponseDocumentCountFieldName = "n"_sd;
 const int kProgressMeterSecondsBetween = 60;
 const int kProgressMeterCheckInterval = 128;
 
+// The number of _ids sampled for each range when splitting a collection into ranges.
+const int kIdSamplesPerRange = 10;
+
 // The number of attempts for the count command, which gets the document count.
 MONGO_EXPORT_SERVER_PARAMETER(numInitialSyncCollectionCountAttempts, int, 3);
 // The number of attempts for the listIndexes commands.
 MONGO_EXPORT_SERVER_PARAMETER(numInitialSyncListIndexesAttempts, int, 3);
 // The number of attempts for the find command, which gets the data.
 MONGO_EXPORT_SERVER_PARAMETER(numInitialSyncCollectionFindAttempts, int, 3);
+
+// The maximum number of _id ranges a collection is split into, each of which is cloned through its
+// own cursor. A value of 1 clones every collection through a single cursor.
+MONGO_EXPORT_SERVER_PARAMETER(numInitialSyncCollectionRangeCursors, int, 1)
+    ->withValidator([](const int& newVal) {
+        if (newVal < 1 || newVal > 64) {
+            return Status(ErrorCodes::BadValue,
+                          "numInitialSyncCollectionRangeCursors must be between 1 and 64");
+        }
+
+        return Status::OK();
+    });
+
+// The minimum number of documents in each _id range cloned through its own cursor.
+MONGO_EXPORT_SERVER_PARAMETER(initialSyncMinDocumentsPerCollectionRange, int, 10000)
+    ->withValidator([](const int& newVal) {
+        if (newVal < 1) {
+            return Status(ErrorCodes::BadValue,
+                          "initialSyncMinDocumentsPerCollectionRange must be at least 1");
+        }
+
+        return Status::OK();
+    });
 }  // namespace
 
 // Failpoint which causes initial sync to hang before establishing its cursor to clone the
@@ -260,8 +289,11 @@ void CollectionCloner::_cancelRemainingWork_inlock() {
     }
     _countScheduler.shutdown();
     _listIndexesFetcher.shutdown();
-    if (_establishCollectionCursorsScheduler) {
-        _establishCollectionCursorsScheduler->shutdown();
+    if (_sampleIdsScheduler) {
+        _sampleIdsScheduler->shutdown();
+    }
+    for (auto&& scheduler : _establishCollectionCursorsSchedulers) {
+        scheduler->shutdown();
     }
     if (_verifyCollectionDroppedScheduler) {
         _verifyCollectionDroppedScheduler->shutdown();
@@ -475,13 +507,6 @@ void CollectionCloner::_beginCollectionCallback(const executor::TaskExecutor::Ca
 
     _collLoader = std::move(collectionBulkLoader.getValue());
 
-    BSONObjBuilder cmdObj;
-
-    cmdObj.appendElements(makeCommandWithUUIDorCollectionName("find", _options.uuid, _sourceNss));
-    cmdObj.append("noCursorTimeout", true);
-    // Set batchSize to be 0 to establish the cursor without fetching any documents,
-    cmdObj.append("batchSize", 0);
-
     Client::initThreadIfNotAlready();
     auto opCtx = cc().getOperationContext();
 
@@ -496,7 +521,140 @@ void CollectionCloner::_beginCollectionCallback(const executor::TaskExecutor::Ca
         }
     }
 
-    _establishCollectionCursorsScheduler = stdx::make_unique<RemoteCommandRetryScheduler>(
+    size_t numRanges;
+    {
+        LockGuard lk(_mutex);
+        numRanges = _getNumRangesToClone_inlock();
+    }
+    if (numRanges == 1) {
+        auto scheduleStatus = _establishNextRangeCursor(opCtx);
+        if (!scheduleStatus.isOK()) {
+            _finishCallback(scheduleStatus);
+        }
+        return;
+    }
+
+    // Sample the _ids of the collection to pick the boundaries of the ranges. The sample is sorted
+    // by the source, so all of it must fit in the first batch.
+    const int sampleSize = numRanges * kIdSamplesPerRange;
+    BSONObj sampleCmd = BSON("aggregate" << _sourceNss.coll() << "pipeline"
+                                         << BSON_ARRAY(BSON("$sample" << BSON("size" << sampleSize))
+                                                       << BSON("$project" << BSON("_id" << 1))
+                                                       << BSON("$sort" << BSON("_id" << 1)))
+                                         << "cursor"
+                                         << BSON("batchSize" << sampleSize));
+    auto sampleIdsScheduler = stdx::make_unique<RemoteCommandRetryScheduler>(
+        _executor,
+        RemoteCommandRequest(_source,
+                             _sourceNss.db().toString(),
+                             sampleCmd,
+                             ReadPreferenceSetting::secondaryPreferredMetadata(),
+                             opCtx,
+                             RemoteCommandRequest::kNoTimeout),
+        [=](const RemoteCommandCallbackArgs& rcbd) { _sampleIdsCallback(rcbd, numRanges); },
+        RemoteCommandRetryScheduler::makeNoRetryPolicy());
+    auto scheduler = sampleIdsScheduler.get();
+    {
+        LockGuard lk(_mutex);
+        _sampleIdsScheduler = std::move(sampleIdsScheduler);
+    }
+    auto scheduleStatus = scheduler->startup();
+    if (!scheduleStatus.isOK()) {
+        _finishCallback(scheduleStatus);
+        return;
+    }
+}
+
+size_t CollectionCloner::_getNumRangesToClone_inlock() const {
+    // Ranges are bounded by keys of the _id index, which must order _ids as they are compared
+    // here. Capped collections must be cloned in their natural order.
+    if (_idIndexSpec.isEmpty() || _options.capped || !_options.collation.isEmpty()) {
+        return 1U;
+    }
+    const size_t maxRanges = numInitialSyncCollectionRangeCursors.load();
+    const size_t minDocumentsPerRange = initialSyncMinDocumentsPerCollectionRange.load();
+    return std::max<size_t>(1U, std::min(maxRanges, _stats.documentToCopy / minDocumentsPerRange));
+}
+
+void CollectionCloner::_sampleIdsCallback(const RemoteCommandCallbackArgs& rcbd,
+                                          size_t numRanges) {
+    if (ErrorCodes::CallbackCanceled == rcbd.response.status || _isShuttingDown()) {
+        _finishCallback({ErrorCodes::CallbackCanceled, "Cloner shutting down."});
+        return;
+    }
+
+    // Splitting the collection only speeds up cloning, so any failure to sample its _ids leaves
+    // it to be cloned through a single cursor.
+    std::vector<BSONObj> splitPoints;
+    Status sampleStatus = rcbd.response.status;
+    if (sampleStatus.isOK()) {
+        sampleStatus = getStatusFromCommandResult(rcbd.response.data);
+    }
+    if (sampleStatus.isOK()) {
+        auto sampleResponse = CursorResponse::parseFromBSON(rcbd.response.data);
+        sampleStatus = sampleResponse.getStatus();
+        if (sampleStatus.isOK()) {
+            const auto& ids = sampleResponse.getValue().getBatch();
+            for (size_t range = 1; range < numRanges && !ids.empty(); ++range) {
+                BSONElement id = ids[range * ids.size() / numRanges]["_id"];
+                if (id.eoo()) {
+                    continue;
+                }
+                BSONObj splitPoint = BSON("_id" << id);
+                if (splitPoints.empty() ||
+                    SimpleBSONObjComparator::kInstance.evaluate(splitPoint > splitPoints.back())) {
+                    splitPoints.push_back(splitPoint.getOwned());
+                }
+            }
+        }
+    }
+    if (!sampleStatus.isOK()) {
+        log() << "CollectionCloner ns:" << _destNss
+              << " cloning through a single cursor after failing to sample _ids: "
+              << redact(sampleStatus);
+    }
+
+    {
+        LockGuard lk(_mutex);
+        _rangeSplitPoints = std::move(splitPoints);
+        if (!_rangeSplitPoints.empty()) {
+            _stats.documentsCopiedPerRange.assign(_rangeSplitPoints.size() + 1, 0U);
+        }
+        LOG(1) << "CollectionCloner ns:" << _destNss << " cloning in "
+               << _rangeSplitPoints.size() + 1 << " ranges.";
+    }
+
+    auto scheduleStatus = _establishNextRangeCursor(nullptr);
+    if (!scheduleStatus.isOK()) {
+        _finishCallback(scheduleStatus);
+    }
+}
+
+Status CollectionCloner::_establishNextRangeCursor(OperationContext* opCtx) {
+    BSONObjBuilder cmdObj;
+
+    cmdObj.appendElements(makeCommandWithUUIDorCollectionName("find", _options.uuid, _sourceNss));
+    cmdObj.append("noCursorTimeout", true);
+    // Set batchSize to be 0 to establish the cursor without fetching any documents,
+    cmdObj.append("batchSize", 0);
+
+    {
+        LockGuard lk(_mutex);
+        if (!_rangeSplitPoints.empty()) {
+            // The bounds of a range are keys of the _id index rather than a query on _id, so the
+            // ranges cover _ids of every type.
+            const size_t range = _rangeCursorResponses.size();
+            cmdObj.append("hint", BSON("_id" << 1));
+            if (range > 0) {
+                cmdObj.append("min", _rangeSplitPoints[range - 1]);
+            }
+            if (range < _rangeSplitPoints.size()) {
+                cmdObj.append("max", _rangeSplitPoints[range]);
+            }
+        }
+    }
+
+    auto establishCursorScheduler = stdx::make_unique<RemoteCommandRetryScheduler>(
         _executor,
         RemoteCommandRequest(_source,
                              _sourceNss.db().toString(),
@@ -509,13 +667,12 @@ void CollectionCloner::_beginCollectionCallback(const executor::TaskExecutor::Ca
             numInitialSyncCollectionFindAttempts.load(),
             executor::RemoteCommandRequest::kNoTimeout,
             RemoteCommandRetryScheduler::kAllRetriableErrors));
-    auto scheduleStatus = _establishCollectionCursorsScheduler->startup();
-
-    if (!scheduleStatus.isOK()) {
-        _establishCollectionCursorsScheduler.reset();
-        _finishCallback(scheduleStatus);
-        return;
+    auto scheduler = establishCursorScheduler.get();
+    {
+        LockGuard lk(_mutex);
+        _establishCollectionCursorsSchedulers.push_back(std::move(establishCursorScheduler));
     }
+    return scheduler->startup();
 }
 
 Status CollectionCloner::_parseCursorResponse(BSONObj response,
@@ -531,6 +688,27 @@ Status CollectionCloner::_parseCursorResponse(BSONObj response,
     return Status::OK();
 }
 
+void CollectionCloner::_killRangeCursors() {
+    std::vector<CursorResponse> cursorResponses;
+    {
+        LockGuard lk(_mutex);
+        cursorResponses.swap(_rangeCursorResponses);
+    }
+
+    for (auto&& cursorResponse : cursorResponses) {
+        if (!cursorResponse.getCursorId()) {
+            continue;
+        }
+        BSONObj cmdObj = KillCursorsRequest(_sourceNss, {cursorResponse.getCursorId()}).toBSON();
+        RemoteCommandRequest request(_source, _sourceNss.db().toString(), cmdObj, nullptr);
+
+        // Send kill request; discard callback handle, if any, or failure report, if not.
+        _executor->scheduleRemoteCommand(request, [](const RemoteCommandCallbackArgs&) {})
+            .getStatus()
+            .ignore();
+    }
+}
+
 void CollectionCloner::_establishCollectionCursorsCallback(const RemoteCommandCallbackArgs& rcbd) {
     if (_state == State::kShuttingDown) {
         Status shuttingDownStatus{ErrorCodes::CallbackCanceled, "Cloner shutting down."};
@@ -554,10 +732,24 @@ void CollectionCloner::_establishCollectionCursorsCallback(const RemoteCommandCa
     }
 
     std::vector<CursorResponse> cursorResponses;
-    Status parseResponseStatus = _parseCursorResponse(response.data, &cursorResponses);
-    if (!parseResponseStatus.isOK()) {
-        _finishCallback(parseResponseStatus);
-        return;
+    {
+        UniqueLock lk(_mutex);
+        Status parseResponseStatus = _parseCursorResponse(response.data, &_rangeCursorResponses);
+        if (!parseResponseStatus.isOK()) {
+            lk.unlock();
+            _finishCallback(parseResponseStatus);
+            return;
+        }
+        if (_rangeCursorResponses.size() <= _rangeSplitPoints.size()) {
+            // Establish the cursor over the next range.
+            lk.unlock();
+            auto scheduleStatus = _establishNextRangeCursor(nullptr);
+            if (!scheduleStatus.isOK()) {
+                _finishCallback(scheduleStatus);
+            }
+            return;
+        }
+        cursorResponses.swap(_rangeCursorResponses);
     }
     LOG(1) << "Collection cloner running with " << cursorResponses.size()
            << " cursors established.";
@@ -805,6 +997,16 @@ void CollectionCloner::_insertDocumentsCallback(
     }
     _documentsToInsert.swap(docs);
     _stats.documentsCopied += docs.size();
+    if (!_rangeSplitPoints.empty()) {
+        for (auto&& doc : docs) {
+            BSONObj id = BSON("_id" << doc["_id"]);
+            auto splitPoint = std::upper_bound(_rangeSplitPoints.begin(),
+                                               _rangeSplitPoints.end(),
+                                               id,
+                                               SimpleBSONObjComparator::kInstance.makeLessThan());
+            ++_stats.documentsCopiedPerRange[splitPoint - _rangeSplitPoints.begin()];
+        }
+    }
     ++_stats.fetchBatches;
     _progressMeter.hit(int(docs.size()));
     invariant(_collLoader);
@@ -837,6 +1039,7 @@ void CollectionCloner::_insertDocumentsCallback(
 void CollectionCloner::_finishCallback(const Status& status) {
     log() << "CollectionCloner ns:" << _destNss
           << " finished cloning with status: " << redact(status);
+    _killRangeCursors();
     // Copy the status so we can change it below if needed.
     auto finalStatus = status;
     bool callCollectionLoader = false;
@@ -899,6 +1102,13 @@ void CollectionCloner::Stats::append(BSONObjBuilder* builder) const {
     builder->appendNumber(kDocumentsCopiedFieldName, documentsCopied);
     builder->appendNumber("indexes", indexes);
     builder->appendNumber("fetchedBatches", fetchBatches);
+    if (!documentsCopiedPerRange.empty()) {
+        BSONArrayBuilder rangesBuilder(builder->subarrayStart("ranges"));
+        for (auto&& rangeDocumentsCopied : documentsCopiedPerRange) {
+            BSONObjBuilder rangeBuilder(rangesBuilder.subobjStart());
+            rangeBuilder.appendNumber(kDocumentsCopiedFieldName, rangeDocumentsCopied);
+        }
+    }
     if (start != Date_t()) {
         builder->appendDate("start", start);
         if (end != Date_t()) {
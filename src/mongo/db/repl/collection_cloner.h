@@ -41,6 +41,7 @@
 #include "mongo/db/catalog/collection_options.h"
 #include "mongo/db/namespace_string.h"
 #include "mongo/db/operation_context.h"
+#include "mongo/db/query/cursor_response.h"
 #include "mongo/db/repl/base_cloner.h"
 #include "mongo/db/repl/callback_completion_guard.h"
 #include "mongo/db/repl/storage_interface.h"
@@ -80,6 +81,8 @@ public:
         size_t documentsCopied{0};
         size_t indexes{0};
         size_t fetchBatches{0};
+        // Documents copied from each range of the collection, when it is cloned in ranges.
+        std::vector<size_t> documentsCopiedPerRange;
 
         std::string toString() const;
         BSONObj toBSON() const;
@@ -190,8 +193,25 @@ private:
     void _beginCollectionCallback(const executor::TaskExecutor::CallbackArgs& callbackData);
 
     /**
-     * Parses the cursor responses from the 'find' command and passes them into the
-     * 'AsyncResultsMerger'.
+     * Returns the number of _id ranges to clone the collection in, each through its own cursor.
+     */
+    size_t _getNumRangesToClone_inlock() const;
+
+    /**
+     * Picks the _id values splitting the collection into 'numRanges' ranges from a sample of the
+     * _ids in the collection. Clones the collection through a single cursor if sampling fails.
+     */
+    void _sampleIdsCallback(const RemoteCommandCallbackArgs& rcbd, size_t numRanges);
+
+    /**
+     * Sends the 'find' command establishing the cursor over the next range of the collection, or
+     * over the whole collection if it is not cloned in ranges.
+     */
+    Status _establishNextRangeCursor(OperationContext* opCtx);
+
+    /**
+     * Parses the cursor response from the 'find' command. Once the cursors over all ranges are
+     * established, passes them into the 'AsyncResultsMerger'.
      */
     void _establishCollectionCursorsCallback(const RemoteCommandCallbackArgs& rcbd);
 
@@ -201,6 +221,13 @@ private:
      */
     Status _parseCursorResponse(BSONObj response, std::vector<CursorResponse>* cursors);
 
+    /**
+     * Sends killCursors for the range cursors established so far which have not been handed to
+     * the 'AsyncResultsMerger'. Their cursors have no timeout, so cloning must not finish without
+     * killing them.
+     */
+    void _killRangeCursors();
+
     /**
      * Calls to get the next event from the 'AsyncResultsMerger'. This schedules
      * '_handleAsyncResultsCallback' to be run when the event is signaled successfully.
@@ -287,8 +314,18 @@ private:
     // (M) The event handle for the 'kill' event of the 'AsyncResultsMerger'.
     executor::TaskExecutor::EventHandle _killArmHandle;
 
-    // (M) Scheduler used to establish the initial cursor or set of cursors.
-    std::unique_ptr<RemoteCommandRetryScheduler> _establishCollectionCursorsScheduler;
+    // (M) Scheduler used to sample the _ids of the collection when it is cloned in ranges.
+    std::unique_ptr<RemoteCommandRetryScheduler> _sampleIdsScheduler;
+
+    // (M) The {_id: <value>} keys splitting the collection into ranges, in ascending order. Each
+    // range is cloned through its own cursor. Empty if the collection is cloned by a single cursor.
+    std::vector<BSONObj> _rangeSplitPoints;
+
+    // (M) The cursors established so far, one for each range, until they are all handed to '_arm'.
+    std::vector<CursorResponse> _rangeCursorResponses;
+
+    // (M) Schedulers used to establish the initial cursor or set of cursors.
+    std::vector<std::unique_ptr<RemoteCommandRetryScheduler>> _establishCollectionCursorsSchedulers;
 
     // (M) Scheduler used to determine if a cursor was closed because the collection was dropped.
     std::unique_ptr<RemoteCommandRetryScheduler> _verifyCollectionDroppedScheduler;
@@ -37,10 +37,12 @@
 #include "mongo/db/repl/collection_cloner.h"
 #include "mongo/db/repl/storage_interface.h"
 #include "mongo/db/repl/storage_interface_mock.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/stdx/memory.h"
 #include "mongo/unittest/task_executor_proxy.h"
 #include "mongo/unittest/unittest.h"
 #include "mongo/util/mongoutils/str.h"
+#include "mongo/util/scopeguard.h"
 
 namespace {
 
@@ -1090,6 +1092,157 @@ TEST_F(CollectionClonerTest, LastBatchContainsNoDocuments) {
     ASSERT_FALSE(collectionCloner->isActive());
 }
 
+TEST_F(CollectionClonerTest, CollectionClonerClonesRangesThroughSeparateCursors) {
+    const auto& serverParameters = ServerParameterSet::getGlobal()->getMap();
+    auto rangeCursorsParameter = serverParameters.find("numInitialSyncCollectionRangeCursors");
+    auto minDocumentsParameter = serverParameters.find("initialSyncMinDocumentsPerCollectionRange");
+    ASSERT(rangeCursorsParameter != serverParameters.end());
+    ASSERT(minDocumentsParameter != serverParameters.end());
+    ASSERT_OK(rangeCursorsParameter->second->setFromString("2"));
+    ASSERT_OK(minDocumentsParameter->second->setFromString("1"));
+    ON_BLOCK_EXIT([&] {
+        invariant(rangeCursorsParameter->second->setFromString("1").isOK());
+        invariant(minDocumentsParameter->second->setFromString("10000").isOK());
+    });
+
+    ASSERT_OK(collectionCloner->startup());
+    ASSERT_TRUE(collectionCloner->isActive());
+
+    {
+        executor::NetworkInterfaceMock::InNetworkGuard guard(getNet());
+        processNetworkResponse(createCountResponse(5));
+        processNetworkResponse(createListIndexesResponse(0, BSON_ARRAY(idIndexSpec)));
+    }
+
+    collectionCloner->waitForDbWorker();
+    ASSERT_TRUE(collectionCloner->isActive());
+    ASSERT_TRUE(collectionStats.initCalled);
+
+    auto net = getNet();
+    {
+        executor::NetworkInterfaceMock::InNetworkGuard guard(net);
+
+        // The collection is split at the median of the sampled _ids.
+        auto noi = net->getNextReadyRequest();
+        ASSERT_EQUALS("aggregate", std::string(noi->getRequest().cmdObj.firstElementFieldName()));
+        scheduleNetworkResponse(noi,
+                                createCursorResponse(0,
+                                                     BSON_ARRAY(BSON("_id" << 1)
+                                                                << BSON("_id" << 2)
+                                                                << BSON("_id" << 3)
+                                                                << BSON("_id" << 4))));
+        net->runReadyNetworkOperations();
+
+        noi = net->getNextReadyRequest();
+        auto findCmd = noi->getRequest().cmdObj;
+        ASSERT_EQUALS("find", std::string(findCmd.firstElementFieldName()));
+        ASSERT_FALSE(findCmd.hasField("min"));
+        ASSERT_BSONOBJ_EQ(BSON("_id" << 3), findCmd["max"].Obj());
+        scheduleNetworkResponse(noi, createCursorResponse(1, BSONArray()));
+        net->runReadyNetworkOperations();
+
+        noi = net->getNextReadyRequest();
+        findCmd = noi->getRequest().cmdObj;
+        ASSERT_EQUALS("find", std::string(findCmd.firstElementFieldName()));
+        ASSERT_BSONOBJ_EQ(BSON("_id" << 3), findCmd["min"].Obj());
+        ASSERT_FALSE(findCmd.hasField("max"));
+        scheduleNetworkResponse(noi, createCursorResponse(2, BSONArray()));
+        net->runReadyNetworkOperations();
+
+        // Each range is read through its own cursor.
+        for (int i = 0; i < 2; ++i) {
+            noi = net->getNextReadyRequest();
+            auto getMoreCmd = noi->getRequest().cmdObj;
+            ASSERT_EQUALS("getMore", std::string(getMoreCmd.firstElementFieldName()));
+            auto docs = getMoreCmd["getMore"].numberLong() == 1
+                ? BSON_ARRAY(BSON("_id" << 1) << BSON("_id" << 2))
+                : BSON_ARRAY(BSON("_id" << 3) << BSON("_id" << 4) << BSON("_id" << 5));
+            scheduleNetworkResponse(noi, createFinalCursorResponse(docs));
+            net->runReadyNetworkOperations();
+        }
+    }
+
+    collectionCloner->join();
+    ASSERT_EQUALS(5, collectionStats.insertCount);
+    ASSERT_TRUE(collectionStats.commitCalled);
+    ASSERT_OK(getStatus());
+
+    auto stats = collectionCloner->getStats();
+    ASSERT_EQUALS(5U, stats.documentsCopied);
+    ASSERT_EQUALS(2U, stats.documentsCopiedPerRange.size());
+    ASSERT_EQUALS(2U, stats.documentsCopiedPerRange[0]);
+    ASSERT_EQUALS(3U, stats.documentsCopiedPerRange[1]);
+}
+
+TEST_F(CollectionClonerTest, CollectionClonerKillsEstablishedRangeCursorsIfALaterFindFails) {
+    const auto& serverParameters = ServerParameterSet::getGlobal()->getMap();
+    auto rangeCursorsParameter = serverParameters.find("numInitialSyncCollectionRangeCursors");
+    auto minDocumentsParameter = serverParameters.find("initialSyncMinDocumentsPerCollectionRange");
+    ASSERT(rangeCursorsParameter != serverParameters.end());
+    ASSERT(minDocumentsParameter != serverParameters.end());
+    ASSERT_OK(rangeCursorsParameter->second->setFromString("2"));
+    ASSERT_OK(minDocumentsParameter->second->setFromString("1"));
+    ON_BLOCK_EXIT([&] {
+        invariant(rangeCursorsParameter->second->setFromString("1").isOK());
+        invariant(minDocumentsParameter->second->setFromString("10000").isOK());
+    });
+
+    ASSERT_OK(collectionCloner->startup());
+    ASSERT_TRUE(collectionCloner->isActive());
+
+    {
+        executor::NetworkInterfaceMock::InNetworkGuard guard(getNet());
+        processNetworkResponse(createCountResponse(5));
+        processNetworkResponse(createListIndexesResponse(0, BSON_ARRAY(idIndexSpec)));
+    }
+
+    collectionCloner->waitForDbWorker();
+    ASSERT_TRUE(collectionCloner->isActive());
+
+    auto net = getNet();
+    {
+        executor::NetworkInterfaceMock::InNetworkGuard guard(net);
+
+        auto noi = net->getNextReadyRequest();
+        ASSERT_EQUALS("aggregate", std::string(noi->getRequest().cmdObj.firstElementFieldName()));
+        scheduleNetworkResponse(noi,
+                                createCursorResponse(0,
+                                                     BSON_ARRAY(BSON("_id" << 1)
+                                                                << BSON("_id" << 2)
+                                                                << BSON("_id" << 3)
+                                                                << BSON("_id" << 4))));
+        net->runReadyNetworkOperations();
+
+        // The first range's cursor is established.
+        noi = net->getNextReadyRequest();
+        ASSERT_EQUALS("find", std::string(noi->getRequest().cmdObj.firstElementFieldName()));
+        scheduleNetworkResponse(noi, createCursorResponse(1, BSONArray()));
+        net->runReadyNetworkOperations();
+
+        // The second range's find fails.
+        noi = net->getNextReadyRequest();
+        ASSERT_EQUALS("find", std::string(noi->getRequest().cmdObj.firstElementFieldName()));
+        scheduleNetworkResponse(noi, ErrorCodes::OperationFailed, "find failed");
+        net->runReadyNetworkOperations();
+
+        // The cursor over the first range is killed.
+        ASSERT_TRUE(net->hasReadyRequests());
+        noi = net->getNextReadyRequest();
+        auto killCursorsCmd = noi->getRequest().cmdObj;
+        ASSERT_EQUALS("killCursors", std::string(killCursorsCmd.firstElementFieldName()));
+        auto killedCursors = killCursorsCmd["cursors"].Array();
+        ASSERT_EQUALS(1U, killedCursors.size());
+        ASSERT_EQUALS(1LL, killedCursors[0].numberLong());
+        scheduleNetworkResponse(noi, BSON("ok" << 1));
+        net->runReadyNetworkOperations();
+        ASSERT_FALSE(net->hasReadyRequests());
+    }
+
+    collectionCloner->join();
+    ASSERT_EQUALS(ErrorCodes::OperationFailed, getStatus());
+    ASSERT_FALSE(collectionCloner->isActive());
+}
+
 TEST_F(CollectionClonerTest, CollectionClonerTransitionsToCompleteIfShutdownBeforeStartup) {
     collectionCloner->shutdown();
     ASSERT_EQUALS(ErrorCodes::ShutdownInProgress, collectionCloner->startup());
@@ -33,9 +33,11 @@
 #include "mongo/db/repl/oplog_fetcher.h"
 
 #include "mongo/base/counter.h"
+#include "mongo/db/client.h"
 #include "mongo/db/commands/server_status_metric.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/repl/replication_coordinator.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/stats/timer_stats.h"
 #include "mongo/rpc/metadata/oplog_query_metadata.h"
 #include "mongo/util/assert_util.h"
@@ -65,6 +67,19 @@ ServerStatusMetricField<Counter64> displayBytesRead("repl.network.bytes", &netwo
 
 const Milliseconds maximumAwaitDataTimeoutMS(30 * 1000);
 
+// The number of fetched batches which may wait to be pushed onto the oplog buffer while the oplog
+// fetcher requests the next batch from its sync source. With 0, each batch is pushed onto the
+// buffer before the next one is requested.
+MONGO_EXPORT_SERVER_PARAMETER(oplogFetcherPipelinedBatches, int, 0)
+    ->withValidator([](const int& newVal) {
+        if (newVal < 0 || newVal > 16) {
+            return Status(ErrorCodes::BadValue,
+                          "oplogFetcherPipelinedBatches must be between 0 and 16");
+        }
+
+        return Status::OK();
+    });
+
 /**
  * Calculates await data timeout based on the current replica set configuration.
  */
@@ -323,7 +338,12 @@ OplogFetcher::OplogFetcher(executor::TaskExecutor* executor,
                            source,
                            nss,
                            maxFetcherRestarts,
-                           onShutdownCallbackFn,
+                           [this, onShutdownCallbackFn](const Status& status) {
+                               // Batches fetched before the fetcher stopped are still pushed onto
+                               // the buffer before it reports that it has finished.
+                               Status enqueueStatus = _waitForPendingEnqueues();
+                               onShutdownCallbackFn(status.isOK() ? enqueueStatus : status);
+                           },
                            "oplog fetcher"),
       _metadataObject(makeMetadataObject()),
       _requiredRBID(requiredRBID),
@@ -331,15 +351,33 @@ OplogFetcher::OplogFetcher(executor::TaskExecutor* executor,
       _dataReplicatorExternalState(dataReplicatorExternalState),
       _enqueueDocumentsFn(enqueueDocumentsFn),
       _awaitDataTimeout(calculateAwaitDataTimeout(config)),
-      _batchSize(batchSize) {
+      _batchSize(batchSize),
+      _maxPendingBatches(oplogFetcherPipelinedBatches.load()) {
 
     invariant(config.isInitialized());
     invariant(enqueueDocumentsFn);
+
+    if (_maxPendingBatches > 0) {
+        ThreadPool::Options options;
+        options.poolName = "OplogFetcherEnqueue";
+        options.minThreads = 0;
+        options.maxThreads = 1;
+        options.onCreateThread = [](const std::string& threadName) {
+            Client::initThread(threadName.c_str());
+        };
+        _enqueuePool = stdx::make_unique<ThreadPool>(options);
+        _enqueuePool->startup();
+    }
 }
 
 OplogFetcher::~OplogFetcher() {
     shutdown();
     join();
+
+    if (_enqueuePool) {
+        _enqueuePool->shutdown();
+        _enqueuePool->join();
+    }
 }
 
 BSONObj OplogFetcher::_makeFindCommandObject(const NamespaceString& nss,
@@ -473,7 +511,7 @@ StatusWith<BSONObj> OplogFetcher::_onSuccessfulBatch(const Fetcher::QueryRespons
     getmoreReplStats.recordMillis(durationCount<Milliseconds>(queryResponse.elapsedMillis));
 
     // TODO: back pressure handling will be added in SERVER-23499.
-    auto status = _enqueueDocumentsFn(firstDocToApply, documents.cend(), info);
+    auto status = _enqueueDocuments(firstDocToApply, documents.cend(), info);
     if (!status.isOK()) {
         return status;
     }
@@ -506,5 +544,51 @@ StatusWith<BSONObj> OplogFetcher::_onSuccessfulBatch(const Fetcher::QueryRespons
                                     _getGetMoreMaxTime(),
                                     _batchSize);
 }
+
+Status OplogFetcher::_enqueueDocuments(Fetcher::Documents::const_iterator begin,
+                                       Fetcher::Documents::const_iterator end,
+                                       const DocumentsInfo& info) {
+    if (!_enqueuePool) {
+        return _enqueueDocumentsFn(begin, end, info);
+    }
+
+    {
+        stdx::unique_lock<stdx::mutex> lk(_enqueueMutex);
+        _enqueueCondition.wait(lk, [this] {
+            return _pendingBatches < _maxPendingBatches || !_enqueueStatus.isOK();
+        });
+        if (!_enqueueStatus.isOK()) {
+            return _enqueueStatus;
+        }
+        ++_pendingBatches;
+    }
+
+    // The documents share ownership of the response they were read from, which keeps it alive
+    // until they have been pushed onto the buffer.
+    Fetcher::Documents documents(begin, end);
+    auto scheduleStatus = _enqueuePool->schedule([this, documents, info] {
+        auto status = _enqueueDocumentsFn(documents.cbegin(), documents.cend(), info);
+        stdx::lock_guard<stdx::mutex> lk(_enqueueMutex);
+        if (_enqueueStatus.isOK()) {
+            _enqueueStatus = status;
+        }
+        --_pendingBatches;
+        _enqueueCondition.notify_all();
+    });
+    if (!scheduleStatus.isOK()) {
+        stdx::lock_guard<stdx::mutex> lk(_enqueueMutex);
+        --_pendingBatches;
+        _enqueueCondition.notify_all();
+        return scheduleStatus;
+    }
+    return Status::OK();
+}
+
+Status OplogFetcher::_waitForPendingEnqueues() {
+    stdx::unique_lock<stdx::mutex> lk(_enqueueMutex);
+    _enqueueCondition.wait(lk, [this] { return _pendingBatches == 0; });
+    return _enqueueStatus;
+}
+
 }  // namespace repl
 }  // namespace mongo
@@ -29,6 +29,7 @@
 #pragma once
 
 #include <cstddef>
+#include <memory>
 
 #include "mongo/base/disallow_copying.h"
 #include "mongo/base/status_with.h"
@@ -38,7 +39,10 @@
 #include "mongo/db/repl/abstract_oplog_fetcher.h"
 #include "mongo/db/repl/data_replicator_external_state.h"
 #include "mongo/db/repl/repl_set_config.h"
+#include "mongo/stdx/condition_variable.h"
 #include "mongo/stdx/functional.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/util/concurrency/thread_pool.h"
 #include "mongo/util/fail_point_service.h"
 
 namespace mongo {
@@ -62,7 +66,10 @@ MONGO_FAIL_POINT_DECLARE(stopReplProducer);
  * Pushes operations from each batch of operations onto a buffer using the "enqueueDocumentsFn"
  * function.
  *
- * Issues a getMore command after successfully processing each batch of operations.
+ * Issues a getMore command after successfully processing each batch of operations. When fetching
+ * is pipelined, a batch is handed to a dedicated thread which pushes it onto the buffer, and the
+ * getMore is issued without waiting for room in the buffer. The number of batches waiting to be
+ * pushed is bounded, so a full buffer still holds back fetching.
  *
  * When there is an error or when it is not possible to issue another getMore request, calls
  * "onShutdownCallbackFn" to signal the end of processing.
@@ -158,6 +165,21 @@ private:
      */
     StatusWith<BSONObj> _onSuccessfulBatch(const Fetcher::QueryResponse& queryResponse) override;
 
+    /**
+     * Pushes the operations of a batch onto the buffer using "enqueueDocumentsFn". When fetching is
+     * pipelined, hands them to the enqueue thread instead, first waiting for a batch to be pushed
+     * if too many are pending. Returns the error any earlier batch met on the enqueue thread.
+     */
+    Status _enqueueDocuments(Fetcher::Documents::const_iterator begin,
+                             Fetcher::Documents::const_iterator end,
+                             const DocumentsInfo& info);
+
+    /**
+     * Waits for all batches handed to the enqueue thread to be pushed onto the buffer. Returns the
+     * first error met pushing them.
+     */
+    Status _waitForPendingEnqueues();
+
     // The metadata object sent with the Fetcher queries.
     const BSONObj _metadataObject;
 
@@ -174,6 +196,22 @@ private:
     const EnqueueDocumentsFn _enqueueDocumentsFn;
     const Milliseconds _awaitDataTimeout;
     const int _batchSize;
+
+    // The number of batches which may be waiting to be pushed onto the buffer while the next batch
+    // is fetched. 0 if each batch is pushed before the next one is requested.
+    const std::size_t _maxPendingBatches;
+
+    // Runs "enqueueDocumentsFn" on a single thread, in the order the batches were fetched, when
+    // fetching is pipelined.
+    std::unique_ptr<ThreadPool> _enqueuePool;
+
+    // Guards '_pendingBatches' and '_enqueueStatus'.
+    stdx::mutex _enqueueMutex;
+    stdx::condition_variable _enqueueCondition;
+    std::size_t _pendingBatches = 0;
+
+    // The first error returned by "enqueueDocumentsFn" on the enqueue thread.
+    Status _enqueueStatus = Status::OK();
 };
 
 }  // namespace repl
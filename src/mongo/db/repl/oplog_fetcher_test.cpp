@@ -33,10 +33,14 @@
 #include "mongo/db/repl/abstract_oplog_fetcher_test_fixture.h"
 #include "mongo/db/repl/data_replicator_external_state_mock.h"
 #include "mongo/db/repl/oplog_fetcher.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/db/service_context_test_fixture.h"
 #include "mongo/rpc/metadata.h"
 #include "mongo/rpc/metadata/oplog_query_metadata.h"
 #include "mongo/rpc/metadata/repl_set_metadata.h"
+#include "mongo/stdx/condition_variable.h"
 #include "mongo/stdx/memory.h"
+#include "mongo/stdx/mutex.h"
 #include "mongo/unittest/ensure_fcv.h"
 #include "mongo/unittest/task_executor_proxy.h"
 #include "mongo/unittest/unittest.h"
@@ -754,6 +758,76 @@ TEST_F(
                       request.cmdObj["lastKnownCommittedOpTime"].Obj())));
 }
 
+// The enqueue thread of a pipelined oplog fetcher needs a global service context for its Client.
+class PipelinedOplogFetcherTest : public OplogFetcherTest,
+                                  public ScopedGlobalServiceContextForTest {};
+
+TEST_F(PipelinedOplogFetcherTest, OplogFetcherRequestsNextBatchBeforeEnqueuingCurrentBatch) {
+    auto parameter =
+        ServerParameterSet::getGlobal()->getMap().find("oplogFetcherPipelinedBatches")->second;
+    ASSERT_OK(parameter->setFromString("1"));
+    ON_BLOCK_EXIT([parameter] { invariant(parameter->setFromString("0").isOK()); });
+
+    // Hold up pushing batches onto the buffer until the next batch has been requested.
+    stdx::mutex mutex;
+    stdx::condition_variable condition;
+    bool enqueueAllowed = false;
+    std::vector<Fetcher::Documents> enqueuedBatches;
+    enqueueDocumentsFn = [&](Fetcher::Documents::const_iterator begin,
+                             Fetcher::Documents::const_iterator end,
+                             const OplogFetcher::DocumentsInfo&) -> Status {
+        stdx::unique_lock<stdx::mutex> lk(mutex);
+        condition.wait(lk, [&] { return enqueueAllowed; });
+        enqueuedBatches.emplace_back(begin, end);
+        return Status::OK();
+    };
+
+    ShutdownState shutdownState;
+    OplogFetcher oplogFetcher(&getExecutor(),
+                              lastFetched,
+                              source,
+                              nss,
+                              _createConfig(),
+                              0,
+                              rbid,
+                              true,
+                              dataReplicatorExternalState.get(),
+                              enqueueDocumentsFn,
+                              stdx::ref(shutdownState),
+                              defaultBatchSize);
+    ASSERT_OK(oplogFetcher.startup());
+
+    auto firstEntry = makeNoopOplogEntry(lastFetched);
+    auto secondEntry = makeNoopOplogEntry({{Seconds(456), 0}, lastFetched.opTime.getTerm()}, 200);
+    auto metadataObj = makeOplogQueryMetadataObject(remoteNewerOpTime, rbid, 2, 2);
+    processNetworkResponse(
+        {concatenate(makeCursorResponse(22LL, {firstEntry, secondEntry}), metadataObj),
+         Milliseconds(0)},
+        true);
+
+    {
+        stdx::lock_guard<stdx::mutex> lk(mutex);
+        ASSERT_TRUE(enqueuedBatches.empty());
+        enqueueAllowed = true;
+    }
+    condition.notify_all();
+
+    auto thirdEntry = makeNoopOplogEntry({{Seconds(789), 0}, lastFetched.opTime.getTerm()}, 300);
+    auto request = processNetworkResponse(makeCursorResponse(0, {thirdEntry}, false));
+    ASSERT_EQUALS(std::string("getMore"), request.cmdObj.firstElementFieldName());
+
+    // The fetcher reports that it has finished only once every batch has been enqueued.
+    oplogFetcher.join();
+    ASSERT_OK(shutdownState.getStatus());
+
+    stdx::lock_guard<stdx::mutex> lk(mutex);
+    ASSERT_EQUALS(2U, enqueuedBatches.size());
+    ASSERT_EQUALS(1U, enqueuedBatches[0].size());
+    ASSERT_BSONOBJ_EQ(secondEntry, enqueuedBatches[0][0]);
+    ASSERT_EQUALS(1U, enqueuedBatches[1].size());
+    ASSERT_BSONOBJ_EQ(thirdEntry, enqueuedBatches[1][0]);
+}
+
 TEST_F(OplogFetcherTest, ValidateDocumentsReturnsNoSuchKeyIfTimestampIsNotFoundInAnyDocument) {
     auto firstEntry = makeNoopOplogEntry(Seconds(123), 100);
     auto secondEntry = BSON("o" << BSON("msg"
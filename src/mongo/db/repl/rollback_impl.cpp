@@ -35,6 +35,7 @@
 #include "mongo/db/background.h"
 #include "mongo/db/catalog/database_holder.h"
 #include "mongo/db/catalog/uuid_catalog.h"
+#include "mongo/db/client.h"
 #include "mongo/db/commands.h"
 #include "mongo/db/concurrency/d_concurrency.h"
 #include "mongo/db/db_raii.h"
@@ -54,6 +55,8 @@
 #include "mongo/db/server_recovery.h"
 #include "mongo/db/session_catalog.h"
 #include "mongo/s/catalog/type_config_version.h"
+#include "mongo/stdx/memory.h"
+#include "mongo/util/concurrency/thread_pool.h"
 #include "mongo/util/log.h"
 #include "mongo/util/scopeguard.h"
 
@@ -82,6 +85,17 @@ MONGO_EXPORT_SERVER_PARAMETER(rollbackTimeLimitSecs, int, 60 * 60 * 24)  // Defa
         return Status(ErrorCodes::BadValue, "rollbackTimeLimitSecs must be greater than 0");
     });
 
+// The number of threads used to write rollback files, each of which writes the file for one
+// namespace at a time. A value of 1 writes every rollback file on the rollback thread.
+MONGO_EXPORT_SERVER_PARAMETER(rollbackFileWriterThreadCount, int, 1)
+    ->withValidator([](const int& newVal) {
+        if (newVal < 1 || newVal > 16) {
+            return Status(ErrorCodes::BadValue,
+                          "rollbackFileWriterThreadCount must be between 1 and 16");
+        }
+        return Status::OK();
+    });
+
 // The name of the insert, update and delete commands as found in oplog command entries.
 constexpr auto kInsertCmdName = "insert"_sd;
 constexpr auto kUpdateCmdName = "update"_sd;
@@ -773,6 +787,27 @@ boost::optional<BSONObj> RollbackImpl::_findDocumentById(OperationContext* opCtx
 
 Status RollbackImpl::_writeRollbackFiles(OperationContext* opCtx) {
     const auto& uuidCatalog = UUIDCatalog::get(opCtx);
+    const auto numThreads = std::min<std::size_t>(rollbackFileWriterThreadCount.load(),
+                                                  _observerInfo.rollbackDeletedIdsMap.size());
+
+    // Rollback files for different namespaces are independent of each other, so when more than one
+    // thread is allowed they are written concurrently, each thread with its own Client and
+    // OperationContext.
+    std::unique_ptr<ThreadPool> pool;
+    if (numThreads > 1U) {
+        ThreadPool::Options options;
+        options.poolName = "RollbackFileWriter";
+        options.maxThreads = numThreads;
+        options.onCreateThread = [](const std::string& threadName) {
+            Client::initThread(threadName.c_str());
+        };
+        pool = stdx::make_unique<ThreadPool>(options);
+        pool->startup();
+    }
+
+    stdx::mutex statusMutex;
+    Status status = Status::OK();
+
     for (auto&& entry : _observerInfo.rollbackDeletedIdsMap) {
         const auto& uuid = entry.first;
         const auto nss = uuidCatalog.lookupNSSByUUID(uuid);
@@ -786,7 +821,41 @@ Status RollbackImpl::_writeRollbackFiles(OperationContext* opCtx) {
             continue;
         }
 
-        _writeRollbackFileForNamespace(opCtx, uuid, nss, entry.second);
+        if (!pool) {
+            _writeRollbackFileForNamespace(opCtx, uuid, nss, entry.second);
+            continue;
+        }
+
+        auto scheduleStatus = pool->schedule([this, &entry, nss, &statusMutex, &status] {
+            const auto& uuid = entry.first;
+            if (_isInShutdown()) {
+                log() << "Rollback shutting down; not writing rollback file for namespace "
+                      << nss.ns() << " with uuid " << uuid;
+                return;
+            }
+
+            try {
+                auto writerOpCtx = cc().makeOperationContext();
+                _writeRollbackFileForNamespace(writerOpCtx.get(), uuid, nss, entry.second);
+            } catch (const DBException& ex) {
+                stdx::lock_guard<stdx::mutex> lock(statusMutex);
+                if (status.isOK()) {
+                    status = ex.toStatus().withContext(str::stream()
+                                                       << "Failed to write rollback file for "
+                                                       << nss.ns() << " with uuid " << uuid);
+                }
+            }
+        });
+        invariant(scheduleStatus.isOK(), scheduleStatus.reason());
+    }
+
+    if (pool) {
+        pool->shutdown();
+        pool->join();
+    }
+
+    if (!status.isOK()) {
+        return status;
     }
 
     if (_isInShutdown()) {
@@ -815,7 +884,11 @@ void RollbackImpl::_writeRollbackFileForNamespace(OperationContext* opCtx,
     //
     // If this is the first data directory created, we save the full directory path in
     // _rollbackStats. Otherwise, we store the longest common prefix of the two directories.
+    //
+    // Rollback files for different namespaces may be written concurrently, so _mutex guards this
+    // update.
     const auto& newDirectoryPath = removeSaver.root().generic_string();
+    stdx::unique_lock<stdx::mutex> lock(_mutex);
     if (!_rollbackStats.rollbackDataFileDirectory) {
         _rollbackStats.rollbackDataFileDirectory = newDirectoryPath;
     } else {
@@ -827,6 +900,7 @@ void RollbackImpl::_writeRollbackFileForNamespace(OperationContext* opCtx,
                                     .first;
         _rollbackStats.rollbackDataFileDirectory = std::string(newDirectoryPath.begin(), prefixEnd);
     }
+    lock.unlock();
 
     for (auto&& id : idSet) {
         // StorageInterface::findById() does not respect the collation, but because we are using
@@ -187,7 +187,8 @@ public:
 
         /**
          * Function called after a rollback file has been written for each namespace with inserts or
-         * updates that are being rolled back.
+         * updates that are being rolled back. May be called concurrently from several threads when
+         * rollback files are written in parallel.
          */
         virtual void onRollbackFileWrittenForNamespace(UUID, NamespaceString) noexcept {}
 
@@ -290,7 +291,7 @@ protected:
 
     /**
      * Writes a rollback file for the namespace 'nss' containing all of the documents whose _ids are
-     * listed in 'idSet'.
+     * listed in 'idSet'. May be called concurrently for different namespaces.
      *
      * This function is protected so that subclasses can override it for test purposes.
      */
@@ -404,7 +405,8 @@ private:
      * Persists rollback files to disk for each namespace that contains documents inserted or
      * updated after the common point, as these changes will be gone after rollback completes.
      * Before each namespace is examined, we check for interrupt and return a non-OK status if
-     * shutdown is in progress.
+     * shutdown is in progress. The files for up to 'rollbackFileWriterThreadCount' namespaces are
+     * written concurrently, each on its own thread.
      *
      * This function causes the server to terminate if an error occurs while fetching documents from
      * disk or while writing documents to the rollback file. It must be called before marking the
@@ -450,7 +452,8 @@ private:
     // method.
     OpObserver::RollbackObserverInfo _observerInfo = {};  // (N)
 
-    // Holds information about this rollback event.
+    // Holds information about this rollback event. The rollback data file directory is guarded by
+    // _mutex while rollback files are written, as they may be written concurrently.
     RollbackStats _rollbackStats;  // (N)
 
     // Maintains a count of the difference between the count of the record store pointed to by the
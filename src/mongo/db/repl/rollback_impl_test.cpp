@@ -42,10 +42,13 @@
 #include "mongo/db/repl/rollback_test_fixture.h"
 #include "mongo/db/s/shard_identity_rollback_notifier.h"
 #include "mongo/db/s/type_shard_identity.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/s/catalog/type_config_version.h"
+#include "mongo/stdx/mutex.h"
 #include "mongo/unittest/death_test.h"
 #include "mongo/util/assert_util.h"
 #include "mongo/util/log.h"
+#include "mongo/util/scopeguard.h"
 #include "mongo/util/uuid.h"
 
 namespace {
@@ -126,6 +129,7 @@ protected:
             log() << "Looking up " << id.jsonString();
             auto document = _findDocumentById(opCtx, uuid, nss, id.firstElement());
             if (document) {
+                stdx::lock_guard<stdx::mutex> lock(_uuidToObjsMapMutex);
                 _uuidToObjsMap[uuid].push_back(*document);
             }
         }
@@ -133,6 +137,8 @@ protected:
     }
 
 private:
+    // Rollback files for different namespaces may be written concurrently.
+    stdx::mutex _uuidToObjsMapMutex;
     stdx::unordered_map<UUID, std::vector<BSONObj>, UUID::Hash> _uuidToObjsMap;
 };
 
@@ -1143,6 +1149,57 @@ TEST_F(RollbackImplTest, RollbackProperlySavesFilesWhenCreateCollAndInsertsAreRo
                                SimpleBSONObjComparator::kInstance.makeEqualTo()));
 }
 
+TEST_F(RollbackImplTest, RollbackWritesRollbackFilesForNamespacesConcurrently) {
+    auto parameter =
+        ServerParameterSet::getGlobal()->getMap().find("rollbackFileWriterThreadCount")->second;
+    ASSERT_OK(parameter->setFromString("2"));
+    ON_BLOCK_EXIT([parameter] { invariant(parameter->setFromString("1").isOK()); });
+
+    const auto commonOp = makeOpAndRecordId(1);
+    _remoteOplog->setOperations({commonOp});
+    ASSERT_OK(_insertOplogEntry(commonOp.first));
+    _storageInterface->setStableTimestamp(nullptr, Timestamp(1, 1));
+
+    const auto nss1 = NamespaceString("db.people");
+    const auto uuid1 = UUID::gen();
+    const auto coll1 = _initializeCollection(_opCtx.get(), uuid1, nss1);
+    const auto obj1 = BSON("_id" << 0 << "name"
+                                 << "kyle");
+    _insertDocAndGenerateOplogEntry(obj1, uuid1, nss1);
+
+    const auto nss2 = NamespaceString("db.persons");
+    const auto uuid2 = UUID::gen();
+    const auto coll2 = _initializeCollection(_opCtx.get(), uuid2, nss2);
+    const auto obj2 = BSON("_id" << 0 << "name"
+                                 << "jungsoo");
+    _insertDocAndGenerateOplogEntry(obj2, uuid2, nss2);
+
+    // The listener is called from the rollback file writer threads.
+    stdx::mutex mutex;
+    std::vector<UUID> collsWithSuccessfullyWrittenDataFiles;
+    _onRollbackFileWrittenForNamespaceFn =
+        [&mutex, &collsWithSuccessfullyWrittenDataFiles](UUID uuid, NamespaceString nss) {
+            stdx::lock_guard<stdx::mutex> lock(mutex);
+            collsWithSuccessfullyWrittenDataFiles.emplace_back(std::move(uuid));
+        };
+
+    ASSERT_OK(_rollback->runRollback(_opCtx.get()));
+
+    const std::vector<UUID> expectedColls{uuid1, uuid2};
+    ASSERT_EQ(collsWithSuccessfullyWrittenDataFiles.size(), expectedColls.size());
+    ASSERT(std::is_permutation(collsWithSuccessfullyWrittenDataFiles.begin(),
+                               collsWithSuccessfullyWrittenDataFiles.end(),
+                               expectedColls.begin()));
+
+    const auto& deletedObjs1 = _rollback->docsDeletedForNamespace_forTest(uuid1);
+    ASSERT_EQ(deletedObjs1.size(), 1UL);
+    ASSERT_BSONOBJ_EQ(deletedObjs1.front(), obj1);
+
+    const auto& deletedObjs2 = _rollback->docsDeletedForNamespace_forTest(uuid2);
+    ASSERT_EQ(deletedObjs2.size(), 1UL);
+    ASSERT_BSONOBJ_EQ(deletedObjs2.front(), obj2);
+}
+
 TEST_F(RollbackImplTest, RollbackStopsWritingRollbackFilesWhenShutdownIsInProgress) {
     const auto commonOp = makeOpAndRecordId(1);
     _remoteOplog->setOperations({commonOp});
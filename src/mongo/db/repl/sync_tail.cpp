@@ -68,6 +68,7 @@
 #include "mongo/db/repl/session_update_tracker.h"
 #include "mongo/db/service_context.h"
 #include "mongo/db/session.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/session_txn_record_gen.h"
 #include "mongo/db/stats/timer_stats.h"
 #include "mongo/stdx/memory.h"
@@ -101,6 +102,79 @@ ServerStatusMetricField<Counter64> displayAttemptsToBecomeSecondary(
 TimerStats applyBatchStats;
 ServerStatusMetricField<TimerStats> displayOpBatchesApplied("repl.apply.batches", &applyBatchStats);
 
+// Why batches were ended: by the operation or byte limits, to apply a command on its own, or
+// because an op depended on a command batched with ops on other collections.
+Counter64 batchEndsAtOpLimit;
+ServerStatusMetricField<Counter64> displayBatchEndsAtOpLimit(
+    "repl.apply.batchBoundaries.opLimit", &batchEndsAtOpLimit);
+Counter64 batchEndsAtByteLimit;
+ServerStatusMetricField<Counter64> displayBatchEndsAtByteLimit(
+    "repl.apply.batchBoundaries.byteLimit", &batchEndsAtByteLimit);
+Counter64 batchEndsAtIsolatedOp;
+ServerStatusMetricField<Counter64> displayBatchEndsAtIsolatedOp(
+    "repl.apply.batchBoundaries.isolatedOp", &batchEndsAtIsolatedOp);
+Counter64 batchEndsAtCommandDependency;
+ServerStatusMetricField<Counter64> displayBatchEndsAtCommandDependency(
+    "repl.apply.batchBoundaries.commandDependency", &batchEndsAtCommandDependency);
+
+// Number of commands applied in the same batch as ops on other collections.
+Counter64 commandsBatchedWithOps;
+ServerStatusMetricField<Counter64> displayCommandsBatchedWithOps(
+    "repl.apply.commandsBatchedWithOps", &commandsBatchedWithOps);
+
+// Lets commands which act on a single collection share a batch with ops on other collections,
+// rather than being applied in a batch of their own.
+MONGO_EXPORT_SERVER_PARAMETER(replBatchCommandsWithUnrelatedOps, bool, true);
+
+/**
+ * Returns the collection which 'entry', a command, acts on if it acts on that collection alone and
+ * can be applied in the same batch as ops on other collections. Returns boost::none for any other
+ * command, which must be applied in a batch of its own.
+ */
+boost::optional<NamespaceString> getBatchableCommandTarget(const OplogEntry& entry) {
+    switch (entry.getCommandType()) {
+        case OplogEntry::CommandType::kCreate:
+            // Creating a view writes to system.views, whose ops are applied one at a time.
+            if (entry.getObject().hasField("viewOn")) {
+                return boost::none;
+            }
+            break;
+        case OplogEntry::CommandType::kDrop:
+        case OplogEntry::CommandType::kCreateIndexes:
+        case OplogEntry::CommandType::kDropIndexes:
+            break;
+        default:
+            return boost::none;
+    }
+
+    const BSONElement collElem = entry.getObject().firstElement();
+    if (collElem.type() != String) {
+        return boost::none;
+    }
+
+    NamespaceString target(entry.getNamespace().db(), collElem.valueStringData());
+    if (!target.isValid() || target.isSystem() || target.isOnInternalDb()) {
+        return boost::none;
+    }
+    return target;
+}
+
+/**
+ * Returns true, and counts the batch boundary, if 'ops' holds as many ops as a batch may.
+ */
+bool batchIsFull(const SyncTail::OpQueue& ops, const OplogApplier::BatchLimits& limits) {
+    if (ops.getCount() < limits.ops) {
+        return false;
+    }
+    batchEndsAtOpLimit.increment();
+    return true;
+}
+
+bool writesToUnknownNamespaces(const OplogEntry& entry) {
+    return (entry.isCommand() && entry.getCommandType() == OplogEntry::CommandType::kApplyOps) ||
+        entry.getNamespace().isSystem();
+}
+
 class ApplyBatchFinalizer {
 public:
     ApplyBatchFinalizer(ReplicationCoordinator* replCoord) : _replCoord(replCoord) {}
@@ -894,6 +968,7 @@ bool SyncTail::tryPopAndWaitForMore(OperationContext* opCtx,
         // We allow single-op batches to exceed the byte limit so that large ops are able to be
         // processed.
         if (!ops->empty() && (ops->getBytes() + size_t(op.objsize())) > limits.bytes) {
+            batchEndsAtByteLimit.increment();
             return true;  // Return before wasting time parsing the op.
         }
 
@@ -928,14 +1003,37 @@ bool SyncTail::tryPopAndWaitForMore(OperationContext* opCtx,
         return true;
     }
 
-    // Commands must be processed one at a time. The only exception to this is applyOps because
-    // applyOps oplog entries are effectively containers for CRUD operations. Therefore, it is safe
-    // to batch applyOps commands with CRUD operations when reading from the oplog buffer.
+    const bool isCommand =
+        entry.isCommand() && entry.getCommandType() != OplogEntry::CommandType::kApplyOps;
+
+    // Commands which act on a single collection, such as create or dropIndexes, may be applied in
+    // the same batch as ops on other collections. Ops within a batch are applied in parallel, so
+    // such a command only joins a batch in which no op writes to its collection, and no later op
+    // on its collection may join the batch after it.
+    if (isCommand && replBatchCommandsWithUnrelatedOps.load()) {
+        if (auto target = getBatchableCommandTarget(entry)) {
+            if (ops->getCount() > 1 && !ops->canAddCommandOn(*target)) {
+                ops->pop_back();
+                batchEndsAtCommandDependency.increment();
+                return true;
+            }
+
+            if (ops->getCount() > 1) {
+                commandsBatchedWithOps.increment();
+            }
+            ops->addCommandOn(*target);
+            _consume(opCtx, oplogBuffer);
+            return batchIsFull(*ops, limits);
+        }
+    }
+
+    // Other commands must be processed one at a time. The only exception to this is applyOps
+    // because applyOps oplog entries are effectively containers for CRUD operations. Therefore, it
+    // is safe to batch applyOps commands with CRUD operations when reading from the oplog buffer.
     // Oplog entries on 'system.views' should also be processed one at a time. View catalog
     // immediately reflects changes for each oplog entry so we can see inconsistent view catalog if
     // multiple oplog entries on 'system.views' are being applied out of the original order.
-    if ((entry.isCommand() && entry.getCommandType() != OplogEntry::CommandType::kApplyOps) ||
-        entry.getNamespace().isSystemDotViews()) {
+    if (isCommand || entry.getNamespace().isSystemDotViews()) {
         if (ops->getCount() == 1) {
             // apply commands one-at-a-time
             _consume(opCtx, oplogBuffer);
@@ -947,14 +1045,48 @@ bool SyncTail::tryPopAndWaitForMore(OperationContext* opCtx,
         }
 
         // Apply what we have so far.
+        batchEndsAtIsolatedOp.increment();
+        return true;
+    }
+
+    // An op which may write to the collection of a command earlier in the batch has to wait for
+    // the command to be applied.
+    if (ops->dependsOnCommandIn(entry)) {
+        ops->pop_back();
+        batchEndsAtCommandDependency.increment();
         return true;
     }
 
     // We are going to apply this Op.
+    ops->addWritesOf(entry);
     _consume(opCtx, oplogBuffer);
 
     // Go back for more ops, unless we've hit the limit.
-    return ops->getCount() >= limits.ops;
+    return batchIsFull(*ops, limits);
+}
+
+void SyncTail::OpQueue::addWritesOf(const OplogEntry& entry) {
+    if (writesToUnknownNamespaces(entry)) {
+        _writesToAnyNamespace = true;
+    } else {
+        _namespaces.insert(entry.getNamespace().ns());
+    }
+}
+
+void SyncTail::OpQueue::addCommandOn(const NamespaceString& target) {
+    _namespaces.insert(target.ns());
+    _commandNamespaces.insert(target.ns());
+}
+
+bool SyncTail::OpQueue::canAddCommandOn(const NamespaceString& target) const {
+    return !_writesToAnyNamespace && !_namespaces.count(target.ns());
+}
+
+bool SyncTail::OpQueue::dependsOnCommandIn(const OplogEntry& entry) const {
+    if (_commandNamespaces.empty()) {
+        return false;
+    }
+    return writesToUnknownNamespaces(entry) || _commandNamespaces.count(entry.getNamespace().ns());
 }
 
 void SyncTail::_consume(OperationContext* opCtx, OplogBuffer* oplogBuffer) {
@@ -42,6 +42,7 @@
 #include "mongo/db/repl/storage_interface.h"
 #include "mongo/stdx/functional.h"
 #include "mongo/stdx/mutex.h"
+#include "mongo/stdx/unordered_set.h"
 #include "mongo/util/concurrency/thread_pool.h"
 
 namespace mongo {
@@ -184,10 +185,42 @@ public:
             return std::move(_batch);
         }
 
+        /**
+         * Records the namespace which 'entry', an op which is not a command other than applyOps,
+         * writes to. Ops on system collections and applyOps may write to namespaces which cannot
+         * be told from the entry, so they are recorded as writing to any namespace.
+         */
+        void addWritesOf(const OplogEntry& entry);
+
+        /**
+         * Records a command which acts on the collection 'target' only, and so can be applied in
+         * the same batch as ops on other collections.
+         */
+        void addCommandOn(const NamespaceString& target);
+
+        /**
+         * Returns true if a command acting on 'target' only can join this batch, which is when no
+         * op in the batch may write to 'target'.
+         */
+        bool canAddCommandOn(const NamespaceString& target) const;
+
+        /**
+         * Returns true if 'entry', an op which is not a command other than applyOps, may write to
+         * the collection of a command in this batch and so must be applied in a later batch.
+         */
+        bool dependsOnCommandIn(const OplogEntry& entry) const;
+
     private:
         std::vector<OplogEntry> _batch;
         size_t _bytes;
         bool _mustShutdown = false;
+
+        // The namespaces written to by the ops and commands in this batch, and those of the
+        // commands alone. '_writesToAnyNamespace' is set once an op is added whose namespaces are
+        // unknown.
+        stdx::unordered_set<std::string> _namespaces;
+        stdx::unordered_set<std::string> _commandNamespaces;
+        bool _writesToAnyNamespace = false;
     };
 
     using BatchLimits = OplogApplier::BatchLimits;
@@ -60,6 +60,7 @@
 #include "mongo/db/repl/replication_process.h"
 #include "mongo/db/repl/storage_interface.h"
 #include "mongo/db/repl/sync_tail.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/service_context.h"
 #include "mongo/db/service_context_d_test_fixture.h"
 #include "mongo/db/session_catalog.h"
@@ -809,6 +810,57 @@ TEST_F(SyncTailTest, MultiSyncApplyLimitsBatchCountWhenGroupingInsertOperation)
     ASSERT_BSONOBJ_EQ(insertOps.back().getObject(), singleInsertDocumentGroup[0]);
 }
 
+TEST_F(SyncTailTest, MultiSyncApplyGroupsInterleavedInsertsUpToConfiguredBatchCount) {
+    auto parameter =
+        ServerParameterSet::getGlobal()->getMap().find("replInsertGroupMaxBatchCount")->second;
+    ASSERT_OK(parameter->setFromString("3"));
+    ON_BLOCK_EXIT([parameter] { invariant(parameter->setFromString("64").isOK()); });
+
+    int seconds = 1;
+    NamespaceString nss1("test." + _agent.getSuiteName() + "_" + _agent.getTestName() + "_1");
+    NamespaceString nss2("test." + _agent.getSuiteName() + "_" + _agent.getTestName() + "_2");
+    MultiApplier::Operations operationsToApply = {
+        makeCreateCollectionOplogEntry({Timestamp(Seconds(seconds++), 0), 1LL}, nss1),
+        makeCreateCollectionOplogEntry({Timestamp(Seconds(seconds++), 0), 1LL}, nss2)};
+
+    // Interleave four inserts into each collection.
+    MultiApplier::Operations insertOps1, insertOps2;
+    auto makeOp = [&](const NamespaceString& nss, MultiApplier::Operations* insertOps) {
+        insertOps->push_back(makeInsertDocumentOplogEntry(
+            {Timestamp(Seconds(seconds), 0), 1LL}, nss, BSON("_id" << seconds)));
+        operationsToApply.push_back(insertOps->back());
+        ++seconds;
+    };
+    for (int i = 0; i < 4; ++i) {
+        makeOp(nss1, &insertOps1);
+        makeOp(nss2, &insertOps2);
+    }
+
+    // Each element in 'docsInserted' is a grouped insert operation.
+    std::vector<std::vector<BSONObj>> docsInserted;
+    _opObserver->onInsertsFn =
+        [&](OperationContext*, const NamespaceString& nss, const std::vector<BSONObj>& docs) {
+            docsInserted.push_back(docs);
+        };
+
+    ASSERT_OK(runOpsSteadyState(operationsToApply));
+
+    // The inserts into each collection are applied in groups of at most three, in their original
+    // order: {insert1_1, insert1_2, insert1_3}, {insert1_4}, {insert2_1, insert2_2, insert2_3},
+    // {insert2_4}.
+    ASSERT_EQUALS(4U, docsInserted.size());
+    std::size_t group = 0;
+    for (const auto& insertOps : {insertOps1, insertOps2}) {
+        ASSERT_EQUALS(3U, docsInserted[group].size());
+        for (std::size_t i = 0; i < 3U; ++i) {
+            ASSERT_BSONOBJ_EQ(insertOps[i].getObject(), docsInserted[group][i]);
+        }
+        ASSERT_EQUALS(1U, docsInserted[group + 1].size());
+        ASSERT_BSONOBJ_EQ(insertOps[3].getObject(), docsInserted[group + 1][0]);
+        group += 2;
+    }
+}
+
 // Create an 'insert' oplog operation of an approximate size in bytes. The '_id' of the oplog entry
 // and its optime in seconds are given by the 'id' argument.
 OplogEntry makeSizedInsertOp(const NamespaceString& nss, int size, int id) {
@@ -1136,6 +1188,69 @@ DEATH_TEST_F(SyncTailTest,
     syncTail.oplogApplication(oplogBuffer.get(), &replCoord);
 }
 
+TEST_F(SyncTailTest, TryPopAndWaitForMoreBatchesCommandWithOpsOnOtherCollections) {
+    NamespaceString nssX("test.x");
+    NamespaceString nssY("test.y");
+    OplogBufferBlockingQueue oplogBuffer;
+    std::vector<BSONObj> entries = {
+        makeInsertDocumentOplogEntry({Timestamp(Seconds(1), 0), 1LL}, nssX, BSON("_id" << 1))
+            .toBSON(),
+        makeCreateCollectionOplogEntry({Timestamp(Seconds(2), 0), 1LL}, nssY).toBSON(),
+        makeInsertDocumentOplogEntry({Timestamp(Seconds(3), 0), 1LL}, nssX, BSON("_id" << 2))
+            .toBSON(),
+        makeInsertDocumentOplogEntry({Timestamp(Seconds(4), 0), 1LL}, nssY, BSON("_id" << 1))
+            .toBSON(),
+    };
+    oplogBuffer.pushAllNonBlocking(_opCtx.get(), entries.begin(), entries.end());
+
+    auto writerPool = OplogApplier::makeWriterPool();
+    SyncTail syncTail(
+        nullptr, getConsistencyMarkers(), getStorageInterface(), multiSyncApply, writerPool.get());
+    OplogApplier::BatchLimits limits;
+    limits.bytes = 16 * 1024 * 1024;
+    limits.ops = 100;
+
+    // The create on 'nssY' joins the inserts into 'nssX', but the insert into 'nssY' must wait for
+    // the create to be applied.
+    SyncTail::OpQueue ops(limits.ops);
+    while (!syncTail.tryPopAndWaitForMore(_opCtx.get(), &oplogBuffer, &ops, limits)) {
+    }
+    auto batch = ops.releaseBatch();
+    ASSERT_EQUALS(3U, batch.size());
+    ASSERT_TRUE(batch[1].isCommand());
+    ASSERT_EQUALS(1U, oplogBuffer.getCount());
+
+    SyncTail::OpQueue nextOps(limits.ops);
+    ASSERT_TRUE(syncTail.tryPopAndWaitForMore(_opCtx.get(), &oplogBuffer, &nextOps, limits));
+    ASSERT_EQUALS(1U, nextOps.getCount());
+    ASSERT_EQUALS(nssY, nextOps.back().getNamespace());
+}
+
+TEST_F(SyncTailTest, TryPopAndWaitForMoreAppliesCommandAloneAfterOpOnItsCollection) {
+    NamespaceString nssX("test.x");
+    OplogBufferBlockingQueue oplogBuffer;
+    std::vector<BSONObj> entries = {
+        makeInsertDocumentOplogEntry({Timestamp(Seconds(1), 0), 1LL}, nssX, BSON("_id" << 1))
+            .toBSON(),
+        makeCommandOplogEntry({Timestamp(Seconds(2), 0), 1LL}, nssX, BSON("drop" << nssX.coll()))
+            .toBSON(),
+    };
+    oplogBuffer.pushAllNonBlocking(_opCtx.get(), entries.begin(), entries.end());
+
+    auto writerPool = OplogApplier::makeWriterPool();
+    SyncTail syncTail(
+        nullptr, getConsistencyMarkers(), getStorageInterface(), multiSyncApply, writerPool.get());
+    OplogApplier::BatchLimits limits;
+    limits.bytes = 16 * 1024 * 1024;
+    limits.ops = 100;
+
+    SyncTail::OpQueue ops(limits.ops);
+    while (!syncTail.tryPopAndWaitForMore(_opCtx.get(), &oplogBuffer, &ops, limits)) {
+    }
+    ASSERT_EQUALS(1U, ops.getCount());
+    ASSERT_EQUALS(1U, oplogBuffer.getCount());
+}
+
 TEST_F(IdempotencyTest, Geo2dsphereIndexFailedOnUpdate) {
     ASSERT_OK(
         ReplicationCoordinator::get(_opCtx.get())->setFollowerMode(MemberState::RS_RECOVERING));
@@ -48,8 +48,10 @@
 #include "mongo/db/sorter/sorter.h"
 
 #include <boost/filesystem/operations.hpp>
+#include <deque>
 #include <snappy.h>
 #include <vector>
+#include <zlib.h>
 
 #include "mongo/base/string_data.h"
 #include "mongo/config.h"
@@ -59,6 +61,7 @@
 #include "mongo/db/storage/storage_options.h"
 #include "mongo/platform/atomic_word.h"
 #include "mongo/s/is_mongos.h"
+#include "mongo/stdx/future.h"
 #include "mongo/util/assert_util.h"
 #include "mongo/util/bufreader.h"
 #include "mongo/util/destructor_guard.h"
@@ -114,6 +117,88 @@ private:
     const std::string _fileName;
 };
 
+/**
+ * Compresses 'size' bytes at 'data' into 'out'. Blocks compressed with zlib are prefixed with their
+ * uncompressed size, which zlib does not record.
+ */
+inline void compressBlock(SortOptions::Compressor compressor,
+                          const char* data,
+                          size_t size,
+                          std::string* out) {
+    switch (compressor) {
+        case SortOptions::Compressor::kNone:
+            MONGO_UNREACHABLE;
+        case SortOptions::Compressor::kSnappy:
+            snappy::Compress(data, size, out);
+            return;
+        case SortOptions::Compressor::kZlib: {
+            const uint32_t uncompressedSize = size;
+            uLongf compressedSize = ::compressBound(size);
+            out->resize(sizeof(uncompressedSize) + compressedSize);
+            memcpy(&(*out)[0], &uncompressedSize, sizeof(uncompressedSize));
+            const int ret =
+                ::compress2(reinterpret_cast<Bytef*>(&(*out)[sizeof(uncompressedSize)]),
+                            &compressedSize,
+                            reinterpret_cast<const Bytef*>(data),
+                            size,
+                            Z_DEFAULT_COMPRESSION);
+            massert(51134, str::stream() << "zlib compression failed: " << ret, ret == Z_OK);
+            out->resize(sizeof(uncompressedSize) + compressedSize);
+            return;
+        }
+    }
+    MONGO_UNREACHABLE;
+}
+
+/**
+ * Uncompresses the 'size' bytes at 'data', which compressBlock() produced, into 'out' and returns
+ * the uncompressed size.
+ */
+inline size_t uncompressBlock(SortOptions::Compressor compressor,
+                              const char* data,
+                              size_t size,
+                              std::unique_ptr<char[]>* out) {
+    switch (compressor) {
+        case SortOptions::Compressor::kNone:
+            MONGO_UNREACHABLE;
+        case SortOptions::Compressor::kSnappy: {
+            dassert(snappy::IsValidCompressedBuffer(data, size));
+
+            size_t uncompressedSize;
+            massert(17061,
+                    "couldn't get uncompressed length",
+                    snappy::GetUncompressedLength(data, size, &uncompressedSize));
+
+            out->reset(new char[uncompressedSize]);
+            massert(17062, "decompression failed", snappy::RawUncompress(data, size, out->get()));
+            return uncompressedSize;
+        }
+        case SortOptions::Compressor::kZlib: {
+            uint32_t uncompressedSize;
+            massert(51135, "compressed block too short", size >= sizeof(uncompressedSize));
+            memcpy(&uncompressedSize, data, sizeof(uncompressedSize));
+
+            uLongf outLen = uncompressedSize;
+            out->reset(new char[uncompressedSize]);
+            const int ret =
+                ::uncompress(reinterpret_cast<Bytef*>(out->get()),
+                             &outLen,
+                             reinterpret_cast<const Bytef*>(data + sizeof(uncompressedSize)),
+                             size - sizeof(uncompressedSize));
+            massert(51136,
+                    str::stream() << "zlib decompression failed: " << ret,
+                    ret == Z_OK && outLen == uncompressedSize);
+            return uncompressedSize;
+        }
+    }
+    MONGO_UNREACHABLE;
+}
+
+/** Returns the checksum stored with each block of a spill file. */
+inline uint32_t blockChecksum(const char* data, size_t size) {
+    return ::crc32(::crc32(0L, Z_NULL, 0), reinterpret_cast<const Bytef*>(data), size);
+}
+
 /** Returns results from sorted in-memory storage */
 template <typename Key, typename Value>
 class InMemIterator : public SortIteratorInterface<Key, Value> {
@@ -152,23 +237,17 @@ public:
         Settings;
     typedef std::pair<Key, Value> Data;
 
+    // The file is not opened until the first read so that runs waiting to be merged do not hold
+    // file handles, and it is closed again once it has been read to the end.
     FileIterator(const std::string& fileName,
                  const Settings& settings,
+                 SortOptions::Compressor compressor,
                  std::shared_ptr<FileDeleter> fileDeleter)
         : _settings(settings),
+          _compressor(compressor),
           _done(false),
           _fileName(fileName),
-          _fileDeleter(fileDeleter),
-          _file(_fileName.c_str(), std::ios::in | std::ios::binary) {
-        massert(16814,
-                str::stream() << "error opening file \"" << _fileName << "\": "
-                              << myErrnoWithDescription(),
-                _file.good());
-
-        massert(16815,
-                str::stream() << "unexpected empty file: " << _fileName,
-                boost::filesystem::file_size(_fileName) != 0);
-    }
+          _fileDeleter(fileDeleter) {}
 
     bool more() {
         if (!_done)
@@ -194,7 +273,22 @@ private:
             fill();
     }
 
+    void open() {
+        _file.open(_fileName.c_str(), std::ios::in | std::ios::binary);
+        massert(16814,
+                str::stream() << "error opening file \"" << _fileName << "\": "
+                              << myErrnoWithDescription(),
+                _file.good());
+
+        massert(16815,
+                str::stream() << "unexpected empty file: " << _fileName,
+                boost::filesystem::file_size(_fileName) != 0);
+    }
+
     void fill() {
+        if (!_file.is_open())
+            open();
+
         int32_t rawSize;
         read(&rawSize, sizeof(rawSize));
         if (_done)
@@ -204,10 +298,18 @@ private:
         const bool compressed = rawSize < 0;
         int32_t blockSize = std::abs(rawSize);
 
-        _buffer.reset(new char[blockSize]);
-        read(_buffer.get(), blockSize);
+        uint32_t checksum;
+        read(&checksum, sizeof(checksum));
+        if (!_done) {
+            _buffer.reset(new char[blockSize]);
+            read(_buffer.get(), blockSize);
+        }
         massert(16816, "file too short?", !_done);
 
+        massert(51133,
+                str::stream() << "checksum mismatch reading file \"" << _fileName << "\"",
+                blockChecksum(_buffer.get(), blockSize) == checksum);
+
         auto encryptionHooks = EncryptionHooks::get(getGlobalServiceContext());
         if (encryptionHooks->enabled()) {
             std::unique_ptr<char[]> out(new char[blockSize]);
@@ -230,17 +332,9 @@ private:
             return;
         }
 
-        dassert(snappy::IsValidCompressedBuffer(_buffer.get(), blockSize));
-
-        size_t uncompressedSize;
-        massert(17061,
-                "couldn't get uncompressed length",
-                snappy::GetUncompressedLength(_buffer.get(), blockSize, &uncompressedSize));
-
-        std::unique_ptr<char[]> decompressionBuffer(new char[uncompressedSize]);
-        massert(17062,
-                "decompression failed",
-                snappy::RawUncompress(_buffer.get(), blockSize, decompressionBuffer.get()));
+        std::unique_ptr<char[]> decompressionBuffer;
+        size_t uncompressedSize =
+            uncompressBlock(_compressor, _buffer.get(), blockSize, &decompressionBuffer);
 
         // hold on to decompressed data and throw out compressed data at block exit
         _buffer.swap(decompressionBuffer);
@@ -253,6 +347,7 @@ private:
         if (!_file.good()) {
             if (_file.eof()) {
                 _done = true;
+                _file.close();
                 return;
             }
 
@@ -264,6 +359,7 @@ private:
     }
 
     const Settings _settings;
+    const SortOptions::Compressor _compressor;
     bool _done;
     std::unique_ptr<char[]> _buffer;
     std::unique_ptr<BufReader> _reader;
@@ -396,6 +492,51 @@ private:
     STLComparator _greater;                      // named so calls make sense
 };
 
+/**
+ * Merges the runs in 'iters' in groups of opts.maxMergeFanIn into new spill files until no more
+ * than opts.maxMergeFanIn remain, so the final merge reads from a bounded number of files at once.
+ * Only adjacent runs are merged together, which keeps the merge stable.
+ */
+template <typename Key, typename Value, typename Comparator>
+void mergeToMaxFanIn(std::vector<std::shared_ptr<SortIteratorInterface<Key, Value>>>* iters,
+                     const SortOptions& opts,
+                     const Comparator& comp,
+                     const typename SortedFileWriter<Key, Value>::Settings& settings) {
+    typedef SortIteratorInterface<Key, Value> Iterator;
+
+    if (opts.maxMergeFanIn == 0)
+        return;
+    invariant(opts.maxMergeFanIn >= 2);
+
+    while (iters->size() > opts.maxMergeFanIn) {
+        std::vector<std::shared_ptr<Iterator>> merged;
+        for (size_t begin = 0; begin < iters->size(); begin += opts.maxMergeFanIn) {
+            const size_t end = std::min(begin + opts.maxMergeFanIn, iters->size());
+            if (end - begin == 1) {
+                merged.push_back(std::move((*iters)[begin]));
+                continue;
+            }
+
+            std::vector<std::shared_ptr<Iterator>> group;
+            for (size_t i = begin; i < end; i++) {
+                // Moving the runs out lets each file be deleted as soon as it has been merged.
+                group.push_back(std::move((*iters)[i]));
+            }
+
+            MergeIterator<Key, Value, Comparator> mergeIter(group, opts, comp);
+            group.clear();
+
+            SortedFileWriter<Key, Value> writer(opts, settings);
+            while (mergeIter.more()) {
+                auto data = mergeIter.next();
+                writer.addAlreadySorted(data.first, data.second);
+            }
+            merged.push_back(std::shared_ptr<Iterator>(writer.done()));
+        }
+        iters->swap(merged);
+    }
+}
+
 template <typename Key, typename Value, typename Comparator>
 class NoLimitSorter : public Sorter<Key, Value> {
 public:
@@ -408,7 +549,12 @@ public:
     NoLimitSorter(const SortOptions& opts,
                   const Comparator& comp,
                   const Settings& settings = Settings())
-        : _comp(comp), _settings(settings), _opts(opts), _memUsed(0) {
+        : _comp(comp),
+          _settings(settings),
+          _opts(opts),
+          _memUsed(0),
+          _maxRunMemoryUsageBytes(opts.maxMemoryUsageBytes /
+                                  std::max(opts.runGenerationThreads, size_t(1))) {
         verify(_opts.limit == 0);
     }
 
@@ -418,23 +564,25 @@ public:
         _memUsed += key.memUsageForSorter();
         _memUsed += val.memUsageForSorter();
 
-        if (_memUsed > _opts.maxMemoryUsageBytes)
+        if (_memUsed > _maxRunMemoryUsageBytes)
             spill();
     }
 
     Iterator* done() {
-        if (_iters.empty()) {
-            sort();
+        if (_iters.empty() && _pendingRuns.empty()) {
+            sort(&_data);
             return new InMemIterator<Key, Value>(_data);
         }
 
         spill();
+        waitForPendingRuns(0);
+        mergeToMaxFanIn(&_iters, _opts, _comp, _settings);
         return Iterator::merge(_iters, _opts, _comp);
     }
 
     // TEMP these are here for compatibility. Will be replaced with a general stats API
     int numFiles() const {
-        return _iters.size();
+        return _iters.size() + _pendingRuns.size();
     }
     size_t memUsed() const {
         return _memUsed;
@@ -453,13 +601,32 @@ private:
         const Comparator& _comp;
     };
 
-    void sort() {
+    void sort(std::deque<Data>* data) const {
         STLComparator less(_comp);
-        std::stable_sort(_data.begin(), _data.end(), less);
+        std::stable_sort(data->begin(), data->end(), less);
 
         // Does 2x more compares than stable_sort
         // TODO test on windows
-        // std::sort(_data.begin(), _data.end(), comp);
+        // std::sort(data->begin(), data->end(), comp);
+    }
+
+    std::shared_ptr<Iterator> sortAndSpill(std::deque<Data>* data) const {
+        sort(data);
+
+        SortedFileWriter<Key, Value> writer(_opts, _settings);
+        for (; !data->empty(); data->pop_front()) {
+            writer.addAlreadySorted(data->front().first, data->front().second);
+        }
+
+        return std::shared_ptr<Iterator>(writer.done());
+    }
+
+    // Collects finished runs, in the order they were started, until at most 'maxPending' remain.
+    void waitForPendingRuns(size_t maxPending) {
+        while (_pendingRuns.size() > maxPending) {
+            _iters.push_back(_pendingRuns.front().get());
+            _pendingRuns.pop_front();
+        }
     }
 
     void spill() {
@@ -480,15 +647,18 @@ private:
                           << " Pass allowDiskUse:true to opt in.");
         }
 
-        sort();
-
-        SortedFileWriter<Key, Value> writer(_opts, _settings);
-        for (; !_data.empty(); _data.pop_front()) {
-            writer.addAlreadySorted(_data.front().first, _data.front().second);
+        if (_opts.runGenerationThreads > 1) {
+            // Hand the run to a worker thread and keep accepting data while it is sorted and
+            // written, waiting only if every worker is already busy.
+            waitForPendingRuns(_opts.runGenerationThreads - 1);
+            auto run = std::make_shared<std::deque<Data>>();
+            run->swap(_data);
+            _pendingRuns.push_back(
+                stdx::async(stdx::launch::async, [this, run] { return sortAndSpill(run.get()); }));
+        } else {
+            _iters.push_back(sortAndSpill(&_data));
         }
 
-        _iters.push_back(std::shared_ptr<Iterator>(writer.done()));
-
         _memUsed = 0;
     }
 
@@ -496,8 +666,13 @@ private:
     const Settings _settings;
     SortOptions _opts;
     size_t _memUsed;
+    const size_t _maxRunMemoryUsageBytes;
     std::deque<Data> _data;                         // the "current" data
     std::vector<std::shared_ptr<Iterator>> _iters;  // data that has already been spilled
+
+    // Runs being sorted and spilled by worker threads. Declared last so that it is destroyed, which
+    // waits for the workers, before the members they use.
+    std::deque<stdx::future<std::shared_ptr<Iterator>>> _pendingRuns;
 };
 
 template <typename Key, typename Value, typename Comparator>
@@ -629,6 +804,7 @@ public:
         }
 
         spill();
+        mergeToMaxFanIn(&_iters, _opts, _comp, _settings);
         return Iterator::merge(_iters, _opts, _comp);
     }
 
@@ -808,7 +984,7 @@ inline unsigned nextFileNumber() {
 
 template <typename Key, typename Value>
 SortedFileWriter<Key, Value>::SortedFileWriter(const SortOptions& opts, const Settings& settings)
-    : _settings(settings) {
+    : _settings(settings), _compressor(opts.spillCompressor) {
     namespace str = mongoutils::str;
 
     // This should be checked by consumers, but if we get here don't allow writes.
@@ -859,10 +1035,13 @@ void SortedFileWriter<Key, Value>::spill() {
         return;
 
     std::string compressed;
-    snappy::Compress(outBuffer, size, &compressed);
-    verify(compressed.size() <= size_t(std::numeric_limits<int32_t>::max()));
+    bool shouldCompress = false;
+    if (_compressor != SortOptions::Compressor::kNone) {
+        sorter::compressBlock(_compressor, outBuffer, size, &compressed);
+        verify(compressed.size() <= size_t(std::numeric_limits<int32_t>::max()));
+        shouldCompress = compressed.size() < size_t(_buffer.len() / 10 * 9);
+    }
 
-    const bool shouldCompress = compressed.size() < size_t(_buffer.len() / 10 * 9);
     if (shouldCompress) {
         size = compressed.size();
         outBuffer = const_cast<char*>(compressed.data());
@@ -886,10 +1065,13 @@ void SortedFileWriter<Key, Value>::spill() {
         size = resultLen;
     }
 
+    const uint32_t checksum = sorter::blockChecksum(outBuffer, size);
+
     // negative size means compressed
     size = shouldCompress ? -size : size;
     try {
         _file.write(reinterpret_cast<const char*>(&size), sizeof(size));
+        _file.write(reinterpret_cast<const char*>(&checksum), sizeof(checksum));
         _file.write(outBuffer, std::abs(size));
 
     } catch (const std::exception&) {
@@ -905,7 +1087,7 @@ template <typename Key, typename Value>
 SortIteratorInterface<Key, Value>* SortedFileWriter<Key, Value>::done() {
     spill();
     _file.close();
-    return new sorter::FileIterator<Key, Value>(_fileName, _settings, _fileDeleter);
+    return new sorter::FileIterator<Key, Value>(_fileName, _settings, _compressor, _fileDeleter);
 }
 
 //
@@ -934,6 +1116,8 @@ Sorter<Key, Value>* Sorter<Key, Value>::make(const SortOptions& opts,
     massert(17149,
             "Attempting to use external sort without setting SortOptions::tempDir",
             !(opts.extSortAllowed && opts.tempDir.empty()));
+
+    invariant(opts.maxMergeFanIn != 1);
     switch (opts.limit) {
         case 0:
             return new sorter::NoLimitSorter<Key, Value, Comparator>(opts, comp, settings);
@@ -28,6 +28,7 @@
 
 #pragma once
 
+#include <boost/optional.hpp>
 #include <deque>
 #include <fstream>
 #include <memory>
@@ -36,6 +37,7 @@
 #include <vector>
 
 #include "mongo/base/disallow_copying.h"
+#include "mongo/base/string_data.h"
 #include "mongo/bson/util/builder.h"
 
 /**
@@ -93,13 +95,39 @@ class FileDeleter;
  * Runtime options that control the Sorter's behavior
  */
 struct SortOptions {
+    /// How blocks of spilled data are compressed. A block is stored uncompressed when compressing
+    /// it would not save at least 10%.
+    enum class Compressor { kNone, kSnappy, kZlib };
+
     unsigned long long limit;    /// number of KV pairs to be returned. 0 for no limit.
     size_t maxMemoryUsageBytes;  /// Approximate.
     bool extSortAllowed;         /// If false, uassert if more mem needed than allowed.
     std::string tempDir;         /// Directory to directly place files in.
                                  /// Must be explicitly set if extSortAllowed is true.
 
-    SortOptions() : limit(0), maxMemoryUsageBytes(64 * 1024 * 1024), extSortAllowed(false) {}
+    size_t runGenerationThreads;  /// Threads which sort and spill runs when there is no limit.
+                                  /// maxMemoryUsageBytes is split between them.
+    size_t maxMergeFanIn;         /// Max runs merged at once. 0 for no limit, otherwise >= 2.
+    Compressor spillCompressor;
+
+    SortOptions()
+        : limit(0),
+          maxMemoryUsageBytes(64 * 1024 * 1024),
+          extSortAllowed(false),
+          runGenerationThreads(1),
+          maxMergeFanIn(0),
+          spillCompressor(Compressor::kSnappy) {}
+
+    /// Returns the Compressor named by 'name' ("none", "snappy" or "zlib"), if there is one.
+    static boost::optional<Compressor> parseCompressor(StringData name) {
+        if (name == "none")
+            return Compressor::kNone;
+        if (name == "snappy")
+            return Compressor::kSnappy;
+        if (name == "zlib")
+            return Compressor::kZlib;
+        return boost::none;
+    }
 
     /// Fluent API to support expressions like SortOptions().Limit(1000).ExtSortAllowed(true)
 
@@ -122,6 +150,21 @@ struct SortOptions {
         tempDir = newTempDir;
         return *this;
     }
+
+    SortOptions& RunGenerationThreads(size_t newRunGenerationThreads) {
+        runGenerationThreads = newRunGenerationThreads;
+        return *this;
+    }
+
+    SortOptions& MaxMergeFanIn(size_t newMaxMergeFanIn) {
+        maxMergeFanIn = newMaxMergeFanIn;
+        return *this;
+    }
+
+    SortOptions& SpillCompressor(Compressor newSpillCompressor) {
+        spillCompressor = newSpillCompressor;
+        return *this;
+    }
 };
 
 /// This is the output from the sorting framework
@@ -204,6 +247,7 @@ private:
     void spill();
 
     const Settings _settings;
+    const SortOptions::Compressor _compressor;
     std::string _fileName;
     std::shared_ptr<sorter::FileDeleter> _fileDeleter;  // Must outlive _file
     std::ofstream _file;
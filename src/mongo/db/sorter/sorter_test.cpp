@@ -243,8 +243,16 @@ public:
 class SortedFileWriterAndFileIteratorTests : public ScopedGlobalServiceContextForTest {
 public:
     void run() {
+        for (auto compressor : {SortOptions::Compressor::kNone,
+                                SortOptions::Compressor::kSnappy,
+                                SortOptions::Compressor::kZlib}) {
+            runWithCompressor(compressor);
+        }
+    }
+
+    void runWithCompressor(SortOptions::Compressor compressor) {
         unittest::TempDir tempDir("sortedFileWriterTests");
-        const SortOptions opts = SortOptions().TempDir(tempDir.path());
+        const SortOptions opts = SortOptions().TempDir(tempDir.path()).SpillCompressor(compressor);
         {  // small
             SortedFileWriter<IntWrapper, IntWrapper> sorter(opts);
             sorter.addAlreadySorted(0, 0);
@@ -268,6 +276,33 @@ public:
     }
 };
 
+class FileIteratorDetectsCorruption : public ScopedGlobalServiceContextForTest {
+public:
+    void run() {
+        unittest::TempDir tempDir("fileIteratorDetectsCorruptionTests");
+        const SortOptions opts =
+            SortOptions().TempDir(tempDir.path()).SpillCompressor(SortOptions::Compressor::kNone);
+
+        SortedFileWriter<IntWrapper, IntWrapper> writer(opts);
+        for (int i = 0; i < 1000; i++)
+            writer.addAlreadySorted(i, -i);
+        std::shared_ptr<IWIterator> iter(writer.done());
+
+        // The file is not opened until it is first read, so it can still be modified here.
+        boost::filesystem::directory_iterator file(tempDir.path());
+        ASSERT(file != boost::filesystem::directory_iterator());
+        {
+            std::fstream stream(file->path().string(),
+                                std::ios::in | std::ios::out | std::ios::binary);
+            stream.seekg(100);
+            const char byte = stream.get();
+            stream.seekp(100);
+            stream.put(~byte);
+        }
+
+        ASSERT_THROWS_CODE(iter->more(), AssertionException, 51133);
+    }
+};
 
 class MergeIteratorTests {
 public:
@@ -511,6 +546,25 @@ public:
 };
 
 
+// Sorts and spills runs on worker threads while more data is added. Splitting the memory limit
+// between the threads makes for many small runs, so the number merged at once is bounded too.
+class LotsOfDataParallelRunGeneration : public LotsOfDataLittleMemory</*random=*/true> {
+    SortOptions adjustSortOptions(SortOptions opts) {
+        opts = LotsOfDataLittleMemory::adjustSortOptions(opts);
+        return opts.RunGenerationThreads(4).MaxMergeFanIn(64);
+    }
+};
+
+// Merges the spilled runs in several passes.
+template <bool Random = true>
+class LotsOfDataBoundedFanIn : public LotsOfDataLittleMemory<Random> {
+    typedef LotsOfDataLittleMemory<Random> Parent;
+    SortOptions adjustSortOptions(SortOptions opts) {
+        opts = Parent::adjustSortOptions(opts);
+        return opts.MaxMergeFanIn(3).SpillCompressor(SortOptions::Compressor::kZlib);
+    }
+};
+
 template <long long Limit, bool Random = true>
 class LotsOfDataWithLimit : public LotsOfDataLittleMemory<Random> {
     typedef LotsOfDataLittleMemory<Random> Parent;
@@ -543,12 +597,16 @@ public:
     void setupTests() {
         add<InMemIterTests>();
         add<SortedFileWriterAndFileIteratorTests>();
+        add<FileIteratorDetectsCorruption>();
         add<MergeIteratorTests>();
         add<SorterTests::Basic>();
         add<SorterTests::Limit>();
         add<SorterTests::Dupes>();
         add<SorterTests::LotsOfDataLittleMemory</*random=*/false>>();
         add<SorterTests::LotsOfDataLittleMemory</*random=*/true>>();
+        add<SorterTests::LotsOfDataParallelRunGeneration>();
+        add<SorterTests::LotsOfDataBoundedFanIn</*random=*/false>>();
+        add<SorterTests::LotsOfDataBoundedFanIn</*random=*/true>>();
         add<SorterTests::LotsOfDataWithLimit<1, /*random=*/false>>();     // limit=1 is special case
         add<SorterTests::LotsOfDataWithLimit<1, /*random=*/true>>();      // limit=1 is special case
         add<SorterTests::LotsOfDataWithLimit<100, /*random=*/false>>();   // fits in mem
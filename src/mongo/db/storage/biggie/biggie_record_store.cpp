@@ -189,6 +189,43 @@ Status RecordStore::insertRecordsWithDocWriter(OperationContext* opCtx,
     return Status::OK();
 }
 
+/**
+ * Adds records to the recovery unit's working copy without a WriteUnitOfWork per record, and
+ * merges them into the master copy once on commit.
+ */
+class RecordStore::BulkBuilder final : public RecordStoreBulkBuilder {
+public:
+    BulkBuilder(RecordStore* rs, OperationContext* opCtx) : _rs(rs), _opCtx(opCtx) {}
+
+    StatusWith<RecordId> addRecord(const char* data, int len) override {
+        int64_t thisRecordId = _rs->nextRecordId();
+        StringStore* workingCopy = getRecoveryUnitBranch_forking(_opCtx);
+        workingCopy->insert(
+            StringStore::value_type{createKey(_rs->_ident, thisRecordId), std::string(data, len)});
+        _numRecords++;
+        return RecordId(thisRecordId);
+    }
+
+    Status commit() override {
+        if (_numRecords == 0)
+            return Status::OK();
+        WriteUnitOfWork wuow(_opCtx);
+        wuow.commit();
+        return Status::OK();
+    }
+
+private:
+    RecordStore* const _rs;
+    OperationContext* const _opCtx;
+    int64_t _numRecords = 0;
+};
+
+std::unique_ptr<RecordStoreBulkBuilder> RecordStore::getBulkBuilder(OperationContext* opCtx) {
+    if (_isCapped || numRecords(opCtx) > 0)
+        return nullptr;
+    return std::make_unique<BulkBuilder>(this, opCtx);
+}
+
 Status RecordStore::updateRecord(OperationContext* opCtx,
                                  const RecordId& oldLocation,
                                  const char* data,
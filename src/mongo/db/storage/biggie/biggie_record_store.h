@@ -91,6 +91,8 @@ public:
                                               size_t nDocs,
                                               RecordId* idsOut);
 
+    virtual std::unique_ptr<RecordStoreBulkBuilder> getBulkBuilder(OperationContext* opCtx);
+
     virtual Status updateRecord(OperationContext* opCtx,
                                 const RecordId& oldLocation,
                                 const char* data,
@@ -131,6 +133,8 @@ public:
                                         long long dataSize);
 
 private:
+    class BulkBuilder;
+
     AtomicInt64 _highest_record_id{1};
     std::string generateKey(const uint8_t* key, size_t key_len) const;
     /*
@@ -28,8 +28,10 @@
 
 #pragma once
 
+#include <algorithm>
 #include <array>
 #include <boost/optional.hpp>
+#include <cstdint>
 #include <exception>
 #include <iostream>
 #include <memory>
@@ -50,6 +52,13 @@ class merge_conflict_exception : std::exception {
  * minimize data duplication. Each node has a notion of ownership and if modifications are made to
  * non-uniquely owned nodes, they are copied to prevent dirtying the data for the other owners of
  * the node.
+ *
+ * The tree is an adaptive radix tree: a node only has room for as many children as it needs, in
+ * node sizes of 0, 4, 16, 48 and 256 children, and a chain of nodes which each have a single child
+ * and no data is compressed into the child, so a key costs one node per branching point rather
+ * than one node per byte. Each node records its depth, the length of the key prefix it stands
+ * for, along with that prefix, so inserting a branching point above a node leaves the node itself
+ * untouched and it can stay shared with other copies of the tree.
  */
 template <class Key, class T>
 class RadixStore {
@@ -135,8 +144,8 @@ public:
             }
 
             // Get path from root to '_current' since it is required to traverse up the tree.
-            Key key = _current->data->first;
-            std::vector<Node*> context = RadixStore::_buildContext(key, _root.get());
+            std::vector<Node*> context =
+                RadixStore::_buildContext(_current->data->first, _root.get());
 
             // 'node' should equal '_current' because that should be the last element in the stack.
             // Pop back once more to get access to it's parent node. The parent node will enable
@@ -149,30 +158,21 @@ public:
             // of the traversal.
             _current = nullptr;
             while (!context.empty()) {
-                uint8_t oldKey = node->trieKey;
-                node = context.back();
+                Node* parent = context.back();
                 context.pop_back();
+                uint8_t oldKey = RadixStore::_trieKey(parent, node);
+                node = parent;
 
                 // Check the children right of the node that the iterator was at already. This way,
-                // there will be no backtracking in the traversal.
-                for (auto iter = oldKey + 1 + node->children.begin(); iter != node->children.end();
-                     ++iter) {
-
-                    // If the node has a child, then the sub-tree must have a node with data that
-                    // has not yet been visited.
-                    if (*iter != nullptr) {
-
-                        // If the current node has data, return it and exit. If not, continue
-                        // following the nodes to find the next one with data. It is necessary to go
-                        // to the left-most node in this sub-tree.
-                        if ((*iter)->data != boost::none) {
-                            _current = iter->get();
-                            return;
-                        }
-                        _current = iter->get();
+                // there will be no backtracking in the traversal. The sub-tree of any child must
+                // have a node with data that has not yet been visited.
+                if (Node* next = node->childAfter(oldKey)) {
+                    // If the child has data, return it and exit. If not, it is necessary to go to
+                    // the left-most node with data in this sub-tree.
+                    _current = next;
+                    if (_current->data == boost::none)
                         _traverseLeftSubtree();
-                        return;
-                    }
+                    return;
                 }
             }
             return;
@@ -183,12 +183,7 @@ public:
             // '_current' is root. However, it cannot return the root, and hence at least 1
             // iteration of the while loop is required.
             do {
-                for (auto child : _current->children) {
-                    if (child != nullptr) {
-                        _current = child.get();
-                        break;
-                    }
-                }
+                _current = _current->firstChild();
             } while (_current->data == boost::none);
         }
 
@@ -292,32 +287,29 @@ public:
             if (_current == nullptr)
                 return;
 
-            Key key = _current->data->first;
-
-            std::vector<Node*> context = RadixStore::_buildContext(key, _root.get());
+            std::vector<Node*> context =
+                RadixStore::_buildContext(_current->data->first, _root.get());
             Node* node = context.back();
             context.pop_back();
 
             // Due to the nature of the traversal, it will always be necessary to move up the tree
             // first because when the 'current' node was visited, it meant all its children had been
             // visited as well.
-            uint8_t oldKey;
             _current = nullptr;
             while (!context.empty()) {
-                oldKey = node->trieKey;
-                node = context.back();
+                Node* parent = context.back();
                 context.pop_back();
+                uint8_t oldKey = RadixStore::_trieKey(parent, node);
+                node = parent;
 
                 // After moving up in the tree, continue searching for neighboring nodes to see if
                 // they have data, moving from right to left.
-                for (int i = oldKey - 1; i >= 0; i--) {
-                    if (node->children[i] != nullptr) {
-                        // If there is a sub-tree found, it must have data, therefore it's necessary
-                        // to traverse to the right most node.
-                        _current = node->children[i].get();
-                        _traverseRightSubtree();
-                        return;
-                    }
+                if (Node* prev = node->childBefore(oldKey)) {
+                    // If there is a sub-tree found, it must have data, therefore it's necessary
+                    // to traverse to the right most node.
+                    _current = prev;
+                    _traverseRightSubtree();
+                    return;
                 }
 
                 // If there were no sub-trees that contained data, and the 'current' node has data,
@@ -332,15 +324,9 @@ public:
         void _traverseRightSubtree() {
             // This function traverses the given tree to the right most leaf of the subtree where
             // 'current' is the root.
-            do {
-                for (auto iter = _current->children.rbegin(); iter != _current->children.rend();
-                     ++iter) {
-                    if (*iter != nullptr) {
-                        _current = iter->get();
-                        break;
-                    }
-                }
-            } while (!_current->isLeaf());
+            while (!_current->isLeaf()) {
+                _current = _current->lastChild();
+            }
         }
 
         // "_root" is a copy of the root of the tree over which this is iterating.
@@ -363,7 +349,7 @@ public:
     }
 
     RadixStore() {
-        _root = std::make_shared<RadixStore::Node>('\0');
+        _root = _makeNode(NodeType::LEAF, 0);
         _numElems = 0;
         _sizeElems = 0;
     }
@@ -402,7 +388,7 @@ public:
 
     // Modifiers
     void clear() noexcept {
-        _root = std::make_shared<Node>('\0');
+        _root = _makeNode(NodeType::LEAF, 0);
         _numElems = 0;
         _sizeElems = 0;
     }
@@ -444,92 +430,47 @@ public:
     }
 
     size_type erase(const Key& key) {
-        std::vector<std::pair<Node*, bool>> context;
-
-        std::shared_ptr<Node> node = _root;
-        bool isUniquelyOwned = _root.use_count() - 1 == 1;
-        context.push_back(std::make_pair(node.get(), isUniquelyOwned));
-
-        for (const char* charKey = key.data(); charKey != key.data() + key.size(); ++charKey) {
-            const uint8_t c = static_cast<const uint8_t>(*charKey);
-            node = node->children[c];
-            if (node == nullptr)
-                return false;
-
-            isUniquelyOwned = isUniquelyOwned && node.use_count() - 1 == 1;
-            context.push_back(std::make_pair(node.get(), isUniquelyOwned));
+        if (_findNode(key) == nullptr)
+            return false;
+
+        // Follow the path to the node to be deleted, copying every node above it which is shared
+        // with another tree. 'context' holds the slots of those nodes, from '_root' down.
+        std::vector<std::shared_ptr<Node>*> context;
+        std::shared_ptr<Node>* slot = &_root;
+        Node* node = _makeUniquelyOwned(slot);
+        while (node->depth < key.size()) {
+            context.push_back(slot);
+            slot = node->findChild(static_cast<uint8_t>(key[node->depth]));
+            node = slot->get();
+            if (node->depth < key.size())
+                node = _makeUniquelyOwned(slot);
         }
 
         size_t sizeOfRemovedNode = node->data->second.size();
-        Node* last = context.back().first;
-        isUniquelyOwned = context.back().second;
-        context.pop_back();
-        if (last->isLeaf()) {
-            // If the node to be deleted is a leaf node, might need to prune the branch.
-            uint8_t trieKey;
-            while (!context.empty()) {
-                trieKey = last->trieKey;
-                last = context.back().first;
-                isUniquelyOwned = context.back().second;
-                context.pop_back();
-
-                // If a node on the branch has data, stop pruning.
-                if (last->data != boost::none)
-                    break;
-
-                // If a node has children other than the one leading to the to-be deleted node, stop
-                // pruning.
-                bool hasOtherChildren = false;
-                for (auto iter = last->children.begin(); iter != last->children.end(); ++iter) {
-                    if (*iter != nullptr && (*iter)->trieKey != trieKey) {
-                        hasOtherChildren = true;
-                        break;
-                    }
-                }
-
-                if (hasOtherChildren)
-                    break;
-            }
-
-            if (isUniquelyOwned) {
-                // If this node is uniquely owned, simply set that child node to null and
-                // "cut" off that branch of our tree
-                last->children[trieKey] = nullptr;
+        if (node->numChildren > 1) {
+            // The to-be deleted node is a branching point, and therefore setting its data to
+            // boost::none will "delete" it. It keeps its prefix for comparisons with other keys.
+            node = _makeUniquelyOwned(slot);
+            Key prefix = node->data->first;
+            node->data = boost::none;
+            node->innerKey = std::move(prefix);
+        } else if (node->numChildren == 1) {
+            // A node with no data and a single child is compressed into the child.
+            std::shared_ptr<Node> child = *node->firstChildSlot();
+            *slot = std::move(child);
+        } else {
+            // If the node to be deleted is a leaf node, cut it off from its parent, which might
+            // then have to be compressed into its remaining child.
+            std::shared_ptr<Node>* parentSlot = context.back();
+            context.pop_back();
+            Node* parent = parentSlot->get();
+            parent->removeChild(static_cast<uint8_t>(key[parent->depth]));
+            if (!context.empty() && parent->data == boost::none && parent->numChildren == 1) {
+                std::shared_ptr<Node> child = *parent->firstChildSlot();
+                *parentSlot = std::move(child);
             } else {
-                // If its not uniquely owned, copy the branch so we can preserve it for the other
-                // owner(s).
-                std::shared_ptr<Node> child = std::make_shared<Node>(last->trieKey);
-                auto lastIter = last->children.begin();
-                for (auto iter = child->children.begin(); iter != child->children.end();
-                     ++iter, ++lastIter) {
-                    if (*lastIter != nullptr && (*lastIter)->trieKey == trieKey)
-                        continue;
-
-                    *iter = *lastIter;
-                }
-
-                std::shared_ptr<Node> node = child;
-                while (!context.empty()) {
-                    trieKey = last->trieKey;
-                    last = context.back().first;
-                    context.pop_back();
-                    node = std::make_shared<Node>(last->trieKey);
-
-                    auto lastIter = last->children.begin();
-                    for (auto iter = node->children.begin(); iter != node->children.end();
-                         ++iter, ++lastIter) {
-                        *iter = *lastIter;
-                    }
-
-                    node->children[trieKey] = child;
-                    child = node;
-                }
-                _root = node;
+                _shrinkIfSparse(parentSlot);
             }
-        } else {
-            // The to-be deleted node is an internal node, and therefore updating its data to be
-            // boost::none will "delete" it
-            _upsertWithCopyOnSharedNodes(key, boost::none);
         }
 
         _numElems--;
@@ -605,32 +546,18 @@ public:
             return RadixStore::end();
         }
 
-        auto node = _root;
-        while (node->data == boost::none) {
-            for (auto child : node->children) {
-                if (child != nullptr) {
-                    node = child;
-                    break;
-                }
-            }
-        }
-        return RadixStore::const_iterator(_root, node.get());
+        return RadixStore::const_iterator(_root, _leftmostWithData(_root.get()));
     }
 
     const_reverse_iterator rbegin() const noexcept {
         if (_numElems == 0)
             return RadixStore::rend();
 
-        auto node = _root;
+        Node* node = _root.get();
         while (!node->isLeaf()) {
-            for (auto iter = node->children.rbegin(); iter != node->children.rend(); ++iter) {
-                if (*iter != nullptr) {
-                    node = *iter;
-                    break;
-                }
-            }
+            node = node->lastChild();
         }
-        return RadixStore::const_reverse_iterator(_root, node.get());
+        return RadixStore::const_reverse_iterator(_root, node);
     }
 
     const_iterator end() const noexcept {
@@ -654,57 +581,46 @@ public:
     const_iterator lower_bound(const Key& key) const {
         Node* node = _root.get();
         std::vector<Node*> context;
-        context.push_back(node);
-
-        const char* charKey = key.data();
-        uint8_t idx = '\0';
 
         // Traverse the path given the key to see if the node exists.
-        for (; charKey != key.data() + key.size(); ++charKey) {
-            idx = static_cast<uint8_t>(*charKey);
-            if (node->children[idx] != nullptr) {
-                node = node->children[idx].get();
-                context.push_back(node);
-            } else {
-                break;
+        while (node->depth < key.size()) {
+            const uint8_t idx = static_cast<uint8_t>(key[node->depth]);
+            std::shared_ptr<Node>* childSlot = node->findChild(idx);
+            if (childSlot == nullptr) {
+                // The key falls between two children of 'node', so the next node with data is the
+                // left-most one under the next larger child.
+                return _nextFrom(std::move(context), node, idx + 1);
             }
-        }
 
-        // If the node existed, then can just return an iterator to that node.
-        if (charKey == key.data() + key.size())
-            return const_iterator(_root, node);
+            // Compare the rest of the key with the prefix compressed into the child.
+            Node* child = childSlot->get();
+            const Key& childKey = child->key();
+            const size_type end = std::min(child->depth, key.size());
+            size_type i = node->depth + 1;
+            while (i < end && key[i] == childKey[i]) {
+                ++i;
+            }
 
-        // The node did not exist, so must find an node with the next largest key (if it exists).
-        // Use the context stack to move up the tree and keep searching for the next node with data
-        // if need be.
-        while (!context.empty()) {
-            node = context.back();
-            context.pop_back();
+            if (i < end) {
+                // The key differs from the child's prefix. Either every key in the child's sub-tree
+                // is larger than the one given, or every one is smaller.
+                if (static_cast<uint8_t>(key[i]) < static_cast<uint8_t>(childKey[i]))
+                    return const_iterator(_root, _leftmostWithData(child));
+                return _nextFrom(std::move(context), node, idx + 1);
+            }
 
-            for (auto iter = idx + 1 + node->children.begin(); iter != node->children.end();
-                 ++iter) {
-
-                if (*iter != nullptr) {
-                    // There exists a node with a key larger than the one given, traverse to this
-                    // node which will be the left-most node in this sub-tree.
-                    node = iter->get();
-                    while (node->data == boost::none) {
-                        for (auto iter = node->children.begin(); iter != node->children.end();
-                             ++iter) {
-                            if (*iter != nullptr) {
-                                node = iter->get();
-                                break;
-                            }
-                        }
-                    }
-                    return const_iterator(_root, node);
-                }
+            if (child->depth > key.size()) {
+                // The key is a prefix of every key in the child's sub-tree.
+                return const_iterator(_root, _leftmostWithData(child));
             }
-            idx = node->trieKey;
+
+            context.push_back(node);
+            node = child;
         }
 
-        // If there was no node with a larger key than the one given, return end().
-        return end();
+        // If the node existed, then can just return an iterator to that node. Otherwise the next
+        // node with data is the left-most one below it.
+        return const_iterator(_root, _leftmostWithData(node));
     }
 
     const_iterator upper_bound(const Key& key) const {
@@ -728,151 +644,541 @@ public:
     }
 
 private:
+    /**
+     * The node sizes, by the number of children they have room for. A LEAF node has room for none.
+     */
+    enum class NodeType : uint8_t { LEAF, NODE4, NODE16, NODE48, NODE256 };
+
+    template <size_t kCapacity>
+    class SortedNode;
+    class Node48;
+    class Node256;
+
     class Node {
         friend class RadixStore;
 
     public:
-        Node(uint8_t key) : trieKey(key) {
-            children.fill(nullptr);
+        Node(NodeType type, size_type depth) : type(type), depth(depth) {}
+
+        bool isLeaf() const {
+            return numChildren == 0;
         }
 
-        bool isLeaf() {
-            for (auto child : children) {
-                if (child != nullptr)
-                    return false;
+        bool isFull() const {
+            return numChildren == capacity();
+        }
+
+        size_type capacity() const {
+            switch (type) {
+                case NodeType::LEAF:
+                    return 0;
+                case NodeType::NODE4:
+                    return 4;
+                case NodeType::NODE16:
+                    return 16;
+                case NodeType::NODE48:
+                    return 48;
+                case NodeType::NODE256:
+                    break;
             }
-            return true;
+            return 256;
         }
 
-        uint8_t trieKey;
+        /**
+         * Returns the key prefix this node stands for. Its length is always 'depth'.
+         */
+        const Key& key() const {
+            return data ? data->first : innerKey;
+        }
+
+        /**
+         * Returns the slot holding the child for the key byte 'c', or nullptr if there is none.
+         */
+        std::shared_ptr<Node>* findChild(uint8_t c) {
+            return visit([c](auto& node) { return node.find(c); });
+        }
+
+        std::shared_ptr<Node>* firstChildSlot() {
+            return visit([](auto& node) { return node.from(0); });
+        }
+
+        Node* firstChild() {
+            return _get(firstChildSlot());
+        }
+
+        Node* lastChild() {
+            return _get(visit([](auto& node) { return node.upTo(255); }));
+        }
+
+        /**
+         * Returns the first child whose key byte is 'c' or larger, or nullptr if there is none.
+         * 'c' may be 256.
+         */
+        Node* childFrom(int c) {
+            return _get(visit([c](auto& node) { return node.from(c); }));
+        }
+
+        Node* childAfter(uint8_t c) {
+            return childFrom(c + 1);
+        }
+
+        Node* childBefore(uint8_t c) {
+            return c == 0 ? nullptr : _get(visit([c](auto& node) { return node.upTo(c - 1); }));
+        }
+
+        /**
+         * Adds 'child' under the key byte 'c', which must not be taken. The node must not be full.
+         */
+        void addChild(uint8_t c, std::shared_ptr<Node> child) {
+            visit([&](auto& node) { node.add(c, std::move(child)); });
+        }
+
+        void removeChild(uint8_t c) {
+            visit([c](auto& node) { node.remove(c); });
+        }
+
+        /**
+         * Calls 'func' with the key byte and slot of each child, in key order.
+         */
+        template <typename Func>
+        void forEachChild(Func&& func) {
+            visit([&](auto& node) { node.forEach(func); });
+        }
+
+        /**
+         * Returns a copy of this node of the same size, which shares its children.
+         */
+        std::shared_ptr<Node> clone() {
+            return visit([](auto& node) -> std::shared_ptr<Node> {
+                return std::make_shared<std::decay_t<decltype(node)>>(node);
+            });
+        }
+
+        NodeType type;
+        uint16_t numChildren = 0;
+
+        // The length of the key prefix this node stands for. The key bytes between the depth of
+        // its parent and its own depth, other than the one selecting it in the parent, are
+        // compressed into the node.
+        size_type depth;
+
+        // The key prefix of a node without data. A node with data uses the key of its data.
+        Key innerKey;
         boost::optional<value_type> data;
-        std::array<std::shared_ptr<Node>, 256> children;
+
+    private:
+        static Node* _get(std::shared_ptr<Node>* slot) {
+            return slot ? slot->get() : nullptr;
+        }
+
+        template <typename Func>
+        auto visit(Func&& func) {
+            switch (type) {
+                case NodeType::LEAF:
+                    return func(static_cast<SortedNode<0>&>(*this));
+                case NodeType::NODE4:
+                    return func(static_cast<SortedNode<4>&>(*this));
+                case NodeType::NODE16:
+                    return func(static_cast<SortedNode<16>&>(*this));
+                case NodeType::NODE48:
+                    return func(static_cast<Node48&>(*this));
+                case NodeType::NODE256:
+                    break;
+            }
+            return func(static_cast<Node256&>(*this));
+        }
     };
 
+    /**
+     * A node with room for up to 'kCapacity' children, whose key bytes are kept sorted so that
+     * small nodes are searched with a short linear scan.
+     */
+    template <size_t kCapacity>
+    class SortedNode : public Node {
+    public:
+        explicit SortedNode(size_type depth)
+            : Node(kCapacity == 0 ? NodeType::LEAF
+                                  : (kCapacity == 4 ? NodeType::NODE4 : NodeType::NODE16),
+                   depth) {}
+
+        std::shared_ptr<Node>* find(uint8_t c) {
+            for (size_t i = 0; i < this->numChildren && keys[i] <= c; ++i) {
+                if (keys[i] == c)
+                    return &children[i];
+            }
+            return nullptr;
+        }
 
-    Node* _findNode(const Key& key) const {
-        auto node = _root;
-        for (const char* it = key.data(); it != key.data() + key.size(); ++it) {
-            const uint8_t k = static_cast<const uint8_t>(*it);
-            if (node->children[k] != nullptr)
-                node = node->children[k];
-            else
-                return nullptr;
+        std::shared_ptr<Node>* from(int c) {
+            for (size_t i = 0; i < this->numChildren; ++i) {
+                if (keys[i] >= c)
+                    return &children[i];
+            }
+            return nullptr;
         }
 
-        if (node->data == boost::none)
+        std::shared_ptr<Node>* upTo(int c) {
+            for (size_t i = this->numChildren; i > 0; --i) {
+                if (keys[i - 1] <= c)
+                    return &children[i - 1];
+            }
             return nullptr;
+        }
 
-        return node.get();
-    }
+        void add(uint8_t c, std::shared_ptr<Node> child) {
+            size_t i = this->numChildren;
+            for (; i > 0 && keys[i - 1] > c; --i) {
+                keys[i] = keys[i - 1];
+                children[i] = std::move(children[i - 1]);
+            }
+            keys[i] = c;
+            children[i] = std::move(child);
+            ++this->numChildren;
+        }
+
+        void remove(uint8_t c) {
+            size_t i = 0;
+            while (keys[i] != c) {
+                ++i;
+            }
+            for (; i + 1 < this->numChildren; ++i) {
+                keys[i] = keys[i + 1];
+                children[i] = std::move(children[i + 1]);
+            }
+            children[i].reset();
+            --this->numChildren;
+        }
+
+        template <typename Func>
+        void forEach(Func& func) {
+            for (size_t i = 0; i < this->numChildren; ++i) {
+                func(keys[i], children[i]);
+            }
+        }
+
+        std::array<uint8_t, kCapacity> keys;
+        std::array<std::shared_ptr<Node>, kCapacity> children;
+    };
 
     /**
-     * _upsertWithCopyOnSharedNodes is a helper function to help manage copy on modification for the
-     * tree. This function follows the path for the to-be modified node using the keystring. If at
-     * any point, the path is no longer uniquely owned, the following nodes are copied to prevent
-     * modification to other owner's data.
-     *
-     * 'key' is the key which can be followed to find the data.
-     * 'value' is the data to be inserted or updated. It can be an empty value in which case it is
-     * equivalent to removing that data from the tree.
+     * A node with room for up to 48 children, found through an index from each key byte to the
+     * slot holding its child.
      */
-    std::pair<const_iterator, bool> _upsertWithCopyOnSharedNodes(
-        Key key, boost::optional<value_type> value) {
-
-        auto node = _root;
-        std::shared_ptr<Node> parent = nullptr;
-        const char* keyString = key.data();
-        size_t i = 0;
-
-        // Follow the path in the tree as defined by the key string until a non-uniquely owned node.
-        // This loop would exit at the root if the root itself was shared, or exit at the end in the
-        // event the entire path was uniquely owned.
-        for (; i < key.size(); i++) {
-
-            // The current node in the traversal, if unique, will always have two pointers to it,
-            // not one. This is because the parent node holds it as a child node, but now also we
-            // have 'node' pointing to it. The loop will exit if the tree node is no longer uniquely
-            // owned.
-            if (node.use_count() > 2)
-                break;
+    class Node48 : public Node {
+    public:
+        static constexpr uint8_t kEmpty = 0xFF;
 
-            uint8_t c = static_cast<uint8_t>(keyString[i]);
+        explicit Node48(size_type depth) : Node(NodeType::NODE48, depth) {
+            childIndex.fill(kEmpty);
+        }
 
-            if (node->children[c] != nullptr) {
-                parent = node;
-                node = node->children[c];
-            } else {
-                node->children[c] = std::make_shared<Node>(c);
-                parent = node;
-                node = node->children[c];
+        std::shared_ptr<Node>* find(uint8_t c) {
+            return childIndex[c] == kEmpty ? nullptr : &children[childIndex[c]];
+        }
+
+        std::shared_ptr<Node>* from(int c) {
+            for (; c < 256; ++c) {
+                if (childIndex[c] != kEmpty)
+                    return &children[childIndex[c]];
             }
+            return nullptr;
         }
 
-        std::shared_ptr<Node> old;
+        std::shared_ptr<Node>* upTo(int c) {
+            for (; c >= 0; --c) {
+                if (childIndex[c] != kEmpty)
+                    return &children[childIndex[c]];
+            }
+            return nullptr;
+        }
+
+        void add(uint8_t c, std::shared_ptr<Node> child) {
+            uint8_t slot = 0;
+            while (children[slot] != nullptr) {
+                ++slot;
+            }
+            children[slot] = std::move(child);
+            childIndex[c] = slot;
+            ++this->numChildren;
+        }
 
-        if (i == 0) {
-            // If the _root node is shared to begin with, copy the _root. This is necessary since
-            // '_root' is a member variable and must be updated if changed, unlike other inner nodes
-            // of the tree.
-            old = _root;
-            _root = std::make_shared<Node>('\0');
-            node = _root;
+        void remove(uint8_t c) {
+            children[childIndex[c]].reset();
+            childIndex[c] = kEmpty;
+            --this->numChildren;
+        }
 
-        } else if (i < key.size()) {
-            // If there is a shared node in the middle of the tree, backtrack and create a new node
-            // that is singly owned by this tree. It is necessary to copy all following nodes as
-            // well.
-            old = node;
-            uint8_t c = static_cast<uint8_t>(keyString[i - 1]);
-            parent->children[c] = std::make_shared<Node>(c);
-            node = parent->children[c];
+        template <typename Func>
+        void forEach(Func& func) {
+            for (int c = 0; c < 256; ++c) {
+                if (childIndex[c] != kEmpty)
+                    func(static_cast<uint8_t>(c), children[childIndex[c]]);
+            }
+        }
 
-        } else if (i >= key.size()) {
-            // If all nodes prior to the last node in the traversal are uniquely owned, then set
-            // 'old' to nullptr to prevent reassigning the node's children.
-            old = nullptr;
+        std::array<uint8_t, 256> childIndex;
+        std::array<std::shared_ptr<Node>, 48> children;
+    };
 
-            if (node.use_count() > 2) {
-                // In the special case in which the to-be modified node (the last node in our
-                // traversal) is itself the first non-uniquely owned node - copy it and reassign its
-                // parents and children.
-                old = node;
-                uint8_t c = static_cast<uint8_t>(keyString[i - 1]);
-                parent->children[c] = std::make_shared<Node>(c);
-                node = parent->children[c];
+    /**
+     * A node with a slot for every key byte.
+     */
+    class Node256 : public Node {
+    public:
+        explicit Node256(size_type depth) : Node(NodeType::NODE256, depth) {}
+
+        std::shared_ptr<Node>* find(uint8_t c) {
+            return children[c] == nullptr ? nullptr : &children[c];
+        }
+
+        std::shared_ptr<Node>* from(int c) {
+            for (; c < 256; ++c) {
+                if (children[c] != nullptr)
+                    return &children[c];
             }
+            return nullptr;
         }
 
-        for (; i < key.size(); i++) {
-            uint8_t c = static_cast<uint8_t>(keyString[i]);
+        std::shared_ptr<Node>* upTo(int c) {
+            for (; c >= 0; --c) {
+                if (children[c] != nullptr)
+                    return &children[c];
+            }
+            return nullptr;
+        }
 
-            if (old != nullptr) {
-                node->children = old->children;
+        void add(uint8_t c, std::shared_ptr<Node> child) {
+            children[c] = std::move(child);
+            ++this->numChildren;
+        }
 
-                if (old->data != boost::none)
-                    node->data.emplace(old->data->first, old->data->second);
+        void remove(uint8_t c) {
+            children[c].reset();
+            --this->numChildren;
+        }
 
-                old = old->children[c];
+        template <typename Func>
+        void forEach(Func& func) {
+            for (int c = 0; c < 256; ++c) {
+                if (children[c] != nullptr)
+                    func(static_cast<uint8_t>(c), children[c]);
             }
+        }
+
+        std::array<std::shared_ptr<Node>, 256> children;
+    };
 
-            node->children[c] = std::make_shared<Node>(c);
-            node = node->children[c];
+    static std::shared_ptr<Node> _makeNode(NodeType type, size_type depth) {
+        switch (type) {
+            case NodeType::LEAF:
+                return std::make_shared<SortedNode<0>>(depth);
+            case NodeType::NODE4:
+                return std::make_shared<SortedNode<4>>(depth);
+            case NodeType::NODE16:
+                return std::make_shared<SortedNode<16>>(depth);
+            case NodeType::NODE48:
+                return std::make_shared<Node48>(depth);
+            case NodeType::NODE256:
+                break;
         }
+        return std::make_shared<Node256>(depth);
+    }
 
-        if (value != boost::none) {
-            node->data.emplace(value->first, value->second);
-        } else {
-            node->data = boost::none;
+    static std::shared_ptr<Node> _makeLeaf(value_type&& value) {
+        auto leaf = _makeNode(NodeType::LEAF, value.first.size());
+        leaf->data.emplace(std::move(value));
+        return leaf;
+    }
+
+    /**
+     * Returns a node of size 'type' holding the data and children of the uniquely owned node
+     * 'from', which is left empty.
+     */
+    static std::shared_ptr<Node> _resize(Node* from, NodeType type) {
+        auto node = _makeNode(type, from->depth);
+        node->innerKey = std::move(from->innerKey);
+        if (from->data)
+            node->data.emplace(std::move(*from->data));
+        from->forEachChild([&](uint8_t c, std::shared_ptr<Node>& child) {
+            node->addChild(c, std::move(child));
+        });
+        return node;
+    }
+
+    /**
+     * Adds 'child' to the uniquely owned node in 'slot', replacing the node with a larger one
+     * first if it is full.
+     */
+    static void _addChild(std::shared_ptr<Node>* slot, uint8_t c, std::shared_ptr<Node> child) {
+        Node* node = slot->get();
+        if (node->isFull()) {
+            const auto larger = static_cast<NodeType>(static_cast<uint8_t>(node->type) + 1);
+            *slot = _resize(node, larger);
+        }
+        (*slot)->addChild(c, std::move(child));
+    }
+
+    /**
+     * Replaces the uniquely owned node in 'slot' with a smaller one once it has few enough
+     * children. The thresholds leave some slack so that a node at the boundary between two sizes
+     * is not resized on every insert and erase.
+     */
+    static void _shrinkIfSparse(std::shared_ptr<Node>* slot) {
+        Node* node = slot->get();
+        switch (node->type) {
+            case NodeType::NODE4:
+                if (node->numChildren == 0)
+                    *slot = _resize(node, NodeType::LEAF);
+                break;
+            case NodeType::NODE16:
+                if (node->numChildren <= 3)
+                    *slot = _resize(node, NodeType::NODE4);
+                break;
+            case NodeType::NODE48:
+                if (node->numChildren <= 12)
+                    *slot = _resize(node, NodeType::NODE16);
+                break;
+            case NodeType::NODE256:
+                if (node->numChildren <= 37)
+                    *slot = _resize(node, NodeType::NODE48);
+                break;
+            case NodeType::LEAF:
+                break;
         }
+    }
 
-        // If 'old' isn't a nullptr, add the children since the modified node need not be a leaf in
-        // the tree. Will only have to do this if the modified node was not uniquely owned, and a
-        // copy was created.
-        if (old != nullptr) {
-            node->children = old->children;
+    /**
+     * Copies the node in 'slot' if it is shared with another tree, and returns the node in 'slot'.
+     * Its parent must already be uniquely owned by this tree; otherwise a shared node may appear to
+     * be owned only by the shared parent.
+     */
+    static Node* _makeUniquelyOwned(std::shared_ptr<Node>* slot) {
+        if (slot->use_count() > 1)
+            *slot = (*slot)->clone();
+        return slot->get();
+    }
+
+    /**
+     * Returns the key byte which selects 'child' among the children of 'parent'.
+     */
+    static uint8_t _trieKey(const Node* parent, const Node* child) {
+        return static_cast<uint8_t>(child->key()[parent->depth]);
+    }
+
+    /**
+     * Returns whether the key bytes compressed into 'child', a child of 'parent', match 'key'.
+     */
+    static bool _prefixMatches(const Key& key, const Node* parent, const Node* child) {
+        const size_type start = parent->depth + 1;
+        return child->depth <= key.size() &&
+            std::equal(key.data() + start,
+                       key.data() + child->depth,
+                       child->key().data() + start);
+    }
+
+    static Node* _leftmostWithData(Node* node) {
+        while (node->data == boost::none) {
+            node = node->firstChild();
         }
+        return node;
+    }
+
+    /**
+     * Returns an iterator to the first node with data under the children of 'node' with a key
+     * byte of 'start' or larger, moving up through the ancestors of 'node' in 'context' if there
+     * are none.
+     */
+    const_iterator _nextFrom(std::vector<Node*> context, Node* node, int start) const {
+        while (true) {
+            if (Node* next = node->childFrom(start))
+                return const_iterator(_root, _leftmostWithData(next));
+            if (context.empty())
+                return end();
+
+            Node* parent = context.back();
+            context.pop_back();
+            start = _trieKey(parent, node) + 1;
+            node = parent;
+        }
+    }
 
-        const_iterator it(_root, node.get());
+    Node* _findNode(const Key& key) const {
+        Node* node = _root.get();
+        while (node->depth < key.size()) {
+            std::shared_ptr<Node>* child =
+                node->findChild(static_cast<uint8_t>(key[node->depth]));
+            if (child == nullptr || !_prefixMatches(key, node, child->get()))
+                return nullptr;
+            node = child->get();
+        }
+
+        if (node->data == boost::none)
+            return nullptr;
+
+        return node;
+    }
+
+    /**
+     * _upsertWithCopyOnSharedNodes is a helper function to help manage copy on modification for the
+     * tree. This function follows the path for the to-be modified node using the keystring,
+     * copying every node on the path which is shared with another tree to prevent modification to
+     * other owner's data. Nodes off the path stay shared.
+     *
+     * 'key' is the key which can be followed to find the data.
+     * 'value' is the data to be inserted or updated.
+     */
+    std::pair<const_iterator, bool> _upsertWithCopyOnSharedNodes(const Key& key,
+                                                                 value_type&& value) {
+        std::shared_ptr<Node>* slot = &_root;
+        Node* node = _makeUniquelyOwned(slot);
+        while (node->depth < key.size()) {
+            const uint8_t c = static_cast<uint8_t>(key[node->depth]);
+            std::shared_ptr<Node>* childSlot = node->findChild(c);
+            if (childSlot == nullptr) {
+                // The rest of the key is compressed into a new leaf.
+                auto leaf = _makeLeaf(std::move(value));
+                Node* result = leaf.get();
+                _addChild(slot, c, std::move(leaf));
+                return std::pair<const_iterator, bool>(const_iterator(_root, result), true);
+            }
+
+            Node* child = childSlot->get();
+            const Key& childKey = child->key();
+            const size_type end = std::min(child->depth, key.size());
+            size_type mismatch = node->depth + 1;
+            while (mismatch < end && key[mismatch] == childKey[mismatch]) {
+                ++mismatch;
+            }
+
+            if (mismatch < child->depth) {
+                // The key leaves the prefix compressed into the child, so a new node for the
+                // common prefix goes between 'node' and the child. The child is left untouched,
+                // since its own prefix has not changed.
+                auto branch = _makeNode(NodeType::NODE4, mismatch);
+                branch->addChild(static_cast<uint8_t>(childKey[mismatch]), *childSlot);
+
+                Node* result;
+                if (mismatch == key.size()) {
+                    branch->data.emplace(std::move(value));
+                    result = branch.get();
+                } else {
+                    branch->innerKey = Key(key.data(), mismatch);
+                    auto leaf = _makeLeaf(std::move(value));
+                    result = leaf.get();
+                    branch->addChild(static_cast<uint8_t>(key[mismatch]), std::move(leaf));
+                }
+                *childSlot = std::move(branch);
+                return std::pair<const_iterator, bool>(const_iterator(_root, result), true);
+            }
+
+            slot = childSlot;
+            node = _makeUniquelyOwned(slot);
+        }
+
+        node->data.emplace(std::move(value));
+        node->innerKey = Key();
+
+        const_iterator it(_root, node);
         return std::pair<const_iterator, bool>(it, true);
     }
 
@@ -882,12 +1188,11 @@ private:
     * reverse iterators. Since both iterator classes use this function, it is declared
     * statically under RadixStore.
     */
-    static std::vector<Node*> _buildContext(Key key, Node* node) {
+    static std::vector<Node*> _buildContext(const Key& key, Node* node) {
         std::vector<Node*> context;
         context.push_back(node);
-        for (const char* it = key.data(); it != key.data() + key.size(); ++it) {
-            uint8_t c = static_cast<uint8_t>(*it);
-            node = node->children[c].get();
+        while (node->depth < key.size()) {
+            node = node->findChild(static_cast<uint8_t>(key[node->depth]))->get();
             context.push_back(node);
         }
         return context;
@@ -898,6 +1203,9 @@ private:
     size_type _sizeElems;
 };
 
+template <class Key, class T>
+constexpr std::uint8_t RadixStore<Key, T>::Node48::kEmpty;
+
 using StringStore = RadixStore<std::string, std::string>;
 }  // namespace biggie
 }  // namespace mongo
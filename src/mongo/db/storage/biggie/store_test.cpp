@@ -33,6 +33,7 @@
 #include "mongo/unittest/unittest.h"
 #include "mongo/util/log.h"
 #include <iostream>
+#include <map>
 
 namespace mongo {
 namespace biggie {
@@ -1245,6 +1246,188 @@ TEST_F(RadixStoreTest, ReverseIteratorAssignmentOpTest) {
     ASSERT_EQ(cur, 0);
 }
 
+TEST_F(RadixStoreTest, NodeGrowsAndShrinksWithChildrenTest) {
+    // Keys which all branch off the same node, one per possible key byte, so that the node is
+    // resized through every node size and back.
+    std::vector<std::string> keys;
+    for (int c = 0; c < 256; ++c) {
+        keys.push_back(std::string("key") + static_cast<char>(c));
+    }
+
+    for (auto& key : keys) {
+        ASSERT_TRUE(thisStore.insert(value_type(key, key)).second);
+    }
+    ASSERT_EQ(thisStore.size(), StringStore::size_type(256));
+
+    auto iter = thisStore.begin();
+    for (auto& key : keys) {
+        ASSERT_EQ(iter->first, key);
+        ++iter;
+    }
+    ASSERT_TRUE(iter == thisStore.end());
+
+    auto riter = thisStore.rbegin();
+    for (auto key = keys.rbegin(); key != keys.rend(); ++key) {
+        ASSERT_EQ(riter->first, *key);
+        ++riter;
+    }
+    ASSERT_TRUE(riter == thisStore.rend());
+
+    for (size_t i = 0; i < keys.size(); i += 2) {
+        ASSERT_TRUE(thisStore.erase(keys[i]));
+    }
+    ASSERT_EQ(thisStore.size(), StringStore::size_type(128));
+    for (size_t i = 1; i < keys.size(); i += 2) {
+        ASSERT_TRUE(thisStore.find(keys[i]) != thisStore.end());
+        ASSERT_TRUE(thisStore.erase(keys[i]));
+    }
+    ASSERT_TRUE(thisStore.empty());
+    ASSERT_TRUE(thisStore.begin() == thisStore.end());
+}
+
+TEST_F(RadixStoreTest, GrowNodeInCopyTest) {
+    std::vector<std::string> keys;
+    for (int c = 'a'; c < 'a' + 20; ++c) {
+        keys.push_back(std::string("pre") + static_cast<char>(c));
+    }
+
+    for (size_t i = 0; i < 4; ++i) {
+        thisStore.insert(value_type(keys[i], "1"));
+    }
+    otherStore = thisStore;
+
+    // Growing the shared node in 'otherStore' leaves 'thisStore' alone, and the existing children
+    // stay shared.
+    for (size_t i = 4; i < keys.size(); ++i) {
+        otherStore.insert(value_type(keys[i], "2"));
+    }
+    ASSERT_EQ(thisStore.size(), StringStore::size_type(4));
+    ASSERT_EQ(otherStore.size(), StringStore::size_type(20));
+
+    auto this_it = thisStore.begin();
+    auto other_it = otherStore.begin();
+    for (size_t i = 0; i < 4; ++i) {
+        ASSERT_EQUALS(&*this_it, &*other_it);
+        ++this_it;
+        ++other_it;
+    }
+    ASSERT_TRUE(this_it == thisStore.end());
+    ASSERT_EQ(other_it->first, keys[4]);
+}
+
+TEST_F(RadixStoreTest, LongCommonPrefixTest) {
+    const std::string prefix(40, 'x');
+    value_type value1 = std::make_pair(prefix + "a", "1");
+    value_type value2 = std::make_pair(prefix + "b", "2");
+    value_type value3 = std::make_pair(prefix.substr(0, 20), "3");
+    value_type value4 = std::make_pair(prefix.substr(0, 20) + "y", "4");
+
+    thisStore.insert(value_type(value1));
+    thisStore.insert(value_type(value2));
+    thisStore.insert(value_type(value3));
+    thisStore.insert(value_type(value4));
+
+    // Keys which end inside, or leave, a compressed prefix are not in the store.
+    ASSERT_TRUE(thisStore.find(prefix) == thisStore.end());
+    ASSERT_TRUE(thisStore.find(prefix.substr(0, 30)) == thisStore.end());
+    ASSERT_TRUE(thisStore.find(prefix.substr(0, 30) + "a") == thisStore.end());
+
+    auto iter = thisStore.begin();
+    ASSERT_EQ(iter->first, value3.first);
+    ++iter;
+    ASSERT_EQ(iter->first, value1.first);
+    ++iter;
+    ASSERT_EQ(iter->first, value2.first);
+    ++iter;
+    ASSERT_EQ(iter->first, value4.first);
+    ++iter;
+    ASSERT_TRUE(iter == thisStore.end());
+
+    // lower_bound() of keys which differ from a compressed prefix.
+    ASSERT_EQ(thisStore.lower_bound(prefix.substr(0, 30))->first, value1.first);
+    ASSERT_EQ(thisStore.lower_bound(prefix.substr(0, 30) + "a")->first, value1.first);
+    ASSERT_EQ(thisStore.lower_bound(prefix.substr(0, 30) + "z")->first, value4.first);
+    ASSERT_TRUE(thisStore.lower_bound(prefix.substr(0, 20) + "z") == thisStore.end());
+    ASSERT_EQ(thisStore.lower_bound(prefix)->first, value1.first);
+    ASSERT_EQ(thisStore.lower_bound(prefix + "c")->first, value4.first);
+
+    // Erasing a key between two others merges its node back into its remaining child.
+    ASSERT_TRUE(thisStore.erase(value2.first));
+    ASSERT_TRUE(thisStore.erase(value3.first));
+    iter = thisStore.begin();
+    ASSERT_EQ(iter->first, value1.first);
+    ++iter;
+    ASSERT_EQ(iter->first, value4.first);
+    ++iter;
+    ASSERT_TRUE(iter == thisStore.end());
+}
+
+TEST_F(RadixStoreTest, MatchesOrderedMapTest) {
+    std::map<std::string, std::string> model;
+    std::vector<std::pair<StringStore, std::map<std::string, std::string>>> snapshots;
+
+    unsigned seed = 1;
+    auto random = [&seed](unsigned bound) {
+        seed = seed * 1103515245 + 12345;
+        return (seed / 65536) % bound;
+    };
+
+    for (int i = 0; i < 5000; ++i) {
+        // Short keys over a small alphabet, so keys often share prefixes or are prefixes of each
+        // other.
+        std::string key;
+        for (unsigned len = 1 + random(6); len > 0; --len) {
+            key.push_back("abc\xff"[random(4)]);
+        }
+
+        if (random(3) == 0) {
+            ASSERT_EQ(thisStore.erase(key), model.erase(key));
+        } else if (model.count(key)) {
+            thisStore.update(value_type(key, std::to_string(i)));
+            model[key] = std::to_string(i);
+        } else {
+            thisStore.insert(value_type(key, std::to_string(i)));
+            model[key] = std::to_string(i);
+        }
+
+        if (i % 500 == 0) {
+            snapshots.emplace_back(thisStore, model);
+        }
+    }
+
+    snapshots.emplace_back(thisStore, model);
+    for (auto& snapshot : snapshots) {
+        const StringStore& store = snapshot.first;
+        const auto& expected = snapshot.second;
+        ASSERT_EQ(store.size(), expected.size());
+
+        auto iter = store.begin();
+        for (auto& entry : expected) {
+            ASSERT_TRUE(iter != store.end());
+            ASSERT_TRUE(*iter == entry);
+            ++iter;
+        }
+        ASSERT_TRUE(iter == store.end());
+
+        auto riter = store.rbegin();
+        for (auto entry = expected.rbegin(); entry != expected.rend(); ++entry) {
+            ASSERT_TRUE(*riter == *entry);
+            ++riter;
+        }
+        ASSERT_TRUE(riter == store.rend());
+
+        for (const char* key : {"a", "ab", "b", "bca", "c\xff", "\xff\xff\xff"}) {
+            auto it = store.lower_bound(key);
+            auto expectedIt = expected.lower_bound(key);
+            if (expectedIt == expected.end()) {
+                ASSERT_TRUE(it == store.end());
+            } else {
+                ASSERT_EQ(it->first, expectedIt->first);
+            }
+        }
+    }
+}
+
 }  // namespace
 }  // mongo namespace
 }  // biggie namespace
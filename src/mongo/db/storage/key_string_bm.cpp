@@ -30,10 +30,13 @@
 
 #include "mongo/platform/basic.h"
 
+#include <algorithm>
 #include <benchmark/benchmark.h>
+#include <memory>
 #include <random>
 #include <vector>
 
+#include "mongo/bson/oid.h"
 #include "mongo/db/storage/key_string.h"
 #include "mongo/platform/decimal128.h"
 #include "mongo/util/bufreader.h"
@@ -46,8 +49,10 @@ std::mt19937_64 seedGen(1234);
 const int kSampleSize = 500;
 const int kStrLenMultiplier = 100;
 const int kArrLenMultiplier = 40;
+const int kCompoundPrefixCardinality = 4;
 
 const Ordering ALL_ASCENDING = Ordering::make(BSONObj());
+const Ordering ALL_DESCENDING = Ordering::make(BSON("a" << -1 << "b" << -1 << "c" << -1));
 
 struct BsonsAndKeyStrings {
     int bsonSize = 0;
@@ -65,8 +70,21 @@ enum BsonValueType {
     STRING,
     ARRAY,
     DECIMAL,
+    OBJECTID,
+    // A {string, int, ObjectId} key whose leading field only takes a few distinct values, as in a
+    // compound index on a low cardinality field.
+    COMPOUND,
 };
 
+OID generateOID(std::mt19937& gen) {
+    unsigned char bytes[OID::kOIDSize];
+    std::uniform_int_distribution<int> byteDist(0, 255);
+    for (auto& byte : bytes) {
+        byte = byteDist(gen);
+    }
+    return OID::from(bytes);
+}
+
 BSONObj generateBson(BsonValueType bsonValueType) {
     std::mt19937 gen(seedGen());
     std::exponential_distribution<double> expReal(1e-3);
@@ -92,18 +110,28 @@ BSONObj generateBson(BsonValueType bsonValueType) {
                                          Decimal128::kRoundTo34Digits,
                                          Decimal128::kRoundTiesToAway)
                                   .quantize(Decimal128("0.01", Decimal128::kRoundTiesToAway)));
+        case OBJECTID:
+            return BSON("" << generateOID(gen));
+        case COMPOUND: {
+            std::uniform_int_distribution<int> prefixDist(0, kCompoundPrefixCardinality - 1);
+            return BSON("" << ("customer_" + std::to_string(prefixDist(gen))) << ""
+                           << static_cast<int>(expReal(gen))
+                           << ""
+                           << generateOID(gen));
+        }
     }
     MONGO_UNREACHABLE;
 }
 
 static BsonsAndKeyStrings generateBsonsAndKeyStrings(BsonValueType bsonValueType,
-                                                     KeyString::Version version) {
+                                                     KeyString::Version version,
+                                                     Ordering ord) {
     BsonsAndKeyStrings result;
     result.bsonSize = 0;
     result.keystringSize = 0;
     for (int i = 0; i < kSampleSize; i++) {
         BSONObj bson = generateBson(bsonValueType);
-        KeyString ks(version, bson, ALL_ASCENDING);
+        KeyString ks(version, bson, ord);
         result.bsonSize += bson.objsize();
         result.keystringSize += ks.getSize();
         result.bsons[i] = bson;
@@ -114,29 +142,42 @@ static BsonsAndKeyStrings generateBsonsAndKeyStrings(BsonValueType bsonValueType
 
         result.typebits[i] = SharedBuffer::allocate(ks.getTypeBits().getSize());
         memcpy(result.typebits[i].get(), ks.getTypeBits().getBuffer(), ks.getTypeBits().getSize());
-        result.typebitsLens[i] = ks.getSize();
+        result.typebitsLens[i] = ks.getTypeBits().getSize();
     }
     return result;
 }
 
+// Reports the encoded sizes, so that encodings can be compared on space as well as on time.
+void setSizeCounters(benchmark::State& state, const BsonsAndKeyStrings& bsonsAndKeyStrings) {
+    state.counters["bsonBytesPerKey"] =
+        static_cast<double>(bsonsAndKeyStrings.bsonSize) / kSampleSize;
+    state.counters["keyStringBytesPerKey"] =
+        static_cast<double>(bsonsAndKeyStrings.keystringSize) / kSampleSize;
+}
+
 void BM_BSONToKeyString(benchmark::State& state,
                         const KeyString::Version version,
-                        BsonValueType bsonType) {
-    const BsonsAndKeyStrings bsonsAndKeyStrings = generateBsonsAndKeyStrings(bsonType, version);
+                        BsonValueType bsonType,
+                        Ordering ord) {
+    const BsonsAndKeyStrings bsonsAndKeyStrings =
+        generateBsonsAndKeyStrings(bsonType, version, ord);
     for (auto _ : state) {
         benchmark::ClobberMemory();
         for (auto bson : bsonsAndKeyStrings.bsons) {
-            benchmark::DoNotOptimize(KeyString(version, bson, ALL_ASCENDING));
+            benchmark::DoNotOptimize(KeyString(version, bson, ord));
         }
     }
     state.SetBytesProcessed(state.iterations() * bsonsAndKeyStrings.bsonSize);
     state.SetItemsProcessed(state.iterations() * kSampleSize);
+    setSizeCounters(state, bsonsAndKeyStrings);
 }
 
 void BM_KeyStringToBSON(benchmark::State& state,
                         const KeyString::Version version,
-                        BsonValueType bsonType) {
-    const BsonsAndKeyStrings bsonsAndKeyStrings = generateBsonsAndKeyStrings(bsonType, version);
+                        BsonValueType bsonType,
+                        Ordering ord) {
+    const BsonsAndKeyStrings bsonsAndKeyStrings =
+        generateBsonsAndKeyStrings(bsonType, version, ord);
     for (auto _ : state) {
         benchmark::ClobberMemory();
         for (size_t i = 0; i < kSampleSize; i++) {
@@ -144,7 +185,7 @@ void BM_KeyStringToBSON(benchmark::State& state,
             benchmark::DoNotOptimize(
                 KeyString::toBson(bsonsAndKeyStrings.keystrings[i].get(),
                                   bsonsAndKeyStrings.keystringLens[i],
-                                  ALL_ASCENDING,
+                                  ord,
                                   KeyString::TypeBits::fromBuffer(version, &buf)));
         }
     }
@@ -152,24 +193,90 @@ void BM_KeyStringToBSON(benchmark::State& state,
     state.SetItemsProcessed(state.iterations() * kSampleSize);
 }
 
-BENCHMARK_CAPTURE(BM_BSONToKeyString, V0_Int, KeyString::Version::V0, INT);
-BENCHMARK_CAPTURE(BM_BSONToKeyString, V1_Int, KeyString::Version::V1, INT);
-BENCHMARK_CAPTURE(BM_BSONToKeyString, V0_Double, KeyString::Version::V0, DOUBLE);
-BENCHMARK_CAPTURE(BM_BSONToKeyString, V1_Double, KeyString::Version::V1, DOUBLE);
-BENCHMARK_CAPTURE(BM_BSONToKeyString, V1_Decimal, KeyString::Version::V1, DECIMAL);
-BENCHMARK_CAPTURE(BM_BSONToKeyString, V0_String, KeyString::Version::V0, STRING);
-BENCHMARK_CAPTURE(BM_BSONToKeyString, V1_String, KeyString::Version::V1, STRING);
-BENCHMARK_CAPTURE(BM_BSONToKeyString, V0_Array, KeyString::Version::V0, ARRAY);
-BENCHMARK_CAPTURE(BM_BSONToKeyString, V1_Array, KeyString::Version::V1, ARRAY);
-
-BENCHMARK_CAPTURE(BM_KeyStringToBSON, V0_Int, KeyString::Version::V0, INT);
-BENCHMARK_CAPTURE(BM_KeyStringToBSON, V1_Int, KeyString::Version::V1, INT);
-BENCHMARK_CAPTURE(BM_KeyStringToBSON, V0_Double, KeyString::Version::V0, DOUBLE);
-BENCHMARK_CAPTURE(BM_KeyStringToBSON, V1_Double, KeyString::Version::V1, DOUBLE);
-BENCHMARK_CAPTURE(BM_KeyStringToBSON, V1_Decimal, KeyString::Version::V1, DECIMAL);
-BENCHMARK_CAPTURE(BM_KeyStringToBSON, V0_String, KeyString::Version::V0, STRING);
-BENCHMARK_CAPTURE(BM_KeyStringToBSON, V1_String, KeyString::Version::V1, STRING);
-BENCHMARK_CAPTURE(BM_KeyStringToBSON, V0_Array, KeyString::Version::V0, ARRAY);
-BENCHMARK_CAPTURE(BM_KeyStringToBSON, V1_Array, KeyString::Version::V1, ARRAY);
+// Measures reconstructing the TypeBits stored alongside each key, which precedes every decode.
+void BM_TypeBitsFromBuffer(benchmark::State& state,
+                           const KeyString::Version version,
+                           BsonValueType bsonType) {
+    const BsonsAndKeyStrings bsonsAndKeyStrings =
+        generateBsonsAndKeyStrings(bsonType, version, ALL_ASCENDING);
+    for (auto _ : state) {
+        benchmark::ClobberMemory();
+        for (size_t i = 0; i < kSampleSize; i++) {
+            BufReader buf(bsonsAndKeyStrings.typebits[i].get(), bsonsAndKeyStrings.typebitsLens[i]);
+            benchmark::DoNotOptimize(KeyString::TypeBits::fromBuffer(version, &buf));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * kSampleSize);
+}
+
+// Measures comparing each key to its successor in sorted order, as a btree search does.
+void BM_KeyStringCompare(benchmark::State& state,
+                         const KeyString::Version version,
+                         BsonValueType bsonType) {
+    const BsonsAndKeyStrings bsonsAndKeyStrings =
+        generateBsonsAndKeyStrings(bsonType, version, ALL_ASCENDING);
+    std::vector<std::unique_ptr<KeyString>> keyStrings;
+    for (auto bson : bsonsAndKeyStrings.bsons) {
+        keyStrings.push_back(std::make_unique<KeyString>(version, bson, ALL_ASCENDING));
+    }
+    std::sort(keyStrings.begin(), keyStrings.end(), [](const auto& lhs, const auto& rhs) {
+        return *lhs < *rhs;
+    });
+
+    for (auto _ : state) {
+        benchmark::ClobberMemory();
+        for (size_t i = 0; i + 1 < keyStrings.size(); i++) {
+            benchmark::DoNotOptimize(keyStrings[i]->compare(*keyStrings[i + 1]));
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * bsonsAndKeyStrings.keystringSize);
+    state.SetItemsProcessed(state.iterations() * (kSampleSize - 1));
+    setSizeCounters(state, bsonsAndKeyStrings);
+}
+
+BENCHMARK_CAPTURE(BM_BSONToKeyString, V0_Int, KeyString::Version::V0, INT, ALL_ASCENDING);
+BENCHMARK_CAPTURE(BM_BSONToKeyString, V1_Int, KeyString::Version::V1, INT, ALL_ASCENDING);
+BENCHMARK_CAPTURE(BM_BSONToKeyString, V0_Double, KeyString::Version::V0, DOUBLE, ALL_ASCENDING);
+BENCHMARK_CAPTURE(BM_BSONToKeyString, V1_Double, KeyString::Version::V1, DOUBLE, ALL_ASCENDING);
+BENCHMARK_CAPTURE(BM_BSONToKeyString, V1_Decimal, KeyString::Version::V1, DECIMAL, ALL_ASCENDING);
+BENCHMARK_CAPTURE(BM_BSONToKeyString, V0_String, KeyString::Version::V0, STRING, ALL_ASCENDING);
+BENCHMARK_CAPTURE(BM_BSONToKeyString, V1_String, KeyString::Version::V1, STRING, ALL_ASCENDING);
+BENCHMARK_CAPTURE(BM_BSONToKeyString, V0_Array, KeyString::Version::V0, ARRAY, ALL_ASCENDING);
+BENCHMARK_CAPTURE(BM_BSONToKeyString, V1_Array, KeyString::Version::V1, ARRAY, ALL_ASCENDING);
+BENCHMARK_CAPTURE(BM_BSONToKeyString, V1_OID, KeyString::Version::V1, OBJECTID, ALL_ASCENDING);
+BENCHMARK_CAPTURE(BM_BSONToKeyString, V1_Compound, KeyString::Version::V1, COMPOUND, ALL_ASCENDING);
+BENCHMARK_CAPTURE(
+    BM_BSONToKeyString, V1_String_Descending, KeyString::Version::V1, STRING, ALL_DESCENDING);
+BENCHMARK_CAPTURE(
+    BM_BSONToKeyString, V1_Compound_Descending, KeyString::Version::V1, COMPOUND, ALL_DESCENDING);
+
+BENCHMARK_CAPTURE(BM_KeyStringToBSON, V0_Int, KeyString::Version::V0, INT, ALL_ASCENDING);
+BENCHMARK_CAPTURE(BM_KeyStringToBSON, V1_Int, KeyString::Version::V1, INT, ALL_ASCENDING);
+BENCHMARK_CAPTURE(BM_KeyStringToBSON, V0_Double, KeyString::Version::V0, DOUBLE, ALL_ASCENDING);
+BENCHMARK_CAPTURE(BM_KeyStringToBSON, V1_Double, KeyString::Version::V1, DOUBLE, ALL_ASCENDING);
+BENCHMARK_CAPTURE(BM_KeyStringToBSON, V1_Decimal, KeyString::Version::V1, DECIMAL, ALL_ASCENDING);
+BENCHMARK_CAPTURE(BM_KeyStringToBSON, V0_String, KeyString::Version::V0, STRING, ALL_ASCENDING);
+BENCHMARK_CAPTURE(BM_KeyStringToBSON, V1_String, KeyString::Version::V1, STRING, ALL_ASCENDING);
+BENCHMARK_CAPTURE(BM_KeyStringToBSON, V0_Array, KeyString::Version::V0, ARRAY, ALL_ASCENDING);
+BENCHMARK_CAPTURE(BM_KeyStringToBSON, V1_Array, KeyString::Version::V1, ARRAY, ALL_ASCENDING);
+BENCHMARK_CAPTURE(BM_KeyStringToBSON, V1_OID, KeyString::Version::V1, OBJECTID, ALL_ASCENDING);
+BENCHMARK_CAPTURE(BM_KeyStringToBSON, V1_Compound, KeyString::Version::V1, COMPOUND, ALL_ASCENDING);
+BENCHMARK_CAPTURE(
+    BM_KeyStringToBSON, V1_String_Descending, KeyString::Version::V1, STRING, ALL_DESCENDING);
+BENCHMARK_CAPTURE(
+    BM_KeyStringToBSON, V1_Compound_Descending, KeyString::Version::V1, COMPOUND, ALL_DESCENDING);
+
+BENCHMARK_CAPTURE(BM_TypeBitsFromBuffer, V0_Int, KeyString::Version::V0, INT);
+BENCHMARK_CAPTURE(BM_TypeBitsFromBuffer, V1_Int, KeyString::Version::V1, INT);
+BENCHMARK_CAPTURE(BM_TypeBitsFromBuffer, V1_Double, KeyString::Version::V1, DOUBLE);
+BENCHMARK_CAPTURE(BM_TypeBitsFromBuffer, V1_Decimal, KeyString::Version::V1, DECIMAL);
+BENCHMARK_CAPTURE(BM_TypeBitsFromBuffer, V1_Array, KeyString::Version::V1, ARRAY);
+BENCHMARK_CAPTURE(BM_TypeBitsFromBuffer, V1_Compound, KeyString::Version::V1, COMPOUND);
+
+BENCHMARK_CAPTURE(BM_KeyStringCompare, V1_Int, KeyString::Version::V1, INT);
+BENCHMARK_CAPTURE(BM_KeyStringCompare, V1_Double, KeyString::Version::V1, DOUBLE);
+BENCHMARK_CAPTURE(BM_KeyStringCompare, V1_String, KeyString::Version::V1, STRING);
+BENCHMARK_CAPTURE(BM_KeyStringCompare, V1_OID, KeyString::Version::V1, OBJECTID);
+BENCHMARK_CAPTURE(BM_KeyStringCompare, V1_Compound, KeyString::Version::V1, COMPOUND);
 }  // namespace
 }  // namespace mongo
@@ -1353,6 +1353,23 @@ TEST_F(KeyStringTest, VeryLargeString) {
     ROUNDTRIP(version, obj);
 }
 
+TEST_F(KeyStringTest, StringsOfEveryLengthNearWordBoundaries) {
+    // Descending keys flip string bytes a word at a time, with a byte-wise tail.
+    for (size_t len = 0; len < 3 * sizeof(uint64_t); len++) {
+        std::string str;
+        for (size_t i = 0; i < len; i++) {
+            str += static_cast<char>('a' + i);
+        }
+        ROUNDTRIP(version, BSON("" << str));
+
+        // Embedded NULs are escaped, which splits the string into several flipped parts.
+        if (len > 0) {
+            str[len / 2] = '\0';
+            ROUNDTRIP(version, BSON("" << str));
+        }
+    }
+}
+
 TEST_F(KeyStringTest, ToBsonSafeShouldNotTerminate) {
     KeyString::TypeBits typeBits(KeyString::Version::V1);
 
@@ -31,15 +31,33 @@
 #include <sqlite3.h>
 
 #include "mongo/base/init.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/service_context.h"
 #include "mongo/db/storage/kv/kv_storage_engine.h"
 #include "mongo/db/storage/mobile/mobile_kv_engine.h"
 #include "mongo/db/storage/storage_engine_init.h"
 #include "mongo/db/storage/storage_options.h"
+#include "mongo/util/mongoutils/str.h"
 
 namespace mongo {
 
 namespace {
+
+// How often, in milliseconds, the write-ahead log is synced when commits are grouped. Zero syncs
+// it on every commit instead.
+MONGO_EXPORT_STARTUP_SERVER_PARAMETER(mobileGroupCommitIntervalMs, int, 0)
+    ->withValidator([](const int& potentialNewValue) {
+        if (potentialNewValue < 0 ||
+            potentialNewValue > StorageGlobalParams::kMaxJournalCommitIntervalMs) {
+            return Status(ErrorCodes::BadValue,
+                          str::stream() << "mobileGroupCommitIntervalMs must be between 0 and "
+                                        << StorageGlobalParams::kMaxJournalCommitIntervalMs
+                                        << ", but attempted to set to: "
+                                        << potentialNewValue);
+        }
+        return Status::OK();
+    });
+
 class MobileFactory : public StorageEngine::Factory {
 public:
     StorageEngine* create(const StorageGlobalParams& params,
@@ -52,7 +70,8 @@ public:
         options.directoryPerDB = params.directoryperdb;
         options.forRepair = params.repair;
 
-        MobileKVEngine* kvEngine = new MobileKVEngine(params.dbpath);
+        MobileKVEngine* kvEngine =
+            new MobileKVEngine(params.dbpath, mobileGroupCommitIntervalMs);
         return new KVStorageEngine(kvEngine, options);
     }
 
@@ -46,15 +46,67 @@
 #include "mongo/db/storage/mobile/mobile_sqlite_statement.h"
 #include "mongo/db/storage/mobile/mobile_util.h"
 #include "mongo/stdx/memory.h"
+#include "mongo/util/background.h"
+#include "mongo/util/concurrency/idle_thread_block.h"
 #include "mongo/util/log.h"
 #include "mongo/util/scopeguard.h"
+#include "mongo/util/time_support.h"
+#include "mongo/util/timer.h"
 
 namespace mongo {
 
 class MobileSession;
 class SqliteStatement;
 
-MobileKVEngine::MobileKVEngine(const std::string& path) {
+/**
+ * With group commit, syncs the write-ahead log every 'intervalMs' so that commits become durable
+ * together, and checkpoints it off the write path.
+ */
+class MobileKVEngine::MobileWALFlusher : public BackgroundJob {
+public:
+    MobileWALFlusher(MobileSessionPool* sessionPool, int intervalMs)
+        : BackgroundJob(false /* deleteSelf */),
+          _sessionPool(sessionPool),
+          _intervalMs(intervalMs) {}
+
+    std::string name() const override {
+        return "MobileWALFlusher";
+    }
+
+    void run() override {
+        LOG(1) << "starting " << name() << " thread";
+
+        Timer sinceCheckpoint;
+        while (!_shuttingDown.load()) {
+            _sessionPool->waitUntilDurable();
+
+            // Checkpoints write back into the database file and sync it, so they run less often
+            // than syncs of the log.
+            if (sinceCheckpoint.millis() >= kCheckpointIntervalMillis) {
+                _sessionPool->checkpoint();
+                sinceCheckpoint.reset();
+            }
+
+            MONGO_IDLE_THREAD_BLOCK;
+            sleepmillis(_intervalMs);
+        }
+        LOG(1) << "stopping " << name() << " thread";
+    }
+
+    void shutdown() {
+        _shuttingDown.store(true);
+        wait();
+    }
+
+private:
+    static const int kCheckpointIntervalMillis = 1000;
+
+    MobileSessionPool* const _sessionPool;
+    const int _intervalMs;
+    AtomicBool _shuttingDown{false};
+};
+
+MobileKVEngine::MobileKVEngine(const std::string& path, int groupCommitIntervalMs) {
     _initDBPath(path);
 
     // Initialize the database to be in WAL mode.
@@ -134,7 +186,35 @@ MobileKVEngine::MobileKVEngine(const std::string& path) {
                                   << ". Val: " << fullfsync_val;
     }
 
-    _sessionPool.reset(new MobileSessionPool(_path));
+    const bool groupCommit = groupCommitIntervalMs > 0;
+    _sessionPool.reset(new MobileSessionPool(_path, 80 /* maxPoolSize */, groupCommit));
+
+    if (groupCommit) {
+        LOG(MOBILE_LOG_LEVEL_LOW) << "MobileSE: Group commit enabled, syncing every "
+                                  << groupCommitIntervalMs << "ms";
+        _walFlusher =
+            stdx::make_unique<MobileWALFlusher>(_sessionPool.get(), groupCommitIntervalMs);
+        _walFlusher->go();
+    }
+}
+
+MobileKVEngine::~MobileKVEngine() {
+    cleanShutdown();
+}
+
+void MobileKVEngine::cleanShutdown() {
+    if (_walFlusher) {
+        _walFlusher->shutdown();
+        _walFlusher.reset();
+        _sessionPool->waitUntilDurable();
+    }
+}
+
+int MobileKVEngine::flushAllFiles(OperationContext* opCtx, bool sync) {
+    if (sync) {
+        _sessionPool->waitUntilDurable();
+    }
+    return 0;
 }
 
 void MobileKVEngine::_initDBPath(const std::string& path) {
@@ -42,7 +42,13 @@ class JournalListener;
 
 class MobileKVEngine : public KVEngine {
 public:
-    MobileKVEngine(const std::string& path);
+    /**
+     * A non-zero 'groupCommitIntervalMs' turns on group commit: transactions commit without
+     * syncing, and a background thread syncs and checkpoints the write-ahead log at that interval.
+     */
+    MobileKVEngine(const std::string& path, int groupCommitIntervalMs = 0);
+
+    ~MobileKVEngine();
 
     RecoveryUnit* newRecoveryUnit() override;
 
@@ -93,11 +99,10 @@ public:
     }
 
     /**
-     * Flush is a no-op since SQLite transactions are durable by default after each commit.
+     * Flush is a no-op since SQLite transactions are durable by default after each commit, unless
+     * group commit is on. Then a synchronous flush makes every commit so far durable.
      */
-    int flushAllFiles(OperationContext* opCtx, bool sync) override {
-        return 0;
-    }
+    int flushAllFiles(OperationContext* opCtx, bool sync) override;
 
     bool isEphemeral() const override {
         return false;
@@ -109,7 +114,7 @@ public:
         return Status::OK();
     }
 
-    void cleanShutdown() override{};
+    void cleanShutdown() override;
 
     bool hasIdent(OperationContext* opCtx, StringData ident) const override;
 
@@ -125,11 +130,16 @@ public:
     }
 
 private:
+    class MobileWALFlusher;
+
     mutable stdx::mutex _mutex;
     void _initDBPath(const std::string& path);
 
     std::unique_ptr<MobileSessionPool> _sessionPool;
 
+    // Only set when group commit is on.
+    std::unique_ptr<MobileWALFlusher> _walFlusher;
+
     // Notified when we write as everything is considered "journalled" since repl depends on it.
     JournalListener* _journalListener = &NoOpJournalListener::instance;
 
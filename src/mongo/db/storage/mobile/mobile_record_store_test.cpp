@@ -54,7 +54,8 @@ static int inc = 0;
 
 class MobileHarnessHelper final : public RecordStoreHarnessHelper {
 public:
-    MobileHarnessHelper() : _dbPath("mobile_record_store_harness") {
+    explicit MobileHarnessHelper(bool groupCommit = false)
+        : _dbPath("mobile_record_store_harness") {
         // TODO: Determine if this should be util function.
         boost::system::error_code err;
         boost::filesystem::path dir(_dbPath.path());
@@ -84,7 +85,7 @@ public:
         }
 
         _fullPath = fullPath.string();
-        _sessionPool.reset(new MobileSessionPool(_fullPath));
+        _sessionPool.reset(new MobileSessionPool(_fullPath, 80 /* maxPoolSize */, groupCommit));
     }
 
     std::unique_ptr<RecordStore> newNonCappedRecordStore() override {
@@ -125,6 +126,10 @@ public:
         return false;
     }
 
+    MobileSessionPool* getSessionPool() {
+        return _sessionPool.get();
+    }
+
 private:
     unittest::TempDir _dbPath;
     std::string _fullPath;
@@ -139,5 +144,38 @@ MONGO_INITIALIZER(RegisterHarnessFactory)(InitializerContext* const) {
     mongo::registerHarnessHelperFactory(makeHarnessHelper);
     return Status::OK();
 }
+
+// With group commit, commits are visible right away and become durable on the next sync.
+TEST(MobileRecordStoreTest, GroupCommit) {
+    MobileHarnessHelper harnessHelper(true /* groupCommit */);
+    ASSERT(harnessHelper.getSessionPool()->isGroupCommitEnabled());
+    {
+        // Group commit relies on the write-ahead log, which MobileKVEngine turns on.
+        ServiceContext::UniqueOperationContext opCtx(harnessHelper.newOperationContext());
+        auto session = harnessHelper.getSessionPool()->getSession(opCtx.get());
+        SqliteStatement::execQuery(session.get(), "PRAGMA journal_mode=WAL;");
+    }
+    std::unique_ptr<RecordStore> rs(harnessHelper.newNonCappedRecordStore());
+
+    const int nToInsert = 10;
+    {
+        ServiceContext::UniqueOperationContext opCtx(harnessHelper.newOperationContext());
+        for (int i = 0; i < nToInsert; i++) {
+            std::string data = "record " + std::to_string(i);
+            WriteUnitOfWork uow(opCtx.get());
+            ASSERT_OK(rs->insertRecord(opCtx.get(), data.c_str(), data.size() + 1, Timestamp())
+                          .getStatus());
+            uow.commit();
+        }
+        ASSERT(opCtx->recoveryUnit()->waitUntilDurable());
+    }
+
+    harnessHelper.getSessionPool()->checkpoint();
+
+    {
+        ServiceContext::UniqueOperationContext opCtx(harnessHelper.newOperationContext());
+        ASSERT_EQUALS(nToInsert, rs->numRecords(opCtx.get()));
+    }
+}
 }  // namespace
 }  // namespace mongo
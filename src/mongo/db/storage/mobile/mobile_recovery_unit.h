@@ -54,9 +54,7 @@ public:
     void commitUnitOfWork() override;
     void abortUnitOfWork() override;
 
-    bool waitUntilDurable() override {
-        return true;
-    }
+    bool waitUntilDurable() override;
 
     void abandonSnapshot() override;
 
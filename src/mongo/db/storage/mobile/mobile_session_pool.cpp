@@ -94,8 +94,10 @@ bool MobileDelayedOpQueue::isEmpty() {
     return (_isEmpty.load());
 }
 
-MobileSessionPool::MobileSessionPool(const std::string& path, std::uint64_t maxPoolSize)
-    : _path(path), _maxPoolSize(maxPoolSize) {}
+MobileSessionPool::MobileSessionPool(const std::string& path,
+                                     std::uint64_t maxPoolSize,
+                                     bool groupCommit)
+    : _path(path), _maxPoolSize(maxPoolSize), _groupCommit(groupCommit) {}
 
 MobileSessionPool::~MobileSessionPool() {
     shutDown();
@@ -116,9 +118,7 @@ std::unique_ptr<MobileSession> MobileSessionPool::getSession(OperationContext* o
 
     // Checks if a new session can be opened.
     if (_curPoolSize < _maxPoolSize) {
-        sqlite3* session;
-        int status = sqlite3_open(_path.c_str(), &session);
-        checkStatus(status, SQLITE_OK, "sqlite3_open");
+        sqlite3* session = _openSession();
         _curPoolSize++;
         return stdx::make_unique<MobileSession>(session, this);
     }
@@ -172,11 +172,104 @@ void MobileSessionPool::shutDown() {
         sqlite3_close(session);
     }
 
+    {
+        stdx::lock_guard<stdx::mutex> syncLk(_syncMutex);
+        if (_syncSession) {
+            sqlite3_close(_syncSession);
+            _syncSession = nullptr;
+        }
+    }
+
     for (auto&& session : _sessions) {
         sqlite3_close(session);
     }
 }
 
+void MobileSessionPool::waitUntilDurable() {
+    if (!_groupCommit) {
+        return;
+    }
+
+    const uint64_t start = _syncCount.load();
+    // Do the remainder in a critical section that ensures only a single thread at a time
+    // will attempt to synchronize.
+    stdx::lock_guard<stdx::mutex> lk(_syncMutex);
+    const uint64_t current = _syncCount.loadRelaxed();  // synchronized with writes through mutex
+    if (current != start) {
+        // Someone else started a sync after we read _syncCount, so it covers our commits.
+        return;
+    }
+    _syncCount.store(current + 1);
+
+    // Commits append to the write-ahead log without syncing it, so syncing the log once makes all
+    // of them durable. Any handle on the log will do; this one belongs to the sync session.
+    sqlite3* session = _getSyncSession_inlock();
+    sqlite3_file* walFile = nullptr;
+    int status = sqlite3_file_control(session, "main", SQLITE_FCNTL_JOURNAL_POINTER, &walFile);
+    checkStatus(status, SQLITE_OK, "sqlite3_file_control");
+
+    // The log is not open until the first transaction has been committed.
+    if (walFile && walFile->pMethods) {
+        status = walFile->pMethods->xSync(walFile, SQLITE_SYNC_FULL);
+        checkStatus(status, SQLITE_OK, "xSync");
+    }
+    LOG(MOBILE_TRACE_LEVEL) << "MobileSE: Synced the write-ahead log";
+}
+
+void MobileSessionPool::checkpoint() {
+    invariant(_groupCommit);
+
+    stdx::lock_guard<stdx::mutex> lk(_syncMutex);
+    int logFrames = 0;
+    int checkpointedFrames = 0;
+    int status = sqlite3_wal_checkpoint_v2(_getSyncSession_inlock(),
+                                           "main",
+                                           SQLITE_CHECKPOINT_PASSIVE,
+                                           &logFrames,
+                                           &checkpointedFrames);
+    if (status == SQLITE_BUSY) {
+        // Another session is checkpointing, for example because it is the last one to close.
+        return;
+    }
+    checkStatus(status, SQLITE_OK, "sqlite3_wal_checkpoint_v2");
+    LOG(MOBILE_TRACE_LEVEL) << "MobileSE: Checkpointed " << checkpointedFrames << " of "
+                            << logFrames << " frames in the write-ahead log";
+}
+
+sqlite3* MobileSessionPool::_openSession() {
+    sqlite3* session;
+    int status = sqlite3_open(_path.c_str(), &session);
+    checkStatus(status, SQLITE_OK, "sqlite3_open");
+
+    if (_groupCommit) {
+        // In WAL mode, NORMAL still syncs the log before every checkpoint, so a crash can lose
+        // recent commits but cannot corrupt the database.
+        char* errMsg = NULL;
+        status = sqlite3_exec(session,
+                              "PRAGMA synchronous = NORMAL; PRAGMA wal_autocheckpoint = 0;",
+                              NULL,
+                              NULL,
+                              &errMsg);
+        checkStatus(status, SQLITE_OK, "sqlite3_exec", errMsg);
+        sqlite3_free(errMsg);
+    }
+    return session;
+}
+
+sqlite3* MobileSessionPool::_getSyncSession_inlock() {
+    if (!_syncSession) {
+        int status = sqlite3_open(_path.c_str(), &_syncSession);
+        checkStatus(status, SQLITE_OK, "sqlite3_open");
+
+        // Reading the schema opens the write-ahead log, which stays open with the connection.
+        char* errMsg = NULL;
+        status = sqlite3_exec(_syncSession, "PRAGMA schema_version;", NULL, NULL, &errMsg);
+        checkStatus(status, SQLITE_OK, "sqlite3_exec", errMsg);
+        sqlite3_free(errMsg);
+    }
+    return _syncSession;
+}
+
 // This method should only be called when _sessions is locked.
 sqlite3* MobileSessionPool::_popSession_inlock() {
     sqlite3* session = _sessions.back();
@@ -36,6 +36,7 @@
 #include "mongo/base/disallow_copying.h"
 #include "mongo/db/operation_context.h"
 #include "mongo/db/storage/mobile/mobile_session.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/stdx/mutex.h"
 
 namespace mongo {
@@ -67,7 +68,14 @@ class MobileSessionPool final {
     MONGO_DISALLOW_COPYING(MobileSessionPool);
 
 public:
-    MobileSessionPool(const std::string& path, std::uint64_t maxPoolSize = 80);
+    /**
+     * With 'groupCommit' set, committing a transaction does not sync the write-ahead log and does
+     * not checkpoint it. waitUntilDurable() syncs every commit made so far at once, and
+     * checkpoint() copies the log back into the database file.
+     */
+    MobileSessionPool(const std::string& path,
+                      std::uint64_t maxPoolSize = 80,
+                      bool groupCommit = false);
 
     ~MobileSessionPool();
 
@@ -87,6 +95,23 @@ public:
      */
     void shutDown();
 
+    /**
+     * Makes every transaction committed before this call durable. This is a no-op without group
+     * commit, as each commit is then synced on its own. Concurrent callers share a single sync.
+     */
+    void waitUntilDurable();
+
+    /**
+     * Runs a passive checkpoint of the write-ahead log, which does not wait for readers or
+     * writers. Only needed with group commit, which turns off the checkpoints SQLite would
+     * otherwise run on the committing session.
+     */
+    void checkpoint();
+
+    bool isGroupCommitEnabled() const {
+        return _groupCommit;
+    }
+
     // Failed drops get queued here and get re-tried periodically
     MobileDelayedOpQueue failedDropsQueue;
 
@@ -96,6 +121,17 @@ private:
      */
     sqlite3* _popSession_inlock();
 
+    /**
+     * Opens a new sqlite3 connection configured for this pool's commit mode.
+     */
+    sqlite3* _openSession();
+
+    /**
+     * Returns the connection used to sync and checkpoint the write-ahead log, opening it first if
+     * necessary. Must be called with _syncMutex held.
+     */
+    sqlite3* _getSyncSession_inlock();
+
     // This is used to lock the _sessions vector.
     stdx::mutex _mutex;
     stdx::condition_variable _releasedSessionNotifier;
@@ -111,5 +147,13 @@ private:
 
     using SessionPool = std::vector<sqlite3*>;
     SessionPool _sessions;
+
+    const bool _groupCommit;
+
+    // Serializes syncs and checkpoints of the write-ahead log, and protects _syncSession.
+    stdx::mutex _syncMutex;
+    // Incremented by every sync of the write-ahead log, before it starts.
+    AtomicUInt64 _syncCount;
+    sqlite3* _syncSession = nullptr;
 };
 }  // namespace mongo
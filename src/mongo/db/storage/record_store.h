@@ -50,6 +50,7 @@ class NamespaceDetails;
 class OperationContext;
 class RecordFetcher;
 
+class RecordStoreBulkBuilder;
 class RecordStoreCompactAdaptor;
 class RecordStore;
 
@@ -418,6 +419,20 @@ public:
         return out;
     }
 
+    /**
+     * Returns a bulk builder for loading records into this RecordStore while it is empty, or
+     * nullptr if this RecordStore does not support one right now. Callers must then fall back to
+     * insertRecords().
+     *
+     * Records added through the builder skip the per-record transactional machinery and are not
+     * visible to other operations until RecordStoreBulkBuilder::commit() succeeds. No other
+     * writes may be made to this RecordStore while a bulk builder is outstanding. Only
+     * non-capped record stores may return a bulk builder.
+     */
+    virtual std::unique_ptr<RecordStoreBulkBuilder> getBulkBuilder(OperationContext* opCtx) {
+        return nullptr;
+    }
+
     /**
      * @param notifier - Only used by record stores which do not support doc-locking. Called only
      *                   in the case of an in-place update. Called just before the in-place write
@@ -639,6 +654,30 @@ protected:
     std::string _ns;
 };
 
+/**
+ * Loads records into an empty RecordStore without a WriteUnitOfWork per record. Obtained through
+ * RecordStore::getBulkBuilder().
+ */
+class RecordStoreBulkBuilder {
+public:
+    virtual ~RecordStoreBulkBuilder() {}
+
+    /**
+     * Adds a record and returns the RecordId assigned to it. RecordIds are assigned in increasing
+     * order. Must not be called inside a WriteUnitOfWork.
+     */
+    virtual StatusWith<RecordId> addRecord(const char* data, int len) = 0;
+
+    /**
+     * Makes the added records visible and accounts for them in numRecords() and dataSize().
+     *
+     * This is called outside of any WriteUnitOfWork. Destroying a builder without committing it
+     * leaves the RecordStore in an unspecified state which the caller must discard, for example
+     * by dropping the collection.
+     */
+    virtual Status commit() = 0;
+};
+
 class RecordStoreCompactAdaptor {
 public:
     virtual ~RecordStoreCompactAdaptor() {}
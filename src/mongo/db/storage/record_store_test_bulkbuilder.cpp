@@ -0,0 +1,107 @@
+// record_store_test_bulkbuilder.cpp
+
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/record_id.h"
+#include "mongo/db/storage/record_data.h"
+#include "mongo/db/storage/record_store.h"
+#include "mongo/db/storage/record_store_test_harness.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+using std::string;
+using std::unique_ptr;
+
+// Load records through a bulk builder and verify they are visible, in order, once committed.
+TEST(RecordStoreTestHarness, BulkBuilderAddRecords) {
+    const auto harnessHelper(newRecordStoreHarnessHelper());
+    unique_ptr<RecordStore> rs(harnessHelper->newNonCappedRecordStore());
+
+    const int nToInsert = 10;
+    RecordId locs[nToInsert];
+    {
+        ServiceContext::UniqueOperationContext opCtx(harnessHelper->newOperationContext());
+        auto builder = rs->getBulkBuilder(opCtx.get());
+        if (!builder) {
+            return;  // Bulk loading is optional.
+        }
+
+        for (int i = 0; i < nToInsert; i++) {
+            string data = "record " + std::to_string(i);
+            StatusWith<RecordId> res = builder->addRecord(data.c_str(), data.size() + 1);
+            ASSERT_OK(res.getStatus());
+            locs[i] = res.getValue();
+            if (i > 0) {
+                ASSERT_LT(locs[i - 1], locs[i]);
+            }
+        }
+        ASSERT_OK(builder->commit());
+    }
+
+    {
+        ServiceContext::UniqueOperationContext opCtx(harnessHelper->newOperationContext());
+        ASSERT_EQUALS(nToInsert, rs->numRecords(opCtx.get()));
+
+        auto cursor = rs->getCursor(opCtx.get());
+        for (int i = 0; i < nToInsert; i++) {
+            auto record = cursor->next();
+            ASSERT(record);
+            ASSERT_EQUALS(locs[i], record->id);
+            ASSERT_EQUALS("record " + std::to_string(i), string(record->data.data()));
+        }
+        ASSERT(!cursor->next());
+    }
+}
+
+// A record store which already holds records cannot be bulk loaded.
+TEST(RecordStoreTestHarness, BulkBuilderRequiresEmptyRecordStore) {
+    const auto harnessHelper(newRecordStoreHarnessHelper());
+    unique_ptr<RecordStore> rs(harnessHelper->newNonCappedRecordStore());
+
+    {
+        ServiceContext::UniqueOperationContext opCtx(harnessHelper->newOperationContext());
+        string data = "my record";
+        WriteUnitOfWork uow(opCtx.get());
+        ASSERT_OK(
+            rs->insertRecord(opCtx.get(), data.c_str(), data.size() + 1, Timestamp()).getStatus());
+        uow.commit();
+    }
+
+    {
+        ServiceContext::UniqueOperationContext opCtx(harnessHelper->newOperationContext());
+        ASSERT(!rs->getBulkBuilder(opCtx.get()));
+    }
+}
+
+}  // namespace
+}  // namespace mongo
@@ -83,6 +83,7 @@
 #include "mongo/util/background.h"
 #include "mongo/util/concurrency/idle_thread_block.h"
 #include "mongo/util/concurrency/ticketholder.h"
+#include "mongo/util/concurrency/with_lock.h"
 #include "mongo/util/exit.h"
 #include "mongo/util/log.h"
 #include "mongo/util/processinfo.h"
@@ -274,9 +275,15 @@ public:
             {
                 stdx::unique_lock<stdx::mutex> lock(_mutex);
                 MONGO_IDLE_THREAD_BLOCK;
-                _condvar.wait_for(lock,
-                                  stdx::chrono::seconds(static_cast<std::int64_t>(
-                                      wiredTigerGlobalOptions.checkpointDelaySecs)));
+                // The cache controller may shorten the checkpoint delay while we wait, so re-read
+                // it at least once a second rather than sleeping for the whole delay.
+                const Date_t waitStart = Date_t::now();
+                while (!_shuttingDown.load() && !_checkpointRequested &&
+                       Date_t::now() - waitStart <
+                           Seconds(_wiredTigerKVEngine->_getCheckpointDelaySecs())) {
+                    _condvar.wait_for(lock, stdx::chrono::seconds(1));
+                }
+                _checkpointRequested = false;
             }
 
             const Timestamp stableTimestamp = _wiredTigerKVEngine->getStableTimestamp();
@@ -354,6 +361,7 @@ public:
             log() << "Triggering the first stable checkpoint. Initial Data: " << initialData
                   << " PrevStable: " << prevStable << " CurrStable: " << currStable;
             stdx::unique_lock<stdx::mutex> lock(_mutex);
+            _checkpointRequested = true;
             _condvar.notify_one();
         }
     }
@@ -377,10 +385,11 @@ private:
     WiredTigerKVEngine* _wiredTigerKVEngine;
     WiredTigerSessionCache* _sessionCache;
 
-    stdx::mutex _mutex;  // protects _condvar
+    stdx::mutex _mutex;  // protects _condvar and _checkpointRequested
     // The checkpoint thead idles on this condition variable for a particular time duration between
     // taking checkpoints. It can be triggered early to expediate immediate checkpointing.
     stdx::condition_variable _condvar;
+    bool _checkpointRequested = false;
 
     AtomicBool _shuttingDown{false};
 
@@ -394,6 +403,239 @@ private:
 
 namespace {
 
+// Lets the cache controller retune eviction and checkpoint scheduling while the server runs. When
+// it is turned off the controller restores the settings the connection was opened with. Settings
+// applied through wiredTigerEngineRuntimeConfig may be overridden while the controller is enabled.
+MONGO_EXPORT_SERVER_PARAMETER(wiredTigerCacheControllerEnabled, bool, false);
+
+// How long the cache controller waits between samples of the connection statistics.
+const auto kCacheControllerPeriod = Seconds(1);
+
+// Number of consecutive samples showing less pressure before the controller steps down a level.
+// Escalation is immediate, so a burst of writes is answered within one period.
+const int kCacheControllerStepDownSamples = 10;
+
+// Application threads are forced to evict pages once the share of dirty bytes in the cache
+// reaches WiredTiger's eviction_dirty_trigger, 20% by default. The controller acts well before
+// that point.
+const double kElevatedDirtyCachePercent = 5.0;
+const double kHighDirtyCachePercent = 15.0;
+
+// Microseconds per second which application threads, summed together, may spend waiting on the
+// cache before the controller treats the cache as under high pressure.
+const int64_t kHighApplicationCacheWaitMicrosPerSec = 10 * 1000;
+
+}  // namespace
+
+/**
+ * Samples the dirty share of the cache, the time application threads spend waiting on eviction
+ * and the rate of committed transactions once per kCacheControllerPeriod, and moves the
+ * connection between three levels of eviction and checkpoint settings.
+ *
+ * Under more pressure it adds eviction worker threads and lowers eviction_dirty_target so that
+ * dirty pages are written out before application threads have to help, and, at the highest
+ * level, halves the checkpoint delay so that each checkpoint has less dirty data to flush.
+ */
+class WiredTigerKVEngine::WiredTigerCacheController : public BackgroundJob {
+public:
+    enum class Level { kNormal = 0, kElevated = 1, kHigh = 2 };
+
+    explicit WiredTigerCacheController(WiredTigerKVEngine* wiredTigerKVEngine,
+                                       WiredTigerSessionCache* sessionCache)
+        : BackgroundJob(false /* deleteSelf */),
+          _wiredTigerKVEngine(wiredTigerKVEngine),
+          _sessionCache(sessionCache) {}
+
+    virtual string name() const {
+        return "WTCacheController";
+    }
+
+    virtual void run() {
+        Client::initThread(name().c_str());
+        ON_BLOCK_EXIT([] { Client::destroy(); });
+
+        LOG(1) << "starting " << name() << " thread";
+
+        while (!_shuttingDown.load()) {
+            {
+                stdx::unique_lock<stdx::mutex> lock(_mutex);
+                MONGO_IDLE_THREAD_BLOCK;
+                _condvar.wait_for(lock, kCacheControllerPeriod.toSystemDuration(), [&] {
+                    return _shuttingDown.load();
+                });
+            }
+            if (_shuttingDown.load()) {
+                break;
+            }
+
+            try {
+                _sample();
+            } catch (const AssertionException& exc) {
+                invariant(ErrorCodes::isShutdownError(exc.code()), exc.what());
+            }
+        }
+        LOG(1) << "stopping " << name() << " thread";
+    }
+
+    void appendStats(BSONObjBuilder* builder) const {
+        stdx::lock_guard<stdx::mutex> lock(_mutex);
+        const auto& settings = _settingsFor(_level);
+        BSONObjBuilder bob(builder->subobjStart("cache controller"));
+        bob.append("enabled", wiredTigerCacheControllerEnabled.load());
+        bob.append("pressure level", static_cast<int>(_level));
+        bob.append("level changes", _levelChanges);
+        bob.append("dirty cache percent", _lastDirtyCachePercent);
+        bob.append("application cache wait micros per second", _lastWaitMicrosPerSec);
+        bob.append("transactions committed per second", _lastCommitsPerSec);
+        bob.append("eviction threads min", settings.evictionThreadsMin);
+        bob.append("eviction threads max", settings.evictionThreadsMax);
+        bob.append("eviction dirty target", settings.evictionDirtyTarget);
+        bob.append("checkpoint delay secs", _wiredTigerKVEngine->_getCheckpointDelaySecs());
+    }
+
+    void shutdown() {
+        _shuttingDown.store(true);
+        {
+            stdx::lock_guard<stdx::mutex> lock(_mutex);
+            _condvar.notify_one();
+        }
+        wait();
+    }
+
+private:
+    struct Settings {
+        int evictionThreadsMin;
+        int evictionThreadsMax;
+        int evictionDirtyTarget;
+        // Divides the configured checkpoint delay.
+        int checkpointDelayDivisor;
+    };
+
+    static const Settings& _settingsFor(Level level) {
+        // kNormal matches the settings the connection is opened with.
+        static const Settings kSettings[] = {{4, 4, 5, 1}, {4, 8, 3, 1}, {8, 16, 2, 2}};
+        return kSettings[static_cast<int>(level)];
+    }
+
+    void _sample() {
+        std::int64_t dirtyBytes, maxBytes, waitMicros, commits;
+        {
+            UniqueWiredTigerSession session = _sessionCache->getSession();
+            WT_SESSION* s = session->getSession();
+            auto getStat = [&](int key) {
+                return uassertStatusOK(
+                    WiredTigerUtil::getStatisticsValueAs<std::int64_t>(s, "statistics:", "", key));
+            };
+            dirtyBytes = getStat(WT_STAT_CONN_CACHE_BYTES_DIRTY);
+            maxBytes = getStat(WT_STAT_CONN_CACHE_BYTES_MAX);
+            waitMicros = getStat(WT_STAT_CONN_APPLICATION_CACHE_TIME);
+            commits = getStat(WT_STAT_CONN_TXN_COMMIT);
+        }
+        const Date_t now = Date_t::now();
+
+        stdx::lock_guard<stdx::mutex> lock(_mutex);
+        const bool firstSample = _lastSampleTime == Date_t();
+        const double elapsedSecs =
+            std::max(durationCount<Milliseconds>(now - _lastSampleTime), 1LL) / 1000.0;
+        _lastDirtyCachePercent = maxBytes > 0 ? 100.0 * dirtyBytes / maxBytes : 0.0;
+        _lastWaitMicrosPerSec =
+            firstSample ? 0 : static_cast<long long>((waitMicros - _lastWaitMicros) / elapsedSecs);
+        _lastCommitsPerSec =
+            firstSample ? 0 : static_cast<long long>((commits - _lastCommits) / elapsedSecs);
+        _lastSampleTime = now;
+        _lastWaitMicros = waitMicros;
+        _lastCommits = commits;
+
+        if (!wiredTigerCacheControllerEnabled.load()) {
+            _stepDownSamples = 0;
+            if (_level != Level::kNormal) {
+                _apply(lock, Level::kNormal, "controller disabled");
+            }
+            return;
+        }
+
+        // Dirty data only drains through eviction and checkpoints, so without writes a dirty
+        // cache alone is no reason to add eviction work. Application threads waiting on the cache
+        // always are.
+        Level target = Level::kNormal;
+        if (_lastWaitMicrosPerSec >= kHighApplicationCacheWaitMicrosPerSec ||
+            (_lastCommitsPerSec > 0 && _lastDirtyCachePercent >= kHighDirtyCachePercent)) {
+            target = Level::kHigh;
+        } else if (_lastWaitMicrosPerSec > 0 ||
+                   (_lastCommitsPerSec > 0 &&
+                    _lastDirtyCachePercent >= kElevatedDirtyCachePercent)) {
+            target = Level::kElevated;
+        }
+
+        if (target > _level) {
+            _stepDownSamples = 0;
+            _apply(lock, target, "cache pressure increased");
+        } else if (target < _level) {
+            if (++_stepDownSamples >= kCacheControllerStepDownSamples) {
+                _stepDownSamples = 0;
+                _apply(lock,
+                       static_cast<Level>(static_cast<int>(_level) - 1),
+                       "cache pressure decreased");
+            }
+        } else {
+            _stepDownSamples = 0;
+        }
+    }
+
+    void _apply(WithLock, Level level, StringData reason) {
+        const auto& settings = _settingsFor(level);
+        const std::string config = str::stream() << "eviction=(threads_min="
+                                                 << settings.evictionThreadsMin << ",threads_max="
+                                                 << settings.evictionThreadsMax
+                                                 << "),eviction_dirty_target="
+                                                 << settings.evictionDirtyTarget;
+        const int ret = _wiredTigerKVEngine->reconfigure(config.c_str());
+        if (ret != 0) {
+            warning() << name() << " failed to apply '" << config
+                      << "': " << wtRCToStatus(ret).reason();
+            return;
+        }
+
+        const auto configuredDelaySecs = wiredTigerGlobalOptions.checkpointDelaySecs;
+        _wiredTigerKVEngine->_adaptiveCheckpointDelaySecs.store(
+            settings.checkpointDelayDivisor > 1 && configuredDelaySecs > 1
+                ? std::max<std::int64_t>(configuredDelaySecs / settings.checkpointDelayDivisor, 1)
+                : 0);
+
+        log() << name() << " moving from pressure level " << static_cast<int>(_level) << " to "
+              << static_cast<int>(level) << " (" << reason
+              << "). Dirty cache: " << _lastDirtyCachePercent
+              << "%, application cache wait: " << _lastWaitMicrosPerSec
+              << " micros/sec, commits: " << _lastCommitsPerSec << "/sec. Applied '" << config
+              << "', checkpoint delay: " << _wiredTigerKVEngine->_getCheckpointDelaySecs()
+              << " secs";
+        _level = level;
+        ++_levelChanges;
+    }
+
+    WiredTigerKVEngine* _wiredTigerKVEngine;
+    WiredTigerSessionCache* _sessionCache;
+
+    mutable stdx::mutex _mutex;  // protects _condvar and everything below
+    stdx::condition_variable _condvar;
+
+    AtomicBool _shuttingDown{false};
+
+    Level _level = Level::kNormal;
+    long long _levelChanges = 0;
+    int _stepDownSamples = 0;
+
+    // Cumulative statistics from the previous sample and the rates derived from them.
+    Date_t _lastSampleTime;
+    std::int64_t _lastWaitMicros = 0;
+    std::int64_t _lastCommits = 0;
+    double _lastDirtyCachePercent = 0.0;
+    long long _lastWaitMicrosPerSec = 0;
+    long long _lastCommitsPerSec = 0;
+};
+
+namespace {
+
 class TicketServerParameter : public ServerParameter {
     MONGO_DISALLOW_COPYING(TicketServerParameter);
 
@@ -574,6 +816,17 @@ WiredTigerKVEngine::WiredTigerKVEngine(const std::string& canonicalName,
         _checkpointThread =
             stdx::make_unique<WiredTigerCheckpointThread>(this, _sessionCache.get());
         _checkpointThread->go();
+
+        // The controller would override eviction settings passed in through the engine config
+        // string, so leave them alone when there are any.
+        if (extraOpenOptions.find("eviction") == std::string::npos) {
+            _cacheController =
+                stdx::make_unique<WiredTigerCacheController>(this, _sessionCache.get());
+            _cacheController->go();
+        } else {
+            log() << "Not starting the WiredTiger cache controller, eviction is configured "
+                     "through the engine config string";
+        }
     }
 
     _sizeStorerUri = _uri("sizeStorer");
@@ -625,6 +878,11 @@ void WiredTigerKVEngine::cleanShutdown() {
     }
 
     // these must be the last things we do before _conn->close();
+    if (_cacheController) {
+        log() << "Shutting down cache controller thread";
+        _cacheController->shutdown();
+        log() << "Finished shutting down cache controller thread";
+    }
     if (_journalFlusher) {
         log() << "Shutting down journal flusher thread";
         _journalFlusher->shutdown();
@@ -1107,7 +1365,8 @@ bool WiredTigerKVEngine::haveDropsQueued() const {
     Date_t now = _clockSource->now();
     Milliseconds delta = now - _previousCheckedDropsQueued;
 
-    if (!_readOnly && _sizeStorerSyncTracker.intervalHasElapsed()) {
+    if (!_readOnly && (_sizeStorerSyncTracker.intervalHasElapsed() ||
+                       (_sizeStorer && _sizeStorer->flushIsDue()))) {
         _sizeStorerSyncTracker.resetLastTime();
         syncSizeInfo(false);
     }
@@ -1562,6 +1821,19 @@ void WiredTigerKVEngine::replicationBatchIsComplete() const {
     _oplogManager->triggerJournalFlush();
 }
 
+void WiredTigerKVEngine::appendCacheControllerStats(BSONObjBuilder* builder) const {
+    if (_cacheController) {
+        _cacheController->appendStats(builder);
+    }
+}
+
+std::int64_t WiredTigerKVEngine::_getCheckpointDelaySecs() const {
+    const auto adaptiveDelaySecs = _adaptiveCheckpointDelaySecs.load();
+    return adaptiveDelaySecs > 0
+        ? adaptiveDelaySecs
+        : static_cast<std::int64_t>(wiredTigerGlobalOptions.checkpointDelaySecs);
+}
+
 bool WiredTigerKVEngine::isCacheUnderPressure(OperationContext* opCtx) const {
     WiredTigerSession* session = WiredTigerRecoveryUnit::get(opCtx)->getSessionNoTxn();
     invariant(session);
@@ -297,6 +297,12 @@ public:
 
     Timestamp getInitialDataTimestamp() const;
 
+    /**
+     * Appends the current settings and recent decisions of the cache controller, if it is running,
+     * for serverStatus and FTDC.
+     */
+    void appendCacheControllerStats(BSONObjBuilder* builder) const;
+
     /**
      * Returns the data file path associated with an ident on disk. Returns boost::none if the data
      * file can not be found. This will attempt to locate a file even if the storage engine's own
@@ -307,6 +313,7 @@ public:
 private:
     class WiredTigerJournalFlusher;
     class WiredTigerCheckpointThread;
+    class WiredTigerCacheController;
 
     Status _salvageIfNeeded(const char* uri);
     void _ensureIdentPath(StringData ident);
@@ -345,6 +352,12 @@ private:
      */
     void _setOldestTimestamp(Timestamp newOldestTimestamp, bool force);
 
+    /**
+     * Returns the number of seconds the checkpoint thread waits between checkpoints: the delay
+     * chosen by the cache controller if it has shortened it, else the configured one.
+     */
+    std::int64_t _getCheckpointDelaySecs() const;
+
     WT_CONNECTION* _conn;
     WiredTigerEventHandler _eventHandler;
     std::unique_ptr<WiredTigerSessionCache> _sessionCache;
@@ -369,6 +382,10 @@ private:
     bool _readOnly;
     std::unique_ptr<WiredTigerJournalFlusher> _journalFlusher;  // Depends on _sizeStorer
     std::unique_ptr<WiredTigerCheckpointThread> _checkpointThread;
+    std::unique_ptr<WiredTigerCacheController> _cacheController;
+
+    // Checkpoint delay set by the cache controller. Zero means the configured delay applies.
+    AtomicWord<std::int64_t> _adaptiveCheckpointDelaySecs{0};
 
     std::string _rsOptions;
     std::string _indexOptions;
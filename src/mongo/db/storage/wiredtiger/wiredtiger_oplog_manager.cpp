@@ -31,14 +31,19 @@
 
 #include "mongo/platform/basic.h"
 
+#include <algorithm>
 #include <cstring>
 
+#include "mongo/bson/bsonobjbuilder.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_kv_engine.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_oplog_manager.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_util.h"
+#include "mongo/platform/bits.h"
 #include "mongo/stdx/mutex.h"
 #include "mongo/util/concurrency/idle_thread_block.h"
 #include "mongo/util/log.h"
+#include "mongo/util/scopeguard.h"
+#include "mongo/util/time_support.h"
 
 namespace mongo {
 namespace {
@@ -122,6 +127,13 @@ void WiredTigerOplogManager::waitForAllEarlierOplogWritesToBeVisible(
     opCtx->recoveryUnit()->abandonSnapshot();
 
     stdx::unique_lock<stdx::mutex> lk(_oplogVisibilityStateMutex);
+
+    // Let the journal thread know that someone is waiting, so that it publishes the next oplog
+    // read timestamp right away rather than delaying to batch up more writes.
+    _opsWaitingForVisibility++;
+    ON_BLOCK_EXIT([&] { _opsWaitingForVisibility--; });
+    _opsWaitingForJournalCV.notify_one();
+
     opCtx->waitForConditionOrInterrupt(_opsBecameVisibleCV, lk, [&] {
         auto newLatestVisibleTimestamp = getOplogReadTimestamp();
         if (newLatestVisibleTimestamp < currentLatestVisibleTimestamp) {
@@ -150,6 +162,9 @@ void WiredTigerOplogManager::triggerJournalFlush() {
     stdx::lock_guard<stdx::mutex> lk(_oplogVisibilityStateMutex);
     if (!_opsWaitingForJournal) {
         _opsWaitingForJournal = true;
+        if (!_oldestUnpublishedCommitMicros) {
+            _oldestUnpublishedCommitMicros = curTimeMicros64();
+        }
         _opsWaitingForJournalCV.notify_one();
     }
 }
@@ -177,12 +192,15 @@ void WiredTigerOplogManager::_oplogJournalThreadLoop(
             auto now = Date_t::now();
             auto deadline = now + journalDelay;
             auto shouldSyncOpsWaitingForJournal = [&] {
-                return _shuttingDown || oplogRecordStore->haveCappedWaiters();
+                return _shuttingDown || _opsWaitingForVisibility > 0 ||
+                    oplogRecordStore->haveCappedWaiters();
             };
 
             // Eventually it would be more optimal to merge this with the normal journal flushing
-            // and block for oplog tailers to show up. For now this loop will poll once a
-            // millisecond up to the journalDelay to see if we have any waiters yet. This reduces
+            // and block for oplog tailers to show up. Operations in
+            // waitForAllEarlierOplogWritesToBeVisible() signal the condition variable when they
+            // start waiting, but await_data cursors do not, so for now this loop will poll once a
+            // millisecond up to the journalDelay to see if we have any of those yet. This reduces
             // sync-related I/O on the primary when secondaries are lagged, but will avoid
             // significant delays in confirming majority writes on replica sets with infrequent
             // writes.
@@ -205,6 +223,7 @@ void WiredTigerOplogManager::_oplogJournalThreadLoop(
         }
         invariant(_opsWaitingForJournal);
         _opsWaitingForJournal = false;
+        const uint64_t flushStartMicros = curTimeMicros64();
         lk.unlock();
 
         const uint64_t newTimestamp = fetchAllCommittedValue(sessionCache->conn());
@@ -226,6 +245,16 @@ void WiredTigerOplogManager::_oplogJournalThreadLoop(
         auto oldTimestamp = getOplogReadTimestamp();
         if (newTimestamp > oldTimestamp) {
             _setOplogReadTimestamp(lk, newTimestamp);
+
+            if (_oldestUnpublishedCommitMicros) {
+                const uint64_t now = curTimeMicros64();
+                _recordVisibilityLatency(lk,
+                                         now > _oldestUnpublishedCommitMicros
+                                             ? now - _oldestUnpublishedCommitMicros
+                                             : 0);
+            }
+            // Writes which committed while we were flushing the journal may not be visible yet.
+            _oldestUnpublishedCommitMicros = _opsWaitingForJournal ? flushStartMicros : 0;
         }
         lk.unlock();
 
@@ -249,6 +278,35 @@ void WiredTigerOplogManager::_setOplogReadTimestamp(WithLock, uint64_t newTimest
     LOG(2) << "setting new oplogReadTimestamp: " << newTimestamp;
 }
 
+void WiredTigerOplogManager::_recordVisibilityLatency(WithLock, uint64_t micros) {
+    // Zero falls in bucket 0 and every other value in the bucket after the log base 2 of micros.
+    const int bucket = micros == 0 ? 0 : std::min(64 - countLeadingZeros64(micros),
+                                                  kVisibilityLatencyBuckets - 1);
+    _visibilityLatencyBuckets[bucket]++;
+    _visibilityLatencyTotalMicros += micros;
+    _visibilityUpdates++;
+}
+
+void WiredTigerOplogManager::appendStats(BSONObjBuilder* builder) const {
+    stdx::lock_guard<stdx::mutex> lk(_oplogVisibilityStateMutex);
+
+    BSONObjBuilder bob(builder->subobjStart("oplog visibility"));
+    bob.append("read timestamp updates", static_cast<long long>(_visibilityUpdates));
+    bob.append("total time to visibility micros",
+               static_cast<long long>(_visibilityLatencyTotalMicros));
+    BSONArrayBuilder histogram(bob.subarrayStart("time to visibility histogram"));
+    for (int i = 0; i < kVisibilityLatencyBuckets; i++) {
+        if (_visibilityLatencyBuckets[i] == 0)
+            continue;
+        BSONObjBuilder entryBuilder(histogram.subobjStart());
+        entryBuilder.append("micros", i == 0 ? 0LL : static_cast<long long>(1ULL << (i - 1)));
+        entryBuilder.append("count", static_cast<long long>(_visibilityLatencyBuckets[i]));
+        entryBuilder.doneFast();
+    }
+    histogram.doneFast();
+    bob.doneFast();
+}
+
 uint64_t WiredTigerOplogManager::fetchAllCommittedValue(WT_CONNECTION* conn) {
     // Fetch the latest all_committed value from the storage engine.  This value will be a
     // timestamp that has no holes (uncommitted transactions with lower timestamps) behind it.
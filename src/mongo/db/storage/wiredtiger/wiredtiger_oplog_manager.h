@@ -29,6 +29,8 @@
 
 #pragma once
 
+#include <array>
+
 #include "mongo/base/disallow_copying.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_record_store.h"
 #include "mongo/stdx/condition_variable.h"
@@ -38,12 +40,14 @@
 
 namespace mongo {
 
+class BSONObjBuilder;
 class WiredTigerRecordStore;
 class WiredTigerSessionCache;
 
 
-// Manages oplog visibility, by periodically querying WiredTiger's all_committed timestamp value and
-// then using that timestamp for all transactions that read the oplog collection.
+// Manages oplog visibility, by querying WiredTiger's all_committed timestamp value whenever
+// timestamped writes commit and then using that timestamp for all transactions that read the oplog
+// collection. Visibility is advanced without delay while anyone is waiting to read new entries.
 class WiredTigerOplogManager {
     MONGO_DISALLOW_COPYING(WiredTigerOplogManager);
 
@@ -82,12 +86,18 @@ public:
     // all committed timestamp are committed.
     uint64_t fetchAllCommittedValue(WT_CONNECTION* conn);
 
+    // Appends the number of oplog read timestamp updates and a histogram of the time from the
+    // commit of the oldest unpublished oplog write until it became visible.
+    void appendStats(BSONObjBuilder* builder) const;
+
 private:
     void _oplogJournalThreadLoop(WiredTigerSessionCache* sessionCache,
                                  WiredTigerRecordStore* oplogRecordStore) noexcept;
 
     void _setOplogReadTimestamp(WithLock, uint64_t newTimestamp);
 
+    void _recordVisibilityLatency(WithLock, uint64_t micros);
+
     stdx::thread _oplogJournalThread;
     mutable stdx::mutex _oplogVisibilityStateMutex;
     mutable stdx::condition_variable
@@ -103,6 +113,22 @@ private:
     RecordId _oplogMaxAtStartup = RecordId(0);  // Guarded by oplogVisibilityStateMutex.
     bool _opsWaitingForJournal = false;         // Guarded by oplogVisibilityStateMutex.
 
+    // The number of operations blocked in waitForAllEarlierOplogWritesToBeVisible(). While this
+    // is non-zero, the journal thread publishes new timestamps without its usual delay.
+    mutable int _opsWaitingForVisibility = 0;  // Guarded by oplogVisibilityStateMutex.
+
+    // When the oldest write which is not yet visible called triggerJournalFlush(), or 0 if every
+    // committed write is visible. Measured with curTimeMicros64().
+    uint64_t _oldestUnpublishedCommitMicros = 0;  // Guarded by oplogVisibilityStateMutex.
+
+    // Time-to-visibility histogram, guarded by oplogVisibilityStateMutex. Bucket 0 counts
+    // latencies under 1 microsecond and bucket i counts latencies in [2^(i-1), 2^i) microseconds;
+    // the last bucket also counts anything longer.
+    static const int kVisibilityLatencyBuckets = 32;
+    std::array<uint64_t, kVisibilityLatencyBuckets> _visibilityLatencyBuckets{};
+    uint64_t _visibilityLatencyTotalMicros = 0;
+    uint64_t _visibilityUpdates = 0;
+
     AtomicUInt64 _oplogReadTimestamp;
 };
 }  // namespace mongo
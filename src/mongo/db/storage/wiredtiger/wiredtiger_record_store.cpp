@@ -37,6 +37,8 @@
 
 #include "mongo/db/storage/wiredtiger/wiredtiger_record_store.h"
 
+#include <cstdlib>
+
 #include "mongo/base/checked_cast.h"
 #include "mongo/base/static_assert.h"
 #include "mongo/bson/util/builder.h"
@@ -47,9 +49,11 @@
 #include "mongo/db/namespace_string.h"
 #include "mongo/db/operation_context.h"
 #include "mongo/db/repl/repl_settings.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/server_recovery.h"
 #include "mongo/db/service_context.h"
 #include "mongo/db/storage/oplog_hack.h"
+#include "mongo/db/storage/storage_options.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_customization_hooks.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_global_options.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_kv_engine.h"
@@ -106,6 +110,25 @@ const std::string kWiredTigerEngineName = "wiredTiger";
 // cursors will be available in the needed session caches.
 static int kCappedDocumentRemoveLimit = 3;
 
+// For a capped collection with stones, the number of documents removed in each transaction while
+// truncating a stone, and the number of write conflicts an insert tolerates before it leaves the
+// rest of the truncation to a later insert.
+static int kCappedStoneRemoveBatchSize = 1000;
+static int kCappedStoneRemoveMaxConflicts = 3;
+
+// Capped collections other than the oplog whose maximum size is at least this many bytes, and which
+// have no maximum document count, keep "stones" like the oplog does. They then reclaim space by
+// truncating a whole stone's worth of their oldest documents at a time, rather than deleting a few
+// documents on every insert. A value of 0, the default, disables stones for such collections.
+MONGO_EXPORT_STARTUP_SERVER_PARAMETER(wiredTigerCappedCollectionStonesMinSizeBytes, long long, 0)
+    ->withValidator([](const long long& potentialNewValue) {
+        if (potentialNewValue < 0) {
+            return Status(ErrorCodes::BadValue,
+                          "wiredTigerCappedCollectionStonesMinSizeBytes must be non-negative");
+        }
+        return Status::OK();
+    });
+
 class WiredTigerRecordStore::OplogStones::InsertChange final : public RecoveryUnit::Change {
 public:
     InsertChange(OplogStones* oplogStones,
@@ -336,7 +359,7 @@ void WiredTigerRecordStore::OplogStones::_calculateStones(OperationContext* opCt
     long long numRecords = _rs->numRecords(opCtx);
     long long dataSize = _rs->dataSize(opCtx);
 
-    log() << "The size storer reports that the oplog contains " << numRecords
+    log() << "The size storer reports that " << _rs->ns() << " contains " << numRecords
           << " records totaling to " << dataSize << " bytes";
 
     // Only use sampling to estimate where to place the oplog stones if the number of samples drawn
@@ -362,7 +385,7 @@ void WiredTigerRecordStore::OplogStones::_calculateStones(OperationContext* opCt
 }
 
 void WiredTigerRecordStore::OplogStones::_calculateStonesByScanning(OperationContext* opCtx) {
-    log() << "Scanning the oplog to determine where to place markers for truncation";
+    log() << "Scanning " << _rs->ns() << " to determine where to place markers for truncation";
 
     long long numRecords = 0;
     long long dataSize = 0;
@@ -769,6 +792,12 @@ void WiredTigerRecordStore::postConstructorInit(OperationContext* opCtx) {
 
     if (WiredTigerKVEngine::initRsOplogBackgroundThread(ns())) {
         _oplogStones = std::make_shared<OplogStones>(opCtx, this);
+    } else if (_isCapped && !_isOplog && _cappedMaxDocs == -1 &&
+               wiredTigerCappedCollectionStonesMinSizeBytes > 0 &&
+               _cappedMaxSize >= wiredTigerCappedCollectionStonesMinSizeBytes &&
+               !storageGlobalParams.repair && !storageGlobalParams.readOnly) {
+        // A document limit must be enforced exactly, which stones cannot do.
+        _oplogStones = std::make_shared<OplogStones>(opCtx, this);
     }
 
     if (_isOplog) {
@@ -935,7 +964,15 @@ int64_t WiredTigerRecordStore::_cappedDeleteAsNeeded(OperationContext* opCtx,
         return 0;
     }
 
-    invariant(!_oplogStones);
+    if (_oplogStones) {
+        // Only one thread truncates at a time. The others need not wait for it, as stones only keep
+        // the collection's size approximately within its limit anyway.
+        stdx::unique_lock<stdx::timed_mutex> lock(_cappedDeleterMutex, stdx::try_to_lock);
+        if (!lock) {
+            return 0;
+        }
+        return _cappedDeleteOldestStone_inlock(opCtx, justInserted);
+    }
 
     // We only want to do the checks occasionally as they are expensive.
     // This variable isn't thread safe, but has loose semantics anyway.
@@ -1164,6 +1201,126 @@ int64_t WiredTigerRecordStore::_cappedDeleteAsNeeded_inlock(OperationContext* op
     return docsRemoved;
 }
 
+int64_t WiredTigerRecordStore::_cappedDeleteOldestStone_inlock(OperationContext* opCtx,
+                                                               const RecordId& justInserted) {
+    auto stone = _oplogStones->peekOldestStoneIfNeeded();
+    if (!stone || stone->lastRecord >= justInserted) {
+        return 0;
+    }
+
+    // We do this in a side transaction in case it aborts, as in _cappedDeleteAsNeeded_inlock().
+    WiredTigerRecoveryUnit* realRecoveryUnit =
+        checked_cast<WiredTigerRecoveryUnit*>(opCtx->releaseRecoveryUnit().release());
+    invariant(realRecoveryUnit);
+    WiredTigerSessionCache* sc = realRecoveryUnit->getSessionCache();
+    WriteUnitOfWork::RecoveryUnitState const realRUstate =
+        opCtx->setRecoveryUnit(std::make_unique<WiredTigerRecoveryUnit>(sc),
+                               WriteUnitOfWork::RecoveryUnitState::kNotInUnitOfWork);
+    ON_BLOCK_EXIT([&] {
+        opCtx->releaseRecoveryUnit();
+        opCtx->setRecoveryUnit(std::unique_ptr<RecoveryUnit>(realRecoveryUnit), realRUstate);
+    });
+
+    // Remove every stone in excess, not just one, so that the collection returns to its maximum
+    // size even if earlier inserts gave up on a conflict.
+    int64_t docsRemoved = 0;
+    int conflicts = 0;
+    for (; stone && stone->lastRecord < justInserted;
+         stone = _oplogStones->peekOldestStoneIfNeeded()) {
+        LOG(1) << "Truncating capped collection " << ns() << " between "
+               << _oplogStones->firstRecord << " and " << stone->lastRecord
+               << " to remove approximately " << stone->records << " records totaling to "
+               << stone->bytes << " bytes";
+
+        // Remove the stone's documents in batches, each in its own transaction, so that a large
+        // stone neither needs a large transaction nor loses all of its progress on a conflict.
+        bool stoneRemoved = false;
+        while (!stoneRemoved) {
+            RecordId lastRemoved;
+            int64_t batchDocsRemoved = 0;
+            int64_t batchSizeSaved = 0;
+            try {
+                WriteUnitOfWork wuow(opCtx);
+
+                WiredTigerCursor curwrap(_uri, _tableId, true, opCtx);
+                WT_CURSOR* cursor = curwrap.get();
+
+                // Unlike the oplog, other capped collections may have indexes, so every document
+                // in the stone has to be passed to the capped callback before it is truncated.
+                _positionAtFirstRecordId(opCtx, cursor, _oplogStones->firstRecord, false);
+                int ret = 0;
+                do {
+                    RecordId id = getKey(cursor);
+                    if (id > stone->lastRecord) {
+                        stoneRemoved = true;
+                        break;
+                    }
+                    if (batchDocsRemoved >= kCappedStoneRemoveBatchSize)
+                        break;
+
+                    WT_ITEM value;
+                    invariantWTOK(cursor->get_value(cursor, &value));
+
+                    stdx::lock_guard<stdx::mutex> cappedCallbackLock(_cappedCallbackMutex);
+                    if (_shuttingDown)
+                        return docsRemoved;
+
+                    if (_cappedCallback) {
+                        uassertStatusOK(_cappedCallback->aboutToDeleteCapped(
+                            opCtx,
+                            id,
+                            RecordData(static_cast<const char*>(value.data), value.size)));
+                    }
+
+                    lastRemoved = id;
+                    ++batchDocsRemoved;
+                    batchSizeSaved += value.size;
+                } while ((ret = wiredTigerPrepareConflictRetry(
+                              opCtx, [&] { return cursor->next(cursor); })) == 0);
+
+                if (ret == WT_NOTFOUND) {
+                    stoneRemoved = true;
+                } else {
+                    invariantWTOK(ret);
+                }
+
+                if (batchDocsRemoved > 0) {
+                    WT_SESSION* session =
+                        WiredTigerRecoveryUnit::get(opCtx)->getSession()->getSession();
+                    setKey(cursor, lastRemoved);
+                    invariantWTOK(session->truncate(session, nullptr, nullptr, cursor, nullptr));
+                    _changeNumRecords(opCtx, -batchDocsRemoved);
+                    _increaseDataSize(opCtx, -batchSizeSaved);
+                }
+
+                wuow.commit();
+            } catch (const WriteConflictException&) {
+                // The batches already committed stay removed. Give up after a few attempts, since
+                // the conflict may be with the transaction of this very insert, and leave the rest
+                // to the next insert, which resumes where this one stopped.
+                if (++conflicts >= kCappedStoneRemoveMaxConflicts) {
+                    log() << "got conflict truncating capped, retrying on a later insert";
+                    return docsRemoved;
+                }
+                WriteConflictException::logAndBackoff(conflicts, "truncating capped", ns());
+                stoneRemoved = false;
+                continue;
+            }
+
+            // Stash the truncate point for next time to cleanly skip over tombstones, etc.
+            if (batchDocsRemoved > 0) {
+                _oplogStones->firstRecord = lastRemoved;
+                docsRemoved += batchDocsRemoved;
+            }
+        }
+
+        _oplogStones->popOldestStone();
+        _oplogStones->firstRecord = stone->lastRecord;
+    }
+
+    return docsRemoved;
+}
+
 bool WiredTigerRecordStore::yieldAndAwaitOplogDeletionRequest(OperationContext* opCtx) {
     // Create another reference to the oplog stones while holding a lock on the collection to
     // prevent it from being destructed.
@@ -1342,7 +1499,11 @@ Status WiredTigerRecordStore::_insertRecords(OperationContext* opCtx,
     if (_oplogStones) {
         _oplogStones->updateCurrentStoneAfterInsertOnCommit(
             opCtx, totalLength, highestId, nRecords);
-    } else {
+    }
+
+    // The oplog's stones are reclaimed by the OplogTruncaterThread. Any other capped collection
+    // reclaims space as part of its inserts.
+    if (!_oplogStones || !_isOplog) {
         _cappedDeleteAsNeeded(opCtx, highestId);
     }
 
@@ -1380,6 +1541,91 @@ void WiredTigerRecordStore::notifyCappedWaitersIfNeeded() {
     }
 }
 
+/**
+ * Appends records to an empty table through a WiredTiger bulk cursor, which writes leaf pages
+ * directly instead of going through a transaction per record.
+ */
+class WiredTigerRecordStore::BulkBuilder final : public RecordStoreBulkBuilder {
+public:
+    BulkBuilder(WiredTigerRecordStore* rs,
+                OperationContext* opCtx,
+                UniqueWiredTigerSession session,
+                WT_CURSOR* cursor)
+        : _rs(rs), _opCtx(opCtx), _session(std::move(session)), _cursor(cursor) {}
+
+    ~BulkBuilder() {
+        if (_cursor)
+            _cursor->close(_cursor);
+    }
+
+    StatusWith<RecordId> addRecord(const char* data, int len) override {
+        invariant(_cursor);
+        invariant(!_opCtx->lockState()->inAWriteUnitOfWork());
+
+        RecordId id = _rs->_nextId();
+        _rs->setKey(_cursor, id);
+        WiredTigerItem value(data, len);
+        _cursor->set_value(_cursor, value.Get());
+        int ret = _cursor->insert(_cursor);
+        if (ret)
+            return wtRCToStatus(ret, "WiredTigerRecordStore::BulkBuilder::addRecord");
+
+        _numRecords++;
+        _dataSize += len;
+        return id;
+    }
+
+    Status commit() override {
+        invariant(_cursor);
+
+        // Closing a bulk cursor flushes the pages it has built and makes them visible.
+        WT_CURSOR* cursor = _cursor;
+        _cursor = nullptr;
+        int ret = cursor->close(cursor);
+        if (ret)
+            return wtRCToStatus(ret, "WiredTigerRecordStore::BulkBuilder::commit");
+
+        WriteUnitOfWork wuow(_opCtx);
+        _rs->_changeNumRecords(_opCtx, _numRecords);
+        _rs->_increaseDataSize(_opCtx, _dataSize);
+        wuow.commit();
+        return Status::OK();
+    }
+
+private:
+    WiredTigerRecordStore* const _rs;
+    OperationContext* const _opCtx;
+    UniqueWiredTigerSession const _session;
+    WT_CURSOR* _cursor;
+    int64_t _numRecords = 0;
+    int64_t _dataSize = 0;
+};
+
+std::unique_ptr<RecordStoreBulkBuilder> WiredTigerRecordStore::getBulkBuilder(
+    OperationContext* opCtx) {
+    if (_isCapped || _isOplog || numRecords(opCtx) > 0)
+        return nullptr;
+
+    // Open cursors can cause bulk open_cursor to fail with EBUSY.
+    WiredTigerRecoveryUnit* ru = _getRecoveryUnit(opCtx);
+    ru->getSession()->closeAllCursors(_uri);
+
+    // Use a different session to ensure we don't hijack an existing transaction, and don't wait
+    // for a running checkpoint since the caller can always fall back to regular inserts.
+    UniqueWiredTigerSession session = ru->getSessionCache()->getSession();
+    WT_SESSION* wtSession = session->getSession();
+    WT_CURSOR* cursor;
+    int ret = wtSession->open_cursor(
+        wtSession, _uri.c_str(), nullptr, "bulk,checkpoint_wait=false", &cursor);
+    if (ret) {
+        LOG(1) << "failed to create WiredTiger bulk cursor for " << _uri << ": "
+               << wiredtiger_strerror(ret) << "; falling back to regular inserts";
+        return nullptr;
+    }
+
+    return stdx::make_unique<BulkBuilder>(this, opCtx, std::move(session), cursor);
+}
+
 Status WiredTigerRecordStore::insertRecordsWithDocWriter(OperationContext* opCtx,
                                                          const DocWriter* const* docs,
                                                          const Timestamp* timestamps,
@@ -1729,56 +1975,67 @@ WiredTigerRecoveryUnit* WiredTigerRecordStore::_getRecoveryUnit(OperationContext
     return checked_cast<WiredTigerRecoveryUnit*>(opCtx->recoveryUnit());
 }
 
-class WiredTigerRecordStore::NumRecordsChange : public RecoveryUnit::Change {
+/**
+ * Accumulates the adjustments a unit of work makes to the record count and data size of a record
+ * store. They are undone on rollback, and handed to the size storer once on commit. A single
+ * SizeChange is registered per unit of work and record store, however many records it touches.
+ */
+class WiredTigerRecordStore::SizeChange : public RecoveryUnit::Change {
 public:
-    NumRecordsChange(WiredTigerRecordStore* rs, int64_t diff) : _rs(rs), _diff(diff) {}
-    virtual void commit(boost::optional<Timestamp>) {}
+    explicit SizeChange(WiredTigerRecordStore* rs) : _rs(rs) {}
+
+    virtual void commit(boost::optional<Timestamp>) {
+        if (_rs->_sizeStorer)
+            _rs->_sizeStorer->store(_rs->_uri, _rs->_sizeInfo, std::abs(numRecordsDiff));
+    }
+
     virtual void rollback() {
-        LOG(3) << "WiredTigerRecordStore: rolling back NumRecordsChange" << -_diff;
-        _rs->_sizeInfo->numRecords.fetchAndAdd(-_diff);
+        LOG(3) << "WiredTigerRecordStore: rolling back SizeChange, numRecords: " << -numRecordsDiff
+               << ", dataSize: " << -dataSizeDiff;
+        _rs->_sizeInfo->numRecords.fetchAndAdd(-numRecordsDiff);
+        if (_rs->_sizeInfo->dataSize.fetchAndAdd(-dataSizeDiff) < 0)
+            _rs->_sizeInfo->dataSize.store(std::max(-dataSizeDiff, int64_t(0)));
+
+        if (_rs->_sizeStorer)
+            _rs->_sizeStorer->store(_rs->_uri, _rs->_sizeInfo);
     }
 
+    int64_t numRecordsDiff = 0;
+    int64_t dataSizeDiff = 0;
+
 private:
-    WiredTigerRecordStore* _rs;
-    int64_t _diff;
+    WiredTigerRecordStore* const _rs;
 };
 
+WiredTigerRecordStore::SizeChange* WiredTigerRecordStore::_getSizeChange(
+    OperationContext* opCtx) {
+    WiredTigerRecoveryUnit* ru = _getRecoveryUnit(opCtx);
+    if (auto change = ru->getKeyedChange(this))
+        return checked_cast<SizeChange*>(change);
+
+    auto change = new SizeChange(this);
+    ru->registerKeyedChange(this, change);
+    return change;
+}
+
 void WiredTigerRecordStore::_changeNumRecords(OperationContext* opCtx, int64_t diff) {
     if (!sizeRecoveryState(getGlobalServiceContext()).collectionNeedsSizeAdjustment(_uri)) {
         return;
     }
 
-    opCtx->recoveryUnit()->registerChange(new NumRecordsChange(this, diff));
+    _getSizeChange(opCtx)->numRecordsDiff += diff;
     if (_sizeInfo->numRecords.fetchAndAdd(diff) < 0)
         _sizeInfo->numRecords.store(std::max(diff, int64_t(0)));
 }
 
-class WiredTigerRecordStore::DataSizeChange : public RecoveryUnit::Change {
-public:
-    DataSizeChange(WiredTigerRecordStore* rs, int64_t amount) : _rs(rs), _amount(amount) {}
-    virtual void commit(boost::optional<Timestamp>) {}
-    virtual void rollback() {
-        _rs->_increaseDataSize(NULL, -_amount);
-    }
-
-private:
-    WiredTigerRecordStore* _rs;
-    int64_t _amount;
-};
-
 void WiredTigerRecordStore::_increaseDataSize(OperationContext* opCtx, int64_t amount) {
     if (!sizeRecoveryState(getGlobalServiceContext()).collectionNeedsSizeAdjustment(_uri)) {
         return;
     }
 
-    if (opCtx)
-        opCtx->recoveryUnit()->registerChange(new DataSizeChange(this, amount));
-
+    _getSizeChange(opCtx)->dataSizeDiff += amount;
     if (_sizeInfo->dataSize.fetchAndAdd(amount) < 0)
         _sizeInfo->dataSize.store(std::max(amount, int64_t(0)));
-
-    if (_sizeStorer)
-        _sizeStorer->store(_uri, _sizeInfo);
 }
 
 void WiredTigerRecordStore::cappedTruncateAfter(OperationContext* opCtx,
@@ -156,6 +156,8 @@ public:
                                               size_t nDocs,
                                               RecordId* idsOut);
 
+    std::unique_ptr<RecordStoreBulkBuilder> getBulkBuilder(OperationContext* opCtx) override;
+
     virtual Status updateRecord(OperationContext* opCtx,
                                 const RecordId& oldLocation,
                                 const char* data,
@@ -287,10 +289,10 @@ protected:
     virtual void setKey(WT_CURSOR* cursor, RecordId id) const = 0;
 
 private:
+    class BulkBuilder;
     class RandomCursor;
 
-    class NumRecordsChange;
-    class DataSizeChange;
+    class SizeChange;
 
     static WiredTigerRecoveryUnit* _getRecoveryUnit(OperationContext* opCtx);
 
@@ -330,10 +332,19 @@ private:
      *      of zero and will discard all cached size metadata. This assumption is incorrect if there
      *      are pending writes to this ident as part of the recovery process, and so we must
      *      always adjust size metadata for these idents.
+     *
+     * Both must be called inside a unit of work. The adjustments take effect immediately and are
+     * collected in a single SizeChange per unit of work, which undoes them on rollback and passes
+     * the new sizes to the size storer on commit.
      */
     void _changeNumRecords(OperationContext* opCtx, int64_t diff);
     void _increaseDataSize(OperationContext* opCtx, int64_t amount);
 
+    /**
+     * Returns the SizeChange of the current unit of work, registering it on first use.
+     */
+    SizeChange* _getSizeChange(OperationContext* opCtx);
+
     /**
      * Delete records from this record store as needed while _cappedMaxSize or _cappedMaxDocs is
      * exceeded.
@@ -343,6 +354,13 @@ private:
     int64_t _cappedDeleteAsNeeded(OperationContext* opCtx, const RecordId& justInserted);
     int64_t _cappedDeleteAsNeeded_inlock(OperationContext* opCtx, const RecordId& justInserted);
 
+    /**
+     * Truncates the oldest stones of a capped collection, other than the oplog, that has stones,
+     * while its stones exceed the collection's maximum size. Documents are removed in bounded
+     * batches, each in its own side transaction. Returns the number of records removed.
+     */
+    int64_t _cappedDeleteOldestStone_inlock(OperationContext* opCtx, const RecordId& justInserted);
+
     const std::string _uri;
     const uint64_t _tableId;  // not persisted
 
@@ -374,7 +392,8 @@ private:
     std::shared_ptr<WiredTigerSizeStorer::SizeInfo> _sizeInfo;
     WiredTigerKVEngine* _kvEngine;  // not owned.
 
-    // Non-null if this record store is underlying the active oplog.
+    // Non-null if this record store is underlying the active oplog, or is a large capped
+    // collection without a maximum document count.
     std::shared_ptr<OplogStones> _oplogStones;
 };
 
@@ -414,6 +433,13 @@ public:
         return _prefix;
     }
 
+    /**
+     * Bulk cursors require an empty table, and a prefixed table is shared with other collections.
+     */
+    std::unique_ptr<RecordStoreBulkBuilder> getBulkBuilder(OperationContext* opCtx) override {
+        return nullptr;
+    }
+
 protected:
     virtual RecordId getKey(WT_CURSOR* cursor) const;
 
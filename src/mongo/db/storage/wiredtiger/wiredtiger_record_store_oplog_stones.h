@@ -42,7 +42,9 @@ class OperationContext;
 class RecordId;
 
 // Keep "milestones" against the oplog to efficiently remove the old records when the collection
-// grows beyond its desired maximum size.
+// grows beyond its desired maximum size. Large capped collections without a maximum document count
+// use them too, but truncate their excess stones as part of inserts rather than on a background
+// thread.
 class WiredTigerRecordStore::OplogStones {
 public:
     struct Stone {
@@ -40,8 +40,12 @@
 #include "mongo/db/concurrency/write_conflict_exception.h"
 #include "mongo/db/json.h"
 #include "mongo/db/operation_context_noop.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/db/storage/capped_callback.h"
 #include "mongo/db/storage/kv/kv_prefix.h"
 #include "mongo/db/storage/record_store_test_harness.h"
+#include "mongo/db/storage/wiredtiger/wiredtiger_kv_engine.h"
+#include "mongo/db/storage/wiredtiger/wiredtiger_oplog_manager.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_record_store.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_record_store_oplog_stones.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_recovery_unit.h"
@@ -350,6 +354,36 @@ TEST(WiredTigerRecordStoreTest, OplogDurableVisibilityOutOfOrder) {
     ASSERT(!wtrs->isOpHidden_forTest(id2));
 }
 
+// Test that waiting for an oplog write to become visible publishes it, and that the time it took
+// is recorded in the oplog manager's statistics.
+TEST(WiredTigerRecordStoreTest, OplogVisibilityLatencyIsRecorded) {
+    unique_ptr<RecordStoreHarnessHelper> harnessHelper(newRecordStoreHarnessHelper());
+    unique_ptr<RecordStore> rs(harnessHelper->newCappedRecordStore("local.oplog.rs", 100000, -1));
+    auto wtrs = checked_cast<WiredTigerRecordStore*>(rs.get());
+
+    ServiceContext::UniqueOperationContext opCtx(harnessHelper->newOperationContext());
+    WiredTigerKVEngine* engine =
+        WiredTigerRecoveryUnit::get(opCtx.get())->getSessionCache()->getKVEngine();
+    WiredTigerOplogManager* oplogManager = engine->getOplogManager();
+    auto getVisibilityUpdates = [&] {
+        BSONObjBuilder bob;
+        oplogManager->appendStats(&bob);
+        return bob.obj()["oplog visibility"]["read timestamp updates"].numberLong();
+    };
+    const long long updatesBefore = getVisibilityUpdates();
+
+    RecordId id;
+    {
+        WriteUnitOfWork uow(opCtx.get());
+        id = _oplogOrderInsertOplog(opCtx.get(), rs, 1);
+        uow.commit();
+    }
+
+    rs->waitForAllEarlierOplogWritesToBeVisible(opCtx.get());
+    ASSERT(!wtrs->isOpHidden_forTest(id));
+    ASSERT_GT(getVisibilityUpdates(), updatesBefore);
+}
+
 TEST(WiredTigerRecordStoreTest, AppendCustomStatsMetadata) {
     std::unique_ptr<RecordStoreHarnessHelper> harnessHelper = newRecordStoreHarnessHelper();
     unique_ptr<RecordStore> rs(harnessHelper->newNonCappedRecordStore("a.b"));
@@ -866,5 +900,156 @@ TEST(WiredTigerRecordStoreTest, OplogStones_AscendingOrder) {
     }
 }
 
+// Sets wiredTigerCappedCollectionStonesMinSizeBytes for the lifetime of this object.
+class CappedCollectionStonesMinSizeGuard {
+public:
+    explicit CappedCollectionStonesMinSizeGuard(long long minSizeBytes)
+        : _param(ServerParameterSet::getGlobal()
+                     ->getMap()
+                     .find("wiredTigerCappedCollectionStonesMinSizeBytes")
+                     ->second) {
+        BSONObjBuilder originalValue;
+        _param->append(nullptr, originalValue, "value");
+        _originalValue = originalValue.obj()["value"].numberLong();
+        ASSERT_OK(_param->setFromString(std::to_string(minSizeBytes)));
+    }
+
+    ~CappedCollectionStonesMinSizeGuard() {
+        invariant(_param->setFromString(std::to_string(_originalValue)).isOK());
+    }
+
+private:
+    ServerParameter* _param;
+    long long _originalValue;
+};
+
+// Fails every capped deletion with a write conflict while 'conflict' is set.
+class ConflictingCappedCallback final : public CappedCallback {
+public:
+    Status aboutToDeleteCapped(OperationContext* opCtx, const RecordId& loc, RecordData data) {
+        if (conflict) {
+            throw WriteConflictException();
+        }
+        return Status::OK();
+    }
+
+    bool haveCappedWaiters() {
+        return false;
+    }
+
+    void notifyCappedWaitersIfNeeded() {}
+
+    bool conflict = false;
+};
+
+// Insert records into a large capped collection other than the oplog, and verify that an insert
+// which finds the stones over the collection's maximum size truncates the oldest stone.
+TEST(WiredTigerRecordStoreTest, CappedCollectionStones_TruncateOldestStone) {
+    CappedCollectionStonesMinSizeGuard minSizeGuard(1000);
+
+    std::unique_ptr<RecordStoreHarnessHelper> harnessHelper = newRecordStoreHarnessHelper();
+
+    const int64_t cappedMaxSize = 1000;
+    unique_ptr<RecordStore> rs(harnessHelper->newCappedRecordStore("a.b", cappedMaxSize, -1));
+
+    WiredTigerRecordStore* wtrs = static_cast<WiredTigerRecordStore*>(rs.get());
+    WiredTigerRecordStore::OplogStones* stones = wtrs->oplogStones();
+    ASSERT(stones);
+
+    stones->setMinBytesPerStone(100);
+
+    ServiceContext::UniqueOperationContext opCtx(harnessHelper->newOperationContext());
+    auto insertRecordWithSize = [&](int size) {
+        BSONObj obj = makeBSONObjWithSize(Timestamp(1, 1), size);
+        WriteUnitOfWork wuow(opCtx.get());
+        StatusWith<RecordId> res =
+            rs->insertRecord(opCtx.get(), obj.objdata(), obj.objsize(), Timestamp());
+        ASSERT_OK(res.getStatus());
+        wuow.commit();
+        return res.getValue();
+    };
+
+    // Ten stones holding exactly the maximum size are not in excess.
+    for (int i = 1; i <= 10; ++i) {
+        ASSERT_EQ(RecordId(i), insertRecordWithSize(100));
+    }
+    ASSERT_EQ(10U, stones->numStones());
+    ASSERT_EQ(10, rs->numRecords(opCtx.get()));
+
+    // The insert that creates the eleventh stone only does so on commit, so nothing is removed yet.
+    ASSERT_EQ(RecordId(11), insertRecordWithSize(100));
+    ASSERT_EQ(11U, stones->numStones());
+    ASSERT_EQ(11, rs->numRecords(opCtx.get()));
+
+    // The next insert truncates the oldest stone.
+    ASSERT_EQ(RecordId(12), insertRecordWithSize(100));
+    ASSERT_EQ(11U, stones->numStones());
+    ASSERT_EQ(11, rs->numRecords(opCtx.get()));
+    ASSERT_EQ(1100, rs->dataSize(opCtx.get()));
+
+    auto cursor = rs->getCursor(opCtx.get());
+    auto record = cursor->next();
+    ASSERT(record);
+    ASSERT_EQ(RecordId(2), record->id);
+}
+
+// Verify that inserts which conflict while truncating a capped collection's stones leave them for a
+// later insert, which then brings the collection back within its maximum size.
+TEST(WiredTigerRecordStoreTest, CappedCollectionStones_TruncateAfterWriteConflict) {
+    CappedCollectionStonesMinSizeGuard minSizeGuard(1000);
+
+    std::unique_ptr<RecordStoreHarnessHelper> harnessHelper = newRecordStoreHarnessHelper();
+
+    const int64_t cappedMaxSize = 1000;
+    unique_ptr<RecordStore> rs(harnessHelper->newCappedRecordStore("a.b", cappedMaxSize, -1));
+
+    WiredTigerRecordStore* wtrs = static_cast<WiredTigerRecordStore*>(rs.get());
+    WiredTigerRecordStore::OplogStones* stones = wtrs->oplogStones();
+    ASSERT(stones);
+
+    stones->setMinBytesPerStone(100);
+
+    ConflictingCappedCallback cappedCallback;
+    rs->setCappedCallback(&cappedCallback);
+
+    ServiceContext::UniqueOperationContext opCtx(harnessHelper->newOperationContext());
+    auto insertRecordWithSize = [&](int size) {
+        BSONObj obj = makeBSONObjWithSize(Timestamp(1, 1), size);
+        WriteUnitOfWork wuow(opCtx.get());
+        StatusWith<RecordId> res =
+            rs->insertRecord(opCtx.get(), obj.objdata(), obj.objsize(), Timestamp());
+        ASSERT_OK(res.getStatus());
+        wuow.commit();
+        return res.getValue();
+    };
+
+    for (int i = 1; i <= 11; ++i) {
+        ASSERT_EQ(RecordId(i), insertRecordWithSize(100));
+    }
+    ASSERT_EQ(11U, stones->numStones());
+    ASSERT_EQ(11, rs->numRecords(opCtx.get()));
+
+    // Inserts which conflict while truncating still succeed, but remove nothing.
+    cappedCallback.conflict = true;
+    ASSERT_EQ(RecordId(12), insertRecordWithSize(100));
+    ASSERT_EQ(RecordId(13), insertRecordWithSize(100));
+    ASSERT_EQ(13U, stones->numStones());
+    ASSERT_EQ(13, rs->numRecords(opCtx.get()));
+
+    // The next insert without a conflict truncates every stone in excess.
+    cappedCallback.conflict = false;
+    ASSERT_EQ(RecordId(14), insertRecordWithSize(100));
+    ASSERT_EQ(11U, stones->numStones());
+    ASSERT_EQ(11, rs->numRecords(opCtx.get()));
+    ASSERT_EQ(1100, rs->dataSize(opCtx.get()));
+
+    auto cursor = rs->getCursor(opCtx.get());
+    auto record = cursor->next();
+    ASSERT(record);
+    ASSERT_EQ(RecordId(4), record->id);
+
+    rs->setCappedCallback(nullptr);
+}
+
 }  // namespace
 }  // namespace mongo
@@ -101,6 +101,7 @@ void WiredTigerRecoveryUnit::_commit() {
             (*it)->commit(commitTime);
         }
         _changes.clear();
+        _keyedChanges.clear();
 
         invariant(!_active);
     } catch (...) {
@@ -131,6 +132,7 @@ void WiredTigerRecoveryUnit::_abort() {
             change->rollback();
         }
         _changes.clear();
+        _keyedChanges.clear();
 
         invariant(!_active);
     } catch (...) {
@@ -201,6 +203,21 @@ void WiredTigerRecoveryUnit::registerChange(Change* change) {
     _changes.push_back(std::unique_ptr<Change>{change});
 }
 
+void WiredTigerRecoveryUnit::registerKeyedChange(const void* key, Change* change) {
+    invariant(!getKeyedChange(key));
+    registerChange(change);
+    _keyedChanges.emplace_back(key, change);
+}
+
+RecoveryUnit::Change* WiredTigerRecoveryUnit::getKeyedChange(const void* key) const {
+    for (const auto& keyedChange : _keyedChanges) {
+        if (keyedChange.first == key) {
+            return keyedChange.second;
+        }
+    }
+    return nullptr;
+}
+
 void WiredTigerRecoveryUnit::assertInActiveTxn() const {
     fassert(28575, _active);
 }
@@ -33,6 +33,7 @@
 #include <boost/optional.hpp>
 #include <cstdint>
 #include <memory>
+#include <utility>
 #include <vector>
 
 #include "mongo/base/checked_cast.h"
@@ -74,6 +75,18 @@ public:
 
     void registerChange(Change* change) override;
 
+    /**
+     * Registers 'change' like registerChange(), and remembers it under 'key' until the unit of work
+     * commits or aborts. Callers which adjust the same object many times in one unit of work use
+     * this with getKeyedChange() to register a single change for it, rather than one per update.
+     */
+    void registerKeyedChange(const void* key, Change* change);
+
+    /**
+     * Returns the change registered under 'key' in the current unit of work, or nullptr.
+     */
+    Change* getKeyedChange(const void* key) const;
+
     void abandonSnapshot() override;
     void preallocateSnapshot() override;
 
@@ -177,6 +190,9 @@ private:
     bool _isOplogReader = false;
     typedef std::vector<std::unique_ptr<Change>> Changes;
     Changes _changes;
+    // Changes in '_changes' registered through registerKeyedChange(). A unit of work rarely
+    // touches more than a handful of keys, so this is searched linearly.
+    std::vector<std::pair<const void*, Change*>> _keyedChanges;
 };
 
 /**
@@ -37,6 +37,7 @@
 #include "mongo/db/storage/wiredtiger/wiredtiger_record_store.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_session_cache.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_util.h"
+#include "mongo/stdx/thread.h"
 #include "mongo/unittest/temp_dir.h"
 #include "mongo/unittest/unittest.h"
 #include "mongo/util/clock_source_mock.h"
@@ -529,5 +530,40 @@ TEST_F(WiredTigerRecoveryUnitTestFixture, CommitTimestampAfterSetTimestampOnAbor
     ASSERT(!commitTs);
 }
 
+TEST_F(WiredTigerRecoveryUnitTestFixture, SessionCacheReusesSessionsReleasedOnOtherThreads) {
+    WiredTigerSessionCache* sessionCache = ru1->getSessionCache();
+    auto getStats = [&] {
+        BSONObjBuilder bob;
+        sessionCache->appendStats(&bob);
+        return bob.obj()["session cache"].Obj().getOwned();
+    };
+
+    // Release a session into the cache from one thread.
+    stdx::thread([&] { sessionCache->getSession(); }).join();
+    const long long sessionsOpened = getStats()["sessions opened"].numberLong();
+    ASSERT_GTE(getStats()["sessions cached"].numberLong(), 1);
+
+    // A thread with any home shard reuses it rather than opening a new session, and its cursor
+    // cache hits and misses are counted once the session is released.
+    const BSONObj before = getStats();
+    stdx::thread([&] {
+        UniqueWiredTigerSession session = sessionCache->getSession();
+        const uint64_t id = WiredTigerSession::kMetadataTableId;
+        WT_CURSOR* cursor = session->getCursor("metadata:", id, false);
+        ASSERT(cursor);
+        session->releaseCursor(id, cursor);
+        cursor = session->getCursor("metadata:", id, false);
+        ASSERT(cursor);
+        session->releaseCursor(id, cursor);
+    }).join();
+
+    const BSONObj after = getStats();
+    ASSERT_EQ(sessionsOpened, after["sessions opened"].numberLong());
+    ASSERT_EQ(before["cursor cache hits"].numberLong() + 1,
+              after["cursor cache hits"].numberLong());
+    ASSERT_EQ(before["cursor cache misses"].numberLong() + 1,
+              after["cursor cache misses"].numberLong());
+}
+
 }  // namespace
 }  // namespace mongo
@@ -35,7 +35,10 @@
 
 #include "mongo/db/storage/wiredtiger/wiredtiger_session_cache.h"
 
+#include <algorithm>
+
 #include "mongo/base/error_codes.h"
+#include "mongo/bson/bsonobjbuilder.h"
 #include "mongo/db/global_settings.h"
 #include "mongo/db/repl/repl_settings.h"
 #include "mongo/db/server_parameters.h"
@@ -45,6 +48,7 @@
 #include "mongo/stdx/memory.h"
 #include "mongo/stdx/thread.h"
 #include "mongo/util/log.h"
+#include "mongo/util/processinfo.h"
 #include "mongo/util/scopeguard.h"
 
 namespace mongo {
@@ -116,10 +120,13 @@ WT_CURSOR* WiredTigerSession::getCursor(const std::string& uri, uint64_t id, boo
             WT_CURSOR* c = i->_cursor;
             _cursors.erase(i);
             _cursorsOut++;
+            _cursorCacheHits++;
             return c;
         }
     }
 
+    _cursorCacheMisses++;
+
     WT_CURSOR* c = NULL;
     int ret = _session->open_cursor(
         _session, uri.c_str(), NULL, forRecordStore ? "" : "overwrite=false", &c);
@@ -192,11 +199,37 @@ uint64_t WiredTigerSession::genTableId() {
 
 // -----------------------
 
+namespace {
+
+const size_t kMaxSessionShards = 64;
+
+// Hands out home shards to threads round-robin, so that threads spread evenly over the shards.
+AtomicUInt32 nextHomeShard;
+
+// One more than the index returned by nextHomeShard for this thread, or 0 if not yet assigned.
+thread_local uint32_t threadHomeShard = 0;
+
+// One shard per available core, so that in the common case each running thread has its own.
+size_t numSessionShards() {
+    return std::min<size_t>(std::max<size_t>(ProcessInfo::getNumAvailableCores(), 1),
+                            kMaxSessionShards);
+}
+
+}  // namespace
+
 WiredTigerSessionCache::WiredTigerSessionCache(WiredTigerKVEngine* engine)
-    : _engine(engine), _conn(engine->getConnection()), _shuttingDown(0) {}
+    : _engine(engine), _conn(engine->getConnection()), _shuttingDown(0) {
+    for (size_t i = 0; i < numSessionShards(); ++i) {
+        _shards.push_back(stdx::make_unique<SessionShard>());
+    }
+}
 
 WiredTigerSessionCache::WiredTigerSessionCache(WT_CONNECTION* conn)
-    : _engine(NULL), _conn(conn), _shuttingDown(0) {}
+    : _engine(NULL), _conn(conn), _shuttingDown(0) {
+    for (size_t i = 0; i < numSessionShards(); ++i) {
+        _shards.push_back(stdx::make_unique<SessionShard>());
+    }
+}
 
 WiredTigerSessionCache::~WiredTigerSessionCache() {
     shuttingDown();
@@ -316,9 +349,11 @@ void WiredTigerSessionCache::notifyPreparedUnitOfWorkHasCommittedOrAborted() {
 
 
 void WiredTigerSessionCache::closeAllCursors(const std::string& uri) {
-    stdx::lock_guard<stdx::mutex> lock(_cacheLock);
-    for (SessionCache::iterator i = _sessions.begin(); i != _sessions.end(); i++) {
-        (*i)->closeAllCursors(uri);
+    for (auto&& shard : _shards) {
+        stdx::lock_guard<stdx::mutex> lock(shard->lock);
+        for (SessionCache::iterator i = shard->sessions.begin(); i != shard->sessions.end(); i++) {
+            (*i)->closeAllCursors(uri);
+        }
     }
 }
 
@@ -326,24 +361,31 @@ void WiredTigerSessionCache::closeCursorsForQueuedDrops() {
     // Increment the cursor epoch so that all cursors from this epoch are closed.
     _cursorEpoch.fetchAndAdd(1);
 
-    stdx::lock_guard<stdx::mutex> lock(_cacheLock);
-    for (SessionCache::iterator i = _sessions.begin(); i != _sessions.end(); i++) {
-        (*i)->closeCursorsForQueuedDrops(_engine);
+    for (auto&& shard : _shards) {
+        stdx::lock_guard<stdx::mutex> lock(shard->lock);
+        for (SessionCache::iterator i = shard->sessions.begin(); i != shard->sessions.end(); i++) {
+            (*i)->closeCursorsForQueuedDrops(_engine);
+        }
     }
 }
 
 void WiredTigerSessionCache::closeAll() {
     // Increment the epoch as we are now closing all sessions with this epoch.
-    SessionCache swap;
+    // A session released concurrently either sees the new epoch and is deleted by its releaser,
+    // or is pushed into a shard before that shard is emptied below.
+    _epoch.fetchAndAdd(1);
 
-    {
-        stdx::lock_guard<stdx::mutex> lock(_cacheLock);
-        _epoch.fetchAndAdd(1);
-        _sessions.swap(swap);
-    }
+    for (auto&& shard : _shards) {
+        SessionCache swap;
 
-    for (SessionCache::iterator i = swap.begin(); i != swap.end(); i++) {
-        delete (*i);
+        {
+            stdx::lock_guard<stdx::mutex> lock(shard->lock);
+            shard->sessions.swap(swap);
+        }
+
+        for (SessionCache::iterator i = swap.begin(); i != swap.end(); i++) {
+            delete (*i);
+        }
     }
 }
 
@@ -356,18 +398,36 @@ UniqueWiredTigerSession WiredTigerSessionCache::getSession() {
     // operations should be allowed to start.
     invariant(!(_shuttingDown.loadRelaxed() & kShuttingDownMask));
 
+    SessionShard& homeShard = _getHomeShard();
     {
-        stdx::lock_guard<stdx::mutex> lock(_cacheLock);
-        if (!_sessions.empty()) {
+        stdx::lock_guard<stdx::mutex> lock(homeShard.lock);
+        if (!homeShard.sessions.empty()) {
             // Get the most recently used session so that if we discard sessions, we're
             // discarding older ones
-            WiredTigerSession* cachedSession = _sessions.back();
-            _sessions.pop_back();
+            WiredTigerSession* cachedSession = homeShard.sessions.back();
+            homeShard.sessions.pop_back();
+            return UniqueWiredTigerSession(cachedSession);
+        }
+    }
+
+    // Our home shard is empty, so steal a session released by a thread with another home shard
+    // before paying for a new one. Otherwise the cache would grow to hold idle sessions in every
+    // shard.
+    for (auto&& shard : _shards) {
+        if (shard.get() == &homeShard)
+            continue;
+
+        stdx::lock_guard<stdx::mutex> lock(shard->lock);
+        if (!shard->sessions.empty()) {
+            WiredTigerSession* cachedSession = shard->sessions.back();
+            shard->sessions.pop_back();
+            shard->sessionsStolen++;
             return UniqueWiredTigerSession(cachedSession);
         }
     }
 
     // Outside of the cache partition lock, but on release will be put back on the cache
+    _sessionsOpened.fetchAndAdd(1);
     return UniqueWiredTigerSession(
         new WiredTigerSession(_conn, this, _epoch.load(), _cursorEpoch.load()));
 }
@@ -420,14 +480,27 @@ void WiredTigerSessionCache::releaseSession(WiredTigerSession* session) {
     // session cache.
     session->dropQueuedIdentsAtSessionEndAllowed(true);
 
-    if (session->_getEpoch() == currentEpoch) {  // check outside of lock to reduce contention
-        stdx::lock_guard<stdx::mutex> lock(_cacheLock);
-        if (session->_getEpoch() == _epoch.load()) {  // recheck inside the lock for correctness
+    const uint64_t cursorCacheHits = session->_cursorCacheHits;
+    const uint64_t cursorCacheMisses = session->_cursorCacheMisses;
+    session->_cursorCacheHits = 0;
+    session->_cursorCacheMisses = 0;
+
+    SessionShard& homeShard = _getHomeShard();
+    {
+        stdx::lock_guard<stdx::mutex> lock(homeShard.lock);
+        homeShard.cursorCacheHits += cursorCacheHits;
+        homeShard.cursorCacheMisses += cursorCacheMisses;
+
+        // The check outside of the lock above is only an optimization for the common case, the
+        // recheck inside the lock is needed for correctness.
+        if (session->_getEpoch() == currentEpoch && session->_getEpoch() == _epoch.load()) {
             returnedToCache = true;
-            _sessions.push_back(session);
+            homeShard.sessions.push_back(session);
         }
-    } else
-        invariant(session->_getEpoch() < currentEpoch);
+    }
+
+    if (!returnedToCache)
+        invariant(session->_getEpoch() < _epoch.load());
 
     if (!returnedToCache)
         delete session;
@@ -437,6 +510,36 @@ void WiredTigerSessionCache::releaseSession(WiredTigerSession* session) {
 }
 
 
+WiredTigerSessionCache::SessionShard& WiredTigerSessionCache::_getHomeShard() {
+    if (!threadHomeShard) {
+        threadHomeShard = nextHomeShard.fetchAndAdd(1) % kMaxSessionShards + 1;
+    }
+    return *_shards[(threadHomeShard - 1) % _shards.size()];
+}
+
+void WiredTigerSessionCache::appendStats(BSONObjBuilder* builder) {
+    long long sessionsCached = 0;
+    long long sessionsStolen = 0;
+    long long cursorCacheHits = 0;
+    long long cursorCacheMisses = 0;
+    for (auto&& shard : _shards) {
+        stdx::lock_guard<stdx::mutex> lock(shard->lock);
+        sessionsCached += shard->sessions.size();
+        sessionsStolen += shard->sessionsStolen;
+        cursorCacheHits += shard->cursorCacheHits;
+        cursorCacheMisses += shard->cursorCacheMisses;
+    }
+
+    BSONObjBuilder bob(builder->subobjStart("session cache"));
+    bob.append("shards", static_cast<int>(_shards.size()));
+    bob.append("sessions opened", static_cast<long long>(_sessionsOpened.load()));
+    bob.append("sessions cached", sessionsCached);
+    bob.append("sessions taken from other shards", sessionsStolen);
+    bob.append("cursor cache hits", cursorCacheHits);
+    bob.append("cursor cache misses", cursorCacheMisses);
+    bob.done();
+}
+
 void WiredTigerSessionCache::setJournalListener(JournalListener* jl) {
     stdx::unique_lock<stdx::mutex> lk(_journalListenerMutex);
     _journalListener = jl;
@@ -32,7 +32,9 @@
 #pragma once
 
 #include <list>
+#include <memory>
 #include <string>
+#include <vector>
 
 #include <wiredtiger.h>
 
@@ -44,6 +46,7 @@
 
 namespace mongo {
 
+class BSONObjBuilder;
 class WiredTigerKVEngine;
 class WiredTigerSessionCache;
 
@@ -146,6 +149,10 @@ private:
     CursorCache _cursors;            // owned
     uint64_t _cursorGen;
     int _cursorsOut;
+    // Counts of getCursor calls served from, or missing, _cursors. Folded into the session
+    // cache's statistics when the session is released.
+    uint64_t _cursorCacheHits = 0;
+    uint64_t _cursorCacheMisses = 0;
     bool _dropQueuedIdentsAtSessionEnd = true;
 };
 
@@ -252,6 +259,12 @@ public:
         return _engine;
     }
 
+    /**
+     * Appends statistics about session reuse and cursor caching for the serverStatus output.
+     * Cursor cache counts only include sessions which have been released back to the cache.
+     */
+    void appendStats(BSONObjBuilder* builder);
+
 private:
     WiredTigerKVEngine* _engine;  // not owned, might be NULL
     WT_CONNECTION* _conn;         // not owned
@@ -263,9 +276,28 @@ private:
     AtomicUInt32 _shuttingDown;
     static const uint32_t kShuttingDownMask = 1 << 31;
 
-    stdx::mutex _cacheLock;
     typedef std::vector<WiredTigerSession*> SessionCache;
-    SessionCache _sessions;
+
+    /**
+     * Released sessions are spread over several independently locked shards, so that concurrent
+     * calls to getSession and releaseSession rarely contend on the same mutex. Each thread is
+     * assigned a home shard; it takes sessions from other shards only when its own is empty.
+     */
+    struct SessionShard {
+        stdx::mutex lock;
+        SessionCache sessions;  // Protected by 'lock'.
+
+        // Statistics, protected by 'lock'.
+        uint64_t sessionsStolen = 0;
+        uint64_t cursorCacheHits = 0;
+        uint64_t cursorCacheMisses = 0;
+    };
+
+    // Shards are allocated separately to keep their mutexes on different cache lines.
+    std::vector<std::unique_ptr<SessionShard>> _shards;
+
+    // Total number of WT sessions opened by this cache.
+    AtomicUInt64 _sessionsOpened;
 
     // Bumped when all open sessions need to be closed
     AtomicUInt64 _epoch;  // atomic so we can check it outside of the lock
@@ -290,6 +322,11 @@ private:
     WT_SESSION* _waitUntilDurableSession = nullptr;  // owned, and never explicitly closed
                                                      // (uses connection close to clean up)
 
+    /**
+     * Returns the shard the calling thread takes sessions from and releases them to.
+     */
+    SessionShard& _getHomeShard();
+
     /**
      * Returns a session to the cache for later reuse. If closeAll was called between getting this
      * session and releasing it, the session is directly released. This method is thread safe.
@@ -37,6 +37,7 @@
 
 #include "mongo/bson/bsonobj.h"
 #include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/service_context.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_begin_transaction_block.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_customization_hooks.h"
@@ -49,6 +50,21 @@
 
 namespace mongo {
 
+namespace {
+
+// Number of records which stores may insert or remove before the size storer asks to be flushed
+// ahead of the periodic flush. Zero disables flushing on this count.
+MONGO_EXPORT_SERVER_PARAMETER(wiredTigerSizeStorerFlushRecordsThreshold, long long, 100 * 1000)
+    ->withValidator([](const long long& potentialNewValue) {
+        if (potentialNewValue < 0) {
+            return Status(ErrorCodes::BadValue,
+                          "wiredTigerSizeStorerFlushRecordsThreshold must be non-negative");
+        }
+        return Status::OK();
+    });
+
+}  // namespace
+
 WiredTigerSizeStorer::WiredTigerSizeStorer(WT_CONNECTION* conn,
                                            const std::string& storageUri,
                                            bool readOnly)
@@ -70,9 +86,17 @@ WiredTigerSizeStorer::~WiredTigerSizeStorer() {
     _cursor->close(_cursor);
 }
 
-void WiredTigerSizeStorer::store(StringData uri, std::shared_ptr<SizeInfo> sizeInfo) {
+void WiredTigerSizeStorer::store(StringData uri,
+                                 std::shared_ptr<SizeInfo> sizeInfo,
+                                 int64_t numRecordsChanged) {
+    if (_readOnly)
+        return;
+
+    if (numRecordsChanged)
+        _numRecordsChangedSinceFlush.fetchAndAdd(numRecordsChanged);
+
     // If the SizeInfo is still dirty, we're done.
-    if (sizeInfo->_dirty.load() || _readOnly)
+    if (sizeInfo->_dirty.load())
         return;
 
     // Ordering is important: as the entry may be flushed concurrently, set the dirty flag last.
@@ -89,6 +113,11 @@ void WiredTigerSizeStorer::store(StringData uri, std::shared_ptr<SizeInfo> sizeI
            << ", dataSize: " << sizeInfo->dataSize.load() << ", use_count: " << entry.use_count();
 }
 
+bool WiredTigerSizeStorer::flushIsDue() const {
+    const long long threshold = wiredTigerSizeStorerFlushRecordsThreshold.load();
+    return threshold > 0 && _numRecordsChangedSinceFlush.load() >= threshold;
+}
+
 std::shared_ptr<WiredTigerSizeStorer::SizeInfo> WiredTigerSizeStorer::load(StringData uri) const {
     {
         // Check if we can satisfy the read from the buffer.
@@ -129,6 +158,7 @@ void WiredTigerSizeStorer::flush(bool syncToDisk) {
     {
         stdx::lock_guard<stdx::mutex> bufferLock(_bufferMutex);
         _buffer.swap(buffer);
+        _numRecordsChangedSinceFlush.store(0);
     }
 
     if (buffer.empty())
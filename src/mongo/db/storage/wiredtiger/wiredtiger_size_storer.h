@@ -83,8 +83,17 @@ public:
     /**
      * Ensure that the shared SizeInfo will be stored by the next call to flush.
      * Values stored are no older than the values at time of this call, but may be newer.
+     * 'numRecordsChanged' is the number of records inserted or removed since the last store of
+     * this SizeInfo, and counts towards flushIsDue().
      */
-    void store(StringData uri, std::shared_ptr<SizeInfo> sizeInfo);
+    void store(StringData uri, std::shared_ptr<SizeInfo> sizeInfo, int64_t numRecordsChanged = 0);
+
+    /**
+     * Returns true once the stores since the last flush have together inserted or removed at least
+     * wiredTigerSizeStorerFlushRecordsThreshold records, so that the sizes after a large bulk write
+     * are written back without waiting for the periodic flush.
+     */
+    bool flushIsDue() const;
 
     std::shared_ptr<SizeInfo> load(StringData uri) const;
 
@@ -104,5 +113,8 @@ private:
 
     mutable stdx::mutex _bufferMutex;  // Guards _buffer
     Buffer _buffer;
+
+    // Records inserted or removed by the stores since the last flush.
+    AtomicInt64 _numRecordsChangedSinceFlush;
 };
 }
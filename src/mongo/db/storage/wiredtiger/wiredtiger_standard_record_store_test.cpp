@@ -42,6 +42,7 @@
 #include "mongo/db/operation_context_noop.h"
 #include "mongo/db/repl/repl_settings.h"
 #include "mongo/db/repl/replication_coordinator_mock.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/service_context.h"
 #include "mongo/db/storage/kv/kv_engine_test_harness.h"
 #include "mongo/db/storage/kv/kv_prefix.h"
@@ -294,6 +295,63 @@ TEST(WiredTigerRecordStoreTest, SizeStorer1) {
     rs.reset(nullptr);  // this has to be deleted before ss
 }
 
+TEST(WiredTigerRecordStoreTest, SizeStorerReceivesOneChangePerUnitOfWork) {
+    unique_ptr<WiredTigerHarnessHelper> harnessHelper(new WiredTigerHarnessHelper());
+    unique_ptr<RecordStore> rs(harnessHelper->newNonCappedRecordStore());
+    WiredTigerRecordStore* wtrs = checked_cast<WiredTigerRecordStore*>(rs.get());
+
+    const bool readOnly = false;
+    WiredTigerSizeStorer ss(harnessHelper->conn(), "table:sizeStorer", readOnly);
+    wtrs->setSizeStorer(&ss);
+    ON_BLOCK_EXIT([&] { rs.reset(); });  // this has to be deleted before ss
+
+    auto thresholdParam = ServerParameterSet::getGlobal()->getMap().find(
+        "wiredTigerSizeStorerFlushRecordsThreshold");
+    ASSERT(thresholdParam != ServerParameterSet::getGlobal()->getMap().end());
+    ASSERT_OK(thresholdParam->second->setFromString("20"));
+    ON_BLOCK_EXIT([&] { invariant(thresholdParam->second->setFromString("100000").isOK()); });
+
+    const int N = 12;
+    auto insertRecords = [&](OperationContext* opCtx) {
+        for (int i = 0; i < N; i++) {
+            ASSERT_OK(rs->insertRecord(opCtx, "a", 2, Timestamp()).getStatus());
+        }
+    };
+
+    {
+        ServiceContext::UniqueOperationContext opCtx(harnessHelper->newOperationContext());
+        WiredTigerRecoveryUnit* ru = WiredTigerRecoveryUnit::get(opCtx.get());
+        {
+            WriteUnitOfWork uow(opCtx.get());
+            insertRecords(opCtx.get());
+            ASSERT(ru->getKeyedChange(wtrs));
+            ASSERT_EQUALS(N, rs->numRecords(opCtx.get()));
+            ASSERT_EQUALS(N * 2, rs->dataSize(opCtx.get()));
+        }
+        ASSERT_FALSE(ru->getKeyedChange(wtrs));
+
+        // The aborted inserts are undone and do not count towards a flush.
+        ASSERT_EQUALS(0, rs->numRecords(opCtx.get()));
+        ASSERT_EQUALS(0, rs->dataSize(opCtx.get()));
+        ASSERT_FALSE(ss.flushIsDue());
+    }
+
+    for (int round = 1; round <= 2; round++) {
+        ServiceContext::UniqueOperationContext opCtx(harnessHelper->newOperationContext());
+        WriteUnitOfWork uow(opCtx.get());
+        insertRecords(opCtx.get());
+        uow.commit();
+
+        ASSERT_EQUALS(round * N, rs->numRecords(opCtx.get()));
+        ASSERT_EQUALS(round * N * 2, rs->dataSize(opCtx.get()));
+        ASSERT_EQUALS(round * N >= 20, ss.flushIsDue());
+    }
+
+    ss.flush(false);
+    ASSERT_FALSE(ss.flushIsDue());
+    ASSERT_EQUALS(2 * N, ss.load(wtrs->getURI())->numRecords.load());
+}
+
 class GoodValidateAdaptor : public ValidateAdaptor {
 public:
     virtual Status validate(const RecordId& recordId, const RecordData& record, size_t* dataSize) {
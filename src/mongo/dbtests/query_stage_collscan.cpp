@@ -35,19 +35,25 @@
 #include "mongo/client/dbclient_cursor.h"
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/catalog/database.h"
+#include "mongo/db/catalog/index_catalog.h"
 #include "mongo/db/client.h"
 #include "mongo/db/db_raii.h"
 #include "mongo/db/dbdirectclient.h"
 #include "mongo/db/exec/collection_scan.h"
+#include "mongo/db/exec/fetch.h"
+#include "mongo/db/exec/index_scan.h"
 #include "mongo/db/exec/plan_stage.h"
+#include "mongo/db/exec/projection.h"
 #include "mongo/db/json.h"
 #include "mongo/db/matcher/expression_parser.h"
 #include "mongo/db/namespace_string.h"
 #include "mongo/db/query/plan_executor.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/storage/record_store.h"
 #include "mongo/dbtests/dbtests.h"
 #include "mongo/stdx/memory.h"
 #include "mongo/util/fail_point_service.h"
+#include "mongo/util/scopeguard.h"
 
 namespace QueryStageCollectionScan {
 
@@ -146,6 +152,28 @@ public:
         return 50;
     }
 
+    /**
+     * Checks that the results of a batch hold the documents with "foo" equal to '*nextFoo',
+     * '*nextFoo' + 'step', and so on, then frees them and advances '*nextFoo' past them. Every
+     * result but the last must hold an owned document, since the cursor which produced it may have
+     * moved on within the batch.
+     */
+    void checkBatchAndFree(WorkingSet* ws,
+                           const vector<WorkingSetID>& batch,
+                           int step,
+                           int* nextFoo) {
+        for (size_t i = 0; i < batch.size(); ++i) {
+            WorkingSetMember* member = ws->get(batch[i]);
+            ASSERT_TRUE(member->hasObj());
+            if (i + 1 < batch.size()) {
+                ASSERT_TRUE(member->obj.value().isOwned());
+            }
+            ASSERT_EQUALS(*nextFoo, member->obj.value()["foo"].numberInt());
+            *nextFoo += step;
+            ws->free(batch[i]);
+        }
+    }
+
 protected:
     const ServiceContext::UniqueOperationContext _txnPtr = cc().makeOperationContext();
     OperationContext& _opCtx = *_txnPtr;
@@ -400,6 +428,163 @@ public:
     }
 };
 
+//
+// Working in batches returns the same RecordIds, in the same order, as working one unit at a time.
+//
+
+class QueryStageCollscanWorkBatchMatchesWork : public QueryStageCollectionScanBase {
+public:
+    void run() {
+        AutoGetCollectionForReadCommand ctx(&_opCtx, nss);
+        Collection* coll = ctx.getCollection();
+
+        vector<RecordId> expected;
+        getRecordIds(coll, CollectionScanParams::FORWARD, &expected);
+
+        CollectionScanParams params;
+        params.collection = coll;
+        params.direction = CollectionScanParams::FORWARD;
+        params.tailable = false;
+
+        WorkingSet ws;
+        unique_ptr<CollectionScan> scan(new CollectionScan(&_opCtx, params, &ws, NULL));
+
+        // Use a batch size which does not divide the number of documents.
+        vector<RecordId> actual;
+        PlanStage::StageState state = PlanStage::NEED_TIME;
+        while (PlanStage::IS_EOF != state) {
+            vector<WorkingSetID> batch;
+            WorkingSetID stateId = WorkingSet::INVALID_ID;
+            state = scan->workBatch(7, &batch, &stateId);
+            ASSERT(PlanStage::NEED_TIME == state || PlanStage::IS_EOF == state);
+            for (auto id : batch) {
+                WorkingSetMember* member = ws.get(id);
+                ASSERT_TRUE(member->hasRecordId());
+                actual.push_back(member->recordId);
+                ws.free(id);
+            }
+        }
+
+        ASSERT_TRUE(scan->isEOF());
+        ASSERT_EQUALS(expected.size(), actual.size());
+        for (size_t i = 0; i < expected.size(); ++i) {
+            ASSERT_EQUALS(expected[i], actual[i]);
+        }
+        ASSERT_EQUALS(static_cast<size_t>(numObj()), scan->getCommonStats()->advanced);
+    }
+};
+
+//
+// The PlanExecutor returns the same results when it works its root stage in batches.
+//
+
+class QueryStageCollscanExecutorWorkBatches : public QueryStageCollectionScanBase {
+public:
+    void run() {
+        const int oldBatchSize = internalQueryExecWorkBatchSize.load();
+        ON_BLOCK_EXIT([&] { internalQueryExecWorkBatchSize.store(oldBatchSize); });
+        internalQueryExecWorkBatchSize.store(16);
+
+        ASSERT_EQUALS(numObj(), countResults(CollectionScanParams::FORWARD, BSONObj()));
+        BSONObj obj = BSON("foo" << BSON("$lt" << 25));
+        ASSERT_EQUALS(25, countResults(CollectionScanParams::BACKWARD, obj));
+    }
+};
+
+//
+// A FetchStage worked in batches over an index scan returns the documents which pass its filter, in
+// index order, and keeps the documents of a batch valid while it fetches the rest of the batch.
+//
+
+class QueryStageCollscanFetchWorkBatch : public QueryStageCollectionScanBase {
+public:
+    void run() {
+        ASSERT_OK(dbtests::createIndex(&_opCtx, nss.ns(), BSON("foo" << 1)));
+
+        AutoGetCollectionForReadCommand ctx(&_opCtx, nss);
+        Collection* coll = ctx.getCollection();
+        std::vector<IndexDescriptor*> indexes;
+        coll->getIndexCatalog()->findIndexesByKeyPattern(
+            &_opCtx, BSON("foo" << 1), false, &indexes);
+        ASSERT_EQ(indexes.size(), 1U);
+
+        IndexScanParams params(&_opCtx, *indexes[0]);
+        params.bounds.isSimpleRange = true;
+        params.bounds.startKey = BSON("" << 0);
+        params.bounds.endKey = BSON("" << numObj());
+        params.bounds.boundInclusion = BoundInclusion::kIncludeStartKeyOnly;
+        params.direction = 1;
+
+        // Only every third document passes the filter.
+        const CollatorInterface* collator = nullptr;
+        const boost::intrusive_ptr<ExpressionContext> expCtx(
+            new ExpressionContext(&_opCtx, collator));
+        StatusWithMatchExpression statusWithMatcher =
+            MatchExpressionParser::parse(BSON("foo" << BSON("$mod" << BSON_ARRAY(3 << 0))), expCtx);
+        ASSERT_OK(statusWithMatcher.getStatus());
+        unique_ptr<MatchExpression> filterExpr = std::move(statusWithMatcher.getValue());
+
+        WorkingSet ws;
+        unique_ptr<FetchStage> fetch = make_unique<FetchStage>(
+            &_opCtx, &ws, new IndexScan(&_opCtx, params, &ws, NULL), filterExpr.get(), coll);
+
+        int nextFoo = 0;
+        PlanStage::StageState state = PlanStage::NEED_TIME;
+        while (PlanStage::IS_EOF != state) {
+            vector<WorkingSetID> batch;
+            WorkingSetID stateId = WorkingSet::INVALID_ID;
+            state = fetch->workBatch(7, &batch, &stateId);
+            ASSERT(PlanStage::NEED_TIME == state || PlanStage::IS_EOF == state);
+            checkBatchAndFree(&ws, batch, 3, &nextFoo);
+        }
+
+        ASSERT_TRUE(fetch->isEOF());
+        ASSERT_EQUALS(51, nextFoo);
+        ASSERT_EQUALS(17U, fetch->getCommonStats()->advanced);
+    }
+};
+
+//
+// A ProjectionStage worked in batches over a collection scan projects every document its child
+// produced in the batch.
+//
+
+class QueryStageCollscanProjectionWorkBatch : public QueryStageCollectionScanBase {
+public:
+    void run() {
+        AutoGetCollectionForReadCommand ctx(&_opCtx, nss);
+
+        CollectionScanParams scanParams;
+        scanParams.collection = ctx.getCollection();
+        scanParams.direction = CollectionScanParams::FORWARD;
+        scanParams.tailable = false;
+
+        ProjectionStageParams projParams;
+        projParams.projObj = BSON("_id" << 0 << "foo" << 1);
+
+        WorkingSet ws;
+        unique_ptr<ProjectionStage> proj = make_unique<ProjectionStage>(
+            &_opCtx, projParams, &ws, new CollectionScan(&_opCtx, scanParams, &ws, NULL));
+
+        int nextFoo = 0;
+        PlanStage::StageState state = PlanStage::NEED_TIME;
+        while (PlanStage::IS_EOF != state) {
+            vector<WorkingSetID> batch;
+            WorkingSetID stateId = WorkingSet::INVALID_ID;
+            state = proj->workBatch(7, &batch, &stateId);
+            ASSERT(PlanStage::NEED_TIME == state || PlanStage::IS_EOF == state);
+            for (auto id : batch) {
+                ASSERT_EQUALS(1, ws.get(id)->obj.value().nFields());
+            }
+            checkBatchAndFree(&ws, batch, 1, &nextFoo);
+        }
+
+        ASSERT_TRUE(proj->isEOF());
+        ASSERT_EQUALS(numObj(), nextFoo);
+        ASSERT_EQUALS(static_cast<size_t>(numObj()), proj->getCommonStats()->advanced);
+    }
+};
+
 class All : public Suite {
 public:
     All() : Suite("QueryStageCollectionScan") {}
@@ -414,6 +599,10 @@ public:
         add<QueryStageCollscanObjectsInOrderBackward>();
         add<QueryStageCollscanInvalidateUpcomingObject>();
         add<QueryStageCollscanInvalidateUpcomingObjectBackward>();
+        add<QueryStageCollscanWorkBatchMatchesWork>();
+        add<QueryStageCollscanExecutorWorkBatches>();
+        add<QueryStageCollscanFetchWorkBatch>();
+        add<QueryStageCollscanProjectionWorkBatch>();
     }
 };
 
@@ -43,8 +43,10 @@
 #include "mongo/db/exec/queued_data_stage.h"
 #include "mongo/db/json.h"
 #include "mongo/db/matcher/expression_parser.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/dbtests/dbtests.h"
 #include "mongo/stdx/memory.h"
+#include "mongo/util/scopeguard.h"
 
 namespace QueryStageFetch {
 
@@ -219,6 +221,69 @@ public:
     }
 };
 
+//
+// Test that records are read ahead of being fetched when the stage is worked in batches, and that
+// results still come back in the order the child produced them.
+//
+class FetchStagePrefetchWorkBatch : public QueryStageFetchBase {
+public:
+    void run() {
+        Lock::DBLock lk(&_opCtx, nsToDatabaseSubstring(ns()), MODE_X);
+        OldClientContext ctx(&_opCtx, ns());
+        Database* db = ctx.db();
+        Collection* coll = db->getCollection(&_opCtx, ns());
+        if (!coll) {
+            WriteUnitOfWork wuow(&_opCtx);
+            coll = db->createCollection(&_opCtx, ns());
+            wuow.commit();
+        }
+
+        const int numDocs = 10;
+        for (int i = 0; i < numDocs; ++i) {
+            insert(BSON("foo" << i));
+        }
+        set<RecordId> recordIds;
+        getRecordIds(&recordIds, coll);
+        ASSERT_EQUALS(size_t(numDocs), recordIds.size());
+
+        const int oldLookahead = internalQueryFetchLookaheadRecords.load();
+        internalQueryFetchLookaheadRecords.store(8);
+        ON_BLOCK_EXIT([&] { internalQueryFetchLookaheadRecords.store(oldLookahead); });
+
+        // Queue the records in descending RecordId order, as a backwards index scan might.
+        WorkingSet ws;
+        auto mockStage = make_unique<QueuedDataStage>(&_opCtx, &ws);
+        for (auto it = recordIds.rbegin(); it != recordIds.rend(); ++it) {
+            WorkingSetID id = ws.allocate();
+            ws.get(id)->recordId = *it;
+            ws.transitionToRecordIdAndIdx(id);
+            mockStage->pushBack(id);
+        }
+
+        unique_ptr<FetchStage> fetchStage(
+            new FetchStage(&_opCtx, &ws, mockStage.release(), nullptr, coll));
+
+        std::vector<WorkingSetID> results;
+        PlanStage::StageState state = PlanStage::NEED_TIME;
+        while (PlanStage::NEED_TIME == state) {
+            WorkingSetID stateId = WorkingSet::INVALID_ID;
+            state = fetchStage->workBatch(4, &results, &stateId);
+        }
+        ASSERT_EQUALS(PlanStage::IS_EOF, state);
+
+        ASSERT_EQUALS(size_t(numDocs), results.size());
+        auto expectedId = recordIds.rbegin();
+        for (auto id : results) {
+            WorkingSetMember* member = ws.get(id);
+            ASSERT_TRUE(member->hasObj());
+            ASSERT_EQUALS(*expectedId++, member->recordId);
+        }
+
+        auto stats = static_cast<const FetchStats*>(fetchStage->getSpecificStats());
+        ASSERT_EQUALS(size_t(numDocs), stats->docsPrefetched);
+    }
+};
+
 class All : public Suite {
 public:
     All() : Suite("query_stage_fetch") {}
@@ -226,6 +291,7 @@ public:
     void setupTests() {
         add<FetchStageAlreadyFetched>();
         add<FetchStageFilter>();
+        add<FetchStagePrefetchWorkBatch>();
     }
 };
 
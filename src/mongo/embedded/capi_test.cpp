@@ -588,6 +588,7 @@ TEST_F(MongodbCAPITest, RunListCommands) {
                                           "planCacheListPlans",
                                           "planCacheListQueryShapes",
                                           "planCacheSetFilter",
+                                          "planCacheStats",
                                           "reIndex",
                                           "renameCollection",
                                           "repairCursor",